@@ -0,0 +1,104 @@
+#include "HistoryPopup.hpp"
+#include "YukiManager.hpp"
+#include <chrono>
+#include <unordered_map>
+
+namespace
+{
+    constexpr size_t MAX_ROWS = 12;
+
+    std::string formatAge(int64_t playedAt)
+    {
+        auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        int64_t seconds = std::max<int64_t>(0, (now - playedAt) / 1000);
+        if (seconds < 60)
+            return "just now";
+        if (seconds < 3600)
+            return fmt::format("{}m ago", seconds / 60);
+        if (seconds < 86400)
+            return fmt::format("{}h ago", seconds / 3600);
+        return fmt::format("{}d ago", seconds / 86400);
+    }
+}
+
+bool HistoryPopup::setup()
+{
+    this->setTitle(m_levelId ? "Level History" : "Score History");
+
+    auto contentSize = m_mainLayer->getContentSize();
+    float centerX = contentSize.width / 2;
+
+    auto &history = YukiManager::get()->history();
+    // A level's records are linked newest to oldest, so this reads only its own
+    auto records = m_levelId ? history.levelRecords(m_levelId, MAX_ROWS) : history.recent(MAX_ROWS);
+
+    if (records.empty())
+    {
+        auto emptyLabel = CCLabelBMFont::create(
+            m_levelId ? "No scores submitted for this level from this device yet"
+                      : "No scores submitted from this device yet",
+            "chatFont.fnt");
+        emptyLabel->setScale(0.6f);
+        emptyLabel->setPosition({centerX, contentSize.height / 2});
+        m_mainLayer->addChild(emptyLabel);
+        return true;
+    }
+
+    // Each level's summary is a single index lookup, so only fetch each once
+    std::unordered_map<int, LevelHistory> levels;
+    std::string rows = "level                       score   attempts   best      played\n";
+    for (const auto &record : records)
+    {
+        auto it = levels.find(record.levelId);
+        if (it == levels.end())
+        {
+            LevelHistory level;
+            history.level(record.levelId, level);
+            it = levels.emplace(record.levelId, std::move(level)).first;
+        }
+        const auto &level = it->second;
+
+        std::string name = level.name.empty() ? fmt::format("Level {}", record.levelId) : level.name;
+        if (name.size() > 24)
+            name = name.substr(0, 23) + "~";
+
+        std::string score = record.passed ? "pass" : fmt::format("{}%", record.percentage);
+        if (record.isPractice)
+            score += "*";
+
+        rows += fmt::format("{:<24} {:>8} {:>10} {:>6}% {:>11}\n",
+                            name, score, record.attempts, level.bestPercentage, formatAge(record.playedAt));
+    }
+
+    auto rowsLabel = CCLabelBMFont::create(rows.c_str(), "chatFont.fnt");
+    rowsLabel->setScale(0.5f);
+    rowsLabel->setAnchorPoint({0.5f, 1.f});
+    rowsLabel->setPosition({centerX, contentSize.height - 40});
+    rowsLabel->setAlignment(CCTextAlignment::kCCTextAlignmentLeft);
+    m_mainLayer->addChild(rowsLabel);
+
+    size_t recorded = m_levelId ? levels[m_levelId].recordCount : history.recordCount();
+    auto footer = CCLabelBMFont::create(
+        fmt::format("{} scores recorded | * practice", recorded).c_str(),
+        "chatFont.fnt");
+    footer->setScale(0.5f);
+    footer->setPosition({centerX, 20});
+    footer->setColor(ccc3(180, 180, 180));
+    m_mainLayer->addChild(footer);
+
+    return true;
+}
+
+HistoryPopup *HistoryPopup::create(int levelId)
+{
+    auto ret = new HistoryPopup();
+    ret->m_levelId = levelId;
+    if (ret->initAnchored(380.f, 260.f))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
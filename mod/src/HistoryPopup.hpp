@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Geode/Geode.hpp>
+#include <Geode/ui/Popup.hpp>
+
+using namespace geode::prelude;
+
+class HistoryPopup : public geode::Popup<>
+{
+protected:
+    // 0 for the newest scores of every level
+    int m_levelId = 0;
+
+    bool setup() override;
+
+public:
+    // `levelId` limits it to one level's scores, as from the pause menu
+    static HistoryPopup *create(int levelId = 0);
+};
@@ -1,5 +1,8 @@
 #include "LinkPopup.hpp"
 #include "YukiManager.hpp"
+#include "MetricsPopup.hpp"
+#include "HistoryPopup.hpp"
+#include "core/Metrics.hpp"
 #include <Geode/ui/TextInput.hpp>
 
 bool LinkPopup::setup()
@@ -81,6 +84,27 @@ bool LinkPopup::setup()
         m_mainLayer->addChild(m_loadingCircle);
     }
 
+    auto historyBtnSpr = CCSprite::createWithSpriteFrameName("GJ_statsBtn_001.png");
+    historyBtnSpr->setScale(0.5f);
+    auto historyBtn = CCMenuItemSpriteExtra::create(
+        historyBtnSpr,
+        this,
+        menu_selector(LinkPopup::onHistory));
+    historyBtn->setPosition({20, 20});
+    menu->addChild(historyBtn);
+
+    if (Metrics::enabled())
+    {
+        auto metricsBtnSpr = CCSprite::createWithSpriteFrameName("GJ_infoIcon_001.png");
+        metricsBtnSpr->setScale(0.7f);
+        auto metricsBtn = CCMenuItemSpriteExtra::create(
+            metricsBtnSpr,
+            this,
+            menu_selector(LinkPopup::onMetrics));
+        metricsBtn->setPosition({contentSize.width - 20, 20});
+        menu->addChild(metricsBtn);
+    }
+
     m_statusLabel = CCLabelBMFont::create("", "chatFont.fnt");
     m_statusLabel->setScale(0.6f);
     m_statusLabel->setPosition({centerX, contentSize.height - 230});
@@ -113,6 +137,16 @@ void LinkPopup::onOpenBrowser(CCObject *sender)
     web::openLinkInBrowser(url);
 }
 
+void LinkPopup::onMetrics(CCObject *sender)
+{
+    MetricsPopup::create()->show();
+}
+
+void LinkPopup::onHistory(CCObject *sender)
+{
+    HistoryPopup::create()->show();
+}
+
 void LinkPopup::onLink(CCObject *sender)
 {
     std::string code = m_codeInput->getString();
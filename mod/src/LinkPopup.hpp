@@ -17,6 +17,8 @@ protected:
     void onLink(CCObject *sender);
     void onUnlink(CCObject *sender);
     void onOpenBrowser(CCObject *sender);
+    void onMetrics(CCObject *sender);
+    void onHistory(CCObject *sender);
     void setLoading(bool loading);
     void showStatus(const std::string &message, bool isError);
     void closePopup();
@@ -0,0 +1,87 @@
+#include "LiveChannel.hpp"
+#include "YukiManager.hpp"
+#include "ServerConnection.hpp"
+#include "core/Metrics.hpp"
+
+LiveChannel* LiveChannel::s_instance = nullptr;
+
+LiveChannel* LiveChannel::get() {
+    if (!s_instance) {
+        s_instance = new LiveChannel();
+    }
+    return s_instance;
+}
+
+void LiveChannel::init() {
+    refreshSettings();
+    CCDirector::get()->getScheduler()->scheduleSelector(
+        schedule_selector(LiveChannel::onTick), this, TICK_INTERVAL, false);
+}
+
+void LiveChannel::refreshSettings() {
+    m_enabled = Mod::get()->getSettingValue<bool>("live-status");
+}
+
+void LiveChannel::onTick(float) {
+    uint64_t coalesced = m_coalescer.coalescedCount();
+    if (coalesced > m_reportedCoalesced) {
+        Metrics::increment(Metrics::Counter::LiveCoalesced, coalesced - m_reportedCoalesced);
+        m_reportedCoalesced = coalesced;
+    }
+
+    auto settings = YukiManager::get()->getSubmitSettings();
+    if (!m_enabled || !settings.linked || !settings.autoSubmit) {
+        // Whatever was last sent expires on the server by itself
+        if (!m_coalescer.inFlight()) {
+            m_coalescer.reset();
+        }
+        return;
+    }
+
+    LiveStatus status;
+    uint32_t seq;
+    if (m_coalescer.take(LiveCoalescer::Clock::now(), status, seq)) {
+        send(status, seq);
+    }
+}
+
+void LiveChannel::send(const LiveStatus& status, uint32_t seq) {
+    matjson::Value body;
+    body["auth_token"] = YukiManager::get()->getAuthToken();
+    body["seq"] = seq;
+    body["level_id"] = status.levelId;
+    body["percentage"] = status.percentage;
+    body["best_percentage"] = status.bestPercentage;
+    body["attempts"] = status.attempts;
+    body["practice"] = status.practice;
+
+    auto req = ServerConnection::get()->request();
+    req.header("Content-Type", "application/json");
+    req.bodyJSON(body);
+
+    std::string url = YukiManager::get()->getServerUrl() + "/api/live";
+
+    auto sentAt = std::chrono::steady_clock::now();
+    Metrics::increment(Metrics::Counter::LiveSent);
+    m_listener.bind([this, seq, sentAt](web::WebTask::Event* event) {
+        if (auto res = event->getValue()) {
+            Metrics::record(Metrics::Timer::LiveRoundTrip, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sentAt).count()));
+
+            // The server echoes the sequence number it applied
+            bool acked = false;
+            if (res->ok()) {
+                auto json = res->json().unwrapOr(matjson::Value());
+                acked = json["ack"].asUInt().unwrapOr(0) == seq;
+            }
+            if (!acked) {
+                log::debug("Live status update {} not acknowledged ({})", seq, res->code());
+            }
+            m_coalescer.onAcked(seq, acked);
+        } else if (event->isCancelled()) {
+            m_coalescer.onAcked(seq, false);
+        }
+    });
+
+    m_listener.setFilter(req.post(url));
+}
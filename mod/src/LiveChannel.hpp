@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Geode/Geode.hpp>
+#include <Geode/utils/web.hpp>
+#include "core/LiveStatus.hpp"
+
+using namespace geode::prelude;
+
+// Tells the server what the player is doing right now, for the bot's /live.
+//
+// Updates ride the same kept-alive HTTP/2 connection as score batches (see
+// ServerConnection), so a status update is a single small request on an already
+// open stream rather than a new handshake. The game loop only writes into a
+// LiveCoalescer; a tick sends the newest state when the previous one has been
+// acknowledged, so a slow connection sees fewer updates instead of a backlog.
+class LiveChannel : public CCObject {
+public:
+    static constexpr auto MIN_INTERVAL = std::chrono::seconds(1);
+    // The server forgets a player after 60s without hearing from them
+    static constexpr auto HEARTBEAT = std::chrono::seconds(20);
+    static constexpr float TICK_INTERVAL = 0.25f;
+
+    static LiveChannel* get();
+
+    void init();
+    void refreshSettings();
+
+    // Safe to call every frame: no allocations, no locks
+    void update(const LiveStatus& status) { m_coalescer.update(status); }
+
+private:
+    LiveChannel() = default;
+    static LiveChannel* s_instance;
+
+    void onTick(float dt);
+    void send(const LiveStatus& status, uint32_t seq);
+
+    LiveCoalescer m_coalescer{MIN_INTERVAL, HEARTBEAT};
+    EventListener<web::WebTask> m_listener;
+    bool m_enabled = false;
+    uint64_t m_reportedCoalesced = 0;
+};
@@ -0,0 +1,99 @@
+#include "MetricsPopup.hpp"
+#include "YukiManager.hpp"
+#include "core/Metrics.hpp"
+
+namespace
+{
+    std::string formatNs(uint64_t ns)
+    {
+        if (ns >= 1000000)
+            return fmt::format("{:.1f}ms", ns / 1e6);
+        if (ns >= 1000)
+            return fmt::format("{:.1f}us", ns / 1e3);
+        return fmt::format("{}ns", ns);
+    }
+}
+
+bool MetricsPopup::setup()
+{
+    this->setTitle("Yuki Metrics");
+
+    auto contentSize = m_mainLayer->getContentSize();
+    float centerX = contentSize.width / 2;
+
+    m_timersLabel = CCLabelBMFont::create("", "chatFont.fnt");
+    m_timersLabel->setScale(0.5f);
+    m_timersLabel->setAnchorPoint({0.5f, 1.f});
+    m_timersLabel->setPosition({centerX, contentSize.height - 40});
+    m_timersLabel->setAlignment(CCTextAlignment::kCCTextAlignmentLeft);
+    m_mainLayer->addChild(m_timersLabel);
+
+    m_countersLabel = CCLabelBMFont::create("", "chatFont.fnt");
+    m_countersLabel->setScale(0.5f);
+    m_countersLabel->setAnchorPoint({0.5f, 1.f});
+    m_countersLabel->setPosition({centerX, 90});
+    m_countersLabel->setAlignment(CCTextAlignment::kCCTextAlignmentCenter);
+    m_mainLayer->addChild(m_countersLabel);
+
+    auto menu = CCMenu::create();
+    menu->setPosition({0, 0});
+    m_mainLayer->addChild(menu);
+
+    auto resetBtnSpr = ButtonSprite::create("Reset", "goldFont.fnt", "GJ_button_05.png", 0.7f);
+    auto resetBtn = CCMenuItemSpriteExtra::create(
+        resetBtnSpr,
+        this,
+        menu_selector(MetricsPopup::onReset));
+    resetBtn->setPosition({centerX, 25});
+    menu->addChild(resetBtn);
+
+    this->refresh(0.f);
+    this->schedule(schedule_selector(MetricsPopup::refresh), 0.5f);
+
+    return true;
+}
+
+void MetricsPopup::refresh(float)
+{
+    auto snapshot = Metrics::snapshot();
+
+    std::string timers = "hook                      n       p50     p99     max\n";
+    for (size_t t = 0; t < Metrics::TIMER_COUNT; t++)
+    {
+        const auto &stats = snapshot.timers[t];
+        timers += fmt::format("{:<22} {:>7} {:>8} {:>8} {:>8}\n",
+                              Metrics::name(static_cast<Metrics::Timer>(t)),
+                              stats.count,
+                              formatNs(stats.p50Ns),
+                              formatNs(stats.p99Ns),
+                              formatNs(stats.maxNs));
+    }
+    m_timersLabel->setString(timers.c_str());
+
+    auto manager = YukiManager::get();
+    std::string counters = fmt::format("queued {} | in flight {}\n", manager->getQueueDepth(), manager->getInFlightCount());
+    for (size_t c = 0; c < Metrics::COUNTER_COUNT; c++)
+    {
+        counters += fmt::format("{} {}{}", Metrics::name(static_cast<Metrics::Counter>(c)),
+                                snapshot.counters[c], c + 1 < Metrics::COUNTER_COUNT ? " | " : "");
+    }
+    m_countersLabel->setString(counters.c_str());
+}
+
+void MetricsPopup::onReset(CCObject *sender)
+{
+    Metrics::reset();
+    this->refresh(0.f);
+}
+
+MetricsPopup *MetricsPopup::create()
+{
+    auto ret = new MetricsPopup();
+    if (ret && ret->initAnchored(380.f, 260.f))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
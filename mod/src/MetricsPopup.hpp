@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Geode/Geode.hpp>
+#include <Geode/ui/Popup.hpp>
+
+using namespace geode::prelude;
+
+class MetricsPopup : public geode::Popup<>
+{
+protected:
+    CCLabelBMFont *m_timersLabel = nullptr;
+    CCLabelBMFont *m_countersLabel = nullptr;
+
+    bool setup() override;
+    void refresh(float dt);
+    void onReset(CCObject *sender);
+
+public:
+    static MetricsPopup *create();
+};
@@ -0,0 +1,81 @@
+#include "OverlayChannel.hpp"
+
+OverlayChannel* OverlayChannel::s_instance = nullptr;
+
+OverlayChannel* OverlayChannel::get() {
+    if (!s_instance) {
+        s_instance = new OverlayChannel();
+    }
+    return s_instance;
+}
+
+void OverlayChannel::init() {
+    refreshSettings();
+}
+
+void OverlayChannel::refreshSettings() {
+    bool enabled = Mod::get()->getSettingValue<bool>("stream-overlay");
+    if (enabled == m_writer.isOpen()) return;
+
+    if (!enabled) {
+        // Overlays still holding the file show the player as gone
+        m_writer.state() = {};
+        m_writer.publish(OverlayState::now());
+        m_writer.close();
+        return;
+    }
+
+    auto path = Mod::get()->getSaveDir() / "overlay.bin";
+    if (!m_writer.open(path, OverlayState::now())) {
+        log::warn("Failed to open {} for stream overlays", path.string());
+        return;
+    }
+    m_writer.publish(OverlayState::now());
+}
+
+void OverlayChannel::enterLevel(int levelId, std::string_view name) {
+    if (!m_writer.isOpen()) return;
+
+    auto& state = m_writer.state();
+    state.levelId = levelId;
+    state.setLevelName(name);
+    state.attempt = 1;
+    state.percent = 0.f;
+    state.bestPercent = 0.f;
+    uint64_t now = OverlayState::now();
+    m_writer.pushEvent(OverlayEventType::EnterLevel, now);
+    m_writer.publish(now);
+}
+
+void OverlayChannel::update(int attempt, float percent, float bestPercent, bool practice) {
+    if (!m_writer.isOpen()) return;
+
+    auto& state = m_writer.state();
+    state.attempt = attempt;
+    state.percent = percent;
+    state.bestPercent = bestPercent;
+    state.practice = practice;
+    m_writer.publish(OverlayState::now());
+}
+
+void OverlayChannel::pushEvent(OverlayEventType type) {
+    if (!m_writer.isOpen()) return;
+    m_writer.pushEvent(type, OverlayState::now());
+}
+
+void OverlayChannel::exitLevel() {
+    if (!m_writer.isOpen()) return;
+
+    uint64_t now = OverlayState::now();
+    m_writer.pushEvent(OverlayEventType::ExitLevel, now);
+    auto gameState = m_writer.state().gameState;
+    m_writer.state() = {};
+    m_writer.state().gameState = gameState;
+    m_writer.publish(now);
+}
+
+void OverlayChannel::setGameState(GameState state) {
+    if (!m_writer.isOpen()) return;
+    m_writer.state().gameState = static_cast<uint8_t>(state);
+    m_writer.publish(OverlayState::now());
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Geode/Geode.hpp>
+#include "core/OverlayExport.hpp"
+#include "core/FlushScheduler.hpp"
+#include <string_view>
+
+using namespace geode::prelude;
+
+// Shares what the player is doing with stream overlays on the same machine,
+// through overlay.bin in the save folder (layout in core/OverlayExport.hpp, a
+// sample reader in tools/overlay). Nothing goes over the network.
+//
+// Every call is a few stores into mapped memory and does nothing while the
+// setting is off, so the frame hook can publish every frame. Main thread only.
+class OverlayChannel {
+public:
+    static OverlayChannel* get();
+
+    void init();
+    void refreshSettings();
+    bool enabled() const { return m_writer.isOpen(); }
+
+    void enterLevel(int levelId, std::string_view name);
+    void update(int attempt, float percent, float bestPercent, bool practice);
+    void pushEvent(OverlayEventType type);
+    void exitLevel();
+    void setGameState(GameState state);
+
+private:
+    OverlayChannel() = default;
+    static OverlayChannel* s_instance;
+
+    OverlayWriter m_writer;
+};
@@ -0,0 +1,71 @@
+#include "ServerConnection.hpp"
+#include "YukiManager.hpp"
+#include "core/Metrics.hpp"
+
+ServerConnection* ServerConnection::s_instance = nullptr;
+
+ServerConnection* ServerConnection::get() {
+    if (!s_instance) {
+        s_instance = new ServerConnection();
+    }
+    return s_instance;
+}
+
+void ServerConnection::init() {
+    CCDirector::get()->getScheduler()->scheduleSelector(
+        schedule_selector(ServerConnection::onPingTick), this, PING_INTERVAL, false);
+    prewarm();
+}
+
+web::WebRequest ServerConnection::request() {
+    m_lastActivity = Clock::now();
+
+    auto req = web::WebRequest();
+    req.version(web::HttpVersion::VERSION_2TLS);
+    return req;
+}
+
+bool ServerConnection::allowed() const {
+    // Nothing goes to the server before the account is linked
+    auto settings = YukiManager::get()->getSubmitSettings();
+    return settings.linked && settings.autoSubmit;
+}
+
+void ServerConnection::prewarm() {
+    if (m_pingInFlight || !allowed()) return;
+    if (Clock::now() - m_lastActivity < IDLE_TIMEOUT) return;
+    ping();
+}
+
+void ServerConnection::onPingTick(float dt) {
+    // Only keeps the connection up while it's being used, a player sitting in the
+    // menus for an hour doesn't need a ping every 30 seconds
+    if (m_pingInFlight || !allowed() || PlayLayer::get() == nullptr) return;
+    if (Clock::now() - m_lastActivity < IDLE_TIMEOUT) return;
+    ping();
+}
+
+void ServerConnection::ping() {
+    auto req = request();
+    std::string url = YukiManager::get()->getServerUrl() + "/api/ping";
+
+    m_pingInFlight = true;
+    auto sentAt = Clock::now();
+    m_pingListener.bind([this, sentAt](web::WebTask::Event* event) {
+        if (auto res = event->getValue()) {
+            m_pingInFlight = false;
+            Metrics::record(Metrics::Timer::PingRoundTrip, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sentAt).count()));
+
+            bool reachable = res->ok();
+            if (reachable != m_reachable) {
+                log::info("Yuki server is {}", reachable ? "reachable again" : "unreachable");
+            }
+            m_reachable = reachable;
+        } else if (event->isCancelled()) {
+            m_pingInFlight = false;
+        }
+    });
+
+    m_pingListener.setFilter(req.get(url));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Geode/Geode.hpp>
+#include <Geode/utils/web.hpp>
+#include <chrono>
+
+using namespace geode::prelude;
+
+// Keeps the connection to the Yuki server warm so the first score after an idle
+// gap doesn't pay for DNS, TCP and TLS setup.
+//
+// Geode's web thread owns the actual sockets; libcurl keeps finished connections
+// alive and reuses them for the same host. This makes every request to the server
+// go through the same settings (HTTP/2 over TLS where the server offers it, so a
+// single multiplexed connection carries concurrent batches), and sends a cheap
+// ping whenever that connection has likely been idle long enough to be closed.
+class ServerConnection : public CCObject {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Servers and proxies commonly drop idle keep-alive connections after 60-75s
+    static constexpr auto IDLE_TIMEOUT = std::chrono::seconds(50);
+    static constexpr float PING_INTERVAL = 30.f;
+
+    static ServerConnection* get();
+
+    void init();
+
+    // Every request to the Yuki server should start from this
+    web::WebRequest request();
+
+    // Opens a connection now if the last one has probably gone idle
+    void prewarm();
+
+    bool isReachable() const { return m_reachable; }
+
+private:
+    ServerConnection() = default;
+    static ServerConnection* s_instance;
+
+    bool allowed() const;
+    void onPingTick(float dt);
+    void ping();
+
+    EventListener<web::WebTask> m_pingListener;
+    bool m_pingInFlight = false;
+    bool m_reachable = true;
+    Clock::time_point m_lastActivity{};
+};
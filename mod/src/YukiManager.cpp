@@ -1,8 +1,43 @@
 #include "YukiManager.hpp"
+#include "ServerConnection.hpp"
+#include "OverlayChannel.hpp"
 #include <Geode/loader/Mod.hpp>
+#include <algorithm>
+#include <utility>
 
 YukiManager* YukiManager::s_instance = nullptr;
 
+static LevelLeaderboard parseLeaderboard(const matjson::Value& json) {
+    LevelLeaderboard board;
+    board.levelId = static_cast<int>(json["level_id"].asInt().unwrapOr(0));
+    board.players = static_cast<uint32_t>(json["players"].asUInt().unwrapOr(0));
+    board.rank = static_cast<int>(json["rank"].asInt().unwrapOr(0));
+    board.best = static_cast<int>(json["best"].asInt().unwrapOr(0));
+
+    if (auto top = json["top"].asArray()) {
+        for (const auto& item : top.unwrap()) {
+            LeaderboardEntry entry;
+            entry.rank = static_cast<int>(item["rank"].asInt().unwrapOr(0));
+            entry.name = item["name"].asString().unwrapOr("");
+            entry.percentage = static_cast<int>(item["percentage"].asInt().unwrapOr(0));
+            entry.self = item["self"].asBool().unwrapOr(false);
+            board.top.push_back(std::move(entry));
+        }
+    }
+    return board;
+}
+
+YukiManager::YukiManager()
+    : m_outbox(Mod::get()->getSaveDir() / "outbox"),
+      m_backoff(std::chrono::seconds(2), std::chrono::minutes(5)),
+      m_batchPolicy(32, std::chrono::seconds(5)),
+      m_flushScheduler(32, std::chrono::minutes(2)),
+      m_submissions(2),
+      m_worker([this](const ScoreEvent& event, const AttemptTimeline* timeline) { onScoreEvent(event, timeline); }),
+      m_heatmaps(Mod::get()->getSaveDir() / "heatmaps"),
+      m_sessions(Mod::get()->getSaveDir() / "sessions"),
+      m_history(Mod::get()->getSaveDir() / "history") {}
+
 YukiManager* YukiManager::get() {
     if (!s_instance) {
         s_instance = new YukiManager();
@@ -10,6 +45,47 @@ YukiManager* YukiManager::get() {
     return s_instance;
 }
 
+void YukiManager::init() {
+    refreshSettings();
+
+    if (!m_outbox.open()) {
+        log::error("Failed to open score outbox, scores won't be submitted");
+    } else if (m_outbox.pendingCount() > 0) {
+        log::info("{} queued scores waiting to be submitted", m_outbox.pendingCount());
+    }
+
+    m_worker.start();
+    uploadHeatmaps();
+    uploadSessions();
+    syncHistory();
+
+    // Retries after backoff and picks up scores queued while offline
+    CCDirector::get()->getScheduler()->scheduleSelector(
+        schedule_selector(YukiManager::onDrainTick), this, 1.f, false);
+}
+
+void YukiManager::refreshSettings() {
+    m_autoSubmit = Mod::get()->getSettingValue<bool>("auto-submit");
+    m_submitFails = Mod::get()->getSettingValue<bool>("submit-fails");
+    m_maxConcurrentSubmissions = static_cast<size_t>(
+        Mod::get()->getSettingValue<int64_t>("max-concurrent-submissions"));
+    m_linked = isLinked();
+    m_flushScheduler.setEnabled(Mod::get()->getSettingValue<bool>("hold-while-playing"));
+    Metrics::setEnabled(Mod::get()->getSettingValue<bool>("debug-metrics"));
+}
+
+SubmitSettings YukiManager::getSubmitSettings() const {
+    return {
+        m_autoSubmit.load(std::memory_order_relaxed),
+        m_submitFails.load(std::memory_order_relaxed),
+        m_linked.load(std::memory_order_relaxed),
+    };
+}
+
+uint32_t YukiManager::internString(std::string_view value) {
+    return m_strings.intern(value);
+}
+
 std::string YukiManager::getServerUrl() const {
     return "https://yuki.tuuli.moe";
 }
@@ -28,6 +104,7 @@ std::string YukiManager::getLinkedDiscordUsername() const {
 
 void YukiManager::setAuthToken(const std::string& token) {
     Mod::get()->setSavedValue("auth-token", token);
+    m_linked = !token.empty();
 }
 
 void YukiManager::setLinkedDiscordUsername(const std::string& username) {
@@ -35,55 +112,730 @@ void YukiManager::setLinkedDiscordUsername(const std::string& username) {
 }
 
 void YukiManager::unlinkAccount() {
+    m_linked = false;
     Mod::get()->setSavedValue("auth-token", std::string(""));
     Mod::get()->setSavedValue("discord-username", std::string(""));
+    m_outbox.clear();
+    m_submissions.reset();
+    m_leaderboards.clear();
+    // Another account's scores aren't this history's, start over from now if relinked
+    Mod::get()->setSavedValue<int64_t>("sync-since", -1);
+}
+
+bool YukiManager::queueScore(ScoreEvent event, const AttemptTimeline* timeline) {
+    // The timeline is copied into the worker's ring and encoded over there
+    if (!m_worker.push(event, timeline)) {
+        Metrics::increment(Metrics::Counter::ScoresDropped);
+        log::warn("Submit queue full, dropped a {}% score on level {} ({} dropped so far)", event.percentage,
+                  event.levelId, m_worker.dropped());
+        return false;
+    }
+    Metrics::increment(Metrics::Counter::ScoresQueued);
+    return true;
 }
 
-void YukiManager::submitScore(const ScoreData& score) {
-    if (!isLinked()) {
+void YukiManager::onScoreEvent(const ScoreEvent& event, const AttemptTimeline* timeline) {
+    ScoreData score;
+    score.levelId = event.levelId;
+    score.levelName = m_strings.lookup(event.levelNameId);
+    score.levelCreator = m_strings.lookup(event.levelCreatorId);
+    score.percentage = event.percentage;
+    score.attempts = event.attempts;
+    score.passed = event.passed;
+    score.isPractice = event.isPractice;
+    score.coinsCollected.resize(event.coinCount);
+    for (uint8_t i = 0; i < event.coinCount; i++) {
+        score.coinsCollected[i] = (event.coinMask >> i) & 1;
+    }
+
+    if (timeline) score.timeline = timeline->encode();
+
+    submitScore(std::move(score));
+}
+
+void YukiManager::submitScore(ScoreData score) {
+    Metrics::ScopedTimer timer(Metrics::Timer::SubmitScore);
+
+    if (!m_linked) {
         log::warn("Cannot submit score: account not linked");
         return;
     }
 
+    // The outbox and the history must agree on the time, history sync matches by it
+    score.playedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // Persist before touching the network so a crash or being offline doesn't lose it
+    if (!m_outbox.append(score)) {
+        log::error("Failed to queue score for level {}", score.levelId);
+        return;
+    }
+
+    if (!m_history.append(score, score.playedAt)) {
+        log::warn("Failed to record score for level {} in history", score.levelId);
+    }
+
+    // Deaths can wait for a batch, passes go out right away
+    bool urgent = score.passed;
+    Loader::get()->queueInMainThread([this, urgent] {
+        m_batchPolicy.onQueued(BatchPolicy::Clock::now(), urgent);
+        drainOutbox();
+    });
+}
+
+void YukiManager::setGameState(GameState state) {
+    OverlayChannel::get()->setGameState(state);
+
+    // Frame pacing is only watched with metrics on, nothing of ours runs per frame otherwise
+    bool timeFrames = state == GameState::Playing && Metrics::enabled();
+    if (timeFrames != m_timingFrames) {
+        m_timingFrames = timeFrames;
+        m_lastFrame = {};
+        auto scheduler = CCDirector::get()->getScheduler();
+        if (timeFrames) {
+            scheduler->scheduleSelector(schedule_selector(YukiManager::onFrame), this, 0.f, false);
+        } else {
+            scheduler->unscheduleSelector(schedule_selector(YukiManager::onFrame), this);
+        }
+    }
+
+    if (!m_flushScheduler.setState(state)) return;
+
+    if (getQueueDepth() > 0) {
+        Metrics::increment(Metrics::Counter::HeldFlushes);
+        drainOutbox();
+    }
+    if (m_syncHeld && m_sync) {
+        m_syncHeld = false;
+        sendSyncRound();
+    }
+}
+
+void YukiManager::onDrainTick(float) {
+    drainOutbox();
+    // Waits for scores queued while offline to go out first
+    syncHistory();
+
+    constexpr int METRICS_DUMP_INTERVAL = 30;
+    if (Metrics::enabled() && ++m_ticksSinceMetricsDump >= METRICS_DUMP_INTERVAL) {
+        m_ticksSinceMetricsDump = 0;
+        dumpMetrics();
+    }
+}
+
+void YukiManager::onFrame(float) {
+    auto now = std::chrono::steady_clock::now();
+    auto last = std::exchange(m_lastFrame, now);
+    // Anything longer was a load, not a frame
+    if (last == std::chrono::steady_clock::time_point{} || now - last > std::chrono::seconds(1)) return;
+    Metrics::record(Metrics::Timer::FrameInterval, static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count()));
+}
+
+void YukiManager::dumpMetrics() {
+    auto json = Metrics::toJson(Metrics::snapshot());
+    auto res = utils::file::writeString(Mod::get()->getSaveDir() / "metrics.json", json);
+    if (!res) {
+        log::warn("Failed to write metrics: {}", res.unwrapErr());
+    }
+}
+
+void YukiManager::drainOutbox() {
+    if (!m_outbox.isOpen() || !isLinked()) return;
+
+    m_submissions.setMaxInFlight(m_maxConcurrentSubmissions);
+
+    auto now = BatchPolicy::Clock::now();
+    if (m_flushScheduler.shouldHold(getQueueDepth(), now)) return;
+
+    while (m_submissions.canStart() && m_backoff.ready(now) &&
+           m_batchPolicy.shouldFlush(getQueueDepth(), now)) {
+        auto batch = m_outbox.readBatch(m_batchPolicy.maxSize());
+        if (batch.empty()) return;
+
+        sendBatch(batch);
+        m_batchPolicy.onFlushed(getQueueDepth(), now);
+        m_flushScheduler.onFlushed();
+    }
+}
+
+void YukiManager::sendBatch(const std::vector<OutboxEntry>& batch) {
+    auto header = makeSessionHeader();
+
+    std::vector<ScoreData> scores;
+    std::vector<LevelMeta> levels;
+    std::vector<int> levelIds;
+    scores.reserve(batch.size());
+    for (const auto& entry : batch) {
+        scores.push_back(entry.score);
+
+        int levelId = entry.score.levelId;
+        auto it = m_pendingLevels.find(levelId);
+        if (it != m_pendingLevels.end() && std::find(levelIds.begin(), levelIds.end(), levelId) == levelIds.end()) {
+            levels.push_back(it->second);
+            levelIds.push_back(levelId);
+        }
+    }
+
+    auto req = ServerConnection::get()->request();
+    if (m_useBinaryWire) {
+        req.header("Content-Type", ScoreCodec::CONTENT_TYPE);
+        req.body(ScoreCodec::encodeBatch(header, scores, levels));
+    } else {
+        req.header("Content-Type", "application/json");
+        req.bodyString(ScoreCodec::encodeBatchJson(header, scores, levels));
+    }
+
+    std::string url = getServerUrl() + "/api/scores/batch";
+
+    size_t count = batch.size();
+    uint64_t firstSeq = batch.front().seq;
+    uint64_t lastSeq = batch.back().seq;
+    uint64_t id = m_submissions.start(lastSeq, count);
+    if (!levelIds.empty()) {
+        m_batchLevels[id] = std::move(levelIds);
+    }
+
+    // One listener per request, so a second batch doesn't drop the first one's result
+    auto& listener = m_submitListeners[id];
+    listener = std::make_unique<EventListener<web::WebTask>>();
+    auto sentAt = std::chrono::steady_clock::now();
+    Metrics::increment(Metrics::Counter::BatchesSent);
+    listener->bind([this, id, count, firstSeq, lastSeq, sentAt](web::WebTask::Event* event) {
+        Metrics::ScopedTimer timer(Metrics::Timer::SubmitCallback);
+        if (event->getValue() || event->isCancelled()) {
+            Metrics::record(Metrics::Timer::SubmitRoundTrip, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sentAt).count()));
+        }
+
+        if (auto res = event->getValue()) {
+            if (res->ok()) {
+                log::info("Submitted {} score(s) successfully", count);
+                // Passes come back with their level's standings
+                if (auto leaderboards = res->json().unwrapOr(matjson::Value())["leaderboards"].asArray()) {
+                    for (const auto& board : leaderboards.unwrap()) {
+                        onLeaderboard(board);
+                    }
+                }
+                onSubmitFinished(id, true, false);
+            } else {
+                int code = res->code();
+                if (code == 415 && m_useBinaryWire) {
+                    // Server doesn't understand the binary format, resend as JSON
+                    log::warn("Server rejected binary score batch, falling back to JSON");
+                    m_useBinaryWire = false;
+                    onSubmitFinished(id, false, true);
+                    return;
+                }
+
+                // Client errors (bad token, malformed body) won't succeed on a retry
+                bool retryable = code < 400 || code >= 500 || code == 429;
+                if (retryable) {
+                    log::error("Failed to submit scores (HTTP {}): {}", code, res->string().unwrapOr("Unknown error"));
+                } else {
+                    log::error("Server rejected {} score(s), seq {}-{}, with HTTP {}; dropping them: {}", count,
+                               firstSeq, lastSeq, code, res->string().unwrapOr("Unknown error"));
+                    Metrics::increment(Metrics::Counter::ScoresRejected, count);
+                }
+                onSubmitFinished(id, false, retryable);
+            }
+        } else if (event->isCancelled()) {
+            log::warn("Score submission cancelled");
+            onSubmitFinished(id, false, true);
+        }
+    });
+
+    listener->setFilter(req.post(url));
+}
+
+void YukiManager::onSubmitFinished(uint64_t id, bool delivered, bool retryable) {
+    // Metadata of a failed batch stays pending and rides along with the retry
+    if (auto it = m_batchLevels.find(id); it != m_batchLevels.end()) {
+        if (delivered) {
+            for (int levelId : it->second) {
+                m_pendingLevels.erase(levelId);
+                m_reportedLevels.insert(levelId);
+            }
+        }
+        m_batchLevels.erase(it);
+    }
+
+    if (delivered || !retryable) {
+        if (uint64_t ackSeq = m_submissions.complete(id)) {
+            m_outbox.ack(ackSeq);
+        }
+        m_backoff.onSuccess();
+    } else {
+        Metrics::increment(Metrics::Counter::BatchesFailed);
+        m_submissions.fail(id);
+        m_backoff.onFailure(RetryBackoff::Clock::now());
+    }
+
+    if (m_submissions.needsRewind()) {
+        m_outbox.rewind();
+        m_submissions.reset();
+        log::info("Retrying score submission in a bit ({} queued)", m_outbox.pendingCount());
+    }
+
+    // Don't destroy the listener from inside its own callback
+    Loader::get()->queueInMainThread([this, id] {
+        m_submitListeners.erase(id);
+        drainOutbox();
+    });
+}
+
+ScoreCodec::SessionHeader YukiManager::makeSessionHeader() const {
     auto am = GJAccountManager::sharedState();
-    int gdAccountId = am->m_accountID;
-    std::string gdUsername = am->m_username;
+
+    ScoreCodec::SessionHeader header;
+    header.authToken = getAuthToken();
+    header.gdAccountId = am->m_accountID;
+    header.gdUsername = am->m_username;
+    header.installId = fmt::format("{:016x}", m_outbox.installId());
+    return header;
+}
+
+size_t YukiManager::getQueueDepth() const {
+    return m_outbox.pendingCount() - m_outbox.inFlightCount();
+}
+
+size_t YukiManager::getInFlightCount() const {
+    return m_submissions.stats().inFlightRequests;
+}
+
+void YukiManager::reportLevel(const LevelMeta& level) {
+    if (level.levelId <= 0 || m_reportedLevels.contains(level.levelId)) return;
+
+    // Levels played without a qualifying score never get flushed, keep that bounded
+    if (m_pendingLevels.size() >= 64 && !m_pendingLevels.contains(level.levelId)) {
+        m_pendingLevels.erase(m_pendingLevels.begin());
+    }
+    m_pendingLevels[level.levelId] = level;
+}
+
+void YukiManager::recordHeatmap(int levelId, const DeathHistogram& session) {
+    if (!m_heatmaps.mergeSession(levelId, session)) {
+        log::error("Failed to save death heatmap for level {}", levelId);
+    }
+    uploadHeatmaps();
+}
+
+void YukiManager::uploadHeatmaps() {
+    if (m_heatmapUploadInFlight || !m_linked || !m_autoSubmit) return;
+    if (!Mod::get()->getSettingValue<bool>("upload-heatmaps")) return;
+
+    constexpr size_t MAX_LEVELS_PER_UPLOAD = 20;
+
+    auto levels = m_heatmaps.pendingLevels();
+    if (levels.empty()) return;
+    if (levels.size() > MAX_LEVELS_PER_UPLOAD) levels.resize(MAX_LEVELS_PER_UPLOAD);
+
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::vector<HeatmapUpload> sent;
+    matjson::Value heatmaps = matjson::Value::array();
+    for (int levelId : levels) {
+        HeatmapUpload upload;
+        if (!m_heatmaps.takeUpload(levelId, now, upload)) continue;
+
+        // Sparse [bucket, count] pairs
+        matjson::Value counts = matjson::Value::array();
+        upload.deaths.forEachNonZero([&](int bucket, uint32_t count) {
+            matjson::Value pair = matjson::Value::array();
+            pair.push(bucket);
+            pair.push(count);
+            counts.push(pair);
+        });
+
+        matjson::Value item;
+        item["level_id"] = levelId;
+        item["buckets"] = DeathHistogram::BUCKETS;
+        item["counts"] = counts;
+        item["upload_seq"] = static_cast<int64_t>(upload.seq);
+        heatmaps.push(item);
+        sent.push_back(std::move(upload));
+    }
+    if (sent.empty()) return;
 
     matjson::Value body;
     body["auth_token"] = getAuthToken();
-    body["gd_account_id"] = gdAccountId;
-    body["gd_username"] = gdUsername;
-    body["level_id"] = score.levelId;
-    body["percentage"] = score.percentage;
-    body["attempts"] = score.attempts;
-    body["passed"] = score.passed;
-    body["is_practice"] = score.isPractice;
-    
-    matjson::Value coins = matjson::Value::array();
-    for (bool coin : score.coinsCollected) {
-        coins.push(coin);
-    }
-    body["coins_collected"] = coins;
-
-    auto req = web::WebRequest();
+    // With the seqs, lets the server skip uploads it merged before the response got lost
+    body["install_id"] = fmt::format("{:016x}", m_outbox.installId());
+    body["heatmaps"] = heatmaps;
+
+    auto req = ServerConnection::get()->request();
     req.header("Content-Type", "application/json");
     req.bodyJSON(body);
 
-    std::string url = getServerUrl() + "/api/scores";
+    std::string url = getServerUrl() + "/api/heatmaps";
 
-    m_submitListener.bind([](web::WebTask::Event* event) {
+    m_heatmapUploadInFlight = true;
+    m_heatmapListener.bind([this, sent = std::move(sent)](web::WebTask::Event* event) {
         if (auto res = event->getValue()) {
+            m_heatmapUploadInFlight = false;
             if (res->ok()) {
-                log::info("Score submitted successfully");
+                for (const auto& upload : sent) {
+                    m_heatmaps.markUploaded(upload);
+                }
+                log::info("Uploaded death heatmaps for {} level(s)", sent.size());
+                // Deaths recorded while this was in flight, or levels past the limit.
+                // Not from inside the listener's own callback
+                Loader::get()->queueInMainThread([this] {
+                    uploadHeatmaps();
+                });
             } else {
-                log::error("Failed to submit score: {}", res->string().unwrapOr("Unknown error"));
+                // Stays pending, the next session end or startup tries again
+                log::error("Failed to upload heatmaps: {}", res->string().unwrapOr("Unknown error"));
             }
         } else if (event->isCancelled()) {
-            log::warn("Score submission cancelled");
+            m_heatmapUploadInFlight = false;
+        }
+    });
+
+    m_heatmapListener.setFilter(req.post(url));
+}
+
+void YukiManager::recordSession(const SessionSummary& summary) {
+    if (!m_sessions.append(summary)) {
+        log::error("Failed to save session summary for level {}", summary.levelId);
+    }
+    uploadSessions();
+}
+
+void YukiManager::uploadSessions() {
+    if (m_sessionUploadInFlight || !m_linked || !m_autoSubmit) return;
+
+    constexpr size_t MAX_SESSIONS_PER_UPLOAD = 50;
+
+    auto summaries = m_sessions.loadPending(MAX_SESSIONS_PER_UPLOAD);
+    if (summaries.empty()) return;
+
+    matjson::Value sessions = matjson::Value::array();
+    for (const auto& summary : summaries) {
+        // Sparse [bucket, count] pairs, same as heatmaps
+        matjson::Value deaths = matjson::Value::array();
+        summary.deaths.forEachNonZero([&](int bucket, uint32_t count) {
+            matjson::Value pair = matjson::Value::array();
+            pair.push(bucket);
+            pair.push(count);
+            deaths.push(pair);
+        });
+
+        matjson::Value item;
+        item["level_id"] = summary.levelId;
+        item["attempts"] = summary.attempts;
+        item["best_percentage"] = summary.bestPercentage;
+        item["time_alive_ms"] = static_cast<int64_t>(summary.timeAliveMs);
+        item["completed"] = summary.completed;
+        item["used_practice"] = summary.usedPractice;
+        item["started_at"] = summary.startedAt;
+        item["ended_at"] = summary.endedAt;
+        item["deaths"] = deaths;
+        sessions.push(item);
+    }
+
+    matjson::Value body;
+    body["auth_token"] = getAuthToken();
+    body["sessions"] = sessions;
+
+    auto req = ServerConnection::get()->request();
+    req.header("Content-Type", "application/json");
+    req.bodyJSON(body);
+
+    std::string url = getServerUrl() + "/api/sessions";
+
+    size_t count = summaries.size();
+    m_sessionUploadInFlight = true;
+    m_sessionListener.bind([this, count](web::WebTask::Event* event) {
+        if (auto res = event->getValue()) {
+            m_sessionUploadInFlight = false;
+            if (res->ok()) {
+                m_sessions.markUploaded(count);
+                log::info("Uploaded {} session summary(s)", count);
+            } else {
+                // Stays pending, the next session end or startup tries again
+                log::error("Failed to upload session summaries: {}", res->string().unwrapOr("Unknown error"));
+            }
+        } else if (event->isCancelled()) {
+            m_sessionUploadInFlight = false;
+        }
+    });
+
+    m_sessionListener.setFilter(req.post(url));
+}
+
+void YukiManager::watchLeaderboard(int levelId, bool fetch,
+                                   std::function<void(const LevelLeaderboard&)> callback) {
+    m_watchedLevel = levelId;
+    m_leaderboardWatcher = std::move(callback);
+
+    LevelLeaderboard cached;
+    bool fresh = false;
+    if (m_leaderboards.get(levelId, LeaderboardCache::Clock::now(), cached, &fresh)) {
+        m_leaderboardWatcher(cached);
+    }
+    if (!fetch || fresh || !m_linked) return;
+
+    matjson::Value body;
+    body["auth_token"] = getAuthToken();
+    body["level_id"] = levelId;
+
+    auto req = ServerConnection::get()->request();
+    req.header("Content-Type", "application/json");
+    req.bodyJSON(body);
+
+    std::string url = getServerUrl() + "/api/leaderboard";
+
+    m_leaderboardListener.bind([this](web::WebTask::Event* event) {
+        if (auto res = event->getValue()) {
+            if (res->ok()) {
+                onLeaderboard(res->json().unwrapOr(matjson::Value())["leaderboard"]);
+            } else {
+                // Whatever was cached stays on screen
+                log::warn("Failed to fetch leaderboard: {}", res->string().unwrapOr("Unknown error"));
+            }
+        }
+    });
+
+    m_leaderboardListener.setFilter(req.post(url));
+}
+
+void YukiManager::unwatchLeaderboard() {
+    m_watchedLevel = 0;
+    m_leaderboardWatcher = nullptr;
+}
+
+void YukiManager::onLeaderboard(const matjson::Value& json) {
+    auto board = parseLeaderboard(json);
+    if (board.levelId == 0) return;
+
+    m_leaderboards.put(board, LeaderboardCache::Clock::now());
+    if (m_leaderboardWatcher && board.levelId == m_watchedLevel) {
+        m_leaderboardWatcher(board);
+    }
+}
+
+void YukiManager::syncHistory() {
+    if (m_syncStarted || !m_linked || !m_outbox.isOpen() || m_outbox.pendingCount() > 0) return;
+    m_syncStarted = true;
+
+    // Scores from before sync existed went out without a time and can't be matched,
+    // so an existing history syncs from when it first could. An empty one, as after
+    // a reinstall, gets everything the server has.
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto since = Mod::get()->getSavedValue<int64_t>("sync-since", -1);
+    if (since < 0) {
+        since = m_history.recordCount() == 0 ? 0 : now;
+        Mod::get()->setSavedValue<int64_t>("sync-since", since);
+    }
+
+    m_syncSince = since;
+    m_syncStartedAt = now;
+    m_syncRounds = 0;
+    m_syncBytesSent = 0;
+    m_syncBytesReceived = 0;
+    m_sync = std::make_unique<RangeReconciler>(m_history.recordsSince(since));
+    sendSyncRound();
+}
+
+static matjson::Value syncKeyJson(const SyncKey& key) {
+    matjson::Value value = matjson::Value::array();
+    value.push(key.levelId);
+    value.push(key.playedAt);
+    return value;
+}
+
+static SyncKey parseSyncKey(const matjson::Value& value) {
+    return {static_cast<int>(value[0].asInt().unwrapOr(0)), static_cast<int64_t>(value[1].asInt().unwrapOr(0))};
+}
+
+static std::vector<RemoteRecord> parseRemoteRecords(const matjson::Value& json) {
+    std::vector<RemoteRecord> items;
+    auto list = json.asArray();
+    if (!list) return items;
+
+    for (const auto& item : list.unwrap()) {
+        RemoteRecord remote;
+        auto& record = remote.record;
+        record.levelId = static_cast<int>(item["level_id"].asInt().unwrapOr(0));
+        record.playedAt = static_cast<int64_t>(item["played_at"].asInt().unwrapOr(0));
+        record.percentage = static_cast<int>(item["percentage"].asInt().unwrapOr(0));
+        record.attempts = static_cast<int>(item["attempts"].asInt().unwrapOr(0));
+        record.passed = item["passed"].asBool().unwrapOr(false);
+        record.isPractice = item["is_practice"].asBool().unwrapOr(false);
+        if (auto coins = item["coins"].asArray()) {
+            for (const auto& coin : coins.unwrap()) {
+                if (record.coinCount >= 64) break;
+                if (coin.asBool().unwrapOr(false)) record.coinMask |= uint64_t(1) << record.coinCount;
+                record.coinCount++;
+            }
+        }
+        remote.levelName = item["name"].asString().unwrapOr("");
+        items.push_back(std::move(remote));
+    }
+    return items;
+}
+
+void YukiManager::sendSyncRound() {
+    constexpr size_t MAX_RANGES_PER_ROUND = 64;
+
+    // Rounds can carry megabytes, nothing here is worth a dropped frame
+    if (m_flushScheduler.playing()) {
+        m_syncHeld = true;
+        return;
+    }
+
+    auto ranges = m_sync->takeRequest(MAX_RANGES_PER_ROUND);
+    matjson::Value list = matjson::Value::array();
+    for (const auto& range : ranges) {
+        matjson::Value item;
+        item["from"] = syncKeyJson(range.from);
+        if (!range.open) item["to"] = syncKeyJson(range.to);
+        item["count"] = range.count;
+        item["hash"] = fmt::format("{:016x}", range.hash);
+        if (range.count <= RangeReconciler::ITEM_LIST_SIZE) {
+            matjson::Value hashes = matjson::Value::array();
+            for (const auto& record : m_sync->localItems(range)) {
+                hashes.push(fmt::format("{:016x}", syncHash(record)));
+            }
+            item["items"] = hashes;
+        }
+        list.push(item);
+    }
+
+    matjson::Value body;
+    body["auth_token"] = getAuthToken();
+    body["since"] = m_syncSince;
+    body["ranges"] = list;
+
+    auto req = ServerConnection::get()->request();
+    req.header("Content-Type", "application/json");
+    auto payload = body.dump(matjson::NO_INDENTATION);
+    m_syncBytesSent += payload.size();
+    req.bodyString(payload);
+
+    std::string url = getServerUrl() + "/api/sync";
+
+    m_syncListener.bind([this, ranges = std::move(ranges)](web::WebTask::Event* event) {
+        if (auto res = event->getValue()) {
+            auto results = res->json().unwrapOr(matjson::Value())["results"].asArray();
+            if (!res->ok() || !results || results.unwrap().size() != ranges.size()) {
+                // Nothing was changed yet, the next launch starts over
+                log::error("History sync failed: {}", res->string().unwrapOr("Unknown error"));
+                m_sync.reset();
+                return;
+            }
+            m_syncRounds++;
+            m_syncBytesReceived += res->data().size();
+
+            auto& answers = results.unwrap();
+            for (size_t i = 0; i < ranges.size(); i++) {
+                const auto& answer = answers[i];
+                auto status = answer["status"].asString().unwrapOr("");
+                if (status == "split") {
+                    std::vector<SyncRange> parts;
+                    if (auto list = answer["parts"].asArray()) {
+                        for (const auto& item : list.unwrap()) {
+                            SyncRange part;
+                            part.from = parseSyncKey(item["from"]);
+                            part.open = !item["to"].isArray();
+                            if (!part.open) part.to = parseSyncKey(item["to"]);
+                            part.count = static_cast<uint32_t>(item["count"].asUInt().unwrapOr(0));
+                            part.hash = std::strtoull(item["hash"].asString().unwrapOr("0").c_str(), nullptr, 16);
+                            parts.push_back(part);
+                        }
+                    }
+                    m_sync->onSplit(parts);
+                } else if (status == "items") {
+                    m_sync->onItems(ranges[i], parseRemoteRecords(answer["items"]));
+                } else if (status == "diff") {
+                    std::vector<size_t> missing;
+                    if (auto list = answer["missing"].asArray()) {
+                        for (const auto& index : list.unwrap()) {
+                            missing.push_back(static_cast<size_t>(index.asUInt().unwrapOr(0)));
+                        }
+                    }
+                    m_sync->onDiff(ranges[i], missing, parseRemoteRecords(answer["items"]));
+                }
+            }
+
+            if (m_sync->done()) {
+                finishSync();
+            } else {
+                // Not from inside the listener's own callback
+                Loader::get()->queueInMainThread([this] {
+                    if (m_sync) sendSyncRound();
+                });
+            }
+        } else if (event->isCancelled()) {
+            m_sync.reset();
         }
     });
 
-    m_submitListener.setFilter(req.post(url));
+    m_syncListener.setFilter(req.post(url));
+}
+
+void YukiManager::finishSync() {
+    const auto& upload = m_sync->missingOnServer();
+    const auto& download = m_sync->missingLocally();
+
+    // Straight into the outbox: the history already has them
+    for (const auto& record : upload) {
+        ScoreData score{};
+        score.levelId = record.levelId;
+        LevelHistory level;
+        if (m_history.level(record.levelId, level)) score.levelName = level.name;
+        score.percentage = record.percentage;
+        score.attempts = record.attempts;
+        score.passed = record.passed;
+        score.isPractice = record.isPractice;
+        score.playedAt = record.playedAt;
+        score.coinsCollected.resize(static_cast<size_t>(record.coinCount));
+        for (int i = 0; i < record.coinCount; i++) {
+            score.coinsCollected[i] = (record.coinMask >> i) & 1;
+        }
+        if (!m_outbox.append(score)) {
+            log::error("Failed to queue score for level {} for resending", score.levelId);
+            break;
+        }
+    }
+
+    size_t recorded = 0;
+    for (const auto& remote : download) {
+        const auto& record = remote.record;
+        // Submitted while the sync ran, so the history has it but the snapshot doesn't
+        if (record.playedAt >= m_syncStartedAt) continue;
+
+        ScoreData score{};
+        score.levelId = record.levelId;
+        score.levelName = remote.levelName;
+        score.percentage = record.percentage;
+        score.attempts = record.attempts;
+        score.passed = record.passed;
+        score.isPractice = record.isPractice;
+        score.coinsCollected.resize(static_cast<size_t>(record.coinCount));
+        for (int i = 0; i < record.coinCount; i++) {
+            score.coinsCollected[i] = (record.coinMask >> i) & 1;
+        }
+        if (!m_history.append(score, record.playedAt)) {
+            log::warn("Failed to record synced score for level {} in history", score.levelId);
+            continue;
+        }
+        recorded++;
+    }
+
+    log::info("History sync: {} local score(s) checked in {} round(s), {} B sent, {} B received, "
+              "{} resent, {} recorded from the server",
+              m_sync->localCount(), m_syncRounds, m_syncBytesSent, m_syncBytesReceived,
+              upload.size(), recorded);
+
+    if (!upload.empty()) {
+        m_batchPolicy.onQueued(BatchPolicy::Clock::now(), false);
+        drainOutbox();
+    }
+    m_sync.reset();
 }
 
 void YukiManager::linkAccount(const std::string& code, int gdAccountId, const std::string& gdUsername,
@@ -93,7 +845,7 @@ void YukiManager::linkAccount(const std::string& code, int gdAccountId, const st
     body["gd_account_id"] = gdAccountId;
     body["gd_username"] = gdUsername;
 
-    auto req = web::WebRequest();
+    auto req = ServerConnection::get()->request();
     req.header("Content-Type", "application/json");
     req.bodyJSON(body);
 
@@ -2,26 +2,84 @@
 
 #include <Geode/Geode.hpp>
 #include <Geode/utils/web.hpp>
+#include "core/ScoreData.hpp"
+#include "core/ScoreOutbox.hpp"
+#include "core/RetryBackoff.hpp"
+#include "core/BatchPolicy.hpp"
+#include "core/FlushScheduler.hpp"
+#include "core/SubmissionTracker.hpp"
+#include "core/ScoreCodec.hpp"
+#include "core/ScoreEvent.hpp"
+#include "core/StringTable.hpp"
+#include "core/SubmitWorker.hpp"
+#include "core/SubmitSettings.hpp"
+#include "core/AttemptTimeline.hpp"
+#include "core/LevelMeta.hpp"
+#include "core/LruSet.hpp"
+#include "core/HeatmapStore.hpp"
+#include "core/SessionStore.hpp"
+#include "core/ScoreHistory.hpp"
+#include "core/Metrics.hpp"
+#include "core/LeaderboardCache.hpp"
+#include "core/RangeSync.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 using namespace geode::prelude;
 
-struct ScoreData {
-    int levelId;
-    std::string levelName;
-    std::string levelCreator;
-    int percentage;
-    int attempts;
-    bool passed;
-    bool isPractice;
-    std::vector<bool> coinsCollected;
-};
-
-class YukiManager {
+class YukiManager : public CCObject {
 public:
     static YukiManager* get();
 
-    void submitScore(const ScoreData& score);
+    void init();
+    void refreshSettings();
+
+    // Safe to call from the game loop: no allocations, no locks, no setting lookups
+    SubmitSettings getSubmitSettings() const;
+    // Encoding and stashing `timeline` allocates, which is fine for the rare passes
+    // and new bests that carry one
+    bool queueScore(ScoreEvent event, const AttemptTimeline* timeline = nullptr);
+
+    uint32_t internString(std::string_view value);
+
+    // Persists a score and schedules its delivery, callable from any thread
+    void submitScore(ScoreData score);
+
+    // Queues a level's metadata to go out with its next score batch, unless the
+    // server already got it this session. Main thread only.
+    void reportLevel(const LevelMeta& level);
+
+    // Merges a session's deaths into the level's stored heatmap and uploads what's new
+    void recordHeatmap(int levelId, const DeathHistogram& session);
+    void uploadHeatmaps();
+
+    // Queues a session summary for upload, kept on disk until the server has it
+    void recordSession(const SessionSummary& summary);
+    void uploadSessions();
+
+    // Hooks report where the player is. Leaving a running level sends what was
+    // held back while it ran. Main thread only.
+    void setGameState(GameState state);
+    GameState getGameState() const { return m_flushScheduler.state(); }
+
+    // Every score this device submitted, readable without the network
+    ScoreHistory& history() { return m_history; }
+
+    // Reconciles the history with the scores the server has for this account:
+    // resends what the server is missing and records what this device is. Once per
+    // launch, and only with an empty outbox, whose scores would look missing.
+    void syncHistory();
+
+    // Calls `callback` with a level's standings: right away if they're cached, and
+    // again whenever a pass response or a fetch brings newer ones. With `fetch`,
+    // asks the server unless the cached ones are fresh. One watcher at a time,
+    // main thread only.
+    void watchLeaderboard(int levelId, bool fetch, std::function<void(const LevelLeaderboard&)> callback);
+    void unwatchLeaderboard();
+
     void linkAccount(const std::string& code, int gdAccountId, const std::string& gdUsername,
                      std::function<void(bool, const std::string&)> callback);
     
@@ -34,10 +92,77 @@ public:
 
     std::string getServerUrl() const;
 
+    // Scores waiting in the outbox that aren't on the wire yet
+    size_t getQueueDepth() const;
+    size_t getInFlightCount() const;
+    const SubmissionTracker::Stats& getSubmitStats() const { return m_submissions.stats(); }
+
 private:
-    YukiManager() = default;
+    YukiManager();
     static YukiManager* s_instance;
 
-    EventListener<web::WebTask> m_submitListener;
+    void onScoreEvent(const ScoreEvent& event, const AttemptTimeline* timeline);
+    void drainOutbox();
+    void onDrainTick(float dt);
+    void onFrame(float dt);
+    void dumpMetrics();
+    void sendBatch(const std::vector<OutboxEntry>& batch);
+    ScoreCodec::SessionHeader makeSessionHeader() const;
+    void onSubmitFinished(uint64_t id, bool delivered, bool retryable);
+    void onLeaderboard(const matjson::Value& json);
+    void sendSyncRound();
+    void finishSync();
+
+    ScoreOutbox m_outbox;
+    RetryBackoff m_backoff;
+    BatchPolicy m_batchPolicy;
+    FlushScheduler m_flushScheduler;
+    bool m_timingFrames = false;
+    std::chrono::steady_clock::time_point m_lastFrame{};
+    SubmissionTracker m_submissions;
+    bool m_useBinaryWire = true;
+
+    StringTable m_strings;
+    SubmitWorker m_worker;
+
+    // Snapshot of settings and link state, refreshed when they change
+    std::atomic<bool> m_autoSubmit{true};
+    std::atomic<bool> m_submitFails{true};
+    std::atomic<bool> m_linked{false};
+    size_t m_maxConcurrentSubmissions = 2;
+    int m_ticksSinceMetricsDump = 0;
+
+    std::unordered_map<uint64_t, std::unique_ptr<EventListener<web::WebTask>>> m_submitListeners;
+
+    // Level metadata the server hasn't acknowledged yet, and the batches carrying it
+    std::unordered_map<int, LevelMeta> m_pendingLevels;
+    std::unordered_map<uint64_t, std::vector<int>> m_batchLevels;
+    LruSet<int> m_reportedLevels{256};
     EventListener<web::WebTask> m_linkListener;
+
+    HeatmapStore m_heatmaps;
+    EventListener<web::WebTask> m_heatmapListener;
+    bool m_heatmapUploadInFlight = false;
+
+    SessionStore m_sessions;
+    EventListener<web::WebTask> m_sessionListener;
+    bool m_sessionUploadInFlight = false;
+
+    ScoreHistory m_history;
+
+    std::unique_ptr<RangeReconciler> m_sync;
+    EventListener<web::WebTask> m_syncListener;
+    bool m_syncStarted = false;
+    // A round that came due while a level was running
+    bool m_syncHeld = false;
+    int64_t m_syncSince = 0;
+    int64_t m_syncStartedAt = 0;
+    size_t m_syncRounds = 0;
+    size_t m_syncBytesSent = 0;
+    size_t m_syncBytesReceived = 0;
+
+    LeaderboardCache m_leaderboards{32, std::chrono::minutes(2)};
+    int m_watchedLevel = 0;
+    std::function<void(const LevelLeaderboard&)> m_leaderboardWatcher;
+    EventListener<web::WebTask> m_leaderboardListener;
 };
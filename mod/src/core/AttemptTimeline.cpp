@@ -0,0 +1,142 @@
+#include "AttemptTimeline.hpp"
+#include "ScoreCodec.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr uint64_t MAX_DECODED_POINTS = 4096;
+
+    double triangleArea(const AttemptTimeline::Sample& a, const AttemptTimeline::Sample& b,
+                        double cx, double cy) {
+        return std::abs((double(a.timeMs) - cx) * (double(b.x) - double(a.x)) -
+                        (double(a.timeMs) - double(b.timeMs)) * (cy - double(a.x)));
+    }
+}
+
+void AttemptTimeline::clear() {
+    m_count = 0;
+    m_stride = 1;
+    m_skipped = 0;
+    m_last = {};
+    m_hasLast = false;
+}
+
+void AttemptTimeline::add(double seconds, float x) {
+    double ms = std::clamp(seconds * 1000.0, 0.0, double(UINT32_MAX));
+    Sample sample{static_cast<uint32_t>(ms), x};
+
+    // Level time only moves forward within an attempt, but don't let a hiccup
+    // break the ordering the downsampler relies on
+    if (m_hasLast && sample.timeMs < m_last.timeMs) {
+        sample.timeMs = m_last.timeMs;
+    }
+    m_last = sample;
+    m_hasLast = true;
+
+    if (m_count > 0 && ++m_skipped < m_stride) return;
+    m_skipped = 0;
+
+    if (m_count == CAPACITY) {
+        m_count = downsample(m_samples.data(), m_count, CAPACITY / 2);
+        m_stride *= 2;
+    }
+    m_samples[m_count++] = sample;
+}
+
+size_t AttemptTimeline::downsample(Sample* samples, size_t count, size_t target) {
+    if (target >= count || target < 3) return count;
+
+    // Output point i + 1 is always written at or before the start of bucket i,
+    // so the reduction can run in place
+    double every = double(count - 2) / double(target - 2);
+    Sample previous = samples[0];
+    size_t out = 1;
+
+    for (size_t i = 0; i < target - 2; i++) {
+        size_t start = static_cast<size_t>(std::floor(i * every)) + 1;
+        size_t end = static_cast<size_t>(std::floor((i + 1) * every)) + 1;
+        size_t nextEnd = std::min(static_cast<size_t>(std::floor((i + 2) * every)) + 1, count);
+
+        double avgTime = 0, avgX = 0;
+        for (size_t j = end; j < nextEnd; j++) {
+            avgTime += samples[j].timeMs;
+            avgX += samples[j].x;
+        }
+        size_t nextCount = nextEnd > end ? nextEnd - end : 0;
+        if (nextCount > 0) {
+            avgTime /= double(nextCount);
+            avgX /= double(nextCount);
+        } else {
+            avgTime = samples[count - 1].timeMs;
+            avgX = samples[count - 1].x;
+        }
+
+        size_t best = start;
+        double bestArea = -1;
+        for (size_t j = start; j < end; j++) {
+            double area = triangleArea(previous, samples[j], avgTime, avgX);
+            if (area > bestArea) {
+                bestArea = area;
+                best = j;
+            }
+        }
+
+        previous = samples[best];
+        samples[out++] = previous;
+    }
+
+    samples[out++] = samples[count - 1];
+    return out;
+}
+
+std::vector<uint8_t> AttemptTimeline::encode() const {
+    std::vector<Sample> points(m_samples.begin(), m_samples.begin() + m_count);
+    if (m_hasLast && (points.empty() || points.back().timeMs != m_last.timeMs ||
+                      points.back().x != m_last.x)) {
+        points.push_back(m_last);
+    }
+    points.resize(downsample(points.data(), points.size(), UPLOAD_POINTS));
+
+    std::vector<uint8_t> out;
+    out.reserve(4 + points.size() * 4);
+    out.push_back(VERSION);
+    ScoreCodec::writeVarUint(out, points.size());
+
+    uint32_t lastTime = 0;
+    int64_t lastX = 0;
+    for (const auto& point : points) {
+        int64_t x = std::llround(point.x);
+        ScoreCodec::writeVarUint(out, point.timeMs - lastTime);
+        ScoreCodec::writeVarInt(out, x - lastX);
+        lastTime = point.timeMs;
+        lastX = x;
+    }
+    return out;
+}
+
+bool AttemptTimeline::decode(const std::vector<uint8_t>& data, std::vector<Sample>& out) {
+    size_t pos = 1;
+    uint64_t count;
+    if (data.empty() || data[0] != VERSION ||
+        !ScoreCodec::readVarUint(data.data(), data.size(), pos, count) || count > MAX_DECODED_POINTS) {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(static_cast<size_t>(count));
+    uint64_t time = 0;
+    int64_t x = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t dt;
+        int64_t dx;
+        if (!ScoreCodec::readVarUint(data.data(), data.size(), pos, dt) ||
+            !ScoreCodec::readVarInt(data.data(), data.size(), pos, dx)) {
+            return false;
+        }
+        time += dt;
+        x += dx;
+        if (time > UINT32_MAX) return false;
+        out.push_back({static_cast<uint32_t>(time), static_cast<float>(x)});
+    }
+    return pos == data.size();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Shape of a single attempt as (time, x position) samples.
+//
+// Storage is a fixed array inside the object, so recording never allocates and an
+// attempt costs the same ~4 KB whether it lasts two seconds or ten minutes. Samples
+// are thinned online: frames are taken every `stride` calls, and when the buffer
+// fills up it is reduced to half with Largest-Triangle-Three-Buckets and the stride
+// doubles. That keeps add() O(1) amortized while preserving the visible shape.
+class AttemptTimeline {
+public:
+    static constexpr size_t CAPACITY = 512;
+    // Most points an encoded timeline holds
+    static constexpr size_t UPLOAD_POINTS = 256;
+    static constexpr uint8_t VERSION = 1;
+
+    struct Sample {
+        uint32_t timeMs;
+        float x;
+    };
+
+    void clear();
+
+    // Every frame while the attempt is running
+    void add(double seconds, float x);
+
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0 && !m_hasLast; }
+    uint32_t durationMs() const { return m_hasLast ? m_last.timeMs : 0; }
+    const Sample* samples() const { return m_samples.data(); }
+
+    // version u8 | varint count | (varint dt ms, zigzag varint dx)...
+    // x is stored in whole units, time as milliseconds since the attempt started.
+    // Always ends with the most recent sample, at most UPLOAD_POINTS points.
+    std::vector<uint8_t> encode() const;
+    static bool decode(const std::vector<uint8_t>& data, std::vector<Sample>& out);
+
+    // Reduces `count` samples in place to `target` points, returns the new count
+    static size_t downsample(Sample* samples, size_t count, size_t target);
+
+private:
+    std::array<Sample, CAPACITY> m_samples;
+    size_t m_count = 0;
+    uint32_t m_stride = 1;
+    uint32_t m_skipped = 0;
+    Sample m_last{};
+    bool m_hasLast = false;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// Decides when queued scores get flushed as one batch: once enough of them piled
+// up, once the oldest one has waited long enough, or right away when asked to
+class BatchPolicy {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    BatchPolicy(size_t maxSize, Clock::duration maxAge) : m_maxSize(maxSize), m_maxAge(maxAge) {}
+
+    size_t maxSize() const { return m_maxSize; }
+
+    void onQueued(Clock::time_point now, bool urgent) {
+        if (!m_hasOldest) {
+            m_oldest = now;
+            m_hasOldest = true;
+        }
+        m_urgent = m_urgent || urgent;
+    }
+
+    bool shouldFlush(size_t pending, Clock::time_point now) const {
+        if (pending == 0) return false;
+        // Scores left over from a previous run have no timestamp, treat them as overdue
+        if (!m_hasOldest || m_urgent) return true;
+        return pending >= m_maxSize || now - m_oldest >= m_maxAge;
+    }
+
+    void onFlushed(size_t remaining, Clock::time_point now) {
+        m_urgent = false;
+        m_hasOldest = remaining > 0;
+        m_oldest = now;
+    }
+
+private:
+    size_t m_maxSize;
+    Clock::duration m_maxAge;
+    Clock::time_point m_oldest{};
+    bool m_hasOldest = false;
+    bool m_urgent = false;
+};
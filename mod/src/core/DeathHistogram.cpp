@@ -0,0 +1,53 @@
+#include "DeathHistogram.hpp"
+#include "ScoreCodec.hpp"
+#include <algorithm>
+
+void DeathHistogram::add(float percent, uint32_t count) {
+    int index = static_cast<int>(percent * (BUCKETS / 100.f));
+    index = std::clamp(index, 0, BUCKETS - 1);
+    m_counts[index] += count;
+    m_total += count;
+}
+
+void DeathHistogram::merge(const DeathHistogram& other) {
+    for (int i = 0; i < BUCKETS; i++) {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_total += other.m_total;
+}
+
+void DeathHistogram::clear() {
+    m_counts.fill(0);
+    m_total = 0;
+}
+
+std::vector<uint8_t> DeathHistogram::encode() const {
+    std::vector<uint8_t> out;
+    int last = -1;
+    forEachNonZero([&](int index, uint32_t count) {
+        ScoreCodec::writeVarUint(out, static_cast<uint64_t>(index - last - 1));
+        ScoreCodec::writeVarUint(out, count);
+        last = index;
+    });
+    return out;
+}
+
+bool DeathHistogram::decode(const std::vector<uint8_t>& data) {
+    clear();
+
+    size_t pos = 0;
+    int index = -1;
+    while (pos < data.size()) {
+        uint64_t gap, count;
+        if (!ScoreCodec::readVarUint(data.data(), data.size(), pos, gap) ||
+            !ScoreCodec::readVarUint(data.data(), data.size(), pos, count) ||
+            gap >= static_cast<uint64_t>(BUCKETS - 1 - index) || count > UINT32_MAX) {
+            clear();
+            return false;
+        }
+        index += static_cast<int>(gap) + 1;
+        m_counts[index] = static_cast<uint32_t>(count);
+        m_total += count;
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Where deaths happen in a level, in fixed 0.1% buckets. Histograms for the same
+// level merge by adding bucket counts, so they can be accumulated per session,
+// kept per level on disk and summed again on the server.
+class DeathHistogram {
+public:
+    static constexpr int BUCKETS = 1000;
+
+    void add(float percent, uint32_t count = 1);
+    void merge(const DeathHistogram& other);
+    void clear();
+
+    bool empty() const { return m_total == 0; }
+    uint64_t total() const { return m_total; }
+    uint32_t bucket(int index) const { return m_counts[index]; }
+
+    // Sparse (gap, count) varint pairs, most buckets of a level are zero
+    std::vector<uint8_t> encode() const;
+    bool decode(const std::vector<uint8_t>& data);
+
+    template <typename F>
+    void forEachNonZero(F&& fn) const {
+        for (int i = 0; i < BUCKETS; i++) {
+            if (m_counts[i]) fn(i, m_counts[i]);
+        }
+    }
+
+private:
+    std::array<uint32_t, BUCKETS> m_counts{};
+    uint64_t m_total = 0;
+};
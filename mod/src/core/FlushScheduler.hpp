@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+enum class GameState : uint8_t {
+    Menu,
+    Playing,
+    Paused,
+    EndScreen,
+};
+
+// Keeps network work off the frames of a running level. Scores queued while
+// playing are held (they're already safe in the outbox) until the player pauses,
+// quits or finishes, unless too many pile up or the oldest has waited too long.
+// Main thread only.
+class FlushScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FlushScheduler(size_t maxHeld, Clock::duration maxDelay) : m_maxHeld(maxHeld), m_maxDelay(maxDelay) {}
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    GameState state() const { return m_state; }
+
+    // Returns true when this ends a stretch of play, the moment to send what was held
+    bool setState(GameState state) {
+        bool wasPlaying = m_state == GameState::Playing;
+        m_state = state;
+        if (state == GameState::Playing) return false;
+        m_holding = false;
+        return wasPlaying;
+    }
+
+    // Whether to sit on network work that can wait
+    bool playing() const { return m_enabled && m_state == GameState::Playing; }
+
+    // Whether `pending` queued scores have to keep waiting. The first call that
+    // sees them starts their delay.
+    bool shouldHold(size_t pending, Clock::time_point now) {
+        if (!playing() || pending == 0) return false;
+        if (!m_holding) {
+            m_holding = true;
+            m_heldSince = now;
+        }
+        return pending < m_maxHeld && now - m_heldSince < m_maxDelay;
+    }
+
+    void onFlushed() { m_holding = false; }
+
+private:
+    size_t m_maxHeld;
+    Clock::duration m_maxDelay;
+    GameState m_state = GameState::Menu;
+    bool m_enabled = true;
+    bool m_holding = false;
+    Clock::time_point m_heldSince{};
+};
@@ -0,0 +1,123 @@
+#include "HeatmapStore.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+std::filesystem::path HeatmapStore::pathFor(int levelId, const char* extension) const {
+    return m_directory / (std::to_string(levelId) + extension);
+}
+
+bool HeatmapStore::load(const std::filesystem::path& path, DeathHistogram& out) const {
+    out.clear();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return out.decode(data);
+}
+
+bool HeatmapStore::save(const std::filesystem::path& path, const DeathHistogram& histogram) const {
+    return writeFile(path, histogram.encode());
+}
+
+bool HeatmapStore::loadSeq(const std::filesystem::path& path, uint64_t& out) const {
+    std::ifstream file(path, std::ios::binary);
+    uint8_t bytes[8];
+    if (!file.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) return false;
+
+    out = 0;
+    for (int i = 0; i < 8; i++) out |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+    return true;
+}
+
+bool HeatmapStore::saveSeq(const std::filesystem::path& path, uint64_t seq) const {
+    std::vector<uint8_t> bytes(8);
+    for (int i = 0; i < 8; i++) bytes[i] = static_cast<uint8_t>(seq >> (i * 8));
+    return writeFile(path, bytes);
+}
+
+bool HeatmapStore::writeFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) const {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    // Write-then-rename so a crash can't leave a half written file behind
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file) return false;
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+bool HeatmapStore::nextSeq(int64_t wallMs, uint64_t& out) const {
+    auto path = m_directory / "upload.seq";
+    uint64_t last = 0;
+    loadSeq(path, last);
+    out = std::max(last + 1, static_cast<uint64_t>(std::max<int64_t>(wallMs, 0)));
+    return saveSeq(path, out);
+}
+
+bool HeatmapStore::mergeSession(int levelId, const DeathHistogram& session) {
+    if (session.empty()) return true;
+
+    DeathHistogram histogram;
+    auto path = pathFor(levelId, ".pending");
+    load(path, histogram);
+    histogram.merge(session);
+    return save(path, histogram);
+}
+
+std::vector<int> HeatmapStore::pendingLevels() const {
+    std::vector<int> levels;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, ec)) {
+        auto extension = entry.path().extension();
+        if (extension != ".pending" && extension != ".sending") continue;
+        try {
+            levels.push_back(std::stoi(entry.path().stem().string()));
+        } catch (...) {
+        }
+    }
+    std::sort(levels.begin(), levels.end());
+    levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+    return levels;
+}
+
+bool HeatmapStore::takeUpload(int levelId, int64_t wallMs, HeatmapUpload& out) {
+    out.levelId = levelId;
+    auto sending = pathFor(levelId, ".sending");
+    auto seqPath = pathFor(levelId, ".seq");
+    std::error_code ec;
+
+    // Unconfirmed, so it might have been merged already: resend it as it is
+    if (std::filesystem::exists(sending, ec)) {
+        if (load(sending, out.deaths) && !out.deaths.empty()) {
+            if (loadSeq(seqPath, out.seq)) return true;
+            return nextSeq(wallMs, out.seq) && saveSeq(seqPath, out.seq);
+        }
+        std::filesystem::remove(sending, ec);
+    }
+
+    if (!load(pathFor(levelId, ".pending"), out.deaths) || out.deaths.empty()) return false;
+
+    // The seq goes first: a crash before the rename only leaves an unused seq
+    if (!nextSeq(wallMs, out.seq) || !saveSeq(seqPath, out.seq)) return false;
+    std::filesystem::rename(pathFor(levelId, ".pending"), sending, ec);
+    return !ec;
+}
+
+void HeatmapStore::markUploaded(const HeatmapUpload& upload) {
+    auto seqPath = pathFor(upload.levelId, ".seq");
+    uint64_t seq = 0;
+    if (!loadSeq(seqPath, seq) || seq != upload.seq) return;
+
+    std::error_code ec;
+    std::filesystem::remove(pathFor(upload.levelId, ".sending"), ec);
+    std::filesystem::remove(seqPath, ec);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "DeathHistogram.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// A level's deaths on their way to the server. `seq` is unique for this install
+// and stays the same when the upload is retried, so the server can skip one it
+// already merged.
+struct HeatmapUpload {
+    int levelId = 0;
+    uint64_t seq = 0;
+    DeathHistogram deaths;
+};
+
+// Per-level death histograms the server hasn't confirmed yet, on disk.
+// `<id>.pending` collects finished sessions. Taking an upload renames it to
+// `<id>.sending`, with its seq in `<id>.seq`, and it stays frozen there until the
+// server confirms it, while newer sessions start a new `.pending`.
+class HeatmapStore {
+public:
+    explicit HeatmapStore(std::filesystem::path directory) : m_directory(std::move(directory)) {}
+
+    // Folds a finished session into the level's pending histogram
+    bool mergeSession(int levelId, const DeathHistogram& session);
+
+    // Levels with deaths waiting to be sent or confirmed
+    std::vector<int> pendingLevels() const;
+
+    // The level's next upload: the unconfirmed one again if there is one, otherwise
+    // the pending deaths under a new seq. `wallMs` (Unix milliseconds) keeps new
+    // seqs ahead of ones used before the counter file was lost.
+    bool takeUpload(int levelId, int64_t wallMs, HeatmapUpload& out);
+    // Called once the server has the upload, anything recorded since stays pending
+    void markUploaded(const HeatmapUpload& upload);
+
+private:
+    std::filesystem::path pathFor(int levelId, const char* extension) const;
+    bool load(const std::filesystem::path& path, DeathHistogram& out) const;
+    bool save(const std::filesystem::path& path, const DeathHistogram& histogram) const;
+    bool loadSeq(const std::filesystem::path& path, uint64_t& out) const;
+    bool saveSeq(const std::filesystem::path& path, uint64_t seq) const;
+    bool nextSeq(int64_t wallMs, uint64_t& out) const;
+    bool writeFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) const;
+
+    std::filesystem::path m_directory;
+};
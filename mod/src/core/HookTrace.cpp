@@ -0,0 +1,216 @@
+#include "HookTrace.hpp"
+#include "ScoreCodec.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+namespace {
+    enum Flags : uint8_t {
+        AUTO_SUBMIT = 1 << 0,
+        SUBMIT_FAILS = 1 << 1,
+        LINKED = 1 << 2,
+        ONLINE = 1 << 3,
+        DEMON = 1 << 4,
+        TRUNCATED = 1 << 5,
+    };
+
+    // Header, level metadata and a few seconds of records
+    constexpr size_t INITIAL_CAPACITY = 64 * 1024;
+
+    void putU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    }
+
+    bool getU32(const uint8_t* data, size_t size, size_t& pos, uint32_t& value) {
+        if (size - pos < 4) return false;
+        value = static_cast<uint32_t>(data[pos]) | static_cast<uint32_t>(data[pos + 1]) << 8 |
+                static_cast<uint32_t>(data[pos + 2]) << 16 | static_cast<uint32_t>(data[pos + 3]) << 24;
+        pos += 4;
+        return true;
+    }
+
+    bool readInt(const uint8_t* data, size_t size, size_t& pos, int& value) {
+        int64_t raw;
+        if (!ScoreCodec::readVarInt(data, size, pos, raw)) return false;
+        value = static_cast<int>(raw);
+        return true;
+    }
+}
+
+bool HookTraceRecord::hasProgress(HookTraceType type) {
+    switch (type) {
+        case HookTraceType::Tick:
+        case HookTraceType::Sample:
+        case HookTraceType::Coin:
+        case HookTraceType::Death:
+        case HookTraceType::Reset:
+        case HookTraceType::Complete:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool HookTraceRecord::hasArg(HookTraceType type) {
+    return type == HookTraceType::Coin || type == HookTraceType::Reset || type == HookTraceType::Complete ||
+           type == HookTraceType::EndScreen;
+}
+
+void HookTraceWriter::begin(const LevelMeta& level, int coinCount, bool online, const SubmitSettings& settings,
+                            int64_t wallMs, Clock::time_point now) {
+    using namespace ScoreCodec;
+
+    m_data.clear();
+    m_data.reserve(INITIAL_CAPACITY);
+    m_active = true;
+    m_last = now;
+
+    putU32(m_data, MAGIC);
+    m_data.push_back(VERSION);
+    m_flagsOffset = m_data.size();
+    m_data.push_back(static_cast<uint8_t>((settings.autoSubmit ? AUTO_SUBMIT : 0) |
+                                          (settings.submitFails ? SUBMIT_FAILS : 0) |
+                                          (settings.linked ? LINKED : 0) | (online ? ONLINE : 0) |
+                                          (level.isDemon ? DEMON : 0)));
+    writeVarInt(m_data, wallMs);
+    writeVarInt(m_data, level.levelId);
+    writeVarInt(m_data, coinCount);
+
+    writeString(m_data, level.name);
+    writeString(m_data, level.creator);
+    writeString(m_data, level.description);
+    writeVarInt(m_data, level.difficulty);
+    writeVarInt(m_data, level.stars);
+    writeVarInt(m_data, level.demonDifficulty);
+    writeVarInt(m_data, level.audioTrack);
+    writeVarInt(m_data, level.songId);
+    writeString(m_data, level.songName);
+    writeString(m_data, level.songAuthor);
+    writeVarInt(m_data, level.length);
+    writeVarInt(m_data, level.downloads);
+    writeVarInt(m_data, level.likes);
+}
+
+void HookTraceWriter::writeHeader(HookTraceType type, Clock::time_point now) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - m_last).count();
+    m_last = std::max(m_last, now);
+
+    m_data.push_back(static_cast<uint8_t>(type));
+    ScoreCodec::writeVarUint(m_data, static_cast<uint64_t>(std::max<int64_t>(elapsed, 0)));
+}
+
+void HookTraceWriter::record(HookTraceType type, Clock::time_point now, uint8_t arg) {
+    record(type, now, 0.f, 0, 0.f, arg);
+}
+
+void HookTraceWriter::record(HookTraceType type, Clock::time_point now, float percent, double seconds, float x,
+                             uint8_t arg) {
+    if (!m_active) return;
+    if (m_data.size() >= MAX_SIZE) {
+        m_data[m_flagsOffset] |= TRUNCATED;
+        return;
+    }
+
+    writeHeader(type, now);
+    if (HookTraceRecord::hasProgress(type)) {
+        // Floats bit for bit, so a replay sees exactly what the game did
+        putU32(m_data, std::bit_cast<uint32_t>(percent));
+        ScoreCodec::writeVarUint(m_data, static_cast<uint64_t>(std::llround(std::max(seconds, 0.0) * 1e6)));
+        putU32(m_data, std::bit_cast<uint32_t>(x));
+    }
+    if (HookTraceRecord::hasArg(type)) m_data.push_back(arg);
+}
+
+bool HookTraceWriter::save(const std::filesystem::path& path) {
+    if (!m_active) return false;
+    m_active = false;
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(m_data.data()), static_cast<std::streamsize>(m_data.size()));
+    bool written = static_cast<bool>(file.flush());
+
+    // Hands the memory back, the level is closing
+    m_data = {};
+    return written;
+}
+
+bool HookTrace::decode(const std::vector<uint8_t>& bytes, HookTrace& out) {
+    using namespace ScoreCodec;
+
+    const uint8_t* data = bytes.data();
+    size_t size = bytes.size();
+    size_t pos = 0;
+
+    uint32_t magic;
+    if (!getU32(data, size, pos, magic) || magic != HookTraceWriter::MAGIC) return false;
+    if (size - pos < 2 || data[pos] != HookTraceWriter::VERSION) return false;
+    uint8_t flags = data[pos + 1];
+    pos += 2;
+
+    out = {};
+    out.settings.autoSubmit = flags & AUTO_SUBMIT;
+    out.settings.submitFails = flags & SUBMIT_FAILS;
+    out.settings.linked = flags & LINKED;
+    out.online = flags & ONLINE;
+    out.level.isDemon = flags & DEMON;
+    out.truncated = flags & TRUNCATED;
+
+    auto& level = out.level;
+    if (!readVarInt(data, size, pos, out.startedAt) || !readInt(data, size, pos, level.levelId) ||
+        !readInt(data, size, pos, out.coinCount) || !readString(data, size, pos, level.name) ||
+        !readString(data, size, pos, level.creator) || !readString(data, size, pos, level.description) ||
+        !readInt(data, size, pos, level.difficulty) || !readInt(data, size, pos, level.stars) ||
+        !readInt(data, size, pos, level.demonDifficulty) || !readInt(data, size, pos, level.audioTrack) ||
+        !readInt(data, size, pos, level.songId) || !readString(data, size, pos, level.songName) ||
+        !readString(data, size, pos, level.songAuthor) || !readInt(data, size, pos, level.length) ||
+        !readInt(data, size, pos, level.downloads) || !readInt(data, size, pos, level.likes)) {
+        return false;
+    }
+
+    uint64_t at = 0;
+    while (pos < size) {
+        HookTraceRecord record;
+        uint8_t type = data[pos++];
+        if (type < static_cast<uint8_t>(HookTraceType::Tick) || type > static_cast<uint8_t>(HookTraceType::Quit)) {
+            return false;
+        }
+        record.type = static_cast<HookTraceType>(type);
+
+        uint64_t delta;
+        if (!readVarUint(data, size, pos, delta)) return false;
+        at += delta;
+        record.atUs = at;
+
+        if (HookTraceRecord::hasProgress(record.type)) {
+            uint32_t percent, x;
+            uint64_t secondsUs;
+            if (!getU32(data, size, pos, percent) || !readVarUint(data, size, pos, secondsUs) ||
+                !getU32(data, size, pos, x)) {
+                return false;
+            }
+            record.percent = std::bit_cast<float>(percent);
+            record.seconds = static_cast<double>(secondsUs) / 1e6;
+            record.x = std::bit_cast<float>(x);
+        }
+        if (HookTraceRecord::hasArg(record.type)) {
+            if (pos >= size) return false;
+            record.arg = data[pos++];
+        }
+        out.records.push_back(record);
+    }
+    return true;
+}
+
+bool HookTrace::load(const std::filesystem::path& path, HookTrace& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decode(data, out);
+}
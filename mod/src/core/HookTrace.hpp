@@ -0,0 +1,98 @@
+#pragma once
+
+#include "LevelMeta.hpp"
+#include "SubmitSettings.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// What the PlayLayer hooks saw while one level was open, with timestamps, so a
+// real session can be replayed offline through the same submission code (see
+// tools/replay). Opening the level is the trace header.
+enum class HookTraceType : uint8_t {
+    // The low-rate progress timer. Samples progress while playing and lets a
+    // rate-limited death out.
+    Tick = 1,
+    // Progress sampled on a game event (checkpoint)
+    Sample,
+    // A coin picked up, `arg` is its index
+    Coin,
+    Death,
+    // The level restarted. Carries where the attempt ended, `arg` is 1 in practice.
+    Reset,
+    // The player reached the end, `arg` is 1 in practice
+    Complete,
+    // The end screen came up, `arg` is 1 in practice
+    EndScreen,
+    Pause,
+    Resume,
+    Quit,
+};
+
+struct HookTraceRecord {
+    HookTraceType type = HookTraceType::Tick;
+    // Microseconds since the level was opened
+    uint64_t atUs = 0;
+    // Only for the types that sample progress
+    float percent = 0.f;
+    double seconds = 0;
+    float x = 0.f;
+    uint8_t arg = 0;
+
+    // Whether percent, seconds and x are stored
+    static bool hasProgress(HookTraceType type);
+    static bool hasArg(HookTraceType type);
+};
+
+struct HookTrace {
+    // Unix time in milliseconds the level was opened
+    int64_t startedAt = 0;
+    SubmitSettings settings;
+    // Only online levels get their metadata reported
+    bool online = false;
+    int coinCount = 0;
+    LevelMeta level;
+    std::vector<HookTraceRecord> records;
+    // The recording hit MAX_SIZE and stopped early
+    bool truncated = false;
+
+    static bool decode(const std::vector<uint8_t>& data, HookTrace& out);
+    static bool load(const std::filesystem::path& path, HookTrace& out);
+};
+
+// Game side. Records go into one growing buffer, a few bytes each: a type, a
+// varint delta from the previous record and the fields of that type. Written to
+// disk only by save(), when the level closes.
+//
+// magic u32 | version u8 | flags u8 | varint startedAt | varint levelId |
+// varint coinCount | level metadata | (type u8, varint dt us, fields)...
+class HookTraceWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr uint32_t MAGIC = 0x43525459; // "YTRC"
+    static constexpr uint8_t VERSION = 1;
+    // Hours of grinding fit, a trace left running for days stops growing here
+    static constexpr size_t MAX_SIZE = 16 * 1024 * 1024;
+
+    void begin(const LevelMeta& level, int coinCount, bool online, const SubmitSettings& settings,
+               int64_t wallMs, Clock::time_point now);
+    bool active() const { return m_active; }
+
+    void record(HookTraceType type, Clock::time_point now, uint8_t arg = 0);
+    void record(HookTraceType type, Clock::time_point now, float percent, double seconds, float x,
+                uint8_t arg = 0);
+
+    // Writes the trace and stops recording
+    bool save(const std::filesystem::path& path);
+
+private:
+    void writeHeader(HookTraceType type, Clock::time_point now);
+
+    std::vector<uint8_t> m_data;
+    bool m_active = false;
+    size_t m_flagsOffset = 0;
+    Clock::time_point m_last{};
+};
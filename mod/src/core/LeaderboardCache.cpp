@@ -0,0 +1,37 @@
+#include "LeaderboardCache.hpp"
+
+LeaderboardCache::LeaderboardCache(size_t capacity, Clock::duration maxAge)
+    : m_capacity(capacity), m_maxAge(maxAge) {}
+
+void LeaderboardCache::put(LevelLeaderboard board, Clock::time_point now) {
+    auto it = m_index.find(board.levelId);
+    if (it != m_index.end()) {
+        it->second->board = std::move(board);
+        it->second->storedAt = now;
+        m_order.splice(m_order.begin(), m_order, it->second);
+        return;
+    }
+
+    if (m_order.size() >= m_capacity && !m_order.empty()) {
+        m_index.erase(m_order.back().board.levelId);
+        m_order.pop_back();
+    }
+    int levelId = board.levelId;
+    m_order.push_front({std::move(board), now});
+    m_index[levelId] = m_order.begin();
+}
+
+bool LeaderboardCache::get(int levelId, Clock::time_point now, LevelLeaderboard& out, bool* fresh) {
+    auto it = m_index.find(levelId);
+    if (it == m_index.end()) return false;
+
+    m_order.splice(m_order.begin(), m_order, it->second);
+    out = it->second->board;
+    if (fresh) *fresh = now - it->second->storedAt < m_maxAge;
+    return true;
+}
+
+void LeaderboardCache::clear() {
+    m_order.clear();
+    m_index.clear();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct LeaderboardEntry {
+    int rank = 0;
+    std::string name;
+    int percentage = 0;
+    // The linked player's own row
+    bool self = false;
+};
+
+// A level's standings as the server sent them
+struct LevelLeaderboard {
+    int levelId = 0;
+    uint32_t players = 0;
+    // The linked player's rank and best, rank 0 if they aren't on the board
+    int rank = 0;
+    int best = 0;
+    std::vector<LeaderboardEntry> top;
+};
+
+// Standings of the most recently seen levels, so the end screen has something to
+// show before (or without) a response. Entries older than `maxAge` are still
+// returned but reported as stale.
+class LeaderboardCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LeaderboardCache(size_t capacity, Clock::duration maxAge);
+
+    void put(LevelLeaderboard board, Clock::time_point now);
+    bool get(int levelId, Clock::time_point now, LevelLeaderboard& out, bool* fresh = nullptr);
+    void clear();
+
+    size_t size() const { return m_order.size(); }
+
+private:
+    struct Entry {
+        LevelLeaderboard board;
+        Clock::time_point storedAt;
+    };
+
+    size_t m_capacity;
+    Clock::duration m_maxAge;
+    // Most recently used first
+    std::list<Entry> m_order;
+    std::unordered_map<int, std::list<Entry>::iterator> m_index;
+};
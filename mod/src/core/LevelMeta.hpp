@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+// What the game already knows about an online level, sent along with scores so
+// the server doesn't have to download the level from the GD servers itself.
+// Fields mirror the keys of downloadGJLevel22.php that server/src/lib/gdApi.ts reads.
+struct LevelMeta {
+    int levelId = 0;
+    std::string name;
+    std::string creator;
+    // Base64, exactly as the game stores it
+    std::string description;
+    int difficulty = 0; // rating numerator, 10 (easy) to 50 (insane)
+    int stars = 0;
+    bool isDemon = false;
+    int demonDifficulty = 0;
+    int audioTrack = 0;
+    int songId = 0;
+    // Only known for custom songs, the server maps official tracks itself
+    std::string songName;
+    std::string songAuthor;
+    int length = 0;
+    int downloads = 0;
+    int likes = 0;
+};
@@ -0,0 +1,231 @@
+#include "LevelSession.hpp"
+#include <algorithm>
+
+void LevelSession::begin(const LevelInfo& level, int64_t wallMs, Clock::time_point now) {
+    m_level = level;
+    m_level.coinCount = std::clamp(level.coinCount, 0, 64);
+    m_attempts = 0;
+    m_bestPercentage = 0;
+    m_current = {};
+    m_completed = false;
+    m_attemptCoins = 0;
+    m_bestCoins = 0;
+    m_coinMask = 0;
+    m_deaths.clear();
+    m_timelines[0].clear();
+    m_timelines[1].clear();
+    m_activeTimeline = 0;
+    m_recording = true;
+    m_bestBeforeAttempt = 0;
+    m_eventTimeline = nullptr;
+    m_summary = {};
+    m_summary.levelId = m_level.levelId;
+    m_summary.startedAt = wallMs;
+    m_attemptCounted = false;
+    m_deathLimiter.reset(now);
+    m_pending = {};
+}
+
+void LevelSession::onProgress(float percent, double seconds, float x) {
+    // Between the death and the reset the attempt is over, keep where it ended
+    if (!m_recording) return;
+
+    m_current.exact = percent;
+    m_current.percent = static_cast<int>(percent);
+    if (m_current.percent > m_bestPercentage) {
+        m_bestPercentage = m_current.percent;
+    }
+    if (m_current.percent > m_summary.bestPercentage) {
+        m_summary.bestPercentage = m_current.percent;
+    }
+
+    m_timelines[m_activeTimeline].add(seconds, x);
+}
+
+LevelSession::Progress LevelSession::onDeath(float percent, double seconds, float x) {
+    if (m_recording) {
+        onProgress(percent, seconds, x);
+        m_recording = false;
+    }
+    return m_current;
+}
+
+int LevelSession::orderCoins(std::span<const float> xs, std::array<int, MAX_COINS>& out) {
+    // Objects aren't stored left to right, so every coin has to be looked at before
+    // the leftmost ones are known. Insertion into the few kept so far.
+    int count = 0;
+    for (size_t i = 0; i < xs.size(); i++) {
+        int slot = count;
+        while (slot > 0 && xs[i] < xs[static_cast<size_t>(out[slot - 1])]) slot--;
+        if (slot == MAX_COINS) continue;
+        for (int j = std::min(count, MAX_COINS - 1); j > slot; j--) out[j] = out[j - 1];
+        out[slot] = static_cast<int>(i);
+        count = std::min(count + 1, MAX_COINS);
+    }
+    return count;
+}
+
+void LevelSession::onCoin(int index) {
+    if (index < 0 || index >= m_level.coinCount) return;
+    m_attemptCoins |= uint64_t(1) << index;
+}
+
+bool LevelSession::onReset(Progress death, bool practice, const SubmitSettings& settings,
+                           Clock::time_point now, ScoreEvent& out) {
+    bool submit = false;
+    const AttemptTimeline& attempt = m_timelines[m_activeTimeline];
+    m_eventTimeline = nullptr;
+
+    if (!m_attemptCounted) {
+        m_summary.attempts++;
+        m_summary.timeAliveMs += attempt.durationMs();
+        m_summary.usedPractice |= practice;
+        if (!practice) {
+            m_summary.deaths.add(death.exact);
+        }
+    }
+    m_attemptCounted = false;
+
+    if (!m_completed) {
+        m_attempts++;
+
+        if (!practice) {
+            m_deaths.add(death.exact);
+            if (death.percent >= m_bestPercentage) {
+                m_bestCoins = m_attemptCoins;
+            }
+        }
+
+        // Submit death if criteria met, merged with any deaths still waiting
+        if (shouldSubmitDeath(death.percent, practice, settings)) {
+            bool replaces = !m_pending.active || death.percent >= m_pending.percentage;
+            if (replaces) {
+                m_pending.percentage = death.percent;
+                m_pending.coinMask = m_attemptCoins;
+                m_pending.timeline = death.percent > m_bestBeforeAttempt ? &attempt : nullptr;
+            }
+            m_pending.active = true;
+
+            if (m_deathLimiter.tryTake(now)) {
+                out = takePending();
+                submit = true;
+            } else if (m_pending.timeline == &attempt) {
+                // The attempt's buffer gets reused after the next reset, keep a copy
+                // for when the death goes out. Only new bests over the limit pay this.
+                m_pendingTimeline = attempt;
+                m_pending.timeline = &m_pendingTimeline;
+            }
+        }
+    }
+
+    // Reset current percentage and coins for new attempt
+    m_current = {};
+    m_attemptCoins = 0;
+    m_bestBeforeAttempt = m_bestPercentage;
+    m_activeTimeline ^= 1;
+    m_timelines[m_activeTimeline].clear();
+    m_recording = true;
+    return submit;
+}
+
+bool LevelSession::shouldSubmitDeath(int percentage, bool practice, const SubmitSettings& settings) const {
+    // Never submit in practice mode
+    if (practice) return false;
+
+    if (!settings.autoSubmit) return false;
+    if (!settings.submitFails) return false;
+    if (!settings.linked) return false;
+
+    // Must be at least MIN_PERCENTAGE_TO_SUBMIT%
+    if (percentage < MIN_PERCENTAGE_TO_SUBMIT) return false;
+
+    return true;
+}
+
+bool LevelSession::flushPendingDeath(Clock::time_point now, ScoreEvent& out) {
+    if (!m_pending.active || !m_deathLimiter.tryTake(now)) return false;
+    out = takePending();
+    return true;
+}
+
+bool LevelSession::takePendingDeath(ScoreEvent& out) {
+    if (!m_pending.active) return false;
+    out = takePending();
+    return true;
+}
+
+ScoreEvent LevelSession::takePending() {
+    m_eventTimeline = m_pending.timeline;
+    // Deaths are never sent in practice mode anyway
+    ScoreEvent score = makeEvent(m_pending.percentage, false, false, m_pending.coinMask);
+    m_pending = {};
+    return score;
+}
+
+void LevelSession::onComplete(bool practice) {
+    m_completed = true;
+    m_bestPercentage = 100;
+
+    m_summary.attempts++;
+    m_summary.bestPercentage = 100;
+    m_summary.timeAliveMs += m_timelines[m_activeTimeline].durationMs();
+    m_summary.completed = true;
+    m_summary.usedPractice |= practice;
+    m_attemptCounted = true;
+    m_coinMask = practice ? 0 : m_attemptCoins;
+}
+
+bool LevelSession::onFinished(bool passed, bool practice, const SubmitSettings& settings,
+                              Clock::time_point now, ScoreEvent& out) {
+    // Practice mode: only allow passes, not fails
+    if (practice && !passed) return false;
+
+    if (!settings.linked) return false;
+    if (!settings.autoSubmit) return false;
+
+    // The final score is never held back, but it uses up a token and covers any
+    // death still waiting: it has the latest attempt count and the best percentage
+    m_deathLimiter.tryTake(now);
+    m_pending = {};
+    // A run that didn't pass reports the coins of its best attempt
+    uint64_t coins = passed || m_completed ? m_coinMask : m_bestCoins;
+    out = makeEvent(passed ? 100 : m_bestPercentage, passed, practice, coins);
+    // Practice runs start from checkpoints, so their timelines say little
+    m_eventTimeline = passed && !practice ? &m_timelines[m_activeTimeline] : nullptr;
+    return true;
+}
+
+bool LevelSession::takeSummary(int64_t wallMs, SessionSummary& out) {
+    // The attempt still running when the player leaves counts too
+    const auto& attempt = m_timelines[m_activeTimeline];
+    if (!m_attemptCounted && !attempt.empty()) {
+        m_summary.attempts++;
+        m_summary.timeAliveMs += attempt.durationMs();
+        m_attemptCounted = true;
+    }
+
+    bool played = m_summary.attempts > 0;
+    if (played) {
+        out = m_summary;
+        out.endedAt = wallMs;
+    }
+
+    m_summary = {};
+    m_summary.levelId = m_level.levelId;
+    m_summary.startedAt = wallMs;
+    return played;
+}
+
+ScoreEvent LevelSession::makeEvent(int percentage, bool passed, bool practice, uint64_t coinMask) const {
+    ScoreEvent score{};
+    score.levelId = m_level.levelId;
+    score.levelNameId = m_level.nameId;
+    score.levelCreatorId = m_level.creatorId;
+    score.percentage = percentage;
+    score.attempts = m_attempts;
+    score.passed = passed;
+    score.isPractice = practice;
+    score.coinCount = static_cast<uint8_t>(m_level.coinCount);
+    score.coinMask = coinMask;
+    return score;
+}
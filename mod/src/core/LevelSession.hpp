@@ -0,0 +1,152 @@
+#pragma once
+
+#include "AttemptTimeline.hpp"
+#include "DeathHistogram.hpp"
+#include "ScoreEvent.hpp"
+#include "SessionSummary.hpp"
+#include "SubmitSettings.hpp"
+#include "TokenBucket.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+
+// Everything YukiPlayLayer tracks while a level is open, and the policy deciding
+// which attempts get submitted. The PlayLayer hooks only translate game callbacks
+// into these calls, which keeps this testable without the game.
+class LevelSession {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int MIN_PERCENTAGE_TO_SUBMIT = 5;
+    // Up to DEATH_BURST deaths go out back to back, then one every
+    // DEATH_REFILL_SECONDS. Deaths over the limit are coalesced, not dropped.
+    // Defaults for the Death Burst and Death Refill settings.
+    static constexpr int DEATH_BURST = 3;
+    static constexpr int DEATH_REFILL_SECONDS = 5;
+
+    explicit LevelSession(int deathBurst = DEATH_BURST,
+                          Clock::duration deathRefill = std::chrono::seconds(DEATH_REFILL_SECONDS))
+        : m_deathLimiter(deathBurst, deathRefill) {}
+
+    // Replaces the death rate limit, for the settings. Call before begin(), which fills it.
+    void setDeathLimit(int burst, Clock::duration refill) { m_deathLimiter = TokenBucket(burst, refill); }
+
+    struct LevelInfo {
+        int levelId = 0;
+        uint32_t nameId = 0;
+        uint32_t creatorId = 0;
+        int coinCount = 0;
+    };
+
+    struct Progress {
+        int percent = 0;
+        float exact = 0.f;
+    };
+
+    // `wallMs` is the current Unix time in milliseconds, used to stamp summaries.
+    // The death rate limit starts over with a full bucket at `now`.
+    void begin(const LevelInfo& level, int64_t wallMs, Clock::time_point now);
+
+    // A sample of the running attempt, `seconds` being its level time. Comes from
+    // game events (checkpoints, coins) and a low-rate timer, not every frame.
+    // Ignored between a death and the reset.
+    void onProgress(float percent, double seconds, float x);
+
+    // Where the attempt ended, taken when the player dies and before the game resets
+    // the level. Ends the attempt's timeline with this point. Later calls before the
+    // reset return the first one's progress, so a restart without a death can call
+    // it from the reset.
+    Progress onDeath(float percent, double seconds, float x);
+    Progress currentProgress() const { return m_current; }
+
+    // GD levels have at most three coins
+    static constexpr int MAX_COINS = 3;
+
+    // Coins are numbered by position, the way the level info shows them. Given the
+    // x of every coin object, fills `out` with the indices of the leftmost MAX_COINS
+    // from left to right and returns how many that is. Coins at the same x keep
+    // their order.
+    static int orderCoins(std::span<const float> xs, std::array<int, MAX_COINS>& out);
+
+    // Coin `index` of the level (counted from the left) was picked up this attempt
+    void onCoin(int index);
+    uint64_t attemptCoins() const { return m_attemptCoins; }
+
+    // After the game reset the level. Returns true if `out` holds a death to submit.
+    // A death arriving while rate limited is merged into the pending death instead,
+    // which keeps the highest percentage and goes out with the latest attempt count.
+    bool onReset(Progress death, bool practice, const SubmitSettings& settings,
+                 Clock::time_point now, ScoreEvent& out);
+
+    bool hasPendingDeath() const { return m_pending.active; }
+    // Sends the pending death once the limiter has a token for it
+    bool flushPendingDeath(Clock::time_point now, ScoreEvent& out);
+    // Sends the pending death regardless of the limiter, for when the level closes
+    bool takePendingDeath(ScoreEvent& out);
+
+    // Keeps the coins picked up on the way. Practice runs never earn coins.
+    void onComplete(bool practice);
+
+    // Returns true if `out` holds the final score of the run to submit
+    bool onFinished(bool passed, bool practice, const SubmitSettings& settings,
+                    Clock::time_point now, ScoreEvent& out);
+
+    const LevelInfo& level() const { return m_level; }
+    int attempts() const { return m_attempts; }
+    int bestPercentage() const { return m_bestPercentage; }
+    bool completed() const { return m_completed; }
+    const DeathHistogram& deaths() const { return m_deaths; }
+
+    // Everything played since begin() or the previous summary. Returns false if
+    // nothing was played in that time.
+    bool takeSummary(int64_t wallMs, SessionSummary& out);
+
+    // Timeline to upload with the event returned by the last onReset/onFinished or
+    // pending death flush, or nullptr. Only passes and new session bests carry one.
+    // Stays valid until the next reset.
+    const AttemptTimeline* eventTimeline() const { return m_eventTimeline; }
+
+private:
+    bool shouldSubmitDeath(int percentage, bool practice, const SubmitSettings& settings) const;
+    ScoreEvent makeEvent(int percentage, bool passed, bool practice, uint64_t coinMask) const;
+    ScoreEvent takePending();
+
+    LevelInfo m_level;
+    int m_attempts = 0;
+    int m_bestPercentage = 0;
+    Progress m_current;
+    bool m_completed = false;
+    // Coins picked up in the running attempt, the one with the best percentage, and
+    // the completed run. Bit i is coin i from the left.
+    uint64_t m_attemptCoins = 0;
+    uint64_t m_bestCoins = 0;
+    uint64_t m_coinMask = 0;
+    TokenBucket m_deathLimiter;
+
+    // Deaths that came in while rate limited, merged into one
+    struct PendingDeath {
+        bool active = false;
+        int percentage = 0;
+        uint64_t coinMask = 0;
+        // nullptr, or m_pendingTimeline once the death outlives its reset
+        const AttemptTimeline* timeline = nullptr;
+    };
+    PendingDeath m_pending;
+    AttemptTimeline m_pendingTimeline;
+    // Every death this session, including the ones too early or too frequent to submit
+    DeathHistogram m_deaths;
+
+    // The running attempt and the one before it, swapped on reset so the previous
+    // attempt's timeline outlives the reset without copying
+    AttemptTimeline m_timelines[2];
+    int m_activeTimeline = 0;
+    bool m_recording = true;
+    int m_bestBeforeAttempt = 0;
+    const AttemptTimeline* m_eventTimeline = nullptr;
+
+    // Accumulates until the next takeSummary()
+    SessionSummary m_summary;
+    // The completed attempt was already counted, the reset that follows it isn't a new one
+    bool m_attemptCounted = false;
+};
@@ -0,0 +1,54 @@
+#include "LiveStatus.hpp"
+
+void LiveCoalescer::update(const LiveStatus& status) {
+    if (status == m_latest) return;
+
+    // A pending state nobody saw yet is being replaced
+    if (m_dirty) m_coalesced++;
+    m_latest = status;
+    m_dirty = needsSend();
+}
+
+bool LiveCoalescer::take(Clock::time_point now, LiveStatus& out, uint32_t& seq) {
+    if (m_inFlight) return false;
+
+    bool heartbeatDue = m_latest.levelId != 0 && now - m_lastSent >= m_heartbeat;
+    if (!m_dirty && !heartbeatDue) return false;
+    if (now - m_lastSent < m_minInterval) return false;
+
+    m_inFlight = true;
+    m_inFlightStatus = m_latest;
+    m_dirty = false;
+    m_lastSent = now;
+    out = m_latest;
+    seq = ++m_seq;
+    return true;
+}
+
+void LiveCoalescer::onAcked(uint32_t seq, bool delivered) {
+    if (!m_inFlight || seq != m_seq) return;
+    m_inFlight = false;
+
+    if (delivered) {
+        m_acked = m_inFlightStatus;
+        m_announced = true;
+    }
+    // After a failure whatever is newest goes out on the next attempt
+    m_dirty = needsSend();
+}
+
+bool LiveCoalescer::needsSend() const {
+    // Nothing to take back if the server never heard of a level
+    if (!m_announced) return m_latest.levelId != 0;
+    return !(m_latest == m_acked);
+}
+
+void LiveCoalescer::reset() {
+    m_latest = {};
+    m_inFlightStatus = {};
+    m_acked = {};
+    m_dirty = false;
+    m_inFlight = false;
+    m_announced = false;
+    m_lastSent = {};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// What the player is doing right now, as shown by the bot's /live
+struct LiveStatus {
+    // 0 while not in a level
+    int levelId = 0;
+    int percentage = 0;
+    int bestPercentage = 0;
+    int attempts = 0;
+    bool practice = false;
+
+    bool operator==(const LiveStatus&) const = default;
+};
+
+// Latest-wins buffer between the game loop and the live channel.
+//
+// update() is called every frame and only overwrites a slot, so it costs nothing
+// beyond a compare. At most one update is on the wire at a time, and nothing goes
+// out more often than `minInterval`: states produced meanwhile replace the pending
+// one instead of queueing up behind a slow connection. An unchanged state is
+// resent every `heartbeat` while in a level so the server knows the player is
+// still there.
+class LiveCoalescer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LiveCoalescer(Clock::duration minInterval, Clock::duration heartbeat)
+        : m_minInterval(minInterval), m_heartbeat(heartbeat) {}
+
+    void update(const LiveStatus& status);
+
+    // Fills `out` and `seq` when a state should be sent now, and marks it in flight
+    bool take(Clock::time_point now, LiveStatus& out, uint32_t& seq);
+    // The in-flight update finished, `seq` is what the server acknowledged
+    void onAcked(uint32_t seq, bool delivered);
+    void reset();
+
+    bool inFlight() const { return m_inFlight; }
+    // Updates replaced before they were sent
+    uint64_t coalescedCount() const { return m_coalesced; }
+
+private:
+    bool needsSend() const;
+
+    Clock::duration m_minInterval;
+    Clock::duration m_heartbeat;
+
+    LiveStatus m_latest;
+    LiveStatus m_inFlightStatus;
+    LiveStatus m_acked;
+    bool m_dirty = false;
+    bool m_inFlight = false;
+    // Whether the server has seen anything yet
+    bool m_announced = false;
+    uint32_t m_seq = 0;
+    uint64_t m_coalesced = 0;
+    Clock::time_point m_lastSent{};
+};
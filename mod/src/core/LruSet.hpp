@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+// Set that remembers the `capacity` most recently touched keys and forgets the
+// least recently used one when full.
+template <typename Key>
+class LruSet {
+public:
+    explicit LruSet(size_t capacity) : m_capacity(capacity) {}
+
+    // Counts as a use
+    bool contains(const Key& key) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) return false;
+        m_order.splice(m_order.begin(), m_order, it->second);
+        return true;
+    }
+
+    void insert(const Key& key) {
+        if (contains(key)) return;
+
+        if (m_order.size() >= m_capacity && !m_order.empty()) {
+            m_index.erase(m_order.back());
+            m_order.pop_back();
+        }
+        m_order.push_front(key);
+        m_index[key] = m_order.begin();
+    }
+
+    void clear() {
+        m_order.clear();
+        m_index.clear();
+    }
+
+    size_t size() const { return m_order.size(); }
+
+private:
+    size_t m_capacity;
+    std::list<Key> m_order;
+    std::unordered_map<Key, typename std::list<Key>::iterator> m_index;
+};
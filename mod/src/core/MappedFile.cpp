@@ -0,0 +1,171 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::filesystem::path& path, size_t minSize) {
+    close();
+    m_writable = true;
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    m_file = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        close();
+        return false;
+    }
+    size_t current = static_cast<size_t>(size.QuadPart);
+    if (!map(current < minSize ? minSize : current)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::openReadOnly(const std::filesystem::path& path) {
+    close();
+    m_writable = false;
+
+    // The writer keeps its handle open, so its write access has to be shared
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    m_file = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || !map(static_cast<size_t>(size.QuadPart))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map(size_t size) {
+    // Mapping a handle with a bigger size extends the file
+    LARGE_INTEGER li;
+    li.QuadPart = static_cast<LONGLONG>(size);
+    HANDLE mapping = CreateFileMappingW(static_cast<HANDLE>(m_file), nullptr,
+                                        m_writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        static_cast<DWORD>(li.HighPart), li.LowPart, nullptr);
+    if (!mapping) return false;
+
+    void* view = MapViewOfFile(mapping, m_writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_data = static_cast<uint8_t*>(view);
+    m_size = size;
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(static_cast<HANDLE>(m_mapping));
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::close() {
+    unmap();
+    if (m_file) CloseHandle(static_cast<HANDLE>(m_file));
+    m_file = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path& path, size_t minSize) {
+    close();
+    m_writable = true;
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) return false;
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) {
+        close();
+        return false;
+    }
+    size_t current = static_cast<size_t>(st.st_size);
+    if (!map(current < minSize ? minSize : current)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::openReadOnly(const std::filesystem::path& path) {
+    close();
+    m_writable = false;
+
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) return false;
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size == 0 || !map(static_cast<size_t>(st.st_size))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map(size_t size) {
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) return false;
+    if (static_cast<size_t>(st.st_size) < size &&
+        (!m_writable || ftruncate(m_fd, static_cast<off_t>(size)) != 0)) {
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, m_writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) return false;
+
+    m_data = static_cast<uint8_t*>(data);
+    m_size = size;
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (m_data) munmap(m_data, m_size);
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::close() {
+    unmap();
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+}
+
+#endif
+
+bool MappedFile::resize(size_t size) {
+    if (size <= m_size) return true;
+    if (!m_writable) return false;
+
+    size_t previous = m_size;
+    unmap();
+    if (map(size)) return true;
+    map(previous);
+    return false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Read-write shared memory mapping of a whole file. Growing the file remaps it,
+// which invalidates every pointer previously returned by data().
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Creates the file if needed and makes it at least `minSize` bytes
+    bool open(const std::filesystem::path& path, size_t minSize);
+    // Maps an existing file as it is, for reading what another process writes
+    bool openReadOnly(const std::filesystem::path& path);
+    void close();
+
+    // Grows the file (never shrinks) and remaps it. Not for read-only mappings.
+    bool resize(size_t size);
+
+    bool isOpen() const { return m_data != nullptr; }
+    uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    bool map(size_t size);
+    void unmap();
+
+    uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_writable = true;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
@@ -0,0 +1,187 @@
+#include "Metrics.hpp"
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Metrics {
+    namespace {
+        struct ThreadBlock {
+            std::array<std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS>, TIMER_COUNT> buckets{};
+            std::array<std::atomic<uint64_t>, TIMER_COUNT> totals{};
+            std::array<std::atomic<uint64_t>, TIMER_COUNT> maxima{};
+            std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+        };
+
+        std::atomic<bool> s_enabled{false};
+
+        // Blocks outlive their threads so snapshots never race with thread exit
+        std::mutex s_registryMutex;
+        std::vector<std::unique_ptr<ThreadBlock>> s_blocks;
+
+        ThreadBlock& localBlock() {
+            thread_local ThreadBlock* block = [] {
+                std::lock_guard lock(s_registryMutex);
+                s_blocks.push_back(std::make_unique<ThreadBlock>());
+                return s_blocks.back().get();
+            }();
+            return *block;
+        }
+
+        size_t bucketFor(uint64_t value) {
+            if (value < 16) return static_cast<size_t>(value);
+            int exponent = std::bit_width(value) - 1;
+            size_t sub = static_cast<size_t>((value >> (exponent - 3)) & 7);
+            return 16 + static_cast<size_t>(exponent - 4) * 8 + sub;
+        }
+
+        uint64_t bucketValue(size_t index) {
+            if (index < 16) return index;
+            int exponent = static_cast<int>((index - 16) / 8) + 4;
+            uint64_t sub = (index - 16) % 8;
+            return (8 | sub) << (exponent - 3);
+        }
+
+        // Single writer per block, so a relaxed load + store is enough
+        void bump(std::atomic<uint64_t>& value, uint64_t amount) {
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    }
+
+    const char* name(Timer timer) {
+        switch (timer) {
+            case Timer::ProgressTick: return "progressTick";
+            case Timer::ResetLevel: return "resetLevel";
+            case Timer::LevelComplete: return "levelComplete";
+            case Timer::EndLevelSetup: return "endLevelCustomSetup";
+            case Timer::SubmitScore: return "submitScore";
+            case Timer::SubmitCallback: return "submitCallback";
+            case Timer::SubmitRoundTrip: return "submitRoundTrip";
+            case Timer::PingRoundTrip: return "pingRoundTrip";
+            case Timer::LiveRoundTrip: return "liveRoundTrip";
+            case Timer::FrameInterval: return "frameInterval";
+            default: return "unknown";
+        }
+    }
+
+    const char* name(Counter counter) {
+        switch (counter) {
+            case Counter::ScoresQueued: return "scoresQueued";
+            case Counter::ScoresDropped: return "scoresDropped";
+            case Counter::ScoresRejected: return "scoresRejected";
+            case Counter::BatchesSent: return "batchesSent";
+            case Counter::BatchesFailed: return "batchesFailed";
+            case Counter::LiveSent: return "liveSent";
+            case Counter::LiveCoalesced: return "liveCoalesced";
+            case Counter::HeldFlushes: return "heldFlushes";
+            default: return "unknown";
+        }
+    }
+
+    void setEnabled(bool value) {
+        s_enabled.store(value, std::memory_order_relaxed);
+    }
+
+    bool enabled() {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    void record(Timer timer, uint64_t nanoseconds) {
+        if (!enabled()) return;
+
+        auto& block = localBlock();
+        size_t t = static_cast<size_t>(timer);
+        bump(block.buckets[t][bucketFor(nanoseconds)], 1);
+        bump(block.totals[t], nanoseconds);
+        if (nanoseconds > block.maxima[t].load(std::memory_order_relaxed)) {
+            block.maxima[t].store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    void increment(Counter counter, uint64_t amount) {
+        if (!enabled()) return;
+        bump(localBlock().counters[static_cast<size_t>(counter)], amount);
+    }
+
+    Snapshot snapshot() {
+        Snapshot result;
+        std::array<std::array<uint64_t, HISTOGRAM_BUCKETS>, TIMER_COUNT> merged{};
+
+        {
+            std::lock_guard lock(s_registryMutex);
+            for (const auto& block : s_blocks) {
+                for (size_t t = 0; t < TIMER_COUNT; t++) {
+                    for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+                        merged[t][b] += block->buckets[t][b].load(std::memory_order_relaxed);
+                    }
+                    result.timers[t].totalNs += block->totals[t].load(std::memory_order_relaxed);
+                    result.timers[t].maxNs = std::max(result.timers[t].maxNs,
+                                                      block->maxima[t].load(std::memory_order_relaxed));
+                }
+                for (size_t c = 0; c < COUNTER_COUNT; c++) {
+                    result.counters[c] += block->counters[c].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        for (size_t t = 0; t < TIMER_COUNT; t++) {
+            auto& stats = result.timers[t];
+            for (uint64_t count : merged[t]) stats.count += count;
+            if (stats.count == 0) continue;
+
+            auto percentile = [&](double p) {
+                uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(stats.count - 1));
+                uint64_t seen = 0;
+                for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+                    seen += merged[t][b];
+                    if (seen > rank) return bucketValue(b);
+                }
+                return stats.maxNs;
+            };
+            stats.p50Ns = percentile(0.50);
+            stats.p90Ns = percentile(0.90);
+            stats.p99Ns = percentile(0.99);
+        }
+        return result;
+    }
+
+    void reset() {
+        std::lock_guard lock(s_registryMutex);
+        for (const auto& block : s_blocks) {
+            for (size_t t = 0; t < TIMER_COUNT; t++) {
+                for (auto& bucket : block->buckets[t]) bucket.store(0, std::memory_order_relaxed);
+                block->totals[t].store(0, std::memory_order_relaxed);
+                block->maxima[t].store(0, std::memory_order_relaxed);
+            }
+            for (auto& counter : block->counters) counter.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::string toJson(const Snapshot& snapshot) {
+        std::string out = "{\"timers\":{";
+        for (size_t t = 0; t < TIMER_COUNT; t++) {
+            const auto& s = snapshot.timers[t];
+            if (t > 0) out += ",";
+            out += '"';
+            out += name(static_cast<Timer>(t));
+            out += "\":{";
+            out += "\"count\":" + std::to_string(s.count);
+            out += ",\"mean_ns\":" + std::to_string(s.count ? s.totalNs / s.count : 0);
+            out += ",\"p50_ns\":" + std::to_string(s.p50Ns);
+            out += ",\"p90_ns\":" + std::to_string(s.p90Ns);
+            out += ",\"p99_ns\":" + std::to_string(s.p99Ns);
+            out += ",\"max_ns\":" + std::to_string(s.maxNs);
+            out += "}";
+        }
+        out += "},\"counters\":{";
+        for (size_t c = 0; c < COUNTER_COUNT; c++) {
+            if (c > 0) out += ",";
+            out += '"';
+            out += name(static_cast<Counter>(c));
+            out += "\":" + std::to_string(snapshot.counters[c]);
+        }
+        out += "}}";
+        return out;
+    }
+}
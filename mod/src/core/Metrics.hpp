@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Low overhead timers and counters for the hooks and the submission path.
+//
+// Every thread records into its own block of HDR-style log-linear histograms
+// (8 sub-buckets per power of two, so values are within 12.5%), which means
+// recording is a couple of relaxed atomic ops with no contention. snapshot()
+// sums the blocks of every thread. Recording is skipped entirely while disabled.
+namespace Metrics {
+    enum class Timer : uint8_t {
+        ProgressTick,
+        ResetLevel,
+        LevelComplete,
+        EndLevelSetup,
+        SubmitScore,
+        SubmitCallback,
+        SubmitRoundTrip,
+        PingRoundTrip,
+        LiveRoundTrip,
+        // Frame time while a level runs, only measured with metrics on
+        FrameInterval,
+        Count
+    };
+
+    enum class Counter : uint8_t {
+        ScoresQueued,
+        ScoresDropped,
+        // Refused by the server with a client error, not retried
+        ScoresRejected,
+        BatchesSent,
+        BatchesFailed,
+        LiveSent,
+        LiveCoalesced,
+        HeldFlushes,
+        Count
+    };
+
+    constexpr size_t TIMER_COUNT = static_cast<size_t>(Timer::Count);
+    constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::Count);
+    constexpr size_t HISTOGRAM_BUCKETS = 512;
+
+    const char* name(Timer timer);
+    const char* name(Counter counter);
+
+    void setEnabled(bool enabled);
+    bool enabled();
+
+    void record(Timer timer, uint64_t nanoseconds);
+    void increment(Counter counter, uint64_t amount = 1);
+
+    struct TimerStats {
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+        uint64_t p50Ns = 0;
+        uint64_t p90Ns = 0;
+        uint64_t p99Ns = 0;
+    };
+
+    struct Snapshot {
+        std::array<TimerStats, TIMER_COUNT> timers{};
+        std::array<uint64_t, COUNTER_COUNT> counters{};
+    };
+
+    Snapshot snapshot();
+    void reset();
+    std::string toJson(const Snapshot& snapshot);
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Timer timer) : m_timer(timer), m_active(enabled()) {
+            if (m_active) m_start = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedTimer() {
+            if (!m_active) return;
+            auto elapsed = std::chrono::steady_clock::now() - m_start;
+            record(m_timer, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Timer m_timer;
+        bool m_active;
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
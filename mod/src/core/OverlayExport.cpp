@@ -0,0 +1,146 @@
+#include "OverlayExport.hpp"
+#include <algorithm>
+
+void OverlayState::setLevelName(std::string_view name) {
+    size_t length = std::min(name.size(), sizeof(levelName) - 1);
+    // Don't leave half a UTF-8 sequence at the end
+    if (length < name.size()) {
+        while (length > 0 && (static_cast<uint8_t>(name[length]) & 0xC0) == 0x80) length--;
+    }
+    std::memcpy(levelName, name.data(), length);
+    std::memset(levelName + length, 0, sizeof(levelName) - length);
+}
+
+bool OverlayWriter::open(const std::filesystem::path& path, uint64_t session) {
+    close();
+    if (!m_file.open(path, sizeof(OverlayLayout))) return false;
+
+    // The atomics live in the mapping and are used in place. A new file is all
+    // zeroes, which is what they start as anyway.
+    m_layout = reinterpret_cast<OverlayLayout*>(m_file.data());
+    auto& layout = *m_layout;
+
+    bool reusable = layout.magic.load(std::memory_order_acquire) == OverlayLayout::MAGIC &&
+                    layout.version.load(std::memory_order_relaxed) == OverlayLayout::VERSION &&
+                    layout.eventCapacity.load(std::memory_order_relaxed) == OverlayLayout::EVENT_CAPACITY;
+    layout.magic.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_state = {};
+    m_stateVersion = 0;
+    m_eventCount = 0;
+    if (reusable) {
+        // A store cut short by a crash left an odd sequence, the next one goes past it
+        m_stateVersion = (layout.state.seq.load(std::memory_order_relaxed) + 1) / 2;
+        m_eventCount = layout.eventCount.load(std::memory_order_relaxed);
+        for (auto& slot : layout.events) {
+            m_eventCount = std::max(m_eventCount, (slot.seq.load(std::memory_order_relaxed) + 1) / 2);
+        }
+    } else {
+        layout.state.seq.store(0, std::memory_order_relaxed);
+        for (auto& slot : layout.events) slot.seq.store(0, std::memory_order_relaxed);
+        layout.eventCount.store(0, std::memory_order_relaxed);
+        layout.version.store(OverlayLayout::VERSION, std::memory_order_relaxed);
+        layout.eventCapacity.store(OverlayLayout::EVENT_CAPACITY, std::memory_order_relaxed);
+    }
+    layout.eventCount.store(m_eventCount, std::memory_order_relaxed);
+    layout.writerSession.store(session, std::memory_order_relaxed);
+    layout.magic.store(OverlayLayout::MAGIC, std::memory_order_release);
+    return true;
+}
+
+void OverlayWriter::close() {
+    m_layout = nullptr;
+    m_file.close();
+}
+
+void OverlayWriter::publish(uint64_t now) {
+    if (!m_layout) return;
+    m_state.updatedAt = now;
+    m_layout->state.store(m_state, ++m_stateVersion);
+}
+
+void OverlayWriter::pushEvent(OverlayEventType type, uint64_t now) {
+    if (!m_layout) return;
+
+    OverlayEvent event;
+    event.at = now;
+    event.type = type;
+    event.levelId = m_state.levelId;
+    event.attempt = m_state.attempt;
+    event.percent = m_state.percent;
+    m_layout->events[m_eventCount % OverlayLayout::EVENT_CAPACITY].store(event, m_eventCount + 1);
+    m_layout->eventCount.store(++m_eventCount, std::memory_order_release);
+}
+
+bool OverlayReader::open(const std::filesystem::path& path) {
+    close();
+    if (!m_file.openReadOnly(path)) return false;
+    if (m_file.size() < sizeof(OverlayLayout)) {
+        close();
+        return false;
+    }
+
+    m_layout = reinterpret_cast<const OverlayLayout*>(m_file.data());
+    if (m_layout->magic.load(std::memory_order_acquire) != OverlayLayout::MAGIC ||
+        m_layout->version.load(std::memory_order_relaxed) != OverlayLayout::VERSION ||
+        m_layout->eventCapacity.load(std::memory_order_relaxed) != OverlayLayout::EVENT_CAPACITY) {
+        close();
+        return false;
+    }
+    m_session = m_layout->writerSession.load(std::memory_order_relaxed);
+    m_eventsStarted = false;
+    return true;
+}
+
+void OverlayReader::close() {
+    m_layout = nullptr;
+    m_file.close();
+}
+
+bool OverlayReader::checkSession() {
+    if (m_layout->magic.load(std::memory_order_acquire) != OverlayLayout::MAGIC) return false;
+    m_session = m_layout->writerSession.load(std::memory_order_relaxed);
+    return true;
+}
+
+bool OverlayReader::readState(OverlayState& out) {
+    if (!m_layout || !checkSession()) return false;
+    if (m_layout->state.seq.load(std::memory_order_relaxed) == 0) return false;
+
+    // A publish takes nanoseconds, needing more than a few tries means the game is
+    // stuck halfway through one
+    constexpr int MAX_TRIES = 16;
+    for (int i = 0; i < MAX_TRIES; i++) {
+        if (m_layout->state.load(out) != 0) return true;
+        m_retries++;
+    }
+    return false;
+}
+
+void OverlayReader::readEvents(std::vector<OverlayEvent>& out) {
+    if (!m_layout || !checkSession()) return;
+
+    uint64_t count = m_layout->eventCount.load(std::memory_order_acquire);
+    // Also where a file that was set up from scratch starts over
+    if (!m_eventsStarted || count < m_nextEvent) {
+        m_eventsStarted = true;
+        m_nextEvent = count;
+        return;
+    }
+
+    constexpr uint64_t CAPACITY = OverlayLayout::EVENT_CAPACITY;
+    if (count - m_nextEvent > CAPACITY) {
+        m_lostEvents += count - m_nextEvent - CAPACITY;
+        m_nextEvent = count - CAPACITY;
+    }
+    for (; m_nextEvent < count; m_nextEvent++) {
+        OverlayEvent event;
+        // Anything but this event's version means the writer already lapped it
+        if (m_layout->events[m_nextEvent % CAPACITY].load(event) == m_nextEvent + 1) {
+            out.push_back(event);
+        } else {
+            m_lostEvents++;
+        }
+    }
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// What a local stream overlay shows. Plain data, the same layout on every
+// platform, so a reader built for another OS (say, natively next to GD running
+// under Wine) can map the same file.
+struct OverlayState {
+    // steady_clock nanoseconds of the last publish, comparable across processes
+    // on the same machine
+    uint64_t updatedAt = 0;
+    // 0 while not in a level
+    int32_t levelId = 0;
+    // 1 for the first attempt of the session
+    int32_t attempt = 0;
+    float percent = 0.f;
+    float bestPercent = 0.f;
+    // A GameState value
+    uint8_t gameState = 0;
+    uint8_t practice = 0;
+    uint8_t reserved[6]{};
+    // UTF-8, cut to fit and always terminated
+    char levelName[64]{};
+
+    void setLevelName(std::string_view name);
+
+    // The clock updatedAt and event times are on
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+};
+static_assert(sizeof(OverlayState) == 96);
+
+enum class OverlayEventType : uint32_t {
+    EnterLevel = 1,
+    NewAttempt,
+    Death,
+    Complete,
+    ExitLevel,
+};
+
+struct OverlayEvent {
+    uint64_t at = 0;
+    OverlayEventType type = OverlayEventType::EnterLevel;
+    int32_t levelId = 0;
+    int32_t attempt = 0;
+    float percent = 0.f;
+};
+static_assert(sizeof(OverlayEvent) == 24);
+
+// One value behind a sequence lock: the single writer makes the sequence odd,
+// stores the words and makes it even again; readers copy the words and keep the
+// copy only if the sequence was even and unchanged around it. Neither side ever
+// waits on the other or enters the kernel.
+template <typename T>
+struct SeqlockCell {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqlockCell only holds POD values");
+    static constexpr size_t WORDS = (sizeof(T) + 3) / 4;
+
+    std::atomic<uint64_t> seq{0};
+    std::array<std::atomic<uint32_t>, WORDS> words{};
+
+    // `version` starts at 1 and has to grow with every store
+    void store(const T& value, uint64_t version) {
+        std::array<uint32_t, WORDS> copy{};
+        std::memcpy(copy.data(), &value, sizeof(T));
+
+        seq.store(version * 2 - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i].store(copy[i], std::memory_order_relaxed);
+        }
+        seq.store(version * 2, std::memory_order_release);
+    }
+
+    // One attempt. Returns the version read, or 0 if nothing was stored yet or a
+    // store overlapped the copy.
+    uint64_t load(T& out) const {
+        uint64_t before = seq.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1)) return 0;
+
+        std::array<uint32_t, WORDS> copy{};
+        for (size_t i = 0; i < WORDS; i++) {
+            copy[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) != before) return 0;
+
+        std::memcpy(static_cast<void*>(&out), copy.data(), sizeof(T));
+        return before / 2;
+    }
+};
+
+// The shared file: the current state plus a ring of the latest game events.
+// Event i sits in slot i % EVENT_CAPACITY, stored with version i + 1.
+struct OverlayLayout {
+    static constexpr uint32_t MAGIC = 0x594b4f56; // "YKOV"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t EVENT_CAPACITY = 64;
+
+    // MAGIC once the writer finished setting the file up, 0 while it does
+    std::atomic<uint32_t> magic{0};
+    std::atomic<uint32_t> version{0};
+    std::atomic<uint32_t> eventCapacity{0};
+    // Changes every time the game starts writing, so readers notice a restart
+    std::atomic<uint64_t> writerSession{0};
+
+    alignas(64) SeqlockCell<OverlayState> state;
+    // Events published so far. On its own cache line, readers poll it.
+    alignas(64) std::atomic<uint64_t> eventCount{0};
+    alignas(64) std::array<SeqlockCell<OverlayEvent>, EVENT_CAPACITY> events;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory needs address-free atomics");
+static_assert(sizeof(std::atomic<uint32_t>) == 4 && sizeof(std::atomic<uint64_t>) == 8,
+              "OverlayLayout has to look the same to every process");
+
+// Game side. publish() and pushEvent() are a few dozen plain stores into mapped
+// memory, cheap enough for every frame: no locks, allocations or syscalls. One
+// thread only.
+class OverlayWriter {
+public:
+    // Picks up the versions a previous run left in the file, so readers that
+    // stayed open carry on. `session` tells runs apart.
+    bool open(const std::filesystem::path& path, uint64_t session);
+    void close();
+    bool isOpen() const { return m_layout != nullptr; }
+
+    // Edit, then publish() to stamp and share it
+    OverlayState& state() { return m_state; }
+    void publish(uint64_t now);
+    // Events carry the current state's level, attempt and percent
+    void pushEvent(OverlayEventType type, uint64_t now);
+
+private:
+    MappedFile m_file;
+    OverlayLayout* m_layout = nullptr;
+    OverlayState m_state;
+    uint64_t m_stateVersion = 0;
+    uint64_t m_eventCount = 0;
+};
+
+// Overlay side. Reads never block the game, a read that raced with a publish
+// is simply retried.
+class OverlayReader {
+public:
+    // False until the game created the file and finished setting it up
+    bool open(const std::filesystem::path& path);
+    void close();
+    bool isOpen() const { return m_layout != nullptr; }
+
+    // The latest published state. False if the game hasn't published one yet, or
+    // it kept publishing faster than this could copy.
+    bool readState(OverlayState& out);
+    // Appends events published since the last call. The first call starts at the
+    // newest event.
+    void readEvents(std::vector<OverlayEvent>& out);
+
+    // Events overwritten before they were read
+    uint64_t lostEvents() const { return m_lostEvents; }
+    // Copies thrown away because a publish overlapped them
+    uint64_t retries() const { return m_retries; }
+    // The writer's session as of the last read, changes when the game restarts
+    uint64_t session() const { return m_session; }
+
+private:
+    // False while the game is setting the file up
+    bool checkSession();
+
+    MappedFile m_file;
+    const OverlayLayout* m_layout = nullptr;
+    uint64_t m_session = 0;
+    uint64_t m_nextEvent = 0;
+    bool m_eventsStarted = false;
+    uint64_t m_lostEvents = 0;
+    uint64_t m_retries = 0;
+};
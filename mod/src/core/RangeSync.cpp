@@ -0,0 +1,125 @@
+#include "RangeSync.hpp"
+#include <algorithm>
+
+namespace {
+    // splitmix64's finalizer
+    uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    SyncKey keyOf(const HistoryRecord& record) {
+        return {record.levelId, record.playedAt};
+    }
+}
+
+uint64_t syncHash(const HistoryRecord& record) {
+    uint64_t h = 0x9e3779b97f4a7c15ULL;
+    h = mix(h ^ static_cast<uint32_t>(record.levelId));
+    h = mix(h ^ static_cast<uint64_t>(record.playedAt));
+    h = mix(h ^ (static_cast<uint64_t>(static_cast<uint32_t>(record.attempts)) << 32 |
+                 static_cast<uint32_t>(record.percentage)));
+    return mix(h ^ ((record.passed ? 1u : 0u) | (record.isPractice ? 2u : 0u)));
+}
+
+RangeReconciler::RangeReconciler(std::vector<HistoryRecord> local) : m_records(std::move(local)) {
+    std::sort(m_records.begin(), m_records.end(),
+              [](const HistoryRecord& a, const HistoryRecord& b) { return keyOf(a) < keyOf(b); });
+
+    m_hashes.reserve(m_records.size());
+    m_hashSums.reserve(m_records.size() + 1);
+    m_hashSums.push_back(0);
+    for (const auto& record : m_records) {
+        m_hashes.push_back(syncHash(record));
+        m_hashSums.push_back(m_hashSums.back() + m_hashes.back());
+    }
+
+    // Everything to start with, the server splits it from there
+    m_queue.push_back(fingerprint({}, {}, true));
+}
+
+size_t RangeReconciler::lowerBound(const SyncKey& key) const {
+    auto it = std::lower_bound(m_records.begin(), m_records.end(), key,
+                               [](const HistoryRecord& record, const SyncKey& k) { return keyOf(record) < k; });
+    return static_cast<size_t>(it - m_records.begin());
+}
+
+std::pair<size_t, size_t> RangeReconciler::span(const SyncRange& range) const {
+    size_t begin = lowerBound(range.from);
+    size_t end = range.open ? m_records.size() : std::max(begin, lowerBound(range.to));
+    return {begin, end};
+}
+
+SyncRange RangeReconciler::fingerprint(const SyncKey& from, const SyncKey& to, bool open) const {
+    size_t begin = lowerBound(from);
+    size_t end = open ? m_records.size() : std::max(begin, lowerBound(to));
+
+    SyncRange range;
+    range.from = from;
+    range.to = to;
+    range.open = open;
+    range.count = static_cast<uint32_t>(end - begin);
+    range.hash = m_hashSums[end] - m_hashSums[begin];
+    return range;
+}
+
+std::vector<SyncRange> RangeReconciler::takeRequest(size_t maxRanges) {
+    size_t count = std::min(maxRanges, m_queue.size());
+    std::vector<SyncRange> ranges(m_queue.begin(), m_queue.begin() + static_cast<std::ptrdiff_t>(count));
+    m_queue.erase(m_queue.begin(), m_queue.begin() + static_cast<std::ptrdiff_t>(count));
+    return ranges;
+}
+
+std::span<const HistoryRecord> RangeReconciler::localItems(const SyncRange& range) const {
+    auto [begin, end] = span(range);
+    return std::span<const HistoryRecord>(m_records).subspan(begin, end - begin);
+}
+
+void RangeReconciler::onSplit(const std::vector<SyncRange>& parts) {
+    for (const auto& part : parts) {
+        auto local = fingerprint(part.from, part.to, part.open);
+        if (!local.sameFingerprint(part)) m_queue.push_back(local);
+    }
+}
+
+void RangeReconciler::onItems(const SyncRange& range, std::vector<RemoteRecord> items) {
+    auto [begin, end] = span(range);
+
+    std::sort(items.begin(), items.end(), [](const RemoteRecord& a, const RemoteRecord& b) {
+        return keyOf(a.record) < keyOf(b.record);
+    });
+
+    // Merge by key. A key both sides have with different contents counts as
+    // missing on both, which sends each side the other's version.
+    std::vector<bool> matched(items.size(), false);
+    size_t remote = 0;
+    for (size_t i = begin; i < end; i++) {
+        SyncKey key = keyOf(m_records[i]);
+        while (remote < items.size() && keyOf(items[remote].record) < key) remote++;
+
+        bool found = false;
+        for (size_t j = remote; j < items.size() && keyOf(items[j].record) == key; j++) {
+            if (!matched[j] && syncHash(items[j].record) == m_hashes[i]) {
+                matched[j] = found = true;
+                break;
+            }
+        }
+        if (!found) m_missingOnServer.push_back(m_records[i]);
+    }
+
+    for (size_t j = 0; j < items.size(); j++) {
+        if (!matched[j]) m_missingLocally.push_back(std::move(items[j]));
+    }
+}
+
+void RangeReconciler::onDiff(const SyncRange& range, const std::vector<size_t>& missing,
+                             std::vector<RemoteRecord> items) {
+    auto local = localItems(range);
+    for (size_t index : missing) {
+        if (index < local.size()) m_missingOnServer.push_back(local[index]);
+    }
+    for (auto& item : items) {
+        m_missingLocally.push_back(std::move(item));
+    }
+}
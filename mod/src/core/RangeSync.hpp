@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ScoreHistory.hpp"
+#include <compare>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <vector>
+
+// Scores are ordered by (level ID, played at), which both the history and the
+// server's scores table can range over
+struct SyncKey {
+    int levelId = 0;
+    int64_t playedAt = 0;
+
+    auto operator<=>(const SyncKey&) const = default;
+};
+
+// Hash of the fields both sides store. server/src/lib/rangeSync.ts computes the same.
+uint64_t syncHash(const HistoryRecord& record);
+
+// The scores in [from, to), or [from, end) when `open`, summarized as their count
+// and the sum of their hashes
+struct SyncRange {
+    SyncKey from;
+    SyncKey to;
+    bool open = false;
+    uint32_t count = 0;
+    uint64_t hash = 0;
+
+    bool sameFingerprint(const SyncRange& other) const { return count == other.count && hash == other.hash; }
+};
+
+// A score the server has, with the level name the history wants
+struct RemoteRecord {
+    HistoryRecord record;
+    std::string levelName;
+};
+
+// Finds which scores only the device or only the server has, without sending
+// either side's full set. The device sends range fingerprints, listing the keys
+// of its scores in ranges where it has few. For each range that differs the
+// server answers with
+//  - the difference, when the device listed its keys,
+//  - its own scores, when it has few,
+//  - or fingerprints of smaller ranges to compare next round.
+// Matching ranges are never looked at again, so a sync costs O(differences x
+// log n) instead of O(n).
+//
+// This class only does the device's side of the bookkeeping. Fingerprints are
+// prefix sums over the sorted local set, so each one is two binary searches.
+class RangeReconciler {
+public:
+    // Ranges with this many local scores or fewer go out with their keys
+    static constexpr uint32_t ITEM_LIST_SIZE = 32;
+
+    explicit RangeReconciler(std::vector<HistoryRecord> local);
+
+    bool done() const { return m_queue.empty(); }
+    // The next ranges to send, with the local fingerprints
+    std::vector<SyncRange> takeRequest(size_t maxRanges);
+    // Local scores of a range, sorted by key, to list when there are few
+    std::span<const HistoryRecord> localItems(const SyncRange& range) const;
+
+    // Server answers, one per range taken
+    void onSplit(const std::vector<SyncRange>& parts);
+    void onItems(const SyncRange& range, std::vector<RemoteRecord> items);
+    // `missing` indexes localItems(range)
+    void onDiff(const SyncRange& range, const std::vector<size_t>& missing, std::vector<RemoteRecord> items);
+
+    SyncRange fingerprint(const SyncKey& from, const SyncKey& to, bool open) const;
+
+    const std::vector<HistoryRecord>& missingOnServer() const { return m_missingOnServer; }
+    const std::vector<RemoteRecord>& missingLocally() const { return m_missingLocally; }
+    size_t localCount() const { return m_records.size(); }
+
+private:
+    size_t lowerBound(const SyncKey& key) const;
+    std::pair<size_t, size_t> span(const SyncRange& range) const;
+
+    std::vector<HistoryRecord> m_records;
+    std::vector<uint64_t> m_hashes;
+    // m_hashSums[i] is the sum of the first i hashes, wrapping
+    std::vector<uint64_t> m_hashSums;
+    std::deque<SyncRange> m_queue;
+
+    std::vector<HistoryRecord> m_missingOnServer;
+    std::vector<RemoteRecord> m_missingLocally;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+// Exponential backoff between delivery attempts: base, 2*base, 4*base... capped at max
+class RetryBackoff {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RetryBackoff(Clock::duration base, Clock::duration max) : m_base(base), m_max(max) {}
+
+    bool ready(Clock::time_point now) const { return now >= m_nextAttempt; }
+
+    void onFailure(Clock::time_point now) {
+        auto delay = m_base * (1 << std::min(m_failures, 16));
+        m_nextAttempt = now + std::min<Clock::duration>(delay, m_max);
+        m_failures++;
+    }
+
+    void onSuccess() {
+        m_failures = 0;
+        m_nextAttempt = {};
+    }
+
+    int failures() const { return m_failures; }
+
+private:
+    Clock::duration m_base;
+    Clock::duration m_max;
+    Clock::time_point m_nextAttempt{};
+    int m_failures = 0;
+};
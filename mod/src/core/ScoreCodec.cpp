@@ -0,0 +1,380 @@
+#include "ScoreCodec.hpp"
+#include <algorithm>
+
+namespace ScoreCodec {
+    namespace {
+        constexpr size_t MAX_STRING_SIZE = 4096;
+        constexpr uint64_t MAX_BATCH_SIZE = 4096;
+        constexpr uint64_t MAX_COINS = 64;
+        constexpr uint64_t MAX_TIMELINE_SIZE = 8192;
+        constexpr uint64_t MAX_LEVELS = 256;
+
+        constexpr uint8_t FLAG_PASSED = 1;
+        constexpr uint8_t FLAG_PRACTICE = 2;
+        constexpr uint8_t FLAG_TIMELINE = 4;
+
+        uint64_t zigzag(int64_t value) {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        int64_t unzigzag(uint64_t value) {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        void writeJsonString(std::string& out, const std::string& value) {
+            static const char* hex = "0123456789abcdef";
+            out += '"';
+            for (char ch : value) {
+                auto c = static_cast<unsigned char>(ch);
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (c < 0x20) {
+                            out += "\\u00";
+                            out += hex[c >> 4];
+                            out += hex[c & 0xf];
+                        } else {
+                            out += ch;
+                        }
+                }
+            }
+            out += '"';
+        }
+    }
+
+    void writeVarUint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void writeVarInt(std::vector<uint8_t>& out, int64_t value) {
+        writeVarUint(out, zigzag(value));
+    }
+
+    void writeString(std::vector<uint8_t>& out, const std::string& value) {
+        writeVarUint(out, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    bool readVarUint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value) {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= size) return false;
+            uint8_t byte = data[pos++];
+            result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                value = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool readVarInt(const uint8_t* data, size_t size, size_t& pos, int64_t& value) {
+        uint64_t raw;
+        if (!readVarUint(data, size, pos, raw)) return false;
+        value = unzigzag(raw);
+        return true;
+    }
+
+    bool readString(const uint8_t* data, size_t size, size_t& pos, std::string& value) {
+        uint64_t length;
+        if (!readVarUint(data, size, pos, length) || length > MAX_STRING_SIZE || length > size - pos) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(data + pos), static_cast<size_t>(length));
+        pos += static_cast<size_t>(length);
+        return true;
+    }
+
+    void encodeHeader(std::vector<uint8_t>& out, const SessionHeader& header, size_t count) {
+        out.push_back('Y');
+        out.push_back('K');
+        out.push_back(VERSION);
+        writeString(out, header.authToken);
+        writeVarInt(out, header.gdAccountId);
+        writeString(out, header.gdUsername);
+        writeString(out, header.installId);
+        writeVarUint(out, count);
+    }
+
+    void encodeScore(std::vector<uint8_t>& out, const ScoreData& score) {
+        writeVarUint(out, score.seq);
+        writeVarUint(out, static_cast<uint64_t>(std::max<int64_t>(score.playedAt, 0)));
+        writeVarInt(out, score.levelId);
+        writeVarUint(out, static_cast<uint64_t>(score.percentage));
+        writeVarUint(out, static_cast<uint64_t>(score.attempts));
+        bool hasTimeline = !score.timeline.empty() && score.timeline.size() <= MAX_TIMELINE_SIZE;
+        out.push_back(static_cast<uint8_t>((score.passed ? FLAG_PASSED : 0) |
+                                           (score.isPractice ? FLAG_PRACTICE : 0) |
+                                           (hasTimeline ? FLAG_TIMELINE : 0)));
+
+        uint64_t coinMask = 0;
+        size_t coinCount = std::min<size_t>(score.coinsCollected.size(), MAX_COINS);
+        for (size_t i = 0; i < coinCount; i++) {
+            if (score.coinsCollected[i]) coinMask |= uint64_t(1) << i;
+        }
+        writeVarUint(out, coinCount);
+        writeVarUint(out, coinMask);
+
+        if (hasTimeline) {
+            writeVarUint(out, score.timeline.size());
+            out.insert(out.end(), score.timeline.begin(), score.timeline.end());
+        }
+    }
+
+    void encodeLevels(std::vector<uint8_t>& out, const std::vector<LevelMeta>& levels) {
+        size_t count = std::min<size_t>(levels.size(), MAX_LEVELS);
+        writeVarUint(out, count);
+        for (size_t i = 0; i < count; i++) {
+            const auto& level = levels[i];
+            writeVarInt(out, level.levelId);
+            writeString(out, level.name);
+            writeString(out, level.creator);
+            writeString(out, level.description.size() <= MAX_STRING_SIZE ? level.description : std::string());
+            writeVarInt(out, level.difficulty);
+            writeVarInt(out, level.stars);
+            out.push_back(level.isDemon ? 1 : 0);
+            writeVarInt(out, level.demonDifficulty);
+            writeVarInt(out, level.audioTrack);
+            writeVarInt(out, level.songId);
+            writeString(out, level.songName);
+            writeString(out, level.songAuthor);
+            writeVarInt(out, level.length);
+            writeVarInt(out, level.downloads);
+            writeVarInt(out, level.likes);
+        }
+    }
+
+    std::vector<uint8_t> encodeBatch(const SessionHeader& header, const std::vector<ScoreData>& scores,
+                                     const std::vector<LevelMeta>& levels) {
+        std::vector<uint8_t> out;
+        size_t extraBytes = levels.size() * 64;
+        for (const auto& score : scores) extraBytes += score.timeline.size();
+        out.reserve(24 + header.authToken.size() + header.gdUsername.size() + header.installId.size() +
+                    scores.size() * 16 + extraBytes);
+        encodeHeader(out, header, scores.size());
+        for (const auto& score : scores) {
+            encodeScore(out, score);
+        }
+        encodeLevels(out, levels);
+        return out;
+    }
+
+    bool decodeBatch(const std::vector<uint8_t>& data, SessionHeader& header, std::vector<ScoreData>& scores) {
+        std::vector<LevelMeta> levels;
+        return decodeBatch(data, header, scores, levels);
+    }
+
+    bool decodeBatch(const std::vector<uint8_t>& data, SessionHeader& header, std::vector<ScoreData>& scores,
+                     std::vector<LevelMeta>& levels) {
+        const uint8_t* p = data.data();
+        size_t size = data.size();
+        size_t pos = 3;
+
+        if (size < 3 || p[0] != 'Y' || p[1] != 'K' || p[2] == 0 || p[2] > VERSION) return false;
+        uint8_t version = p[2];
+
+        int64_t accountId;
+        uint64_t count;
+        header.installId.clear();
+        if (!readString(p, size, pos, header.authToken) || !readVarInt(p, size, pos, accountId) ||
+            !readString(p, size, pos, header.gdUsername) ||
+            (version >= 4 && !readString(p, size, pos, header.installId)) ||
+            !readVarUint(p, size, pos, count) || count > MAX_BATCH_SIZE) {
+            return false;
+        }
+        header.gdAccountId = static_cast<int>(accountId);
+
+        scores.clear();
+        scores.reserve(static_cast<size_t>(count));
+        for (uint64_t i = 0; i < count; i++) {
+            ScoreData score{};
+            int64_t levelId;
+            uint64_t percentage, attempts, coinCount, coinMask, playedAt = 0;
+            if ((version >= 4 && !readVarUint(p, size, pos, score.seq)) ||
+                (version >= 5 && !readVarUint(p, size, pos, playedAt)) || !readVarInt(p, size, pos, levelId) ||
+                !readVarUint(p, size, pos, percentage) || !readVarUint(p, size, pos, attempts) || pos >= size) {
+                return false;
+            }
+            score.playedAt = static_cast<int64_t>(playedAt);
+            uint8_t flags = p[pos++];
+            if (!readVarUint(p, size, pos, coinCount) || coinCount > MAX_COINS ||
+                !readVarUint(p, size, pos, coinMask)) {
+                return false;
+            }
+
+            score.levelId = static_cast<int>(levelId);
+            score.percentage = static_cast<int>(percentage);
+            score.attempts = static_cast<int>(attempts);
+            score.passed = (flags & FLAG_PASSED) != 0;
+            score.isPractice = (flags & FLAG_PRACTICE) != 0;
+            score.coinsCollected.resize(static_cast<size_t>(coinCount));
+            for (size_t c = 0; c < coinCount; c++) {
+                score.coinsCollected[c] = (coinMask >> c) & 1;
+            }
+
+            if (flags & FLAG_TIMELINE) {
+                uint64_t timelineSize;
+                if (!readVarUint(p, size, pos, timelineSize) || timelineSize > MAX_TIMELINE_SIZE ||
+                    timelineSize > size - pos) {
+                    return false;
+                }
+                score.timeline.assign(p + pos, p + pos + timelineSize);
+                pos += static_cast<size_t>(timelineSize);
+            }
+            scores.push_back(std::move(score));
+        }
+
+        levels.clear();
+        if (version >= 3) {
+            uint64_t levelCount;
+            if (!readVarUint(p, size, pos, levelCount) || levelCount > MAX_LEVELS) return false;
+
+            levels.reserve(static_cast<size_t>(levelCount));
+            for (uint64_t i = 0; i < levelCount; i++) {
+                LevelMeta level;
+                int64_t levelId, difficulty, stars, demonDifficulty, audioTrack, songId, length, downloads, likes;
+                if (!readVarInt(p, size, pos, levelId) || !readString(p, size, pos, level.name) ||
+                    !readString(p, size, pos, level.creator) || !readString(p, size, pos, level.description) ||
+                    !readVarInt(p, size, pos, difficulty) || !readVarInt(p, size, pos, stars) || pos >= size) {
+                    return false;
+                }
+                level.isDemon = (p[pos++] & 1) != 0;
+                if (!readVarInt(p, size, pos, demonDifficulty) || !readVarInt(p, size, pos, audioTrack) ||
+                    !readVarInt(p, size, pos, songId) || !readString(p, size, pos, level.songName) ||
+                    !readString(p, size, pos, level.songAuthor) || !readVarInt(p, size, pos, length) ||
+                    !readVarInt(p, size, pos, downloads) || !readVarInt(p, size, pos, likes)) {
+                    return false;
+                }
+
+                level.levelId = static_cast<int>(levelId);
+                level.difficulty = static_cast<int>(difficulty);
+                level.stars = static_cast<int>(stars);
+                level.demonDifficulty = static_cast<int>(demonDifficulty);
+                level.audioTrack = static_cast<int>(audioTrack);
+                level.songId = static_cast<int>(songId);
+                level.length = static_cast<int>(length);
+                level.downloads = static_cast<int>(downloads);
+                level.likes = static_cast<int>(likes);
+                levels.push_back(std::move(level));
+            }
+        }
+        return pos == size;
+    }
+
+    std::string base64Encode(const std::vector<uint8_t>& data) {
+        static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string out;
+        out.reserve((data.size() + 2) / 3 * 4);
+        for (size_t i = 0; i < data.size(); i += 3) {
+            uint32_t chunk = uint32_t(data[i]) << 16;
+            if (i + 1 < data.size()) chunk |= uint32_t(data[i + 1]) << 8;
+            if (i + 2 < data.size()) chunk |= data[i + 2];
+
+            out += alphabet[(chunk >> 18) & 63];
+            out += alphabet[(chunk >> 12) & 63];
+            out += i + 1 < data.size() ? alphabet[(chunk >> 6) & 63] : '=';
+            out += i + 2 < data.size() ? alphabet[chunk & 63] : '=';
+        }
+        return out;
+    }
+
+    std::string encodeBatchJson(const SessionHeader& header, const std::vector<ScoreData>& scores,
+                                const std::vector<LevelMeta>& levels) {
+        std::string out;
+        out.reserve(96 + header.authToken.size() + header.gdUsername.size() + scores.size() * 128);
+
+        out += "{\"auth_token\":";
+        writeJsonString(out, header.authToken);
+        out += ",\"gd_account_id\":";
+        out += std::to_string(header.gdAccountId);
+        out += ",\"gd_username\":";
+        writeJsonString(out, header.gdUsername);
+        if (!header.installId.empty()) {
+            out += ",\"install_id\":";
+            writeJsonString(out, header.installId);
+        }
+        out += ",\"scores\":[";
+
+        for (size_t i = 0; i < scores.size(); i++) {
+            const auto& score = scores[i];
+            if (i > 0) out += ',';
+
+            out += "{\"level_id\":";
+            out += std::to_string(score.levelId);
+            if (score.seq) {
+                out += ",\"seq\":";
+                out += std::to_string(score.seq);
+            }
+            if (score.playedAt > 0) {
+                out += ",\"played_at\":";
+                out += std::to_string(score.playedAt);
+            }
+            out += ",\"percentage\":";
+            out += std::to_string(score.percentage);
+            out += ",\"attempts\":";
+            out += std::to_string(score.attempts);
+            out += ",\"passed\":";
+            out += score.passed ? "true" : "false";
+            out += ",\"is_practice\":";
+            out += score.isPractice ? "true" : "false";
+            out += ",\"coins_collected\":[";
+            for (size_t c = 0; c < score.coinsCollected.size(); c++) {
+                if (c > 0) out += ',';
+                out += score.coinsCollected[c] ? "true" : "false";
+            }
+            out += ']';
+            if (!score.timeline.empty()) {
+                out += ",\"timeline\":\"";
+                out += base64Encode(score.timeline);
+                out += '"';
+            }
+            out += '}';
+        }
+        out += ']';
+
+        if (!levels.empty()) {
+            out += ",\"levels\":[";
+            for (size_t i = 0; i < levels.size(); i++) {
+                const auto& level = levels[i];
+                if (i > 0) out += ',';
+
+                out += "{\"level_id\":" + std::to_string(level.levelId);
+                out += ",\"name\":";
+                writeJsonString(out, level.name);
+                out += ",\"creator\":";
+                writeJsonString(out, level.creator);
+                out += ",\"description\":";
+                writeJsonString(out, level.description);
+                out += ",\"difficulty\":" + std::to_string(level.difficulty);
+                out += ",\"stars\":" + std::to_string(level.stars);
+                out += ",\"is_demon\":";
+                out += level.isDemon ? "true" : "false";
+                out += ",\"demon_difficulty\":" + std::to_string(level.demonDifficulty);
+                out += ",\"audio_track\":" + std::to_string(level.audioTrack);
+                out += ",\"song_id\":" + std::to_string(level.songId);
+                out += ",\"song_name\":";
+                writeJsonString(out, level.songName);
+                out += ",\"song_author\":";
+                writeJsonString(out, level.songAuthor);
+                out += ",\"length\":" + std::to_string(level.length);
+                out += ",\"downloads\":" + std::to_string(level.downloads);
+                out += ",\"likes\":" + std::to_string(level.likes);
+                out += '}';
+            }
+            out += ']';
+        }
+
+        out += '}';
+        return out;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "LevelMeta.hpp"
+#include "ScoreData.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compact binary encoding for score batches (Content-Type: application/x-yuki-scores).
+//
+//   "YK" | version u8 | session header | varint count | score... | varint levels | level...
+//
+// The session header carries the identity fields once per batch instead of once per
+// score. Integers are LEB128 varints (signed ones zigzagged) and coins are packed
+// into a bitmask. Version 2 added an optional attempt timeline after the coins,
+// signalled by flag bit 2. Version 3 appended metadata for levels the server hasn't
+// been told about yet. Version 4 added the install ID to the header and each score's
+// outbox sequence number in front of it, so the server can drop resent scores.
+// Version 5 added when each score was played, after its sequence number.
+// server/src/lib/scoreCodec.ts holds the matching decoder.
+namespace ScoreCodec {
+    constexpr uint8_t VERSION = 5;
+    constexpr const char* CONTENT_TYPE = "application/x-yuki-scores";
+
+    struct SessionHeader {
+        std::string authToken;
+        int gdAccountId = 0;
+        std::string gdUsername;
+        // ScoreOutbox::installId() as 16 hex digits, empty if unknown
+        std::string installId;
+    };
+
+    void writeVarUint(std::vector<uint8_t>& out, uint64_t value);
+    void writeVarInt(std::vector<uint8_t>& out, int64_t value);
+    void writeString(std::vector<uint8_t>& out, const std::string& value);
+
+    // Returns false on truncated or oversized input, advancing `pos` on success
+    bool readVarUint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value);
+    bool readVarInt(const uint8_t* data, size_t size, size_t& pos, int64_t& value);
+    bool readString(const uint8_t* data, size_t size, size_t& pos, std::string& value);
+
+    // A batch is encodeHeader, `count` encodeScore calls, then encodeLevels
+    void encodeHeader(std::vector<uint8_t>& out, const SessionHeader& header, size_t count);
+    void encodeScore(std::vector<uint8_t>& out, const ScoreData& score);
+    void encodeLevels(std::vector<uint8_t>& out, const std::vector<LevelMeta>& levels);
+
+    std::vector<uint8_t> encodeBatch(const SessionHeader& header, const std::vector<ScoreData>& scores,
+                                     const std::vector<LevelMeta>& levels = {});
+    bool decodeBatch(const std::vector<uint8_t>& data, SessionHeader& header, std::vector<ScoreData>& scores);
+    bool decodeBatch(const std::vector<uint8_t>& data, SessionHeader& header, std::vector<ScoreData>& scores,
+                     std::vector<LevelMeta>& levels);
+
+    std::string base64Encode(const std::vector<uint8_t>& data);
+
+    // Same batch as the JSON body of POST /api/scores/batch, for servers without the binary route
+    std::string encodeBatchJson(const SessionHeader& header, const std::vector<ScoreData>& scores,
+                                const std::vector<LevelMeta>& levels = {});
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ScoreData {
+    int levelId;
+    std::string levelName;
+    std::string levelCreator;
+    int percentage;
+    int attempts;
+    bool passed;
+    bool isPractice;
+    std::vector<bool> coinsCollected;
+    // AttemptTimeline::encode() output, empty for most scores
+    std::vector<uint8_t> timeline;
+    // Outbox sequence number, set when the score is read back for delivery.
+    // With the outbox's install ID it makes resends idempotent.
+    uint64_t seq = 0;
+    // Unix milliseconds, set when the score is submitted. With the level ID it's
+    // the key history sync matches local and server scores by.
+    int64_t playedAt = 0;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ScoreData.hpp"
+#include <cstdint>
+#include <type_traits>
+
+// Fixed-size version of ScoreData that the game thread hands to the submit worker.
+// Level strings are interned up front (see StringTable) and coins are a bitmask,
+// so building one never allocates.
+struct ScoreEvent {
+    int levelId;
+    uint32_t levelNameId;
+    uint32_t levelCreatorId;
+    int percentage;
+    int attempts;
+    bool passed;
+    bool isPractice;
+    uint8_t coinCount;
+    uint64_t coinMask;
+    // Set by SubmitWorker::push when a copy of the attempt's timeline rides along
+    bool hasTimeline;
+};
+
+static_assert(std::is_trivially_copyable_v<ScoreEvent>);
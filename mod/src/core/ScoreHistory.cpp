@@ -0,0 +1,392 @@
+#include "ScoreHistory.hpp"
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+namespace {
+    constexpr char LOG_MAGIC[4] = {'Y', 'H', 'S', 'T'};
+    constexpr char INDEX_MAGIC[4] = {'Y', 'H', 'I', 'X'};
+    constexpr uint32_t VERSION = 1;
+    constexpr size_t HEADER_SIZE = 32;
+    constexpr size_t INITIAL_RECORDS = 1024;
+    constexpr uint32_t INITIAL_SLOTS = 256;
+
+    // Header fields, both files: magic | version u32 | ... | count u64 at 16
+    constexpr size_t LOG_RECORD_SIZE_OFFSET = 8;
+    constexpr size_t LOG_COUNT_OFFSET = 16;
+    constexpr size_t INDEX_CAPACITY_OFFSET = 8;
+    constexpr size_t INDEX_USED_OFFSET = 12;
+    constexpr size_t INDEX_INDEXED_OFFSET = 16;
+    constexpr size_t INDEX_REBUILDING_OFFSET = 24;
+
+    constexpr uint32_t RECORD_PASSED = 1;
+    constexpr uint32_t RECORD_PRACTICE = 2;
+    constexpr uint32_t SLOT_COMPLETED = 1;
+    // A record older than the newest one came in (history sync), totalAttempts
+    // is recounted from the level's records on the next lookup
+    constexpr uint32_t SLOT_ATTEMPTS_STALE = 2;
+
+    struct RecordData {
+        int32_t levelId;
+        int32_t percentage;
+        int32_t attempts;
+        uint32_t flags;
+        uint64_t coinMask;
+        int64_t playedAt;
+        // Index of the level's previous record, -1 for its first
+        int32_t previous;
+        uint32_t coinCount;
+    };
+    static_assert(sizeof(RecordData) == 40);
+
+    template <typename T>
+    T load(const uint8_t* base, size_t offset) {
+        T value;
+        std::memcpy(&value, base + offset, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void store(uint8_t* base, size_t offset, const T& value) {
+        std::memcpy(base + offset, &value, sizeof(T));
+    }
+
+    size_t recordOffset(uint64_t index) {
+        return HEADER_SIZE + static_cast<size_t>(index) * sizeof(RecordData);
+    }
+
+    struct Slot {
+        int32_t levelId; // 0 marks an empty slot
+        int32_t bestPercentage;
+        uint64_t totalAttempts;
+        int64_t lastPlayed;
+        int32_t lastRecord;
+        uint32_t recordCount;
+        // Attempt count of the most recently played record, to tell a new session
+        // from the same one
+        int32_t lastAttempts;
+        uint32_t flags;
+        char name[48];
+    };
+    static_assert(sizeof(Slot) == 88);
+
+    size_t slotOffset(size_t index) {
+        return HEADER_SIZE + index * sizeof(Slot);
+    }
+
+    Slot readSlot(const MappedFile& index, size_t slot) {
+        return load<Slot>(index.data(), slotOffset(slot));
+    }
+
+    void writeSlot(MappedFile& index, size_t slot, const Slot& value) {
+        store(index.data(), slotOffset(slot), value);
+    }
+}
+
+ScoreHistory::ScoreHistory(std::filesystem::path directory) : m_directory(std::move(directory)) {}
+
+uint64_t ScoreHistory::storedCount() const {
+    return load<uint64_t>(m_log.data(), LOG_COUNT_OFFSET);
+}
+
+uint64_t ScoreHistory::indexedCount() const {
+    return load<uint64_t>(m_index.data(), INDEX_INDEXED_OFFSET);
+}
+
+uint32_t ScoreHistory::indexCapacity() const {
+    return load<uint32_t>(m_index.data(), INDEX_CAPACITY_OFFSET);
+}
+
+HistoryRecord ScoreHistory::readRecord(uint64_t index, int32_t* previous) const {
+    auto data = load<RecordData>(m_log.data(), recordOffset(index));
+
+    HistoryRecord record;
+    record.levelId = data.levelId;
+    record.percentage = data.percentage;
+    record.attempts = data.attempts;
+    record.passed = (data.flags & RECORD_PASSED) != 0;
+    record.isPractice = (data.flags & RECORD_PRACTICE) != 0;
+    record.coinCount = static_cast<int>(data.coinCount);
+    record.coinMask = data.coinMask;
+    record.playedAt = data.playedAt;
+    if (previous) *previous = data.previous;
+    return record;
+}
+
+bool ScoreHistory::ensureOpen() {
+    if (m_opened) return true;
+    if (m_openFailed) return false;
+    m_openFailed = true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    if (!m_log.open(m_directory / "history.log", recordOffset(INITIAL_RECORDS))) return false;
+
+    uint8_t* log = m_log.data();
+    bool valid = std::memcmp(log, LOG_MAGIC, 4) == 0 && load<uint32_t>(log, 4) == VERSION &&
+                 load<uint32_t>(log, LOG_RECORD_SIZE_OFFSET) == sizeof(RecordData);
+    if (!valid) {
+        // New or unreadable, start over
+        std::memset(log, 0, HEADER_SIZE);
+        std::memcpy(log, LOG_MAGIC, 4);
+        store<uint32_t>(log, 4, VERSION);
+        store<uint32_t>(log, LOG_RECORD_SIZE_OFFSET, sizeof(RecordData));
+    }
+
+    uint64_t capacity = (m_log.size() - HEADER_SIZE) / sizeof(RecordData);
+    if (storedCount() > capacity) {
+        store<uint64_t>(log, LOG_COUNT_OFFSET, capacity);
+    }
+
+    if (!openIndex(!valid)) return false;
+
+    m_opened = true;
+    m_openFailed = false;
+    return true;
+}
+
+bool ScoreHistory::openIndex(bool rebuild) {
+    if (!m_index.open(m_directory / "history.idx", slotOffset(INITIAL_SLOTS))) return false;
+
+    uint8_t* index = m_index.data();
+    uint32_t capacity = load<uint32_t>(index, INDEX_CAPACITY_OFFSET);
+    bool valid = std::memcmp(index, INDEX_MAGIC, 4) == 0 && load<uint32_t>(index, 4) == VERSION &&
+                 capacity >= INITIAL_SLOTS && (capacity & (capacity - 1)) == 0 &&
+                 slotOffset(capacity) <= m_index.size() &&
+                 load<uint32_t>(index, INDEX_REBUILDING_OFFSET) == 0 &&
+                 load<uint64_t>(index, INDEX_INDEXED_OFFSET) <= storedCount();
+
+    if (rebuild || !valid) {
+        // Only after a crash or corruption: rebuild from the log, which costs a full scan
+        if (!valid) capacity = INITIAL_SLOTS;
+        std::memset(index, 0, slotOffset(capacity));
+        std::memcpy(index, INDEX_MAGIC, 4);
+        store<uint32_t>(index, 4, VERSION);
+        store<uint32_t>(index, INDEX_CAPACITY_OFFSET, capacity);
+    }
+
+    // Records appended right before a crash may not have made it into the index
+    for (uint64_t i = indexedCount(); i < storedCount(); i++) {
+        if (!indexRecord(i, nullptr)) return false;
+    }
+    return true;
+}
+
+size_t ScoreHistory::findSlot(int levelId) const {
+    size_t mask = indexCapacity() - 1;
+    size_t i = (static_cast<uint32_t>(levelId) * 2654435761u) & mask;
+    for (;;) {
+        int32_t id = load<int32_t>(m_index.data(), slotOffset(i));
+        if (id == levelId || id == 0) return i;
+        i = (i + 1) & mask;
+    }
+}
+
+bool ScoreHistory::growIndex() {
+    uint32_t capacity = indexCapacity();
+    std::vector<Slot> slots;
+    for (size_t i = 0; i < capacity; i++) {
+        Slot slot = readSlot(m_index, i);
+        if (slot.levelId != 0) slots.push_back(slot);
+    }
+
+    // Flag the index so a crash halfway through gets it rebuilt on the next start
+    store<uint32_t>(m_index.data(), INDEX_REBUILDING_OFFSET, 1);
+
+    uint32_t newCapacity = capacity * 2;
+    if (!m_index.resize(slotOffset(newCapacity))) return false;
+
+    std::memset(m_index.data() + HEADER_SIZE, 0, slotOffset(newCapacity) - HEADER_SIZE);
+    store<uint32_t>(m_index.data(), INDEX_CAPACITY_OFFSET, newCapacity);
+    for (const auto& slot : slots) {
+        writeSlot(m_index, findSlot(slot.levelId), slot);
+    }
+
+    store<uint32_t>(m_index.data(), INDEX_REBUILDING_OFFSET, 0);
+    return true;
+}
+
+bool ScoreHistory::indexRecord(uint64_t recordIndex, const std::string* name) {
+    HistoryRecord record = readRecord(recordIndex);
+
+    if (record.levelId != 0) {
+        uint32_t used = load<uint32_t>(m_index.data(), INDEX_USED_OFFSET);
+        if ((used + 1) * 4 > indexCapacity() * 3 && !growIndex()) return false;
+
+        size_t slotIndex = findSlot(record.levelId);
+        Slot slot = readSlot(m_index, slotIndex);
+        if (slot.levelId == 0) {
+            std::memset(&slot, 0, sizeof(slot));
+            slot.levelId = record.levelId;
+            slot.lastRecord = -1;
+            store<uint32_t>(m_index.data(), INDEX_USED_OFFSET, used + 1);
+        }
+
+        // Attempt counts restart every session and only grow within one, which only
+        // tells sessions apart in the order they were played. Synced records can
+        // arrive after newer ones, those leave the count to be redone in order.
+        if (slot.recordCount > 0 && record.playedAt < slot.lastPlayed) {
+            slot.flags |= SLOT_ATTEMPTS_STALE;
+        } else if (!(slot.flags & SLOT_ATTEMPTS_STALE)) {
+            slot.totalAttempts += attemptsAdded(slot.lastAttempts, record.attempts);
+            slot.lastAttempts = record.attempts;
+        }
+
+        // Practice runs don't count towards the best
+        if (!record.isPractice) {
+            slot.bestPercentage = std::max(slot.bestPercentage, record.percentage);
+            if (record.passed) slot.flags |= SLOT_COMPLETED;
+        }
+        slot.lastPlayed = std::max(slot.lastPlayed, record.playedAt);
+        slot.lastRecord = static_cast<int32_t>(recordIndex);
+        slot.recordCount++;
+
+        if (name && !name->empty()) {
+            size_t length = std::min(name->size(), sizeof(slot.name) - 1);
+            std::memset(slot.name, 0, sizeof(slot.name));
+            std::memcpy(slot.name, name->data(), length);
+        }
+        writeSlot(m_index, slotIndex, slot);
+    }
+
+    store<uint64_t>(m_index.data(), INDEX_INDEXED_OFFSET, recordIndex + 1);
+    return true;
+}
+
+uint64_t ScoreHistory::attemptsAdded(int previous, int attempts) {
+    if (attempts > previous) return static_cast<uint64_t>(attempts - previous);
+    // A new session
+    return attempts > 0 ? static_cast<uint64_t>(attempts) : 0;
+}
+
+void ScoreHistory::recountAttempts(size_t slotIndex) {
+    Slot slot = readSlot(m_index, slotIndex);
+
+    std::vector<std::pair<int64_t, int>> played;
+    played.reserve(slot.recordCount);
+    int32_t index = slot.lastRecord;
+    uint64_t count = storedCount();
+    while (index >= 0 && static_cast<uint64_t>(index) < count) {
+        int32_t previous;
+        HistoryRecord record = readRecord(static_cast<uint64_t>(index), &previous);
+        played.emplace_back(record.playedAt, record.attempts);
+        if (previous >= index) break;
+        index = previous;
+    }
+    std::sort(played.begin(), played.end());
+
+    slot.totalAttempts = 0;
+    slot.lastAttempts = 0;
+    for (const auto& [playedAt, attempts] : played) {
+        slot.totalAttempts += attemptsAdded(slot.lastAttempts, attempts);
+        slot.lastAttempts = attempts;
+    }
+    slot.flags &= ~SLOT_ATTEMPTS_STALE;
+    writeSlot(m_index, slotIndex, slot);
+}
+
+bool ScoreHistory::append(const ScoreData& score, int64_t playedAt) {
+    std::lock_guard lock(m_mutex);
+    if (score.levelId == 0 || !ensureOpen()) return false;
+
+    uint64_t count = storedCount();
+    if (count >= INT32_MAX) return false;
+
+    size_t needed = recordOffset(count + 1);
+    if (needed > m_log.size() && !m_log.resize(std::max(needed, m_log.size() * 2))) return false;
+
+    size_t slotIndex = findSlot(score.levelId);
+    Slot slot = readSlot(m_index, slotIndex);
+
+    RecordData data{};
+    data.levelId = score.levelId;
+    data.percentage = score.percentage;
+    data.attempts = score.attempts;
+    data.flags = (score.passed ? RECORD_PASSED : 0) | (score.isPractice ? RECORD_PRACTICE : 0);
+    data.coinCount = static_cast<uint32_t>(std::min<size_t>(score.coinsCollected.size(), 64));
+    for (uint32_t i = 0; i < data.coinCount; i++) {
+        if (score.coinsCollected[i]) data.coinMask |= uint64_t(1) << i;
+    }
+    data.playedAt = playedAt;
+    data.previous = slot.levelId == score.levelId ? slot.lastRecord : -1;
+
+    // The record first, then the count that makes it visible
+    store(m_log.data(), recordOffset(count), data);
+    store<uint64_t>(m_log.data(), LOG_COUNT_OFFSET, count + 1);
+
+    return indexRecord(count, &score.levelName);
+}
+
+bool ScoreHistory::level(int levelId, LevelHistory& out) {
+    std::lock_guard lock(m_mutex);
+    if (levelId == 0 || !ensureOpen()) return false;
+
+    size_t slotIndex = findSlot(levelId);
+    Slot slot = readSlot(m_index, slotIndex);
+    if (slot.levelId != levelId) return false;
+    if (slot.flags & SLOT_ATTEMPTS_STALE) {
+        recountAttempts(slotIndex);
+        slot = readSlot(m_index, slotIndex);
+    }
+
+    out.levelId = slot.levelId;
+    out.name.assign(slot.name, std::find(slot.name, slot.name + sizeof(slot.name), '\0'));
+    out.bestPercentage = slot.bestPercentage;
+    out.completed = (slot.flags & SLOT_COMPLETED) != 0;
+    out.totalAttempts = slot.totalAttempts;
+    out.lastPlayed = slot.lastPlayed;
+    out.recordCount = slot.recordCount;
+    return true;
+}
+
+std::vector<HistoryRecord> ScoreHistory::recent(size_t maxCount) {
+    std::lock_guard lock(m_mutex);
+    std::vector<HistoryRecord> records;
+    if (!ensureOpen()) return records;
+
+    uint64_t count = storedCount();
+    for (uint64_t i = count; i > 0 && records.size() < maxCount; i--) {
+        records.push_back(readRecord(i - 1));
+    }
+    return records;
+}
+
+std::vector<HistoryRecord> ScoreHistory::levelRecords(int levelId, size_t maxCount) {
+    std::lock_guard lock(m_mutex);
+    std::vector<HistoryRecord> records;
+    if (levelId == 0 || !ensureOpen()) return records;
+
+    Slot slot = readSlot(m_index, findSlot(levelId));
+    if (slot.levelId != levelId) return records;
+
+    int32_t index = slot.lastRecord;
+    uint64_t count = storedCount();
+    while (index >= 0 && static_cast<uint64_t>(index) < count && records.size() < maxCount) {
+        int32_t previous;
+        records.push_back(readRecord(static_cast<uint64_t>(index), &previous));
+        // Links only ever point backwards, anything else is corruption
+        if (previous >= index) break;
+        index = previous;
+    }
+    return records;
+}
+
+std::vector<HistoryRecord> ScoreHistory::recordsSince(int64_t playedAt) {
+    std::lock_guard lock(m_mutex);
+    std::vector<HistoryRecord> records;
+    if (!ensureOpen()) return records;
+
+    uint64_t count = storedCount();
+    for (uint64_t i = 0; i < count; i++) {
+        HistoryRecord record = readRecord(i);
+        if (record.playedAt >= playedAt) records.push_back(record);
+    }
+    return records;
+}
+
+size_t ScoreHistory::recordCount() {
+    std::lock_guard lock(m_mutex);
+    return ensureOpen() ? static_cast<size_t>(storedCount()) : 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "ScoreData.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct HistoryRecord {
+    int levelId = 0;
+    int percentage = 0;
+    int attempts = 0;
+    bool passed = false;
+    bool isPractice = false;
+    int coinCount = 0;
+    uint64_t coinMask = 0;
+    // Unix milliseconds
+    int64_t playedAt = 0;
+};
+
+struct LevelHistory {
+    int levelId = 0;
+    std::string name;
+    int bestPercentage = 0;
+    bool completed = false;
+    uint64_t totalAttempts = 0;
+    int64_t lastPlayed = 0;
+    uint32_t recordCount = 0;
+};
+
+// Every score this device submitted, for showing history in game without asking
+// the server.
+//
+// `history.log` is an append-only array of fixed-size records, so record N sits
+// at a known offset and each record links to the previous one of its level.
+// `history.idx` is an open-addressing hash table of per-level summaries (best %,
+// attempts, last played, newest record). Both are memory mapped and only mapped
+// on first use, so opening costs the same with ten records or a hundred thousand,
+// and a level lookup touches a single slot.
+class ScoreHistory {
+public:
+    explicit ScoreHistory(std::filesystem::path directory);
+
+    ScoreHistory(const ScoreHistory&) = delete;
+    ScoreHistory& operator=(const ScoreHistory&) = delete;
+
+    bool append(const ScoreData& score, int64_t playedAt);
+
+    bool level(int levelId, LevelHistory& out);
+    // Newest first
+    std::vector<HistoryRecord> recent(size_t maxCount);
+    std::vector<HistoryRecord> levelRecords(int levelId, size_t maxCount);
+    // Every record played at or after `playedAt`, in the order they were recorded
+    std::vector<HistoryRecord> recordsSince(int64_t playedAt);
+    size_t recordCount();
+
+private:
+    bool ensureOpen();
+    bool openIndex(bool rebuild);
+    bool indexRecord(uint64_t recordIndex, const std::string* name);
+    bool growIndex();
+    // Walks the level's records in the order they were played, one slot's worth
+    void recountAttempts(size_t slotIndex);
+    static uint64_t attemptsAdded(int previous, int attempts);
+    size_t findSlot(int levelId) const;
+
+    uint64_t storedCount() const;
+    uint64_t indexedCount() const;
+    HistoryRecord readRecord(uint64_t index, int32_t* previous = nullptr) const;
+    uint32_t indexCapacity() const;
+
+    std::mutex m_mutex;
+    std::filesystem::path m_directory;
+    bool m_opened = false;
+    bool m_openFailed = false;
+    MappedFile m_log;
+    MappedFile m_index;
+};
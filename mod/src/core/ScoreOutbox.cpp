@@ -0,0 +1,577 @@
+#include "ScoreOutbox.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char LOG_MAGIC[4] = {'Y', 'O', 'B', 'X'};
+    constexpr uint32_t LOG_VERSION = 1;
+    constexpr uint64_t HEADER_SIZE = 8;
+    constexpr uint64_t FRAME_OVERHEAD = 12; // len + crc + trailing len
+    constexpr uint32_t MAX_PAYLOAD_SIZE = 64 * 1024;
+    constexpr uint64_t COMPACT_THRESHOLD = 256 * 1024;
+
+    uint32_t crc32(const uint8_t* data, size_t size) {
+        static const auto table = [] {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    void putU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    }
+
+    void putU64(std::vector<uint8_t>& out, uint64_t v) {
+        for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    }
+
+    void putString(std::vector<uint8_t>& out, const std::string& s) {
+        putU32(out, static_cast<uint32_t>(s.size()));
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    uint32_t getU32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    uint64_t getU64(const uint8_t* p) {
+        return static_cast<uint64_t>(getU32(p)) | static_cast<uint64_t>(getU32(p + 4)) << 32;
+    }
+
+    // 63 bits so it also fits a signed 64-bit column, never 0
+    uint64_t newInstallId() {
+        std::random_device device;
+        uint64_t id = static_cast<uint64_t>(device()) << 32 | device();
+        id ^= static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+        id &= 0x7FFFFFFFFFFFFFFFull;
+        return id ? id : 1;
+    }
+
+    class Reader {
+    public:
+        explicit Reader(const std::vector<uint8_t>& data) : m_data(data) {}
+
+        bool u32(uint32_t& v) {
+            if (m_pos + 4 > m_data.size()) return false;
+            v = getU32(m_data.data() + m_pos);
+            m_pos += 4;
+            return true;
+        }
+
+        bool u64(uint64_t& v) {
+            if (m_pos + 8 > m_data.size()) return false;
+            v = getU64(m_data.data() + m_pos);
+            m_pos += 8;
+            return true;
+        }
+
+        bool i32(int& v) {
+            uint32_t raw;
+            if (!u32(raw)) return false;
+            v = static_cast<int>(raw);
+            return true;
+        }
+
+        bool string(std::string& s) {
+            uint32_t size;
+            if (!u32(size) || m_pos + size > m_data.size()) return false;
+            s.assign(reinterpret_cast<const char*>(m_data.data() + m_pos), size);
+            m_pos += size;
+            return true;
+        }
+
+        bool done() const { return m_pos == m_data.size(); }
+
+        bool bytes(size_t count, const uint8_t*& out) {
+            if (m_pos + count > m_data.size()) return false;
+            out = m_data.data() + m_pos;
+            m_pos += count;
+            return true;
+        }
+
+    private:
+        const std::vector<uint8_t>& m_data;
+        size_t m_pos = 0;
+    };
+
+    std::vector<uint8_t> encodeEntry(uint64_t seq, const ScoreData& score) {
+        std::vector<uint8_t> out;
+        out.reserve(64 + score.levelName.size() + score.levelCreator.size() + score.timeline.size());
+        putU64(out, seq);
+        putU32(out, static_cast<uint32_t>(score.levelId));
+        putString(out, score.levelName);
+        putString(out, score.levelCreator);
+        putU32(out, static_cast<uint32_t>(score.percentage));
+        putU32(out, static_cast<uint32_t>(score.attempts));
+        out.push_back(static_cast<uint8_t>((score.passed ? 1 : 0) | (score.isPractice ? 2 : 0)));
+        putU32(out, static_cast<uint32_t>(score.coinsCollected.size()));
+        for (size_t i = 0; i < score.coinsCollected.size(); i += 8) {
+            uint8_t bits = 0;
+            for (size_t b = 0; b < 8 && i + b < score.coinsCollected.size(); b++) {
+                if (score.coinsCollected[i + b]) bits |= static_cast<uint8_t>(1 << b);
+            }
+            out.push_back(bits);
+        }
+        // Optional trailing fields, absent in records written before they existed.
+        // The timeline goes out empty when only the time follows it.
+        if (!score.timeline.empty() || score.playedAt != 0) {
+            putU32(out, static_cast<uint32_t>(score.timeline.size()));
+            out.insert(out.end(), score.timeline.begin(), score.timeline.end());
+        }
+        if (score.playedAt != 0) {
+            putU64(out, static_cast<uint64_t>(score.playedAt));
+        }
+        return out;
+    }
+
+    bool decodeEntry(const std::vector<uint8_t>& payload, OutboxEntry& entry) {
+        Reader r(payload);
+        const uint8_t* flags;
+        uint32_t coinCount;
+        const uint8_t* coinBits;
+        ScoreData& s = entry.score;
+
+        if (!r.u64(entry.seq) || !r.i32(s.levelId) || !r.string(s.levelName) ||
+            !r.string(s.levelCreator) || !r.i32(s.percentage) || !r.i32(s.attempts) ||
+            !r.bytes(1, flags) || !r.u32(coinCount) || coinCount > 64 ||
+            !r.bytes((coinCount + 7) / 8, coinBits)) {
+            return false;
+        }
+
+        s.passed = (flags[0] & 1) != 0;
+        s.isPractice = (flags[0] & 2) != 0;
+        s.coinsCollected.resize(coinCount);
+        for (uint32_t i = 0; i < coinCount; i++) {
+            s.coinsCollected[i] = (coinBits[i / 8] >> (i % 8)) & 1;
+        }
+
+        s.timeline.clear();
+        if (!r.done()) {
+            uint32_t timelineSize;
+            const uint8_t* timeline;
+            if (!r.u32(timelineSize) || !r.bytes(timelineSize, timeline)) return false;
+            s.timeline.assign(timeline, timeline + timelineSize);
+        }
+        s.playedAt = 0;
+        if (!r.done()) {
+            uint64_t playedAt;
+            if (!r.u64(playedAt)) return false;
+            s.playedAt = static_cast<int64_t>(playedAt);
+        }
+        return true;
+    }
+
+    bool syncFile(std::FILE* file) {
+        if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    bool seek(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+        return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+}
+
+ScoreOutbox::ScoreOutbox(std::filesystem::path directory)
+    : m_logPath(directory / "outbox.log"), m_cursorPath(directory / "outbox.cursor") {}
+
+ScoreOutbox::~ScoreOutbox() {
+    if (m_file) std::fclose(m_file);
+}
+
+bool ScoreOutbox::open() {
+    std::lock_guard lock(m_mutex);
+    std::error_code ec;
+    std::filesystem::create_directories(m_logPath.parent_path(), ec);
+
+    if (!std::filesystem::exists(m_logPath, ec)) {
+        m_ackedSeq = 0;
+        m_nextSeq = 1;
+        m_installId = newInstallId();
+        if (!createEmptyLog()) return false;
+        return writeCursor();
+    }
+
+    // Cursor: [ackedOffset u64][ackedSeq u64][installId u64][crc u32]. Cursors from
+    // before install IDs lack the ID and are 20 bytes.
+    m_ackedOffset = HEADER_SIZE;
+    m_ackedSeq = 0;
+    m_installId = 0;
+    if (std::FILE* cursor = std::fopen(m_cursorPath.string().c_str(), "rb")) {
+        uint8_t buf[28];
+        size_t size = std::fread(buf, 1, sizeof(buf), cursor);
+        if (size == 28 && crc32(buf, 24) == getU32(buf + 24)) {
+            m_ackedOffset = getU64(buf);
+            m_ackedSeq = getU64(buf + 8);
+            m_installId = getU64(buf + 16);
+        } else if (size == 20 && crc32(buf, 16) == getU32(buf + 16)) {
+            m_ackedOffset = getU64(buf);
+            m_ackedSeq = getU64(buf + 8);
+        }
+        std::fclose(cursor);
+    }
+    // Without a cursor the numbering may restart below what the server has seen
+    if (m_installId == 0) {
+        m_installId = newInstallId();
+    }
+
+    m_file = std::fopen(m_logPath.string().c_str(), "r+b");
+    if (!m_file) return false;
+
+    char header[HEADER_SIZE];
+    uint64_t fileSize = std::filesystem::file_size(m_logPath, ec);
+    if (ec || fileSize < HEADER_SIZE || std::fread(header, 1, HEADER_SIZE, m_file) != HEADER_SIZE ||
+        std::memcmp(header, LOG_MAGIC, 4) != 0) {
+        // Unreadable log, nothing in it can be trusted. Entries past the cursor may
+        // have reached the server, so their numbers can't be handed out again.
+        std::fclose(m_file);
+        m_file = nullptr;
+        m_nextSeq = m_ackedSeq + 1;
+        m_installId = newInstallId();
+        return createEmptyLog() && writeCursor();
+    }
+
+    if (!recoverTail(fileSize)) return false;
+    if (!locateFirstPending(m_fileSize)) return false;
+
+    m_readOffset = m_ackedOffset;
+    return true;
+}
+
+bool ScoreOutbox::isOpen() const {
+    std::lock_guard lock(m_mutex);
+    return m_file != nullptr || m_reopenPending;
+}
+
+uint64_t ScoreOutbox::installId() const {
+    std::lock_guard lock(m_mutex);
+    return m_installId;
+}
+
+size_t ScoreOutbox::pendingCount() const {
+    std::lock_guard lock(m_mutex);
+    return static_cast<size_t>(m_nextSeq - 1 - m_ackedSeq);
+}
+
+size_t ScoreOutbox::inFlightCount() const {
+    std::lock_guard lock(m_mutex);
+    return m_inFlight.size();
+}
+
+bool ScoreOutbox::createEmptyLog() {
+    // Nothing is truncated when the open fails, so the current handle stays usable
+    std::FILE* file = std::fopen(m_logPath.string().c_str(), "w+b");
+    if (!file) return false;
+    if (m_file) std::fclose(m_file);
+    m_file = file;
+    m_reopenPending = false;
+
+    std::vector<uint8_t> header(LOG_MAGIC, LOG_MAGIC + 4);
+    putU32(header, LOG_VERSION);
+    if (std::fwrite(header.data(), 1, header.size(), m_file) != header.size() || !syncFile(m_file)) {
+        std::fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+
+    m_fileSize = HEADER_SIZE;
+    m_ackedOffset = HEADER_SIZE;
+    m_readOffset = HEADER_SIZE;
+    m_inFlight.clear();
+    return true;
+}
+
+bool ScoreOutbox::readRecord(uint64_t offset, std::vector<uint8_t>& payload, uint64_t& endOffset) {
+    if (offset + FRAME_OVERHEAD > m_fileSize || !seek(m_file, offset)) return false;
+
+    uint8_t frame[8];
+    if (std::fread(frame, 1, 8, m_file) != 8) return false;
+
+    uint32_t length = getU32(frame);
+    uint32_t crc = getU32(frame + 4);
+    if (length == 0 || length > MAX_PAYLOAD_SIZE || offset + FRAME_OVERHEAD + length > m_fileSize) return false;
+
+    payload.resize(length + 4);
+    if (std::fread(payload.data(), 1, payload.size(), m_file) != payload.size()) return false;
+    if (getU32(payload.data() + length) != length) return false;
+    payload.resize(length);
+    if (crc32(payload.data(), length) != crc) return false;
+
+    endOffset = offset + FRAME_OVERHEAD + length;
+    return true;
+}
+
+bool ScoreOutbox::recoverTail(uint64_t fileSize) {
+    m_fileSize = fileSize;
+    std::vector<uint8_t> payload;
+    uint64_t end = 0;
+
+    // Fast path: the trailing length points at a valid final record
+    if (fileSize >= HEADER_SIZE + FRAME_OVERHEAD && seek(m_file, fileSize - 4)) {
+        uint8_t trailer[4];
+        if (std::fread(trailer, 1, 4, m_file) == 4) {
+            uint64_t length = getU32(trailer);
+            if (length + FRAME_OVERHEAD <= fileSize - HEADER_SIZE) {
+                uint64_t start = fileSize - FRAME_OVERHEAD - length;
+                if (readRecord(start, payload, end) && end == fileSize && payload.size() >= 8) {
+                    m_nextSeq = std::max(getU64(payload.data()), m_ackedSeq) + 1;
+                    return true;
+                }
+            }
+        }
+    }
+
+    if (fileSize == HEADER_SIZE) {
+        m_nextSeq = m_ackedSeq + 1;
+        return true;
+    }
+
+    // Torn write at the tail, walk the records and cut off whatever doesn't parse
+    uint64_t offset = HEADER_SIZE;
+    uint64_t lastSeq = 0;
+    while (readRecord(offset, payload, end) && payload.size() >= 8) {
+        lastSeq = getU64(payload.data());
+        offset = end;
+    }
+
+    std::fclose(m_file);
+    m_file = nullptr;
+
+    std::error_code ec;
+    std::filesystem::resize_file(m_logPath, offset, ec);
+    if (ec) return false;
+
+    m_file = std::fopen(m_logPath.string().c_str(), "r+b");
+    if (!m_file) return false;
+
+    m_fileSize = offset;
+    m_nextSeq = std::max(lastSeq, m_ackedSeq) + 1;
+    return true;
+}
+
+bool ScoreOutbox::locateFirstPending(uint64_t fileSize) {
+    std::vector<uint8_t> payload;
+    uint64_t end = 0;
+
+    if (m_ackedOffset == fileSize && m_nextSeq == m_ackedSeq + 1) return true;
+    if (m_ackedOffset >= HEADER_SIZE && m_ackedOffset < fileSize &&
+        readRecord(m_ackedOffset, payload, end) && payload.size() >= 8 &&
+        getU64(payload.data()) == m_ackedSeq + 1) {
+        return true;
+    }
+
+    // The cursor doesn't line up with the log (e.g. crashed mid-compaction), scan for it
+    uint64_t offset = HEADER_SIZE;
+    while (readRecord(offset, payload, end) && payload.size() >= 8) {
+        if (getU64(payload.data()) > m_ackedSeq) break;
+        offset = end;
+    }
+    m_ackedOffset = offset;
+    return writeCursor();
+}
+
+bool ScoreOutbox::writeCursor() {
+    std::vector<uint8_t> buf;
+    putU64(buf, m_ackedOffset);
+    putU64(buf, m_ackedSeq);
+    putU64(buf, m_installId);
+    putU32(buf, crc32(buf.data(), buf.size()));
+
+    // Overwritten in place, it's always the same size. Truncating first would make
+    // every sync a metadata commit, which is most of the cost of an ack.
+    std::FILE* cursor = std::fopen(m_cursorPath.string().c_str(), "r+b");
+    if (!cursor) cursor = std::fopen(m_cursorPath.string().c_str(), "wb");
+    if (!cursor) return false;
+    bool ok = std::fwrite(buf.data(), 1, buf.size(), cursor) == buf.size() && syncFile(cursor);
+    std::fclose(cursor);
+    return ok;
+}
+
+uint64_t ScoreOutbox::append(const ScoreData& score) {
+    std::lock_guard lock(m_mutex);
+    if (!ensureOpen()) return 0;
+
+    uint64_t seq = m_nextSeq;
+    std::vector<uint8_t> payload = encodeEntry(seq, score);
+    if (payload.size() > MAX_PAYLOAD_SIZE) return 0;
+
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    std::vector<uint8_t> frame;
+    frame.reserve(payload.size() + FRAME_OVERHEAD);
+    putU32(frame, length);
+    putU32(frame, crc32(payload.data(), payload.size()));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    putU32(frame, length);
+
+    if (!seek(m_file, m_fileSize) || std::fwrite(frame.data(), 1, frame.size(), m_file) != frame.size() ||
+        !syncFile(m_file)) {
+        // Drop the partial frame so the next append starts on a record boundary
+        std::error_code ec;
+        recoverTail(std::filesystem::file_size(m_logPath, ec));
+        return 0;
+    }
+
+    m_fileSize += frame.size();
+    m_nextSeq++;
+    return seq;
+}
+
+std::vector<OutboxEntry> ScoreOutbox::readBatch(size_t maxCount) {
+    std::lock_guard lock(m_mutex);
+    std::vector<OutboxEntry> batch;
+    std::vector<uint8_t> payload;
+    uint64_t end = 0;
+    if (!ensureOpen()) return batch;
+
+    while (batch.size() < maxCount && m_readOffset < m_fileSize) {
+        OutboxEntry entry;
+        if (!readRecord(m_readOffset, payload, end) || !decodeEntry(payload, entry)) break;
+
+        m_inFlight.push_back({entry.seq, end});
+        m_readOffset = end;
+        entry.score.seq = entry.seq;
+        batch.push_back(std::move(entry));
+    }
+    return batch;
+}
+
+void ScoreOutbox::ack(uint64_t seq) {
+    std::lock_guard lock(m_mutex);
+    bool advanced = false;
+    while (!m_inFlight.empty() && m_inFlight.front().seq <= seq) {
+        m_ackedSeq = m_inFlight.front().seq;
+        m_ackedOffset = m_inFlight.front().endOffset;
+        m_inFlight.pop_front();
+        advanced = true;
+    }
+    if (!advanced) return;
+
+    writeCursor();
+    compactIfNeeded();
+}
+
+void ScoreOutbox::rewind() {
+    std::lock_guard lock(m_mutex);
+    m_inFlight.clear();
+    m_readOffset = m_ackedOffset;
+}
+
+void ScoreOutbox::clear() {
+    std::lock_guard lock(m_mutex);
+    m_ackedSeq = m_nextSeq - 1;
+    if (createEmptyLog()) writeCursor();
+}
+
+void ScoreOutbox::compactIfNeeded() {
+    uint64_t acked = m_ackedOffset - HEADER_SIZE;
+    if (acked == 0 || !ensureOpen()) return;
+
+    // Everything delivered: starting over is cheaper than copying
+    if (m_ackedOffset == m_fileSize) {
+        if (createEmptyLog()) writeCursor();
+        return;
+    }
+
+    if (acked < COMPACT_THRESHOLD || acked * 2 < m_fileSize) return;
+
+    std::filesystem::path tmpPath = m_logPath;
+    tmpPath += ".tmp";
+    std::FILE* tmp = std::fopen(tmpPath.string().c_str(), "wb");
+    if (!tmp) return;
+
+    std::vector<uint8_t> buf(LOG_MAGIC, LOG_MAGIC + 4);
+    putU32(buf, LOG_VERSION);
+    bool ok = std::fwrite(buf.data(), 1, buf.size(), tmp) == buf.size() && seek(m_file, m_ackedOffset);
+
+    buf.resize(64 * 1024);
+    uint64_t remaining = m_fileSize - m_ackedOffset;
+    while (ok && remaining > 0) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, buf.size()));
+        ok = std::fread(buf.data(), 1, chunk, m_file) == chunk && std::fwrite(buf.data(), 1, chunk, tmp) == chunk;
+        remaining -= chunk;
+    }
+    ok = ok && syncFile(tmp);
+    std::fclose(tmp);
+
+    std::error_code ec;
+    if (!ok) {
+        std::filesystem::remove(tmpPath, ec);
+        return;
+    }
+
+    // The current log stays open until the compacted one has replaced it, so a
+    // failed rename leaves the outbox exactly as it was
+    std::filesystem::rename(tmpPath, m_logPath, ec);
+#ifdef _WIN32
+    if (ec) {
+        // Windows won't replace a file that is still open
+        std::fclose(m_file);
+        m_file = nullptr;
+        ec.clear();
+        std::filesystem::rename(tmpPath, m_logPath, ec);
+    }
+#endif
+    if (ec) {
+        std::error_code ignored;
+        std::filesystem::remove(tmpPath, ignored);
+        // Still the old log on disk, and the offsets still describe it
+        if (!m_file) m_file = std::fopen(m_logPath.string().c_str(), "r+b");
+        m_reopenPending = !m_file;
+        return;
+    }
+
+    // From here the compacted log is the one on disk
+    uint64_t shift = m_ackedOffset - HEADER_SIZE;
+    m_fileSize -= shift;
+    m_ackedOffset = HEADER_SIZE;
+    m_readOffset -= shift;
+    for (auto& entry : m_inFlight) {
+        entry.endOffset -= shift;
+    }
+    writeCursor();
+
+    // The old handle now points at the replaced file, writing there would lose scores
+    if (m_file) std::fclose(m_file);
+    m_file = std::fopen(m_logPath.string().c_str(), "r+b");
+    m_reopenPending = !m_file;
+}
+
+bool ScoreOutbox::ensureOpen() {
+    if (m_file) return true;
+    if (!m_reopenPending) return false;
+
+    m_file = std::fopen(m_logPath.string().c_str(), "r+b");
+    m_reopenPending = !m_file;
+    return m_file != nullptr;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ScoreData.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+struct OutboxEntry {
+    uint64_t seq;
+    ScoreData score;
+};
+
+// Persistent, append-only queue of scores waiting to be delivered.
+//
+// Every score is written (and fsynced) to `outbox.log` before any network I/O
+// happens. Records are framed as [len][crc][payload][len] so the last record can
+// be located from the end of the file, which keeps open() independent of how
+// many entries are queued. Delivery progress and the install ID live in a small
+// `outbox.cursor` file, and acknowledged records are dropped by compaction.
+//
+// All public methods are thread-safe: the submit worker appends while the main
+// thread reads batches and acknowledges them.
+class ScoreOutbox {
+public:
+    explicit ScoreOutbox(std::filesystem::path directory);
+    ~ScoreOutbox();
+
+    ScoreOutbox(const ScoreOutbox&) = delete;
+    ScoreOutbox& operator=(const ScoreOutbox&) = delete;
+
+    bool open();
+    bool isOpen() const;
+
+    // Durably queues a score, returns its sequence number (0 on failure)
+    uint64_t append(const ScoreData& score);
+
+    // Hands out up to `maxCount` entries that haven't been handed out yet
+    std::vector<OutboxEntry> readBatch(size_t maxCount);
+
+    // Marks every entry up to and including `seq` as delivered
+    void ack(uint64_t seq);
+
+    // Makes every handed out but unacknowledged entry available again
+    void rewind();
+
+    // Drops everything, acknowledged or not
+    void clear();
+
+    size_t pendingCount() const;
+    size_t inFlightCount() const;
+
+    // Random ID that, together with a sequence number, names a score for the
+    // server to deduplicate retries. Sequence numbers never repeat under one ID:
+    // whenever the outbox can't be sure where its numbering left off, it picks a
+    // new ID instead. 0 until open().
+    uint64_t installId() const;
+
+private:
+    struct InFlight {
+        uint64_t seq;
+        uint64_t endOffset;
+    };
+
+    bool readRecord(uint64_t offset, std::vector<uint8_t>& payload, uint64_t& endOffset);
+    bool recoverTail(uint64_t fileSize);
+    bool locateFirstPending(uint64_t fileSize);
+    bool writeCursor();
+    bool createEmptyLog();
+    void compactIfNeeded();
+    // Reopens the log if compaction replaced it but couldn't open the new one
+    bool ensureOpen();
+
+    mutable std::mutex m_mutex;
+    std::filesystem::path m_logPath;
+    std::filesystem::path m_cursorPath;
+    std::FILE* m_file = nullptr;
+    bool m_reopenPending = false;
+
+    uint64_t m_fileSize = 0;
+    uint64_t m_ackedOffset = 0;
+    uint64_t m_ackedSeq = 0;
+    uint64_t m_readOffset = 0;
+    uint64_t m_nextSeq = 1;
+    uint64_t m_installId = 0;
+    std::deque<InFlight> m_inFlight;
+};
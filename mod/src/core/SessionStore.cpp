@@ -0,0 +1,118 @@
+#include "SessionStore.hpp"
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+namespace {
+    constexpr uint32_t MAX_RECORD_SIZE = 64 * 1024;
+
+    void putU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    }
+
+    uint32_t getU32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+}
+
+SessionStore::SessionStore(std::filesystem::path directory)
+    : m_directory(std::move(directory)), m_path(m_directory / "sessions.pending") {}
+
+bool SessionStore::append(const SessionSummary& summary) {
+    std::lock_guard lock(m_mutex);
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    // Cut off a torn record left by a crash, or everything appended after it would be unreadable
+    if (!m_tailChecked) {
+        m_tailChecked = true;
+        uint64_t validSize = 0;
+        readRecords(&validSize);
+        auto fileSize = std::filesystem::file_size(m_path, ec);
+        if (!ec && fileSize > validSize) {
+            std::filesystem::resize_file(m_path, validSize, ec);
+        }
+        ec.clear();
+    }
+
+    auto payload = summary.encode();
+    std::vector<uint8_t> record;
+    record.reserve(payload.size() + 4);
+    putU32(record, static_cast<uint32_t>(payload.size()));
+    record.insert(record.end(), payload.begin(), payload.end());
+
+    std::ofstream file(m_path, std::ios::binary | std::ios::app);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(record.data()), static_cast<std::streamsize>(record.size()));
+    return static_cast<bool>(file.flush());
+}
+
+std::vector<std::vector<uint8_t>> SessionStore::readRecords(uint64_t* validSize) const {
+    std::vector<std::vector<uint8_t>> records;
+    if (validSize) *validSize = 0;
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file) return records;
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t pos = 0;
+    while (pos + 4 <= data.size()) {
+        uint32_t length = getU32(data.data() + pos);
+        if (length > MAX_RECORD_SIZE || length > data.size() - pos - 4) break;
+        records.emplace_back(data.begin() + pos + 4, data.begin() + pos + 4 + length);
+        pos += 4 + length;
+    }
+    if (validSize) *validSize = pos;
+    return records;
+}
+
+std::vector<SessionSummary> SessionStore::loadPending(size_t maxCount) const {
+    std::lock_guard lock(m_mutex);
+
+    std::vector<SessionSummary> summaries;
+    for (const auto& record : readRecords()) {
+        if (summaries.size() >= maxCount) break;
+        SessionSummary summary;
+        if (summary.decode(record)) {
+            summaries.push_back(std::move(summary));
+        }
+    }
+    return summaries;
+}
+
+void SessionStore::markUploaded(size_t count) {
+    std::lock_guard lock(m_mutex);
+
+    // Undecodable records were skipped by loadPending, drop them along with the rest
+    auto records = readRecords();
+    size_t dropped = 0;
+    size_t index = 0;
+    for (; index < records.size() && dropped < count; index++) {
+        SessionSummary summary;
+        if (summary.decode(records[index])) dropped++;
+    }
+
+    std::error_code ec;
+    if (index >= records.size()) {
+        std::filesystem::remove(m_path, ec);
+        return;
+    }
+
+    // Write-then-rename so a crash can't lose the summaries still pending
+    auto tmpPath = m_path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        for (; index < records.size(); index++) {
+            std::vector<uint8_t> header;
+            putU32(header, static_cast<uint32_t>(records[index].size()));
+            file.write(reinterpret_cast<const char*>(header.data()), 4);
+            file.write(reinterpret_cast<const char*>(records[index].data()),
+                       static_cast<std::streamsize>(records[index].size()));
+        }
+        if (!file) return;
+    }
+    std::filesystem::rename(tmpPath, m_path, ec);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "SessionSummary.hpp"
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+// Session summaries waiting to be uploaded, kept in `sessions.pending` as
+// length-prefixed records so they survive the game closing before an upload.
+class SessionStore {
+public:
+    explicit SessionStore(std::filesystem::path directory);
+
+    bool append(const SessionSummary& summary);
+
+    // Oldest first. A torn record at the end (crash mid-write) ends the list.
+    std::vector<SessionSummary> loadPending(size_t maxCount) const;
+
+    // Drops the `count` oldest summaries once the server has them
+    void markUploaded(size_t count);
+
+private:
+    std::vector<std::vector<uint8_t>> readRecords(uint64_t* validSize = nullptr) const;
+
+    mutable std::mutex m_mutex;
+    std::filesystem::path m_directory;
+    std::filesystem::path m_path;
+    bool m_tailChecked = false;
+};
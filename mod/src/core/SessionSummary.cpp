@@ -0,0 +1,53 @@
+#include "SessionSummary.hpp"
+#include "ScoreCodec.hpp"
+
+namespace {
+    constexpr uint8_t VERSION = 1;
+    constexpr uint8_t FLAG_COMPLETED = 1;
+    constexpr uint8_t FLAG_PRACTICE = 2;
+}
+
+std::vector<uint8_t> SessionSummary::encode() const {
+    std::vector<uint8_t> out;
+    out.reserve(32);
+    out.push_back(VERSION);
+    ScoreCodec::writeVarInt(out, levelId);
+    ScoreCodec::writeVarUint(out, static_cast<uint64_t>(attempts));
+    ScoreCodec::writeVarUint(out, static_cast<uint64_t>(bestPercentage));
+    ScoreCodec::writeVarUint(out, timeAliveMs);
+    out.push_back(static_cast<uint8_t>((completed ? FLAG_COMPLETED : 0) | (usedPractice ? FLAG_PRACTICE : 0)));
+    ScoreCodec::writeVarInt(out, startedAt);
+    ScoreCodec::writeVarInt(out, endedAt);
+
+    auto histogram = deaths.encode();
+    ScoreCodec::writeVarUint(out, histogram.size());
+    out.insert(out.end(), histogram.begin(), histogram.end());
+    return out;
+}
+
+bool SessionSummary::decode(const std::vector<uint8_t>& data) {
+    const uint8_t* p = data.data();
+    size_t size = data.size();
+    size_t pos = 1;
+
+    int64_t level;
+    uint64_t attemptCount, best, alive, histogramSize;
+    if (size < 1 || p[0] != VERSION || !ScoreCodec::readVarInt(p, size, pos, level) ||
+        !ScoreCodec::readVarUint(p, size, pos, attemptCount) || !ScoreCodec::readVarUint(p, size, pos, best) ||
+        !ScoreCodec::readVarUint(p, size, pos, alive) || pos >= size) {
+        return false;
+    }
+    uint8_t flags = p[pos++];
+    if (!ScoreCodec::readVarInt(p, size, pos, startedAt) || !ScoreCodec::readVarInt(p, size, pos, endedAt) ||
+        !ScoreCodec::readVarUint(p, size, pos, histogramSize) || histogramSize != size - pos) {
+        return false;
+    }
+
+    levelId = static_cast<int>(level);
+    attempts = static_cast<int>(attemptCount);
+    bestPercentage = static_cast<int>(best);
+    timeAliveMs = alive;
+    completed = (flags & FLAG_COMPLETED) != 0;
+    usedPractice = (flags & FLAG_PRACTICE) != 0;
+    return deaths.decode(std::vector<uint8_t>(p + pos, p + size));
+}
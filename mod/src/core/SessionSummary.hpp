@@ -0,0 +1,26 @@
+#pragma once
+
+#include "DeathHistogram.hpp"
+#include <cstdint>
+#include <vector>
+
+// One record for a stretch of play on a level, emitted when the player completes
+// it or leaves. Summaries of the same level add up, so the server can build stats
+// from them instead of from individual death scores.
+struct SessionSummary {
+    int levelId = 0;
+    int attempts = 0;
+    int bestPercentage = 0;
+    // Level time summed over every attempt
+    uint64_t timeAliveMs = 0;
+    bool completed = false;
+    bool usedPractice = false;
+    // Unix milliseconds
+    int64_t startedAt = 0;
+    int64_t endedAt = 0;
+    // Normal mode deaths only, practice deaths say little about the level
+    DeathHistogram deaths;
+
+    std::vector<uint8_t> encode() const;
+    bool decode(const std::vector<uint8_t>& data);
+};
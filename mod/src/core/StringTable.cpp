@@ -0,0 +1,18 @@
+#include "StringTable.hpp"
+
+uint32_t StringTable::intern(std::string_view value) {
+    std::lock_guard lock(m_mutex);
+
+    auto it = m_ids.find(std::string(value));
+    if (it != m_ids.end()) return it->second;
+
+    uint32_t id = static_cast<uint32_t>(m_strings.size());
+    m_strings.emplace_back(value);
+    m_ids.emplace(m_strings.back(), id);
+    return id;
+}
+
+std::string StringTable::lookup(uint32_t id) const {
+    std::lock_guard lock(m_mutex);
+    return id < m_strings.size() ? m_strings[id] : std::string();
+}
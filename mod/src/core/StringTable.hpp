@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interns strings to small ids so they can travel inside POD events.
+// Interning takes a lock and may allocate, so do it outside of hot paths.
+class StringTable {
+public:
+    uint32_t intern(std::string_view value);
+    std::string lookup(uint32_t id) const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::string> m_strings{""};
+    std::unordered_map<std::string, uint32_t> m_ids{{"", 0}};
+};
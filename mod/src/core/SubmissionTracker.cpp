@@ -0,0 +1,53 @@
+#include "SubmissionTracker.hpp"
+
+uint64_t SubmissionTracker::start(uint64_t lastSeq, size_t count) {
+    uint64_t id = m_nextId++;
+    m_requests.push_back({id, lastSeq, count, State::Running});
+    m_stats.inFlightRequests++;
+    m_stats.inFlightScores += count;
+    return id;
+}
+
+SubmissionTracker::Request* SubmissionTracker::find(uint64_t id) {
+    for (auto& request : m_requests) {
+        if (request.id == id) return &request;
+    }
+    return nullptr;
+}
+
+void SubmissionTracker::finish(Request& request, State state) {
+    request.state = state;
+    m_stats.inFlightRequests--;
+    m_stats.inFlightScores -= request.count;
+}
+
+uint64_t SubmissionTracker::complete(uint64_t id) {
+    auto request = find(id);
+    if (!request || request->state != State::Running) return 0;
+
+    finish(*request, State::Done);
+    m_stats.delivered += request->count;
+
+    uint64_t ackSeq = 0;
+    while (!m_requests.empty() && m_requests.front().state == State::Done) {
+        ackSeq = m_requests.front().lastSeq;
+        m_requests.pop_front();
+    }
+    return ackSeq;
+}
+
+void SubmissionTracker::fail(uint64_t id) {
+    auto request = find(id);
+    if (!request || request->state != State::Running) return;
+
+    finish(*request, State::Failed);
+    m_stats.failed += request->count;
+    m_failed = true;
+}
+
+void SubmissionTracker::reset() {
+    m_requests.clear();
+    m_failed = false;
+    m_stats.inFlightRequests = 0;
+    m_stats.inFlightScores = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Bookkeeping for outbox batches that are on the wire at the same time.
+//
+// Requests may finish in any order, but the outbox can only be acknowledged as a
+// prefix, so a batch is only released once every batch started before it is done.
+// After a retryable failure no new requests are started until the ones still
+// running settle, at which point the caller rewinds the outbox and backs off.
+class SubmissionTracker {
+public:
+    struct Stats {
+        size_t inFlightRequests = 0;
+        size_t inFlightScores = 0;
+        uint64_t delivered = 0;
+        uint64_t failed = 0;
+    };
+
+    explicit SubmissionTracker(size_t maxInFlight) : m_maxInFlight(maxInFlight) {}
+
+    void setMaxInFlight(size_t maxInFlight) { m_maxInFlight = maxInFlight > 0 ? maxInFlight : 1; }
+    bool canStart() const { return !m_failed && m_stats.inFlightRequests < m_maxInFlight; }
+
+    uint64_t start(uint64_t lastSeq, size_t count);
+
+    // Returns the highest seq that can now be acknowledged, or 0 if none
+    uint64_t complete(uint64_t id);
+    void fail(uint64_t id);
+
+    // A failure happened and nothing is running anymore
+    bool needsRewind() const { return m_failed && m_stats.inFlightRequests == 0; }
+    void reset();
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    enum class State { Running, Done, Failed };
+
+    struct Request {
+        uint64_t id;
+        uint64_t lastSeq;
+        size_t count;
+        State state;
+    };
+
+    Request* find(uint64_t id);
+    void finish(Request& request, State state);
+
+    size_t m_maxInFlight;
+    uint64_t m_nextId = 1;
+    bool m_failed = false;
+    std::deque<Request> m_requests;
+    Stats m_stats;
+};
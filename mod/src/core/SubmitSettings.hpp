@@ -0,0 +1,9 @@
+#pragma once
+
+// Settings and link state the submission policy depends on, snapshotted so the
+// game loop doesn't have to look them up
+struct SubmitSettings {
+    bool autoSubmit = true;
+    bool submitFails = true;
+    bool linked = false;
+};
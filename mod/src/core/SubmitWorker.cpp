@@ -0,0 +1,60 @@
+#include "SubmitWorker.hpp"
+
+SubmitWorker::~SubmitWorker() {
+    stop();
+}
+
+void SubmitWorker::start() {
+    if (m_running.exchange(true)) return;
+    m_thread = std::thread([this] { run(); });
+}
+
+void SubmitWorker::stop() {
+    if (!m_running.exchange(false)) return;
+    wake();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool SubmitWorker::push(const ScoreEvent& event, const AttemptTimeline* timeline) {
+    // Checked up front so a timeline is never queued for an event that doesn't fit.
+    // This is the only producer, so a slot seen free here stays free.
+    if (m_ring.size() == m_ring.capacity()) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    ScoreEvent queued = event;
+    queued.hasTimeline = timeline && !timeline->empty() && m_timelines.push(*timeline);
+    m_ring.push(queued);
+    wake();
+    return true;
+}
+
+void SubmitWorker::wake() {
+    // Already signaled means the worker hasn't looked yet and will see this event too
+    if (m_signaled.exchange(1, std::memory_order_release) == 0) {
+        m_signaled.notify_one();
+    }
+}
+
+void SubmitWorker::run() {
+    ScoreEvent event;
+    while (m_running.load(std::memory_order_acquire)) {
+        m_signaled.wait(0, std::memory_order_acquire);
+        // Cleared before draining, so a push during the drain wakes the next round
+        m_signaled.store(0, std::memory_order_relaxed);
+
+        while (m_ring.pop(event)) deliver(event);
+    }
+
+    while (m_ring.pop(event)) deliver(event);
+}
+
+void SubmitWorker::deliver(const ScoreEvent& event) {
+    // Timelines are queued in event order, so the next one is this event's
+    if (event.hasTimeline && m_timelines.pop(m_timeline)) {
+        m_sink(event, &m_timeline);
+    } else {
+        m_sink(event, nullptr);
+    }
+}
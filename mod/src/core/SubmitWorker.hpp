@@ -0,0 +1,52 @@
+#pragma once
+
+#include "AttemptTimeline.hpp"
+#include "ScoreEvent.hpp"
+#include "SpscRing.hpp"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// Moves score handling off the game thread. The game thread push()es POD events
+// into a lock-free ring, a worker thread drains them into the sink (which does the
+// allocation-heavy work: building ScoreData, serializing, writing the outbox).
+// Timelines travel as copies in a second, smaller ring and are encoded by the sink.
+class SubmitWorker {
+public:
+    // `timeline` is null when the event has none, valid only for the call
+    using Sink = std::function<void(const ScoreEvent&, const AttemptTimeline*)>;
+
+    explicit SubmitWorker(Sink sink) : m_sink(std::move(sink)) {}
+    ~SubmitWorker();
+
+    SubmitWorker(const SubmitWorker&) = delete;
+    SubmitWorker& operator=(const SubmitWorker&) = delete;
+
+    void start();
+    void stop();
+
+    // Game thread only. Returns false (and counts a drop) if the ring is full. If the
+    // timeline ring is full the event still goes through, just without its timeline.
+    bool push(const ScoreEvent& event, const AttemptTimeline* timeline = nullptr);
+
+    // Events lost to a full ring since start
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void wake();
+    void deliver(const ScoreEvent& event);
+
+    Sink m_sink;
+    SpscRing<ScoreEvent, 256> m_ring;
+    // Only deaths with a timeline use this, and each slot is ~4 KB
+    SpscRing<AttemptTimeline, 16> m_timelines;
+    // Worker side landing spot for the timeline being handed to the sink
+    AttemptTimeline m_timeline;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_dropped{0};
+    // Set when there's something to do. The worker sleeps on it, so push() only
+    // enters the kernel when the worker is actually asleep.
+    std::atomic<uint32_t> m_signaled{0};
+    std::thread m_thread;
+};
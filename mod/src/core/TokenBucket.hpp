@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+// Allows bursts of up to `burst` events and refills one token every `refill`.
+//
+// Kept as the time the bucket will be full again rather than a token count, so
+// checking it is a comparison and nothing has to tick: with n tokens missing, that
+// time is n refills from now.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket(int burst, Clock::duration refill)
+        : m_burst(std::max(burst, 1)), m_refill(refill) {}
+
+    // Starts over with a full bucket at `now`
+    void reset(Clock::time_point now) { m_fullAt = now; }
+
+    bool ready(Clock::time_point now) const {
+        return now >= m_fullAt - (m_burst - 1) * m_refill;
+    }
+
+    bool tryTake(Clock::time_point now) {
+        if (!ready(now)) return false;
+        m_fullAt = std::max(m_fullAt, now) + m_refill;
+        return true;
+    }
+
+    int burst() const { return m_burst; }
+    Clock::duration refill() const { return m_refill; }
+
+private:
+    int m_burst;
+    Clock::duration m_refill;
+    Clock::time_point m_fullAt{};
+};
@@ -0,0 +1,188 @@
+// Microbenchmarks for the hot paths of the core library. Prints the time and heap
+// allocations per operation. Paths the game thread runs on every death or sample
+// are expected not to allocate at all, and the run fails if one does, so CTest
+// gates on that with --quick.
+
+#include "../tests/AllocationCounter.hpp"
+#include "AttemptTimeline.hpp"
+#include "LevelSession.hpp"
+#include "Metrics.hpp"
+#include "ScoreCodec.hpp"
+#include "SpscRing.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        // Fewer iterations, for CI
+        bool quick = false;
+        const char* filter = nullptr;
+    };
+
+    Options g_options;
+    bool g_failed = false;
+
+    // Keeps results observable so the optimizer can't drop the work
+    volatile uint64_t g_sink = 0;
+
+    // Runs `op` `iterations` times (a tenth with --quick). `allocationFree` paths
+    // fail the run if they allocate.
+    template <typename Op>
+    void bench(const char* name, size_t iterations, bool allocationFree, Op&& op) {
+        if (g_options.filter && !std::strstr(name, g_options.filter)) return;
+        if (g_options.quick) iterations = std::max<size_t>(iterations / 10, 1);
+
+        // Warm up caches and let one-off allocations (first growth of a buffer) happen
+        for (size_t i = 0; i < std::min<size_t>(iterations, 1000); i++) op(i);
+
+        CountAllocations allocations;
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; i++) op(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        double perOp = static_cast<double>(allocations.count()) / static_cast<double>(iterations);
+
+        bool bad = allocationFree && allocations.count() > 0;
+        g_failed |= bad;
+        std::printf("%-34s %10.1f ns/op %8.2f allocs/op%s\n", name, ns / static_cast<double>(iterations), perOp,
+                    bad ? "  FAIL: expected no allocations" : "");
+    }
+
+    ScoreData makeScore(int i) {
+        ScoreData score{};
+        score.levelId = 100000 + i % 50;
+        score.levelName = "Bench Level";
+        score.levelCreator = "BenchCreator";
+        score.percentage = 5 + i % 90;
+        score.attempts = 1 + i;
+        score.passed = false;
+        score.isPractice = false;
+        score.coinsCollected = {true, false, false};
+        score.seq = static_cast<uint64_t>(i) + 1;
+        score.playedAt = 1700000000000 + i;
+        return score;
+    }
+
+    void benchLevelSession() {
+        const SubmitSettings settings{true, true, true};
+        LevelSession::LevelInfo info;
+        info.levelId = 42;
+        info.coinCount = 3;
+
+        LevelSession session;
+        auto now = Clock::time_point{} + std::chrono::hours(1);
+        session.begin(info, 0, now);
+        bench("LevelSession::onProgress", 5000000, true, [&](size_t i) {
+            session.onProgress(static_cast<float>(i % 100), static_cast<double>(i) * 0.01, static_cast<float>(i));
+        });
+
+        session.begin(info, 0, now);
+        ScoreEvent event{};
+        bench("LevelSession death + reset", 1000000, true, [&](size_t i) {
+            float percent = static_cast<float>(5 + i % 90);
+            auto death = session.onDeath(percent, percent * 0.1, percent * 10.f);
+            // Deaths a second apart, so the limiter both passes and coalesces some
+            now += std::chrono::seconds(1);
+            if (session.onReset(death, false, settings, now, event)) g_sink = g_sink + event.percentage;
+        });
+
+        // The first pickup finds the level's coins among a few hundred objects
+        std::vector<float> coinXs;
+        for (int i = 0; i < 300; i++) coinXs.push_back(static_cast<float>((i * 7919) % 30000));
+        std::array<int, LevelSession::MAX_COINS> order{};
+        bench("LevelSession::orderCoins (300)", 200000, true, [&](size_t i) {
+            coinXs[i % coinXs.size()] += 1.f;
+            g_sink = g_sink + static_cast<uint64_t>(LevelSession::orderCoins(coinXs, order) + order[0]);
+        });
+
+        session.begin(info, 0, now);
+        bench("LevelSession coin + death + reset", 1000000, true, [&](size_t i) {
+            session.onCoin(static_cast<int>(i % 3));
+            auto death = session.onDeath(50.f, 5.0, 500.f);
+            now += std::chrono::seconds(1);
+            if (session.onReset(death, false, settings, now, event)) g_sink = g_sink + event.coinMask;
+        });
+    }
+
+    void benchRing() {
+        SpscRing<ScoreEvent, 256> ring;
+        ScoreEvent event{};
+        bench("SpscRing push + pop", 10000000, true, [&](size_t i) {
+            event.attempts = static_cast<int>(i);
+            ring.push(event);
+            ScoreEvent out{};
+            ring.pop(out);
+            g_sink = g_sink + static_cast<uint64_t>(out.attempts);
+        });
+    }
+
+    void benchTimeline() {
+        AttemptTimeline timeline;
+        bench("AttemptTimeline::add", 10000000, true, [&](size_t i) {
+            if (i % 100000 == 0) timeline.clear();
+            timeline.add(static_cast<double>(i % 100000) / 240.0, static_cast<float>(i % 100000));
+        });
+        bench("AttemptTimeline::encode", 100000, false, [&](size_t) {
+            g_sink = g_sink + timeline.encode().size();
+        });
+    }
+
+    void benchCodec() {
+        ScoreCodec::SessionHeader header;
+        header.authToken = std::string(64, 'a');
+        header.gdAccountId = 12345678;
+        header.gdUsername = "BenchPlayer";
+        header.installId = "0123456789abcdef";
+
+        std::vector<ScoreData> batch;
+        for (int i = 0; i < 32; i++) batch.push_back(makeScore(i));
+
+        std::vector<uint8_t> encoded;
+        bench("ScoreCodec::encodeBatch (32)", 200000, false, [&](size_t) {
+            encoded = ScoreCodec::encodeBatch(header, batch);
+            g_sink = g_sink + encoded.size();
+        });
+        bench("ScoreCodec::decodeBatch (32)", 200000, false, [&](size_t) {
+            ScoreCodec::SessionHeader decodedHeader;
+            std::vector<ScoreData> scores;
+            ScoreCodec::decodeBatch(encoded, decodedHeader, scores);
+            g_sink = g_sink + scores.size();
+        });
+        bench("ScoreCodec::encodeBatchJson (32)", 50000, false, [&](size_t) {
+            g_sink = g_sink + ScoreCodec::encodeBatchJson(header, batch).size();
+        });
+        std::printf("%-34s %10zu bytes binary, %zu bytes JSON\n", "  32 score batch", encoded.size(),
+                    ScoreCodec::encodeBatchJson(header, batch).size());
+    }
+
+    void benchMetrics() {
+        Metrics::setEnabled(true);
+        bench("Metrics::record", 10000000, true, [&](size_t i) {
+            Metrics::record(Metrics::Timer::ProgressTick, i % 100000);
+        });
+        Metrics::setEnabled(false);
+        Metrics::reset();
+    }
+}
+
+// yuki-core-bench [--quick] [substring]
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0) g_options.quick = true;
+        else g_options.filter = argv[i];
+    }
+
+    benchLevelSession();
+    benchRing();
+    benchTimeline();
+    benchCodec();
+    benchMetrics();
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+#include "AllocationCounter.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace {
+    thread_local uint64_t t_allocations = 0;
+}
+
+uint64_t AllocationCounter::thisThread() {
+    return t_allocations;
+}
+
+// The array and nothrow forms all end up here
+void* operator new(std::size_t size) {
+    t_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts the calls to operator new made by the calling thread. Linking
+// AllocationCounter.cpp replaces the global operator new, so only the test and
+// benchmark executables do.
+namespace AllocationCounter {
+    uint64_t thisThread();
+}
+
+// Allocations made by this thread since construction
+class CountAllocations {
+public:
+    CountAllocations() : m_start(AllocationCounter::thisThread()) {}
+    uint64_t count() const { return AllocationCounter::thisThread() - m_start; }
+
+private:
+    uint64_t m_start;
+};
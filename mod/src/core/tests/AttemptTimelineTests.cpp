@@ -0,0 +1,102 @@
+#include "Test.hpp"
+#include "AttemptTimeline.hpp"
+
+namespace {
+    using Sample = AttemptTimeline::Sample;
+
+    // x rising steadily, one sample per 4ms frame
+    std::vector<Sample> ramp(size_t count) {
+        std::vector<Sample> samples;
+        for (size_t i = 0; i < count; i++) samples.push_back({static_cast<uint32_t>(i * 4), static_cast<float>(i)});
+        return samples;
+    }
+
+    bool contains(const Sample* samples, size_t count, Sample wanted) {
+        for (size_t i = 0; i < count; i++) {
+            if (samples[i].timeMs == wanted.timeMs && samples[i].x == wanted.x) return true;
+        }
+        return false;
+    }
+}
+
+TEST(downsampleKeepsTheEndsAndTheBound) {
+    for (size_t target : {3, 10, 64, 256}) {
+        auto samples = ramp(5000);
+        Sample first = samples.front();
+        Sample last = samples.back();
+
+        size_t count = AttemptTimeline::downsample(samples.data(), samples.size(), target);
+        CHECK_EQ(count, target);
+        CHECK_EQ(samples[0].timeMs, first.timeMs);
+        CHECK_EQ(samples[count - 1].timeMs, last.timeMs);
+        CHECK_EQ(samples[count - 1].x, last.x);
+        for (size_t i = 1; i < count; i++) CHECK(samples[i].timeMs > samples[i - 1].timeMs);
+    }
+}
+
+TEST(downsampleLeavesShortInputAlone) {
+    auto samples = ramp(20);
+    CHECK_EQ(AttemptTimeline::downsample(samples.data(), samples.size(), 64), size_t(20));
+    CHECK_EQ(AttemptTimeline::downsample(samples.data(), samples.size(), 2), size_t(20));
+}
+
+TEST(downsampleKeepsPeaks) {
+    // Flat with a spike every 500 samples, one per bucket or less at 64 points
+    auto samples = ramp(4000);
+    std::vector<Sample> peaks;
+    for (auto& sample : samples) sample.x = 100.f;
+    for (size_t i = 250; i < samples.size(); i += 500) {
+        samples[i].x = 5000.f + static_cast<float>(i);
+        peaks.push_back(samples[i]);
+    }
+
+    size_t count = AttemptTimeline::downsample(samples.data(), samples.size(), 64);
+    for (const auto& peak : peaks) CHECK(contains(samples.data(), count, peak));
+}
+
+TEST(timelineStaysBoundedOnLongAttempts) {
+    // Ten minutes at 240 fps
+    AttemptTimeline timeline;
+    constexpr int FRAMES = 10 * 60 * 240;
+    for (int i = 0; i < FRAMES; i++) {
+        timeline.add(i / 240.0, static_cast<float>(i % 3000));
+        CHECK(timeline.size() <= AttemptTimeline::CAPACITY);
+    }
+    CHECK_EQ(timeline.samples()[0].timeMs, uint32_t(0));
+
+    std::vector<Sample> decoded;
+    REQUIRE(AttemptTimeline::decode(timeline.encode(), decoded));
+    CHECK(decoded.size() <= AttemptTimeline::UPLOAD_POINTS);
+    CHECK(decoded.size() >= AttemptTimeline::UPLOAD_POINTS / 2);
+    CHECK_EQ(decoded.front().timeMs, uint32_t(0));
+    // The last frame is always there, even when the stride skipped it
+    CHECK_EQ(decoded.back().timeMs, timeline.durationMs());
+    CHECK_EQ(decoded.back().x, static_cast<float>((FRAMES - 1) % 3000));
+}
+
+TEST(timelineEncodesShortAttemptsExactly) {
+    AttemptTimeline timeline;
+    timeline.add(0.0, 0.f);
+    timeline.add(0.5, 150.f);
+    timeline.add(0.4, 120.f); // time going backwards is held at the last sample's
+    timeline.add(1.25, 310.f);
+
+    std::vector<Sample> decoded;
+    REQUIRE(AttemptTimeline::decode(timeline.encode(), decoded));
+    REQUIRE(decoded.size() == 4);
+    CHECK_EQ(decoded[1].timeMs, uint32_t(500));
+    CHECK_EQ(decoded[2].timeMs, uint32_t(500));
+    CHECK_EQ(decoded[2].x, 120.f);
+    CHECK_EQ(decoded[3].timeMs, uint32_t(1250));
+    CHECK_EQ(decoded[3].x, 310.f);
+}
+
+TEST(timelineDecodeRejectsTruncatedData) {
+    AttemptTimeline timeline;
+    for (int i = 0; i < 50; i++) timeline.add(i * 0.1, i * 7.f);
+    auto data = timeline.encode();
+    std::vector<Sample> decoded;
+    for (size_t size = 0; size < data.size(); size++) {
+        CHECK(!AttemptTimeline::decode(std::vector<uint8_t>(data.begin(), data.begin() + size), decoded));
+    }
+}
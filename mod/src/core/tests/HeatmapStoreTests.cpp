@@ -0,0 +1,71 @@
+#include "Test.hpp"
+#include "HeatmapStore.hpp"
+
+namespace {
+    constexpr int LEVEL = 4284013;
+    constexpr int64_t NOW = 1700000000000;
+
+    DeathHistogram deathsAt(float percent, uint32_t count) {
+        DeathHistogram histogram;
+        histogram.add(percent, count);
+        return histogram;
+    }
+}
+
+TEST(heatmapStoreResendsAnUnconfirmedUploadUnchanged) {
+    Test::TempDir dir;
+    HeatmapStore store(dir.path());
+    REQUIRE(store.mergeSession(LEVEL, deathsAt(40.f, 3)));
+
+    HeatmapUpload first;
+    REQUIRE(store.takeUpload(LEVEL, NOW, first));
+    CHECK_EQ(first.deaths.total(), uint64_t(3));
+
+    // Deaths after the upload was taken don't change what a retry sends
+    REQUIRE(store.mergeSession(LEVEL, deathsAt(60.f, 2)));
+    HeatmapUpload retry;
+    REQUIRE(store.takeUpload(LEVEL, NOW + 1000, retry));
+    CHECK_EQ(retry.seq, first.seq);
+    CHECK_EQ(retry.deaths.total(), uint64_t(3));
+
+    // Once confirmed, the newer deaths go out under a new seq
+    store.markUploaded(retry);
+    HeatmapUpload next;
+    REQUIRE(store.takeUpload(LEVEL, NOW, next));
+    CHECK(next.seq > first.seq);
+    CHECK_EQ(next.deaths.total(), uint64_t(2));
+    CHECK_EQ(next.deaths.bucket(600), uint32_t(2));
+
+    store.markUploaded(next);
+    CHECK(store.pendingLevels().empty());
+    CHECK(!store.takeUpload(LEVEL, NOW, next));
+}
+
+TEST(heatmapStoreSeqsStayUniqueAcrossLevelsAndRestarts) {
+    Test::TempDir dir;
+    uint64_t last = 0;
+    for (int level = 1; level <= 3; level++) {
+        // A new store each time, like a restart
+        HeatmapStore store(dir.path());
+        store.mergeSession(level, deathsAt(10.f, 1));
+        HeatmapUpload upload;
+        REQUIRE(store.takeUpload(level, NOW, upload));
+        CHECK(upload.seq > last);
+        CHECK(upload.seq >= uint64_t(NOW));
+        last = upload.seq;
+    }
+    CHECK_EQ(HeatmapStore(dir.path()).pendingLevels().size(), size_t(3));
+}
+
+TEST(heatmapStoreIgnoresAStaleConfirmation) {
+    Test::TempDir dir;
+    HeatmapStore store(dir.path());
+    store.mergeSession(LEVEL, deathsAt(25.f, 1));
+
+    HeatmapUpload upload;
+    REQUIRE(store.takeUpload(LEVEL, NOW, upload));
+    HeatmapUpload stale = upload;
+    stale.seq--;
+    store.markUploaded(stale);
+    CHECK_EQ(store.pendingLevels().size(), size_t(1));
+}
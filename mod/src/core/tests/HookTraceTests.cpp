@@ -0,0 +1,149 @@
+#include "Test.hpp"
+#include "HookTrace.hpp"
+#include <fstream>
+
+using namespace std::chrono_literals;
+using Clock = HookTraceWriter::Clock;
+
+namespace {
+    const auto T0 = Clock::time_point{} + 1h;
+
+    LevelMeta makeLevel() {
+        LevelMeta level;
+        level.levelId = 4284013;
+        level.name = "Bloodbath";
+        level.creator = "Riot";
+        level.description = "V2hhdCBpcyBsb3ZlPw==";
+        level.difficulty = 50;
+        level.stars = 10;
+        level.isDemon = true;
+        level.demonDifficulty = 6;
+        level.songId = 467339;
+        level.songName = "At the Speed of Light";
+        level.songAuthor = "Dimrain47";
+        level.length = 3;
+        level.downloads = 29000000;
+        level.likes = 1400000;
+        return level;
+    }
+
+    // Open, two attempts, a coin and a quit
+    void recordSession(HookTraceWriter& writer) {
+        SubmitSettings settings;
+        settings.submitFails = false;
+        settings.linked = true;
+        writer.begin(makeLevel(), 3, true, settings, 1700000000000, T0);
+        writer.record(HookTraceType::Tick, T0 + 250ms, 1.5f, 0.25, 31.125f);
+        writer.record(HookTraceType::Coin, T0 + 1s, 12.f, 1.0, 412.f, 2);
+        writer.record(HookTraceType::Death, T0 + 2s, 37.33f, 2.0, 1290.5f);
+        writer.record(HookTraceType::Reset, T0 + 2500ms, 37.33f, 2.0, 1290.5f, 1);
+        writer.record(HookTraceType::Pause, T0 + 3s);
+        writer.record(HookTraceType::Resume, T0 + 10s);
+        writer.record(HookTraceType::Quit, T0 + 11s);
+    }
+
+    std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    void writeFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+}
+
+TEST(hookTraceRoundTripsThroughAFile) {
+    Test::TempDir dir;
+    auto path = dir.path() / "traces" / "4284013.trace";
+    HookTraceWriter writer;
+    recordSession(writer);
+    REQUIRE(writer.save(path));
+    CHECK(!writer.active());
+
+    HookTrace trace;
+    REQUIRE(HookTrace::load(path, trace));
+    CHECK_EQ(trace.startedAt, int64_t(1700000000000));
+    CHECK(trace.settings.autoSubmit);
+    CHECK(!trace.settings.submitFails);
+    CHECK(trace.settings.linked);
+    CHECK(trace.online);
+    CHECK(!trace.truncated);
+    CHECK_EQ(trace.coinCount, 3);
+
+    auto level = makeLevel();
+    CHECK_EQ(trace.level.levelId, level.levelId);
+    CHECK_EQ(trace.level.name, level.name);
+    CHECK_EQ(trace.level.description, level.description);
+    CHECK(trace.level.isDemon);
+    CHECK_EQ(trace.level.demonDifficulty, 6);
+    CHECK_EQ(trace.level.songAuthor, level.songAuthor);
+    CHECK_EQ(trace.level.downloads, level.downloads);
+    CHECK_EQ(trace.level.likes, level.likes);
+
+    REQUIRE(trace.records.size() == 7);
+    const auto& coin = trace.records[1];
+    CHECK(coin.type == HookTraceType::Coin);
+    CHECK_EQ(coin.atUs, uint64_t(1000000));
+    CHECK_EQ(coin.arg, uint8_t(2));
+    // Floats come back bit for bit
+    const auto& death = trace.records[2];
+    CHECK_EQ(death.percent, 37.33f);
+    CHECK_EQ(death.x, 1290.5f);
+    CHECK_EQ(death.seconds, 2.0);
+    CHECK_EQ(trace.records[3].arg, uint8_t(1));
+    CHECK(trace.records[5].type == HookTraceType::Resume);
+    CHECK_EQ(trace.records[5].atUs, uint64_t(10000000));
+    CHECK(trace.records[6].type == HookTraceType::Quit);
+}
+
+TEST(hookTraceRejectsACutFile) {
+    Test::TempDir dir;
+    auto path = dir.path() / "level.trace";
+    HookTraceWriter writer;
+    recordSession(writer);
+    REQUIRE(writer.save(path));
+    auto full = readFile(path);
+
+    // Every cut that isn't on a record boundary is caught, none reads past the end
+    auto boundaries = 0;
+    for (size_t size = 0; size < full.size(); size++) {
+        HookTrace trace;
+        if (HookTrace::decode({full.begin(), full.begin() + static_cast<std::ptrdiff_t>(size)}, trace)) {
+            boundaries++;
+        }
+    }
+    // The end of the header and the end of each record but the last
+    CHECK_EQ(boundaries, 7);
+
+    HookTrace trace;
+    writeFile(path, {full.begin(), full.end() - 3});
+    CHECK(!HookTrace::load(path, trace));
+    CHECK(!HookTrace::load(dir.path() / "missing.trace", trace));
+    writeFile(path, {'Y', 'T', 'R', 'C', 9, 0});
+    CHECK(!HookTrace::load(path, trace));
+}
+
+TEST(hookTraceStopsGrowingAtMaxSize) {
+    Test::TempDir dir;
+    auto path = dir.path() / "long.trace";
+    HookTraceWriter writer;
+    writer.begin(makeLevel(), 0, false, {}, 1700000000000, T0);
+    auto now = T0;
+    size_t recorded = 0;
+    while (recorded * 8 < HookTraceWriter::MAX_SIZE) {
+        now += 4ms;
+        writer.record(HookTraceType::Tick, now, 50.f, 1.0, 100.f);
+        recorded++;
+    }
+    REQUIRE(writer.save(path));
+    CHECK(std::filesystem::file_size(path) < HookTraceWriter::MAX_SIZE + 64);
+
+    HookTrace trace;
+    REQUIRE(HookTrace::load(path, trace));
+    CHECK(trace.truncated);
+    CHECK(!trace.online);
+    CHECK(!trace.records.empty());
+    CHECK(trace.records.size() < recorded);
+    CHECK_EQ(trace.records.back().atUs, uint64_t(trace.records.size()) * 4000);
+}
@@ -0,0 +1,259 @@
+#include "Test.hpp"
+#include "LevelSession.hpp"
+#include <array>
+#include <vector>
+
+namespace {
+    using namespace std::chrono_literals;
+
+    const SubmitSettings SETTINGS{true, true, true};
+    const auto T0 = LevelSession::Clock::time_point{} + 1h;
+
+    LevelSession::LevelInfo makeLevel(int coins = 3) {
+        LevelSession::LevelInfo info;
+        info.levelId = 128;
+        info.nameId = 1;
+        info.creatorId = 2;
+        info.coinCount = coins;
+        return info;
+    }
+
+    // Plays an attempt up to `percent` and dies there
+    bool die(LevelSession& session, int percent, LevelSession::Clock::time_point now, ScoreEvent& out,
+             bool practice = false) {
+        for (int p = 0; p <= percent; p++) {
+            session.onProgress(static_cast<float>(p), p * 0.1, p * 10.f);
+        }
+        auto death = session.onDeath(static_cast<float>(percent), percent * 0.1, percent * 10.f);
+        return session.onReset(death, practice, SETTINGS, now, out);
+    }
+}
+
+TEST(levelSessionSubmitsDeathsFromFivePercent) {
+    LevelSession session;
+    session.begin(makeLevel(), 0, T0);
+    auto now = T0;
+
+    ScoreEvent score{};
+    CHECK(!die(session, LevelSession::MIN_PERCENTAGE_TO_SUBMIT - 1, now, score));
+    REQUIRE(die(session, 40, now, score));
+    CHECK_EQ(score.percentage, 40);
+    CHECK_EQ(score.attempts, 2);
+    CHECK_EQ(score.levelId, 128);
+    CHECK(!score.passed);
+    CHECK_EQ(session.bestPercentage(), 40);
+}
+
+TEST(levelSessionNeverSubmitsPracticeDeaths) {
+    LevelSession session;
+    session.begin(makeLevel(), 0, T0);
+    ScoreEvent score{};
+    CHECK(!die(session, 80, T0, score, true));
+    CHECK(!session.hasPendingDeath());
+}
+
+TEST(levelSessionRespectsSettings) {
+    LevelSession session;
+    session.begin(makeLevel(), 0, T0);
+    auto now = T0;
+
+    ScoreEvent score{};
+    for (int p = 0; p <= 50; p++) session.onProgress(static_cast<float>(p), p * 0.1, 0.f);
+    auto death = session.onDeath(50.f, 5.0, 0.f);
+    CHECK(!session.onReset(death, false, SubmitSettings{true, false, true}, now, score));
+    CHECK(!session.onFinished(false, false, SubmitSettings{true, true, false}, now, score));
+}
+
+TEST(levelSessionPassCarriesCoinsAndTimeline) {
+    LevelSession session;
+    session.begin(makeLevel(), 0, T0);
+    auto now = T0;
+
+    for (int p = 0; p <= 100; p++) {
+        session.onProgress(static_cast<float>(p), p * 0.1, p * 10.f);
+        if (p == 20) session.onCoin(0);
+        if (p == 70) session.onCoin(2);
+    }
+    session.onCoin(7); // beyond the level's coins, ignored
+    session.onComplete(false);
+
+    ScoreEvent score{};
+    REQUIRE(session.onFinished(true, false, SETTINGS, now, score));
+    CHECK(score.passed);
+    CHECK_EQ(score.percentage, 100);
+    CHECK_EQ(score.coinCount, 3);
+    CHECK_EQ(score.coinMask, uint64_t(0b101));
+    REQUIRE(session.eventTimeline() != nullptr);
+    CHECK(!session.eventTimeline()->empty());
+}
+
+TEST(levelSessionReportsPartialCoins) {
+    LevelSession session;
+    session.begin(makeLevel(), 0, T0);
+
+    for (int p = 0; p <= 100; p++) {
+        session.onProgress(static_cast<float>(p), p * 0.1, p * 10.f);
+        if (p == 50) session.onCoin(1);
+    }
+    session.onComplete(false);
+
+    ScoreEvent score{};
+    REQUIRE(session.onFinished(true, false, SETTINGS, T0, score));
+    CHECK_EQ(score.coinCount, 3);
+    CHECK_EQ(score.coinMask, uint64_t(0b010));
+}
+
+TEST(levelSessionDropsCoinsOfADeathAttempt) {
+    LevelSession session;
+    session.begin(makeLevel(), 0, T0);
+
+    // Coin 0 picked up, then a death: it was never earned
+    ScoreEvent death{};
+    session.onCoin(0);
+    REQUIRE(die(session, 50, T0, death));
+    CHECK_EQ(death.coinMask, uint64_t(0b001));
+    CHECK_EQ(session.attemptCoins(), uint64_t(0));
+
+    for (int p = 0; p <= 100; p++) {
+        session.onProgress(static_cast<float>(p), p * 0.1, p * 10.f);
+        if (p == 80) session.onCoin(2);
+    }
+    session.onComplete(false);
+
+    ScoreEvent score{};
+    REQUIRE(session.onFinished(true, false, SETTINGS, T0 + 10s, score));
+    CHECK_EQ(score.coinMask, uint64_t(0b100));
+}
+
+TEST(levelSessionFailedRunReportsItsBestAttemptsCoins) {
+    LevelSession session;
+    session.begin(makeLevel(), 0, T0);
+
+    ScoreEvent score{};
+    session.onCoin(0);
+    die(session, 60, T0, score);
+    session.onCoin(0);
+    session.onCoin(1);
+    die(session, 30, T0 + 10s, score);
+
+    REQUIRE(session.onFinished(false, false, SETTINGS, T0 + 20s, score));
+    CHECK_EQ(score.percentage, 60);
+    CHECK_EQ(score.coinMask, uint64_t(0b001));
+}
+
+TEST(levelSessionPracticeEarnsNoCoins) {
+    LevelSession session;
+    session.begin(makeLevel(), 0, T0);
+
+    // A practice death doesn't make its coins the best attempt's either
+    ScoreEvent score{};
+    session.onCoin(2);
+    CHECK(!die(session, 90, T0, score, true));
+
+    for (int p = 0; p <= 100; p++) {
+        session.onProgress(static_cast<float>(p), p * 0.1, p * 10.f);
+        if (p == 10) session.onCoin(0);
+        if (p == 60) session.onCoin(1);
+    }
+    session.onComplete(true);
+
+    REQUIRE(session.onFinished(true, true, SETTINGS, T0 + 10s, score));
+    CHECK(score.isPractice);
+    CHECK_EQ(score.coinMask, uint64_t(0));
+}
+
+TEST(levelSessionOrdersCoinsFromTheLeft) {
+    std::array<int, LevelSession::MAX_COINS> order{};
+
+    // More coin objects than the level has coins, stored out of order
+    std::vector<float> xs{900.f, 150.f, 4000.f, 620.f, 150.f, 30.f};
+    REQUIRE(LevelSession::orderCoins(xs, order) == 3);
+    CHECK(order == (std::array<int, 3>{5, 1, 4}));
+
+    std::vector<float> two{500.f, 20.f};
+    REQUIRE(LevelSession::orderCoins(two, order) == 2);
+    CHECK_EQ(order[0], 1);
+    CHECK_EQ(order[1], 0);
+
+    CHECK_EQ(LevelSession::orderCoins({}, order), 0);
+}
+
+TEST(levelSessionSummarizesTheSession) {
+    LevelSession session;
+    session.begin(makeLevel(), 1000, T0);
+    auto now = T0;
+
+    ScoreEvent score{};
+    die(session, 12, now, score);
+    die(session, 30, now, score);
+
+    SessionSummary summary;
+    REQUIRE(session.takeSummary(5000, summary));
+    CHECK_EQ(summary.attempts, 2);
+    CHECK_EQ(summary.bestPercentage, 30);
+    CHECK_EQ(summary.startedAt, int64_t(1000));
+    CHECK_EQ(summary.endedAt, int64_t(5000));
+    CHECK(!session.takeSummary(6000, summary));
+}
+
+TEST(levelSessionCoalescesDeathsOverTheLimit) {
+    LevelSession session;
+    session.setDeathLimit(2, 5s);
+    session.begin(makeLevel(), 0, T0);
+
+    ScoreEvent score{};
+    CHECK(die(session, 10, T0, score));
+    CHECK(die(session, 20, T0, score));
+
+    // Out of tokens: held back and merged, keeping the best percentage
+    CHECK(!die(session, 40, T0 + 1s, score));
+    CHECK(!die(session, 30, T0 + 2s, score));
+    CHECK(session.hasPendingDeath());
+    CHECK(!session.flushPendingDeath(T0 + 4s, score));
+
+    REQUIRE(session.flushPendingDeath(T0 + 5s, score));
+    CHECK_EQ(score.percentage, 40);
+    CHECK_EQ(score.attempts, 4);
+    CHECK(!session.hasPendingDeath());
+}
+
+TEST(levelSessionSendsTheMergedDeathWithTheNextToken) {
+    LevelSession session(1, 5s);
+    session.begin(makeLevel(), 0, T0);
+
+    ScoreEvent score{};
+    CHECK(die(session, 50, T0, score));
+    CHECK(!die(session, 60, T0 + 1s, score));
+
+    // The next death to get a token carries the one waiting, the higher of the two
+    REQUIRE(die(session, 15, T0 + 5s, score));
+    CHECK_EQ(score.percentage, 60);
+    CHECK_EQ(score.attempts, 3);
+    CHECK(!session.hasPendingDeath());
+}
+
+TEST(levelSessionFinalScoreCoversThePendingDeath) {
+    LevelSession session(1, 5s);
+    session.begin(makeLevel(), 0, T0);
+
+    ScoreEvent score{};
+    die(session, 30, T0, score);
+    CHECK(!die(session, 70, T0 + 1s, score));
+
+    REQUIRE(session.onFinished(false, false, SETTINGS, T0 + 2s, score));
+    CHECK_EQ(score.percentage, 70);
+    CHECK(!session.hasPendingDeath());
+}
+
+TEST(levelSessionBeginRefillsTheLimiter) {
+    LevelSession session(1, 1h);
+    session.begin(makeLevel(), 0, T0);
+
+    ScoreEvent score{};
+    CHECK(die(session, 30, T0, score));
+    CHECK(!die(session, 40, T0 + 1s, score));
+
+    session.begin(makeLevel(), 0, T0 + 2s);
+    CHECK(!session.hasPendingDeath());
+    CHECK(die(session, 30, T0 + 2s, score));
+}
@@ -0,0 +1,156 @@
+#include "Test.hpp"
+#include "ScoreOutbox.hpp"
+#include <fstream>
+
+namespace {
+    ScoreData makeScore(int percentage, size_t nameSize = 12) {
+        ScoreData score{};
+        score.levelId = 4284013;
+        score.levelName = std::string(nameSize, 'n');
+        score.levelCreator = "Creator";
+        score.percentage = percentage;
+        score.attempts = 3;
+        score.coinsCollected = {false, true};
+        score.playedAt = 1700000000000;
+        return score;
+    }
+
+    std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    void writeFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::vector<uint64_t> seqs(const std::vector<OutboxEntry>& batch) {
+        std::vector<uint64_t> out;
+        for (const auto& entry : batch) out.push_back(entry.seq);
+        return out;
+    }
+}
+
+TEST(outboxRoundTripsScores) {
+    Test::TempDir dir;
+    ScoreOutbox outbox(dir.path());
+    REQUIRE(outbox.open());
+    CHECK_EQ(outbox.append(makeScore(40)), uint64_t(1));
+    CHECK_EQ(outbox.append(makeScore(75)), uint64_t(2));
+
+    auto batch = outbox.readBatch(10);
+    REQUIRE(batch.size() == 2);
+    CHECK_EQ(batch[1].score.percentage, 75);
+    CHECK_EQ(batch[1].score.seq, uint64_t(2));
+    CHECK(batch[1].score.coinsCollected == std::vector<bool>({false, true}));
+    CHECK_EQ(batch[1].score.playedAt, int64_t(1700000000000));
+    CHECK_EQ(outbox.inFlightCount(), size_t(2));
+}
+
+TEST(outboxCutsATruncatedTail) {
+    Test::TempDir dir;
+    uint64_t installId;
+    {
+        ScoreOutbox outbox(dir.path());
+        REQUIRE(outbox.open());
+        for (int i = 0; i < 3; i++) outbox.append(makeScore(10 + i));
+        installId = outbox.installId();
+    }
+
+    // A write torn by a crash, partway into the last record
+    auto log = readFile(dir.path() / "outbox.log");
+    log.resize(log.size() - 5);
+    writeFile(dir.path() / "outbox.log", log);
+
+    ScoreOutbox outbox(dir.path());
+    REQUIRE(outbox.open());
+    CHECK_EQ(outbox.pendingCount(), size_t(2));
+    CHECK_EQ(outbox.installId(), installId);
+    CHECK(seqs(outbox.readBatch(10)) == std::vector<uint64_t>({1, 2}));
+    // Appends land on a record boundary again
+    CHECK_EQ(outbox.append(makeScore(90)), uint64_t(3));
+    CHECK(seqs(outbox.readBatch(10)) == std::vector<uint64_t>({3}));
+}
+
+TEST(outboxStopsAtACrcMismatch) {
+    Test::TempDir dir;
+    {
+        ScoreOutbox outbox(dir.path());
+        REQUIRE(outbox.open());
+        for (int i = 0; i < 3; i++) outbox.append(makeScore(10 + i));
+    }
+
+    // Flip a byte inside the last record's payload, its frame still looks intact
+    auto log = readFile(dir.path() / "outbox.log");
+    log[log.size() - 10] ^= 0xFF;
+    writeFile(dir.path() / "outbox.log", log);
+
+    ScoreOutbox outbox(dir.path());
+    REQUIRE(outbox.open());
+    auto batch = outbox.readBatch(10);
+    CHECK(seqs(batch) == std::vector<uint64_t>({1, 2}));
+    CHECK_EQ(outbox.append(makeScore(50)), uint64_t(3));
+}
+
+TEST(outboxReplaysUnackedEntriesAfterARestart) {
+    Test::TempDir dir;
+    {
+        ScoreOutbox outbox(dir.path());
+        REQUIRE(outbox.open());
+        for (int i = 0; i < 5; i++) outbox.append(makeScore(10 + i));
+        CHECK_EQ(outbox.readBatch(3).size(), size_t(3));
+        outbox.ack(2);
+    }
+
+    // Seq 3 was handed out but never acknowledged, so it goes out again
+    ScoreOutbox outbox(dir.path());
+    REQUIRE(outbox.open());
+    CHECK_EQ(outbox.pendingCount(), size_t(3));
+    CHECK(seqs(outbox.readBatch(10)) == std::vector<uint64_t>({3, 4, 5}));
+
+    outbox.rewind();
+    CHECK(seqs(outbox.readBatch(1)) == std::vector<uint64_t>({3}));
+    CHECK_EQ(outbox.append(makeScore(99)), uint64_t(6));
+}
+
+TEST(outboxCompactsAcknowledgedEntries) {
+    Test::TempDir dir;
+    auto logPath = dir.path() / "outbox.log";
+    ScoreOutbox outbox(dir.path());
+    REQUIRE(outbox.open());
+    for (int i = 0; i < 40; i++) outbox.append(makeScore(i, 8 * 1024));
+    auto before = std::filesystem::file_size(logPath);
+
+    REQUIRE(outbox.readBatch(36).size() == 36);
+    outbox.ack(36);
+    CHECK(std::filesystem::file_size(logPath) < before / 4);
+    CHECK(!std::filesystem::exists(dir.path() / "outbox.log.tmp"));
+
+    CHECK_EQ(outbox.append(makeScore(99)), uint64_t(41));
+    CHECK(seqs(outbox.readBatch(10)) == std::vector<uint64_t>({37, 38, 39, 40, 41}));
+
+    ScoreOutbox reopened(dir.path());
+    REQUIRE(reopened.open());
+    CHECK(seqs(reopened.readBatch(10)) == std::vector<uint64_t>({37, 38, 39, 40, 41}));
+}
+
+TEST(outboxKeepsItsLogWhenCompactionCantReplaceIt) {
+    Test::TempDir dir;
+    auto logPath = dir.path() / "outbox.log";
+    ScoreOutbox outbox(dir.path());
+    REQUIRE(outbox.open());
+    for (int i = 0; i < 40; i++) outbox.append(makeScore(i, 8 * 1024));
+
+    // A directory in the log's place makes the rename (and any reopen) fail.
+    // The open handle still reaches the old log.
+    std::filesystem::remove(logPath);
+    std::filesystem::create_directory(logPath);
+
+    REQUIRE(outbox.readBatch(36).size() == 36);
+    outbox.ack(36);
+    CHECK(outbox.isOpen());
+    CHECK(!std::filesystem::exists(dir.path() / "outbox.log.tmp"));
+    CHECK_EQ(outbox.append(makeScore(99)), uint64_t(41));
+    CHECK(seqs(outbox.readBatch(10)) == std::vector<uint64_t>({37, 38, 39, 40, 41}));
+}
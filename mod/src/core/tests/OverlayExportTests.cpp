@@ -0,0 +1,122 @@
+#include "Test.hpp"
+#include "OverlayExport.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace {
+    constexpr uint64_t PUBLISHES = 500000;
+
+    // Every field derived from `n`, so a copy mixing two publishes shows
+    void fill(OverlayState& state, uint64_t n) {
+        state.levelId = static_cast<int32_t>(n);
+        state.attempt = static_cast<int32_t>(n * 3);
+        state.percent = static_cast<float>(n % 100);
+        state.bestPercent = static_cast<float>(n % 7);
+        state.practice = static_cast<uint8_t>(n & 1);
+        state.setLevelName(std::string(1 + n % 60, static_cast<char>('a' + n % 26)));
+    }
+
+    bool consistent(const OverlayState& state) {
+        auto n = static_cast<uint64_t>(state.levelId);
+        OverlayState expected;
+        fill(expected, n);
+        return state.updatedAt == n && state.attempt == expected.attempt && state.percent == expected.percent &&
+               state.bestPercent == expected.bestPercent && state.practice == expected.practice &&
+               std::string(state.levelName) == expected.levelName;
+    }
+}
+
+TEST(overlayReaderNeverSeesATornState) {
+    Test::TempDir dir;
+    auto path = dir.path() / "overlay.bin";
+    OverlayWriter writer;
+    REQUIRE(writer.open(path, 1));
+
+    std::atomic<bool> done{false};
+    std::thread game([&] {
+        for (uint64_t n = 1; n <= PUBLISHES; n++) {
+            fill(writer.state(), n);
+            writer.publish(n);
+            if (n % 16 == 0) writer.pushEvent(OverlayEventType::Death, n);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    OverlayReader reader;
+    REQUIRE(reader.open(path));
+    uint64_t reads = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;
+    uint64_t last = 0;
+    std::vector<OverlayEvent> events;
+    while (!done.load(std::memory_order_acquire)) {
+        OverlayState state;
+        if (reader.readState(state)) {
+            reads++;
+            if (!consistent(state)) torn++;
+            if (state.updatedAt < last) backwards++;
+            last = state.updatedAt;
+        }
+        reader.readEvents(events);
+    }
+    game.join();
+
+    for (const auto& event : events) {
+        // Stamped with the publish it followed
+        if (event.levelId != static_cast<int32_t>(event.at) || event.attempt != static_cast<int32_t>(event.at * 3)) {
+            torn++;
+        }
+    }
+
+    OverlayState final;
+    REQUIRE(reader.readState(final));
+    CHECK_EQ(final.updatedAt, PUBLISHES);
+    CHECK(reads > 0);
+    CHECK_EQ(torn, uint64_t(0));
+    CHECK_EQ(backwards, uint64_t(0));
+}
+
+TEST(seqlockCellRejectsACopyAStoreOverlapped) {
+    SeqlockCell<OverlayEvent> cell;
+    OverlayEvent event;
+    CHECK_EQ(cell.load(event), uint64_t(0));
+
+    event.levelId = 7;
+    cell.store(event, 1);
+    OverlayEvent out;
+    CHECK_EQ(cell.load(out), uint64_t(1));
+    CHECK_EQ(out.levelId, 7);
+
+    // A writer stopped halfway leaves the sequence odd
+    cell.seq.store(3);
+    CHECK_EQ(cell.load(out), uint64_t(0));
+}
+
+TEST(overlayReaderPicksUpEventsInOrder) {
+    Test::TempDir dir;
+    auto path = dir.path() / "overlay.bin";
+    OverlayWriter writer;
+    REQUIRE(writer.open(path, 1));
+    OverlayReader reader;
+    REQUIRE(reader.open(path));
+
+    std::vector<OverlayEvent> events;
+    reader.readEvents(events); // starts at the newest
+    for (int i = 1; i <= 10; i++) {
+        writer.state().attempt = i;
+        writer.pushEvent(OverlayEventType::NewAttempt, static_cast<uint64_t>(i));
+    }
+    reader.readEvents(events);
+    REQUIRE(events.size() == 10);
+    for (int i = 0; i < 10; i++) CHECK_EQ(events[static_cast<size_t>(i)].attempt, i + 1);
+
+    // Lapping the ring loses the oldest, and says so
+    for (int i = 0; i < static_cast<int>(OverlayLayout::EVENT_CAPACITY) + 5; i++) {
+        writer.pushEvent(OverlayEventType::Death, 100);
+    }
+    events.clear();
+    reader.readEvents(events);
+    CHECK_EQ(events.size(), size_t(OverlayLayout::EVENT_CAPACITY));
+    CHECK_EQ(reader.lostEvents(), uint64_t(5));
+}
@@ -0,0 +1,134 @@
+#include "Test.hpp"
+#include "BatchPolicy.hpp"
+#include "FlushScheduler.hpp"
+#include "LruSet.hpp"
+#include "SpscRing.hpp"
+#include "StringTable.hpp"
+#include "SubmissionTracker.hpp"
+#include <thread>
+
+namespace {
+    using namespace std::chrono_literals;
+    const auto T0 = std::chrono::steady_clock::time_point{} + 1h;
+}
+
+TEST(spscRingIsFifoAndBounded) {
+    SpscRing<int, 4> ring;
+    for (int i = 0; i < 4; i++) CHECK(ring.push(i));
+    CHECK(!ring.push(4));
+    CHECK_EQ(ring.size(), size_t(4));
+
+    int value;
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(ring.pop(value));
+        CHECK_EQ(value, i);
+    }
+    CHECK(!ring.pop(value));
+}
+
+TEST(spscRingKeepsOrderAcrossThreads) {
+    constexpr int COUNT = 200000;
+    SpscRing<int, 64> ring;
+    std::thread producer([&] {
+        for (int i = 0; i < COUNT;) {
+            if (ring.push(i)) i++;
+            else std::this_thread::yield();
+        }
+    });
+
+    int expected = 0;
+    bool ordered = true;
+    while (expected < COUNT) {
+        int value;
+        if (!ring.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered &= value == expected++;
+    }
+    producer.join();
+    CHECK(ordered);
+}
+
+TEST(batchPolicyFlushesOnSizeAgeOrUrgency) {
+    BatchPolicy policy(4, 5s);
+    CHECK(!policy.shouldFlush(0, T0));
+
+    policy.onQueued(T0, false);
+    CHECK(!policy.shouldFlush(1, T0 + 4s));
+    CHECK(policy.shouldFlush(1, T0 + 5s));
+    CHECK(policy.shouldFlush(4, T0));
+
+    policy.onFlushed(0, T0 + 5s);
+    policy.onQueued(T0 + 6s, true);
+    CHECK(policy.shouldFlush(1, T0 + 6s));
+}
+
+TEST(batchPolicyTreatsLeftoversAsOverdue) {
+    BatchPolicy policy(32, 5s);
+    CHECK(policy.shouldFlush(3, T0));
+}
+
+TEST(submissionTrackerAcksOnlyAPrefix) {
+    SubmissionTracker tracker(2);
+    uint64_t first = tracker.start(10, 10);
+    uint64_t second = tracker.start(20, 10);
+    CHECK(!tracker.canStart());
+
+    // The later batch finishing first can't be acknowledged yet
+    CHECK_EQ(tracker.complete(second), uint64_t(0));
+    CHECK_EQ(tracker.complete(first), uint64_t(20));
+    CHECK_EQ(tracker.stats().delivered, uint64_t(20));
+    CHECK(tracker.canStart());
+}
+
+TEST(submissionTrackerStopsAfterAFailure) {
+    SubmissionTracker tracker(2);
+    uint64_t first = tracker.start(10, 10);
+    uint64_t second = tracker.start(20, 10);
+    tracker.fail(first);
+    CHECK(!tracker.canStart());
+    CHECK(!tracker.needsRewind());
+
+    tracker.complete(second);
+    CHECK(tracker.needsRewind());
+    tracker.reset();
+    CHECK(tracker.canStart());
+}
+
+TEST(flushSchedulerHoldsWhilePlaying) {
+    FlushScheduler scheduler(3, 2min);
+    CHECK(!scheduler.setState(GameState::Playing));
+    CHECK(scheduler.shouldHold(1, T0));
+    CHECK(!scheduler.shouldHold(3, T0));
+    CHECK(!scheduler.shouldHold(1, T0 + 2min));
+
+    // Pausing ends the stretch of play, the moment to send
+    CHECK(scheduler.setState(GameState::Paused));
+    CHECK(!scheduler.shouldHold(1, T0));
+
+    scheduler.setEnabled(false);
+    scheduler.setState(GameState::Playing);
+    CHECK(!scheduler.shouldHold(1, T0));
+}
+
+TEST(stringTableInternsOnce) {
+    StringTable strings;
+    uint32_t a = strings.intern("Bloodbath");
+    CHECK_EQ(strings.intern("Bloodbath"), a);
+    CHECK(strings.intern("Sonic Wave") != a);
+    CHECK_EQ(strings.lookup(a), std::string("Bloodbath"));
+    CHECK_EQ(strings.intern(""), uint32_t(0));
+    CHECK_EQ(strings.lookup(9999), std::string());
+}
+
+TEST(lruSetForgetsTheLeastRecentlyUsed) {
+    LruSet<int> set(2);
+    set.insert(1);
+    set.insert(2);
+    CHECK(set.contains(1));
+    set.insert(3);
+    CHECK(set.contains(1));
+    CHECK(!set.contains(2));
+    CHECK(set.contains(3));
+}
@@ -0,0 +1,319 @@
+#include "Test.hpp"
+#include "RangeSync.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+
+namespace {
+    // server/src/routes/sync.ts
+    constexpr size_t MAX_RANGES_PER_ROUND = 64;
+    constexpr size_t MAX_DIFF_SIZE = 1024;
+    constexpr uint32_t LEAF_SIZE = 32;
+    constexpr uint32_t FANOUT = 16;
+
+    constexpr size_t HISTORY_SIZE = 100000;
+
+    SyncKey keyOf(const HistoryRecord& record) {
+        return {record.levelId, record.playedAt};
+    }
+
+    std::string hex(uint64_t hash) {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(16, '0');
+        for (int i = 15; i >= 0; i--, hash >>= 4) out[static_cast<size_t>(i)] = digits[hash & 15];
+        return out;
+    }
+
+    std::string keyJson(const SyncKey& key) {
+        char out[48];
+        int size = std::snprintf(out, sizeof(out), "[%d,%lld]", key.levelId, static_cast<long long>(key.playedAt));
+        return std::string(out, static_cast<size_t>(size));
+    }
+
+    std::string itemJson(const HistoryRecord& record) {
+        char out[256];
+        int size = std::snprintf(out, sizeof(out),
+                                 "{\"hash\":\"%s\",\"level_id\":%d,\"played_at\":%lld,\"percentage\":%d,"
+                                 "\"attempts\":%d,\"passed\":%s,\"is_practice\":false,\"coins\":[],\"name\":\"\"}",
+                                 hex(syncHash(record)).c_str(), record.levelId,
+                                 static_cast<long long>(record.playedAt), record.percentage, record.attempts,
+                                 record.passed ? "true" : "false");
+        return std::string(out, static_cast<size_t>(size));
+    }
+
+    // The server's answers to /api/sync, over an in-memory scores table, with the
+    // size of the JSON both ways
+    class ModelServer {
+    public:
+        explicit ModelServer(std::vector<HistoryRecord> scores) : m_scores(std::move(scores)) {
+            std::sort(m_scores.begin(), m_scores.end(),
+                      [](const HistoryRecord& a, const HistoryRecord& b) { return keyOf(a) < keyOf(b); });
+        }
+
+        size_t rounds = 0;
+        size_t bytesSent = 0;
+        size_t bytesReceived = 0;
+
+        // One request's worth of ranges, answered into `sync`
+        void round(RangeReconciler& sync) {
+            rounds++;
+            auto ranges = sync.takeRequest(MAX_RANGES_PER_ROUND);
+            bytesSent += 40; // auth token, since
+            bytesReceived += 30;
+            for (const auto& range : ranges) answer(sync, range);
+        }
+
+        void run(RangeReconciler& sync) {
+            while (!sync.done() && rounds < 10000) round(sync);
+        }
+
+    private:
+        using Iterator = std::vector<HistoryRecord>::const_iterator;
+
+        std::pair<Iterator, Iterator> span(const SyncKey& from, const SyncKey* to) const {
+            auto less = [](const HistoryRecord& record, const SyncKey& key) { return keyOf(record) < key; };
+            auto begin = std::lower_bound(m_scores.begin(), m_scores.end(), from, less);
+            auto end = to ? std::lower_bound(begin, m_scores.end(), *to, less) : m_scores.end();
+            return {begin, end};
+        }
+
+        static uint64_t hashSum(Iterator begin, Iterator end) {
+            uint64_t sum = 0;
+            for (auto it = begin; it != end; ++it) sum += syncHash(*it);
+            return sum;
+        }
+
+        static std::vector<RemoteRecord> remote(const std::vector<HistoryRecord>& records, size_t& bytes) {
+            std::vector<RemoteRecord> out;
+            for (const auto& record : records) {
+                bytes += itemJson(record).size() + 1;
+                out.push_back({record, ""});
+            }
+            return out;
+        }
+
+        void answer(RangeReconciler& sync, const SyncRange& range) {
+            bool listed = range.count <= RangeReconciler::ITEM_LIST_SIZE;
+            auto local = sync.localItems(range);
+
+            bytesSent += 60 + keyJson(range.from).size() + (range.open ? 0 : keyJson(range.to).size());
+            if (listed) bytesSent += 10 + local.size() * 19;
+
+            auto [begin, end] = span(range.from, range.open ? nullptr : &range.to);
+            auto count = static_cast<uint32_t>(end - begin);
+            if (count == range.count && hashSum(begin, end) == range.hash) {
+                bytesReceived += 19;
+                return;
+            }
+
+            if (listed && count <= MAX_DIFF_SIZE) {
+                std::map<uint64_t, std::vector<size_t>> unmatched;
+                for (size_t i = 0; i < local.size(); i++) unmatched[syncHash(local[i])].push_back(i);
+
+                std::vector<HistoryRecord> serverOnly;
+                for (auto it = begin; it != end; ++it) {
+                    auto waiting = unmatched.find(syncHash(*it));
+                    if (waiting != unmatched.end() && !waiting->second.empty()) {
+                        waiting->second.pop_back();
+                    } else {
+                        serverOnly.push_back(*it);
+                    }
+                }
+                std::vector<size_t> missing;
+                for (const auto& [hash, indexes] : unmatched) missing.insert(missing.end(), indexes.begin(), indexes.end());
+                std::sort(missing.begin(), missing.end());
+
+                bytesReceived += 40 + missing.size() * 6;
+                sync.onDiff(range, missing, remote(serverOnly, bytesReceived));
+                return;
+            }
+
+            if (count > LEAF_SIZE) {
+                auto parts = split(range, begin, end);
+                if (!parts.empty()) {
+                    for (const auto& part : parts) {
+                        bytesReceived += 50 + keyJson(part.from).size() + (part.open ? 0 : keyJson(part.to).size());
+                    }
+                    sync.onSplit(parts);
+                    return;
+                }
+            }
+
+            bytesReceived += 30;
+            sync.onItems(range, remote({begin, end}, bytesReceived));
+        }
+
+        // Cuts at every ceil(count / FANOUT)-th key, each key only once
+        std::vector<SyncRange> split(const SyncRange& range, Iterator begin, Iterator end) const {
+            auto count = static_cast<size_t>(end - begin);
+            size_t step = (count + FANOUT - 1) / FANOUT;
+
+            std::vector<SyncKey> bounds;
+            SyncKey last = range.from;
+            for (size_t n = step; n < count; n += step) {
+                SyncKey key = keyOf(begin[static_cast<std::ptrdiff_t>(n)]);
+                if (key == last) continue;
+                bounds.push_back(key);
+                last = key;
+            }
+
+            std::vector<SyncRange> parts;
+            if (bounds.empty()) return parts;
+            std::vector<SyncKey> edges{range.from};
+            edges.insert(edges.end(), bounds.begin(), bounds.end());
+            for (size_t i = 0; i < edges.size(); i++) {
+                SyncRange part;
+                part.from = edges[i];
+                bool lastPart = i + 1 == edges.size();
+                part.open = lastPart && range.open;
+                if (!part.open) part.to = lastPart ? range.to : edges[i + 1];
+                auto [partBegin, partEnd] = span(part.from, part.open ? nullptr : &part.to);
+                part.count = static_cast<uint32_t>(partEnd - partBegin);
+                part.hash = hashSum(partBegin, partEnd);
+                parts.push_back(part);
+            }
+            return parts;
+        }
+
+        std::vector<HistoryRecord> m_scores;
+    };
+
+    // `count` scores over a few thousand levels, a few per level and minute
+    std::vector<HistoryRecord> makeHistory(size_t count, uint32_t seed, int64_t start = 1700000000000) {
+        std::mt19937 random(seed);
+        std::vector<HistoryRecord> records;
+        records.reserve(count);
+        int64_t playedAt = start;
+        for (size_t i = 0; i < count; i++) {
+            HistoryRecord record;
+            record.levelId = 1 + static_cast<int>(random() % 3000);
+            playedAt += 1 + static_cast<int64_t>(random() % 60000);
+            record.playedAt = playedAt;
+            record.percentage = static_cast<int>(random() % 101);
+            record.attempts = 1 + static_cast<int>(random() % 200);
+            record.passed = record.percentage == 100;
+            records.push_back(record);
+        }
+        return records;
+    }
+
+    std::vector<SyncKey> keys(const std::vector<HistoryRecord>& records) {
+        std::vector<SyncKey> out;
+        for (const auto& record : records) out.push_back(keyOf(record));
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    std::vector<SyncKey> keys(const std::vector<RemoteRecord>& records) {
+        std::vector<SyncKey> out;
+        for (const auto& remote : records) out.push_back(keyOf(remote.record));
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+}
+
+TEST(rangeSyncIdenticalHistoriesMatchInOneRound) {
+    auto history = makeHistory(HISTORY_SIZE, 1);
+    ModelServer server(history);
+    RangeReconciler sync(history);
+    server.run(sync);
+
+    CHECK_EQ(server.rounds, size_t(1));
+    CHECK(sync.missingOnServer().empty());
+    CHECK(sync.missingLocally().empty());
+    CHECK(server.bytesSent + server.bytesReceived < 300);
+}
+
+TEST(rangeSyncDisjointHistoriesSwapEverything) {
+    auto local = makeHistory(HISTORY_SIZE, 2);
+    // Played later, no key in common
+    auto remote = makeHistory(HISTORY_SIZE, 3, 1800000000000);
+    ModelServer server(remote);
+    RangeReconciler sync(local);
+    server.run(sync);
+
+    CHECK_EQ(sync.missingOnServer().size(), HISTORY_SIZE);
+    CHECK_EQ(sync.missingLocally().size(), HISTORY_SIZE);
+    CHECK(keys(sync.missingLocally()) == keys(remote));
+    // The server's scores all come down, and cost about what they'd cost listed in full
+    size_t full = 0;
+    for (const auto& record : remote) full += itemJson(record).size() + 1;
+    CHECK(server.bytesReceived >= full);
+    CHECK(server.bytesReceived < full + full / 4);
+    CHECK(server.bytesSent < HISTORY_SIZE * 24);
+    // Leaf ranges of a few dozen scores, 64 of them a round
+    CHECK(server.rounds <= 2 * HISTORY_SIZE / LEAF_SIZE / MAX_RANGES_PER_ROUND);
+}
+
+TEST(rangeSyncNearIdenticalHistoriesSendOnlyTheDifference) {
+    auto history = makeHistory(HISTORY_SIZE, 4);
+    auto local = history;
+    auto remote = history;
+
+    // Five only on the device, five only on the server, two edited on one side
+    std::mt19937 random(5);
+    std::vector<SyncKey> localOnly, remoteOnly;
+    for (int i = 0; i < 5; i++) {
+        size_t index = random() % remote.size();
+        localOnly.push_back(keyOf(remote[index]));
+        remote.erase(remote.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+    for (int i = 0; i < 5; i++) {
+        size_t index = random() % local.size();
+        remoteOnly.push_back(keyOf(local[index]));
+        local.erase(local.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+    for (int i = 0; i < 2; i++) {
+        size_t index = random() % remote.size();
+        remote[index].percentage = (remote[index].percentage + 1) % 100;
+        localOnly.push_back(keyOf(remote[index]));
+        remoteOnly.push_back(keyOf(remote[index]));
+    }
+    std::sort(localOnly.begin(), localOnly.end());
+    std::sort(remoteOnly.begin(), remoteOnly.end());
+
+    ModelServer server(remote);
+    RangeReconciler sync(local);
+    server.run(sync);
+
+    CHECK(keys(sync.missingOnServer()) == localOnly);
+    CHECK(keys(sync.missingLocally()) == remoteOnly);
+    // About log16(100k / 32) splits deep, each round taking every differing range
+    CHECK(server.rounds <= 6);
+    // Versus megabytes for either side's full list
+    CHECK(server.bytesSent + server.bytesReceived < 64 * 1024);
+}
+
+TEST(rangeSyncHandlesScoresSharingAKey) {
+    // Runs of scores recorded in the same millisecond, more than a leaf holds
+    std::vector<HistoryRecord> local;
+    for (int level = 1; level <= 40; level++) {
+        for (int i = 0; i < 50; i++) {
+            HistoryRecord record;
+            record.levelId = level;
+            record.playedAt = 1700000000000 + i / 25;
+            record.percentage = i;
+            record.attempts = i + 1;
+            local.push_back(record);
+        }
+    }
+    auto remote = local;
+    // One copy of a duplicated key missing on each side, one changed
+    remote.erase(remote.begin() + 1030);
+    local.erase(local.begin() + 10);
+    remote[1500].attempts = 999;
+
+    ModelServer server(remote);
+    RangeReconciler sync(local);
+    server.run(sync);
+
+    std::vector<SyncKey> localOnly{keyOf(local[1029]), keyOf(local[1500])};
+    std::vector<SyncKey> remoteOnly{keyOf(remote[10]), keyOf(remote[1500])};
+    std::sort(localOnly.begin(), localOnly.end());
+    std::sort(remoteOnly.begin(), remoteOnly.end());
+    CHECK(keys(sync.missingOnServer()) == localOnly);
+    CHECK(keys(sync.missingLocally()) == remoteOnly);
+    REQUIRE(sync.missingLocally().size() == 2);
+    CHECK(server.rounds < 10);
+}
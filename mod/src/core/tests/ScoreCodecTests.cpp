@@ -0,0 +1,97 @@
+#include "Test.hpp"
+#include "ScoreCodec.hpp"
+
+namespace {
+    ScoreData makeScore(int levelId, int percentage) {
+        ScoreData score{};
+        score.levelId = levelId;
+        score.levelName = "Level " + std::to_string(levelId);
+        score.levelCreator = "Creator";
+        score.percentage = percentage;
+        score.attempts = 12;
+        score.passed = percentage == 100;
+        score.isPractice = false;
+        score.coinsCollected = {true, false, true};
+        score.seq = static_cast<uint64_t>(levelId) * 3;
+        score.playedAt = 1700000000123;
+        return score;
+    }
+
+    ScoreCodec::SessionHeader makeHeader() {
+        ScoreCodec::SessionHeader header;
+        header.authToken = "token";
+        header.gdAccountId = 71;
+        header.gdUsername = "Player";
+        header.installId = "00000000deadbeef";
+        return header;
+    }
+}
+
+TEST(scoreCodecRoundTripsABatch) {
+    std::vector<ScoreData> scores = {makeScore(10, 37), makeScore(-5, 100)};
+    scores[1].timeline = {1, 2, 3, 4};
+    LevelMeta level;
+    level.levelId = 10;
+    level.name = "Level 10";
+    level.isDemon = true;
+    level.likes = -3;
+
+    auto data = ScoreCodec::encodeBatch(makeHeader(), scores, {level});
+
+    ScoreCodec::SessionHeader header;
+    std::vector<ScoreData> decoded;
+    std::vector<LevelMeta> levels;
+    REQUIRE(ScoreCodec::decodeBatch(data, header, decoded, levels));
+    CHECK_EQ(header.authToken, std::string("token"));
+    CHECK_EQ(header.gdAccountId, 71);
+    CHECK_EQ(header.installId, std::string("00000000deadbeef"));
+
+    REQUIRE(decoded.size() == 2);
+    for (size_t i = 0; i < decoded.size(); i++) {
+        CHECK_EQ(decoded[i].levelId, scores[i].levelId);
+        CHECK_EQ(decoded[i].percentage, scores[i].percentage);
+        CHECK_EQ(decoded[i].attempts, scores[i].attempts);
+        CHECK_EQ(decoded[i].passed, scores[i].passed);
+        CHECK(decoded[i].coinsCollected == scores[i].coinsCollected);
+        CHECK(decoded[i].timeline == scores[i].timeline);
+        CHECK_EQ(decoded[i].seq, scores[i].seq);
+        CHECK_EQ(decoded[i].playedAt, scores[i].playedAt);
+    }
+
+    REQUIRE(levels.size() == 1);
+    CHECK_EQ(levels[0].name, std::string("Level 10"));
+    CHECK(levels[0].isDemon);
+    CHECK_EQ(levels[0].likes, -3);
+}
+
+TEST(scoreCodecRejectsEveryTruncation) {
+    auto data = ScoreCodec::encodeBatch(makeHeader(), {makeScore(1, 50), makeScore(2, 60)});
+    for (size_t size = 0; size < data.size(); size++) {
+        std::vector<uint8_t> cut(data.begin(), data.begin() + static_cast<std::ptrdiff_t>(size));
+        ScoreCodec::SessionHeader header;
+        std::vector<ScoreData> scores;
+        CHECK(!ScoreCodec::decodeBatch(cut, header, scores));
+    }
+}
+
+TEST(scoreCodecRejectsNewerVersions) {
+    auto data = ScoreCodec::encodeBatch(makeHeader(), {makeScore(1, 50)});
+    data[2] = ScoreCodec::VERSION + 1;
+    ScoreCodec::SessionHeader header;
+    std::vector<ScoreData> scores;
+    CHECK(!ScoreCodec::decodeBatch(data, header, scores));
+}
+
+TEST(varintsRoundTripAtTheEdges) {
+    const int64_t values[] = {0, 1, -1, 63, -64, 64, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN};
+    std::vector<uint8_t> out;
+    for (int64_t value : values) ScoreCodec::writeVarInt(out, value);
+
+    size_t pos = 0;
+    for (int64_t value : values) {
+        int64_t decoded;
+        REQUIRE(ScoreCodec::readVarInt(out.data(), out.size(), pos, decoded));
+        CHECK_EQ(decoded, value);
+    }
+    CHECK_EQ(pos, out.size());
+}
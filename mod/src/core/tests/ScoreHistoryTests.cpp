@@ -0,0 +1,221 @@
+#include "Test.hpp"
+#include "ScoreHistory.hpp"
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+
+namespace {
+    constexpr int64_t PLAYED = 1700000000000;
+
+    ScoreData makeScore(int levelId, int percentage, int attempts, bool passed = false) {
+        ScoreData score{};
+        score.levelId = levelId;
+        score.levelName = "Level " + std::to_string(levelId);
+        score.percentage = percentage;
+        score.attempts = attempts;
+        score.passed = passed;
+        score.coinsCollected = {true, false, true};
+        return score;
+    }
+
+    // Two sessions on one level: three attempts, then two
+    std::vector<std::pair<ScoreData, int64_t>> twoSessions(int levelId) {
+        return {
+            {makeScore(levelId, 10, 1), PLAYED + 1000},
+            {makeScore(levelId, 25, 2), PLAYED + 2000},
+            {makeScore(levelId, 40, 3), PLAYED + 3000},
+            {makeScore(levelId, 15, 1), PLAYED + 90000},
+            {makeScore(levelId, 100, 2, true), PLAYED + 95000},
+        };
+    }
+}
+
+TEST(scoreHistoryAppendsAndLooksUpLevels) {
+    Test::TempDir dir;
+    ScoreHistory history(dir.path());
+    CHECK_EQ(history.recordCount(), size_t(0));
+
+    REQUIRE(history.append(makeScore(128, 30, 4), PLAYED));
+    REQUIRE(history.append(makeScore(77, 100, 1, true), PLAYED + 10));
+    REQUIRE(history.append(makeScore(128, 55, 9), PLAYED + 20));
+    CHECK(!history.append(makeScore(0, 10, 1), PLAYED));
+
+    LevelHistory level;
+    REQUIRE(history.level(128, level));
+    CHECK_EQ(level.name, std::string("Level 128"));
+    CHECK_EQ(level.bestPercentage, 55);
+    CHECK(!level.completed);
+    CHECK_EQ(level.totalAttempts, uint64_t(9));
+    CHECK_EQ(level.lastPlayed, PLAYED + 20);
+    CHECK_EQ(level.recordCount, uint32_t(2));
+    REQUIRE(history.level(77, level));
+    CHECK(level.completed);
+    CHECK(!history.level(5, level));
+
+    auto records = history.levelRecords(128, 10);
+    REQUIRE(records.size() == 2);
+    CHECK_EQ(records[0].percentage, 55);
+    CHECK_EQ(records[1].percentage, 30);
+    CHECK_EQ(records[1].coinCount, 3);
+    CHECK_EQ(records[1].coinMask, uint64_t(0b101));
+
+    auto recent = history.recent(2);
+    REQUIRE(recent.size() == 2);
+    CHECK_EQ(recent[0].levelId, 128);
+    CHECK_EQ(recent[1].levelId, 77);
+    CHECK_EQ(history.recordsSince(PLAYED + 10).size(), size_t(2));
+
+    // Everything is on disk
+    ScoreHistory reopened(dir.path());
+    CHECK_EQ(reopened.recordCount(), size_t(3));
+    REQUIRE(reopened.level(128, level));
+    CHECK_EQ(level.totalAttempts, uint64_t(9));
+}
+
+TEST(scoreHistoryGrowsTheIndexPastItsFirstSlots) {
+    Test::TempDir dir;
+    {
+        ScoreHistory history(dir.path());
+        for (int id = 1; id <= 2000; id++) REQUIRE(history.append(makeScore(id * 37, id % 100, 1), PLAYED + id));
+        int found = 0;
+        LevelHistory level;
+        for (int id = 1; id <= 2000; id++) found += history.level(id * 37, level) && level.recordCount == 1;
+        CHECK_EQ(found, 2000);
+    }
+
+    ScoreHistory history(dir.path());
+    LevelHistory level;
+    REQUIRE(history.level(1999 * 37, level));
+    CHECK_EQ(level.bestPercentage, 99);
+    CHECK_EQ(level.lastPlayed, PLAYED + 1999);
+    CHECK(!history.level(38, level));
+}
+
+TEST(scoreHistoryRebuildsFromATruncatedLog) {
+    Test::TempDir dir;
+    {
+        ScoreHistory history(dir.path());
+        for (int i = 0; i < 3000; i++) REQUIRE(history.append(makeScore(1 + i % 10, i % 90, 1), PLAYED + i));
+    }
+
+    // Cut partway into record 2000, as if the log's tail never made it to disk. The
+    // index remembers 3000 records and has to be rebuilt.
+    auto logPath = dir.path() / "history.log";
+    std::filesystem::resize_file(logPath, 32 + 2000 * 40 + 13);
+
+    ScoreHistory history(dir.path());
+    CHECK_EQ(history.recordCount(), size_t(2000));
+    LevelHistory level;
+    REQUIRE(history.level(1, level));
+    CHECK_EQ(level.recordCount, uint32_t(200));
+    CHECK_EQ(level.lastPlayed, PLAYED + 1990);
+    auto records = history.levelRecords(1, 1000);
+    CHECK_EQ(records.size(), size_t(200));
+    CHECK_EQ(records.front().playedAt, PLAYED + 1990);
+
+    // Appends continue after the last whole record
+    REQUIRE(history.append(makeScore(1, 89, 1), PLAYED + 5000));
+    CHECK_EQ(history.recordCount(), size_t(2001));
+    CHECK_EQ(history.levelRecords(1, 1).front().playedAt, PLAYED + 5000);
+}
+
+TEST(scoreHistoryRebuildsALostIndex) {
+    Test::TempDir dir;
+    {
+        ScoreHistory history(dir.path());
+        for (const auto& [score, playedAt] : twoSessions(128)) history.append(score, playedAt);
+    }
+    std::filesystem::remove(dir.path() / "history.idx");
+
+    ScoreHistory history(dir.path());
+    LevelHistory level;
+    REQUIRE(history.level(128, level));
+    CHECK_EQ(level.recordCount, uint32_t(5));
+    CHECK_EQ(level.totalAttempts, uint64_t(5));
+    CHECK(level.completed);
+}
+
+TEST(scoreHistoryCountsAttemptsInPlayOrder) {
+    // Recorded as played, and as a history sync could deliver them: older scores
+    // from the server after newer local ones, in any order
+    auto played = twoSessions(128);
+    std::mt19937 random(7);
+    for (int round = 0; round < 20; round++) {
+        Test::TempDir dir;
+        ScoreHistory history(dir.path());
+        auto order = played;
+        if (round > 0) std::shuffle(order.begin(), order.end(), random);
+        for (const auto& [score, playedAt] : order) REQUIRE(history.append(score, playedAt));
+
+        LevelHistory level;
+        REQUIRE(history.level(128, level));
+        CHECK_EQ(level.totalAttempts, uint64_t(5));
+        CHECK_EQ(level.lastPlayed, PLAYED + 95000);
+
+        // And in order again after that
+        REQUIRE(history.append(makeScore(128, 50, 3), PLAYED + 96000));
+        REQUIRE(history.level(128, level));
+        CHECK_EQ(level.totalAttempts, uint64_t(6));
+    }
+}
+
+TEST(scoreHistoryHandlesTensOfThousandsOfRecords) {
+    Test::TempDir dir;
+    constexpr int RECORDS = 50000;
+    constexpr int LEVELS = 500;
+    {
+        ScoreHistory history(dir.path());
+        // Every level played in sessions of ten attempts
+        for (int i = 0; i < RECORDS; i++) {
+            int run = i / LEVELS;
+            REQUIRE(history.append(makeScore(1000 + i % LEVELS, run % 100, 1 + run % 10), PLAYED + i));
+        }
+    }
+
+    ScoreHistory history(dir.path());
+    CHECK_EQ(history.recordCount(), size_t(RECORDS));
+    LevelHistory level;
+    REQUIRE(history.level(1000 + 123, level));
+    CHECK_EQ(level.recordCount, uint32_t(RECORDS / LEVELS));
+    CHECK_EQ(level.totalAttempts, uint64_t(RECORDS / LEVELS));
+    CHECK_EQ(level.bestPercentage, 99);
+    CHECK_EQ(history.levelRecords(1000 + 123, 5000).size(), size_t(RECORDS / LEVELS));
+    CHECK_EQ(history.recent(50).size(), size_t(50));
+    CHECK_EQ(history.recordsSince(PLAYED + RECORDS - 10).size(), size_t(10));
+}
+
+TEST(scoreHistoryReadsWhileAWorkerAppends) {
+    Test::TempDir dir;
+    ScoreHistory history(dir.path());
+    constexpr int RECORDS = 20000;
+
+    // The worker records scores, growing the log and the index under the reader
+    std::atomic<bool> done{false};
+    std::thread worker([&] {
+        for (int i = 0; i < RECORDS; i++) history.append(makeScore(1 + i % 300, i % 100, 1 + i), PLAYED + i);
+        done.store(true, std::memory_order_release);
+    });
+
+    int bad = 0;
+    uint32_t lastCount = 0;
+    while (!done.load(std::memory_order_acquire)) {
+        LevelHistory level;
+        if (history.level(1, level)) {
+            bad += level.recordCount < lastCount;
+            lastCount = level.recordCount;
+        }
+        auto records = history.levelRecords(1, 50);
+        for (size_t i = 0; i < records.size(); i++) {
+            bad += records[i].levelId != 1;
+            if (i > 0) bad += records[i].playedAt >= records[i - 1].playedAt;
+        }
+    }
+    worker.join();
+
+    CHECK_EQ(bad, 0);
+    LevelHistory level;
+    REQUIRE(history.level(1, level));
+    CHECK_EQ(level.recordCount, uint32_t(RECORDS / 300 + 1));
+    CHECK_EQ(history.recordCount(), size_t(RECORDS));
+}
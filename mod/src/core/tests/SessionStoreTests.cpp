@@ -0,0 +1,100 @@
+#include "Test.hpp"
+#include "SessionStore.hpp"
+#include <fstream>
+
+namespace {
+    SessionSummary makeSummary(int attempts) {
+        SessionSummary summary;
+        summary.levelId = 4284013;
+        summary.attempts = attempts;
+        summary.bestPercentage = 40 + attempts;
+        summary.timeAliveMs = 12000;
+        summary.startedAt = 1700000000000;
+        summary.endedAt = 1700000600000;
+        summary.deaths.add(37.5f, static_cast<uint32_t>(attempts));
+        return summary;
+    }
+
+    std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    void writeFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::vector<int> attempts(const std::vector<SessionSummary>& summaries) {
+        std::vector<int> out;
+        for (const auto& summary : summaries) out.push_back(summary.attempts);
+        return out;
+    }
+}
+
+TEST(sessionStoreRoundTripsSummaries) {
+    Test::TempDir dir;
+    SessionStore store(dir.path());
+    REQUIRE(store.append(makeSummary(1)));
+    REQUIRE(store.append(makeSummary(2)));
+
+    auto pending = store.loadPending(10);
+    REQUIRE(pending.size() == 2);
+    CHECK_EQ(pending[1].bestPercentage, 42);
+    CHECK_EQ(pending[1].endedAt, int64_t(1700000600000));
+    CHECK_EQ(pending[1].deaths.total(), uint64_t(2));
+    CHECK_EQ(store.loadPending(1).size(), size_t(1));
+}
+
+TEST(sessionStoreCutsATornTail) {
+    Test::TempDir dir;
+    auto path = dir.path() / "sessions.pending";
+    size_t boundary;
+    {
+        SessionStore store(dir.path());
+        store.append(makeSummary(1));
+        store.append(makeSummary(2));
+        boundary = std::filesystem::file_size(path);
+        store.append(makeSummary(3));
+    }
+    auto full = readFile(path);
+
+    // A crash partway into the length prefix, just after it, and partway into the payload
+    for (size_t cut : {boundary + 2, boundary + 4, full.size() - 3}) {
+        writeFile(path, {full.begin(), full.begin() + static_cast<std::ptrdiff_t>(cut)});
+
+        SessionStore store(dir.path());
+        CHECK(attempts(store.loadPending(10)) == std::vector<int>({1, 2}));
+        // The next append starts where the last whole record ended
+        REQUIRE(store.append(makeSummary(4)));
+        CHECK_EQ(std::filesystem::file_size(path), full.size());
+        CHECK(attempts(store.loadPending(10)) == std::vector<int>({1, 2, 4}));
+    }
+}
+
+TEST(sessionStoreSkipsSummariesThatDontDecode) {
+    Test::TempDir dir;
+    auto path = dir.path() / "sessions.pending";
+    {
+        SessionStore store(dir.path());
+        store.append(makeSummary(1));
+    }
+    // Zeroed blocks, as a filesystem can leave behind after a crash: empty records
+    auto data = readFile(path);
+    data.resize(data.size() + 8, 0);
+    writeFile(path, data);
+
+    SessionStore store(dir.path());
+    REQUIRE(store.append(makeSummary(2)));
+    REQUIRE(store.append(makeSummary(3)));
+    CHECK(attempts(store.loadPending(10)) == std::vector<int>({1, 2, 3}));
+
+    // The empty records go along with the summaries uploaded around them
+    store.markUploaded(2);
+    CHECK(attempts(store.loadPending(10)) == std::vector<int>({3}));
+    CHECK(!std::filesystem::exists(dir.path() / "sessions.pending.tmp"));
+
+    store.markUploaded(1);
+    CHECK(store.loadPending(10).empty());
+    CHECK(!std::filesystem::exists(path));
+}
@@ -0,0 +1,138 @@
+#include "Test.hpp"
+#include "AllocationCounter.hpp"
+#include "SubmitWorker.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace std::chrono_literals;
+    using Clock = std::chrono::steady_clock;
+
+    AttemptTimeline makeTimeline(int seconds) {
+        AttemptTimeline timeline;
+        for (int frame = 0; frame < seconds * 240; frame++) {
+            timeline.add(frame / 240.0, static_cast<float>(frame) * 2.5f);
+        }
+        return timeline;
+    }
+}
+
+TEST(submitWorkerDeliversInOrderAndDrainsOnStop) {
+    std::vector<int> seen;
+    SubmitWorker worker([&](const ScoreEvent& event, const AttemptTimeline*) { seen.push_back(event.attempts); });
+    worker.start();
+    for (int i = 0; i < 100; i++) {
+        ScoreEvent event{};
+        event.attempts = i;
+        while (!worker.push(event)) std::this_thread::yield();
+    }
+    worker.stop();
+
+    REQUIRE(seen.size() == 100);
+    for (int i = 0; i < 100; i++) CHECK_EQ(seen[static_cast<size_t>(i)], i);
+}
+
+TEST(submitWorkerWakesOnPush) {
+    std::mutex mutex;
+    std::condition_variable delivered;
+    Clock::time_point receivedAt{};
+    SubmitWorker worker([&](const ScoreEvent&, const AttemptTimeline*) {
+        std::lock_guard lock(mutex);
+        receivedAt = Clock::now();
+        delivered.notify_one();
+    });
+    worker.start();
+    // Let the worker go to sleep first, the push has to wake it
+    std::this_thread::sleep_for(50ms);
+
+    auto pushedAt = Clock::now();
+    REQUIRE(worker.push(ScoreEvent{}));
+    std::unique_lock lock(mutex);
+    REQUIRE(delivered.wait_for(lock, 1s, [&] { return receivedAt != Clock::time_point{}; }));
+    lock.unlock();
+    worker.stop();
+
+    // A sleep poll would take up to its whole interval; a wake is well under a millisecond
+    // on an idle machine, so this only allows for a loaded CI runner
+    CHECK(receivedAt - pushedAt < 15ms);
+}
+
+TEST(submitWorkerCountsDropsWhenFull) {
+    std::atomic<bool> release{false};
+    SubmitWorker worker([&](const ScoreEvent&, const AttemptTimeline*) {
+        while (!release.load()) std::this_thread::yield();
+    });
+    worker.start();
+
+    // The worker holds one event in the sink, so the ring fills after this many
+    int accepted = 0;
+    for (int i = 0; i < 1000; i++) accepted += worker.push(ScoreEvent{}) ? 1 : 0;
+    CHECK(accepted < 1000);
+    CHECK_EQ(worker.dropped(), uint64_t(1000 - accepted));
+
+    release = true;
+    worker.stop();
+}
+
+TEST(submitWorkerCarriesTheTimelineToTheSink) {
+    auto timeline = makeTimeline(30);
+    std::vector<uint8_t> encoded;
+    int withoutTimeline = 0;
+    SubmitWorker worker([&](const ScoreEvent& event, const AttemptTimeline* received) {
+        if (received) encoded = received->encode();
+        else withoutTimeline += event.attempts;
+    });
+    worker.start();
+
+    ScoreEvent event{};
+    event.attempts = 1;
+    REQUIRE(worker.push(event, &timeline));
+    REQUIRE(worker.push(event));
+    worker.stop();
+
+    CHECK(encoded == timeline.encode());
+    CHECK_EQ(withoutTimeline, 1);
+}
+
+TEST(submitWorkerPushDoesNotAllocate) {
+    auto timeline = makeTimeline(30);
+    SubmitWorker worker([](const ScoreEvent&, const AttemptTimeline* received) {
+        // The encode the game thread used to do, now on the worker
+        if (received) (void)received->encode();
+    });
+    worker.start();
+
+    ScoreEvent event{};
+    bool pushed = true;
+    {
+        CountAllocations allocations;
+        for (int i = 0; i < 8; i++) pushed &= worker.push(event, &timeline);
+        CHECK_EQ(allocations.count(), uint64_t(0));
+    }
+    worker.stop();
+    CHECK(pushed);
+}
+
+TEST(submitWorkerSendsEventsWithoutTimelinesWhenThoseBackUp) {
+    std::atomic<bool> release{false};
+    int withTimeline = 0;
+    int total = 0;
+    SubmitWorker worker([&](const ScoreEvent&, const AttemptTimeline* received) {
+        while (!release.load()) std::this_thread::yield();
+        withTimeline += received ? 1 : 0;
+        total++;
+    });
+    worker.start();
+
+    auto timeline = makeTimeline(2);
+    for (int i = 0; i < 40; i++) CHECK(worker.push(ScoreEvent{}, &timeline));
+    release = true;
+    worker.stop();
+
+    CHECK_EQ(total, 40);
+    CHECK(withTimeline >= 16 && withTimeline < 40);
+}
@@ -0,0 +1,74 @@
+#include "Test.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <system_error>
+#include <vector>
+
+namespace {
+    struct Registered {
+        const char* name;
+        Test::Case run;
+    };
+
+    // Filled by static initializers, so a function-local static to dodge the init order
+    std::vector<Registered>& registry() {
+        static std::vector<Registered> cases;
+        return cases;
+    }
+
+    int g_failures = 0;
+}
+
+namespace Test {
+    Registrar::Registrar(const char* name, Case run) {
+        registry().push_back({name, run});
+    }
+
+    void fail(const char* file, int line, const std::string& message) {
+        g_failures++;
+        std::fprintf(stderr, "  %s:%d: %s\n", file, line, message.c_str());
+    }
+
+    TempDir::TempDir() {
+        static std::atomic<uint64_t> counter{0};
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        m_path = std::filesystem::temp_directory_path() /
+                 ("yuki-core-tests-" + std::to_string(stamp) + "-" + std::to_string(counter++));
+        std::filesystem::create_directories(m_path);
+    }
+
+    TempDir::~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(m_path, ec);
+    }
+}
+
+// yuki-core-tests [substring]: runs every case, or the ones whose name contains it
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    int run = 0;
+    int failed = 0;
+    for (const auto& test : registry()) {
+        if (filter && !std::strstr(test.name, filter)) continue;
+
+        int failuresBefore = g_failures;
+        try {
+            test.run();
+        } catch (const Test::Abort&) {
+        } catch (const std::exception& e) {
+            Test::fail(test.name, 0, std::string("threw: ") + e.what());
+        }
+
+        run++;
+        bool passed = g_failures == failuresBefore;
+        if (!passed) failed++;
+        std::printf("%s %s\n", passed ? "ok  " : "FAIL", test.name);
+    }
+
+    std::printf("\n%d of %d passed\n", run - failed, run);
+    return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <concepts>
+#include <filesystem>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// Just enough of a test framework for the core library, which has no dependencies
+// to lean on. TEST registers a case, CHECK and CHECK_EQ record a failure and carry
+// on, REQUIRE ends the case.
+namespace Test {
+    using Case = void (*)();
+
+    struct Registrar {
+        Registrar(const char* name, Case run);
+    };
+
+    // Thrown by REQUIRE, caught by the runner
+    struct Abort {};
+
+    void fail(const char* file, int line, const std::string& message);
+
+    template <typename T>
+    std::string show(const T& value) {
+        if constexpr (requires(std::ostream& os) { os << value; }) {
+            std::ostringstream out;
+            out << value;
+            return out.str();
+        } else {
+            return "?";
+        }
+    }
+
+    // An empty folder of its own, deleted with everything in it when done
+    class TempDir {
+    public:
+        TempDir();
+        ~TempDir();
+
+        TempDir(const TempDir&) = delete;
+        TempDir& operator=(const TempDir&) = delete;
+
+        const std::filesystem::path& path() const { return m_path; }
+
+    private:
+        std::filesystem::path m_path;
+    };
+}
+
+#define YUKI_TEST_CONCAT_(a, b) a##b
+#define YUKI_TEST_CONCAT(a, b) YUKI_TEST_CONCAT_(a, b)
+
+#define TEST(name)                                                                   \
+    static void name();                                                              \
+    static const Test::Registrar YUKI_TEST_CONCAT(name, Registrar)(#name, name);     \
+    static void name()
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) Test::fail(__FILE__, __LINE__, #cond);                          \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                               \
+    do {                                                                             \
+        const auto& checkA_ = (a);                                                   \
+        const auto& checkB_ = (b);                                                   \
+        if (!(checkA_ == checkB_)) {                                                 \
+            Test::fail(__FILE__, __LINE__, #a " == " #b " (" + Test::show(checkA_) + \
+                                               " vs " + Test::show(checkB_) + ")");  \
+        }                                                                            \
+    } while (0)
+
+#define REQUIRE(cond)                                                                \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            Test::fail(__FILE__, __LINE__, #cond);                                   \
+            throw Test::Abort{};                                                     \
+        }                                                                            \
+    } while (0)
@@ -0,0 +1,51 @@
+#include "Test.hpp"
+#include "TokenBucket.hpp"
+
+namespace {
+    using namespace std::chrono_literals;
+    const auto T0 = TokenBucket::Clock::time_point{} + 1h;
+}
+
+TEST(tokenBucketAllowsABurstThenRunsDry) {
+    TokenBucket bucket(3, 5s);
+    bucket.reset(T0);
+    for (int i = 0; i < 3; i++) CHECK(bucket.tryTake(T0));
+    CHECK(!bucket.ready(T0));
+    CHECK(!bucket.tryTake(T0 + 4999ms));
+}
+
+TEST(tokenBucketRefillsOneTokenPerInterval) {
+    TokenBucket bucket(3, 5s);
+    bucket.reset(T0);
+    for (int i = 0; i < 3; i++) bucket.tryTake(T0);
+
+    CHECK(bucket.tryTake(T0 + 5s));
+    CHECK(!bucket.tryTake(T0 + 9s));
+    CHECK(bucket.tryTake(T0 + 10s));
+
+    // Idle long enough to fill up, and never beyond the burst
+    for (int i = 0; i < 3; i++) CHECK(bucket.tryTake(T0 + 1min));
+    CHECK(!bucket.tryTake(T0 + 1min));
+}
+
+TEST(tokenBucketResetFillsIt) {
+    TokenBucket bucket(2, 5s);
+    bucket.reset(T0);
+    bucket.tryTake(T0);
+    bucket.tryTake(T0);
+    CHECK(!bucket.ready(T0 + 1s));
+
+    bucket.reset(T0 + 1s);
+    CHECK(bucket.tryTake(T0 + 1s));
+    CHECK(bucket.tryTake(T0 + 1s));
+    CHECK(!bucket.tryTake(T0 + 1s));
+}
+
+TEST(tokenBucketKeepsAtLeastOneToken) {
+    TokenBucket bucket(0, 5s);
+    bucket.reset(T0);
+    CHECK_EQ(bucket.burst(), 1);
+    CHECK(bucket.tryTake(T0));
+    CHECK(!bucket.tryTake(T0 + 4s));
+    CHECK(bucket.tryTake(T0 + 5s));
+}
@@ -1,132 +1,272 @@
 #include <Geode/Geode.hpp>
 #include <Geode/modify/PlayLayer.hpp>
 #include <Geode/modify/EndLevelLayer.hpp>
+#include <Geode/modify/PauseLayer.hpp>
+#include "../HistoryPopup.hpp"
 #include "../YukiManager.hpp"
+#include "../ServerConnection.hpp"
+#include "../LiveChannel.hpp"
+#include "../OverlayChannel.hpp"
+#include "../core/HookTrace.hpp"
+#include "../core/LevelSession.hpp"
+#include "../core/Metrics.hpp"
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <vector>
 
 using namespace geode::prelude;
 
+static int64_t unixMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static LevelMeta makeLevelMeta(GJGameLevel* level) {
+    LevelMeta meta;
+    meta.levelId = level->m_levelID.value();
+    meta.name = level->m_levelName;
+    meta.creator = level->m_creatorName;
+    meta.description = level->m_levelDesc;
+    meta.difficulty = level->m_ratingsSum;
+    meta.stars = level->m_stars.value();
+    meta.isDemon = level->m_demon.value() != 0;
+    meta.demonDifficulty = level->m_demonDifficulty;
+    meta.audioTrack = level->m_audioTrack;
+    meta.songId = level->m_songID;
+    meta.length = level->m_levelLength;
+    meta.downloads = level->m_downloads;
+    meta.likes = level->m_likes;
+
+    if (level->m_songID > 0) {
+        if (auto song = MusicDownloadManager::sharedState()->getSongInfoObject(level->m_songID)) {
+            meta.songName = song->m_songName;
+            meta.songAuthor = song->m_artistName;
+        }
+    }
+    return meta;
+}
+
+// Secret coins and user coins
+static constexpr int SECRET_COIN_ID = 142;
+static constexpr int USER_COIN_ID = 1329;
+
 class $modify(YukiPlayLayer, PlayLayer) {
+    // Timeline samples and live status between game events. Nothing of ours runs
+    // on the frames in between, unless the stream overlay file is on.
+    static constexpr float PROGRESS_TICK_INTERVAL = 0.1f;
+
     struct Fields {
-        int attempts = 0;
-        int bestPercentage = 0;
-        int currentPercentage = 0;
-        bool levelCompleted = false;
-        std::vector<bool> coinsCollected;
-        std::chrono::steady_clock::time_point lastSubmitTime;
-        bool hasSubmittedThisSession = false;
+        LevelSession session;
+        // Best non-practice percentage from earlier sessions, -1 if never played
+        int previousBest = -1;
+        // The level's coins from left to right, found on the first pickup
+        std::array<GameObject*, LevelSession::MAX_COINS> coins{};
+        bool coinsFound = false;
+        // Empty unless Record Hook Traces is on
+        HookTraceWriter trace;
     };
 
-    static constexpr int MIN_PERCENTAGE_TO_SUBMIT = 5;
-    static constexpr int MIN_SECONDS_BETWEEN_SUBMITS = 5;
-
     bool init(GJGameLevel* level, bool useReplay, bool dontCreateObjects) {
         if (!PlayLayer::init(level, useReplay, dontCreateObjects)) {
             return false;
         }
 
-        m_fields->attempts = 0;
-        m_fields->bestPercentage = 0;
-        m_fields->currentPercentage = 0;
-        m_fields->levelCompleted = false;
-        m_fields->coinsCollected.clear();
-        m_fields->hasSubmittedThisSession = false;
-        m_fields->lastSubmitTime = std::chrono::steady_clock::now() - std::chrono::seconds(MIN_SECONDS_BETWEEN_SUBMITS);
+        // Intern level strings now so building a score on death doesn't allocate
+        LevelSession::LevelInfo info;
+        info.levelId = level->m_levelID.value();
+        info.nameId = YukiManager::get()->internString(std::string(level->m_levelName));
+        info.creatorId = YukiManager::get()->internString(std::string(level->m_creatorName));
+        info.coinCount = level->m_coins;
+
+        m_fields->session.setDeathLimit(
+            static_cast<int>(Mod::get()->getSettingValue<int64_t>("death-burst")),
+            std::chrono::seconds(Mod::get()->getSettingValue<int64_t>("death-refill-seconds")));
+        m_fields->session.begin(info, unixMillis(), std::chrono::steady_clock::now());
 
-        // Initialize coins array based on level's coin count
-        int coinCount = level->m_coins;
-        for (int i = 0; i < coinCount; i++) {
-            m_fields->coinsCollected.push_back(false);
+        // Read now, before this session's scores land in the history
+        LevelHistory past;
+        if (YukiManager::get()->history().level(info.levelId, past)) {
+            m_fields->previousBest = past.bestPercentage;
+        }
+
+        // Only online levels exist on the server's side of the GD API
+        bool online = level->m_levelType == GJLevelType::Saved;
+        if (online) {
+            YukiManager::get()->reportLevel(makeLevelMeta(level));
+        }
+        if (Mod::get()->getSettingValue<bool>("record-hook-traces")) {
+            m_fields->trace.begin(makeLevelMeta(level), info.coinCount, online,
+                                  YukiManager::get()->getSubmitSettings(), unixMillis(),
+                                  std::chrono::steady_clock::now());
+        }
+
+        // So the first death of the session doesn't wait on a handshake
+        ServerConnection::get()->prewarm();
+        OverlayChannel::get()->enterLevel(info.levelId, std::string(level->m_levelName));
+        YukiManager::get()->setGameState(GameState::Playing);
+
+        schedule(schedule_selector(YukiPlayLayer::onProgressTick), PROGRESS_TICK_INTERVAL);
+        // Overlays want the bar to move smoothly, and a publish costs well under a
+        // microsecond. Turning the setting on takes effect from the next level.
+        if (OverlayChannel::get()->enabled()) {
+            schedule(schedule_selector(YukiPlayLayer::onOverlayFrame));
         }
 
         return true;
     }
 
-    void updateProgressbar() {
-        PlayLayer::updateProgressbar();
-        
-        // Track current percentage
-        m_fields->currentPercentage = getCurrentPercentInt();
-        if (m_fields->currentPercentage > m_fields->bestPercentage) {
-            m_fields->bestPercentage = m_fields->currentPercentage;
+    void onProgressTick(float) {
+        Metrics::ScopedTimer timer(Metrics::Timer::ProgressTick);
+        auto& session = m_fields->session;
+        traceProgress(HookTraceType::Tick);
+
+        // Level time stands still while paused, samples would only repeat
+        if (YukiManager::get()->getGameState() == GameState::Playing) {
+            sampleProgress();
+            updateLive();
+        }
+
+        // A death held back by the rate limit goes out once a token frees up
+        if (session.hasPendingDeath()) {
+            ScoreEvent score;
+            if (session.flushPendingDeath(std::chrono::steady_clock::now(), score)) {
+                YukiManager::get()->queueScore(score, session.eventTimeline());
+            }
         }
     }
 
-    void resetLevel() {
-        // Capture percentage before reset
-        int deathPercentage = m_fields->currentPercentage;
-        
-        PlayLayer::resetLevel();
+    void onOverlayFrame(float) {
+        updateOverlay();
+    }
 
-        if (!m_fields->levelCompleted) {
-            m_fields->attempts++;
-            
-            // Submit death if criteria met
-            if (shouldSubmitDeath(deathPercentage)) {
-                submitDeath(deathPercentage);
+    void updateOverlay() {
+        float best = m_isPracticeMode ? m_level->m_practicePercent : m_level->m_normalPercent.value();
+        OverlayChannel::get()->update(m_fields->session.attempts() + 1, getCurrentPercent(), best,
+                                      m_isPracticeMode);
+    }
+
+    void sampleProgress() {
+        float x = m_player1 ? m_player1->getPositionX() : 0.f;
+        m_fields->session.onProgress(getCurrentPercent(), m_gameState.m_levelTime, x);
+    }
+
+    // Where the player is, for the hook being traced
+    void traceProgress(HookTraceType type, uint8_t arg = 0) {
+        auto& trace = m_fields->trace;
+        if (!trace.active()) return;
+        float x = m_player1 ? m_player1->getPositionX() : 0.f;
+        trace.record(type, std::chrono::steady_clock::now(), getCurrentPercent(), m_gameState.m_levelTime, x, arg);
+    }
+
+    void traceEvent(HookTraceType type, uint8_t arg = 0) {
+        m_fields->trace.record(type, std::chrono::steady_clock::now(), arg);
+    }
+
+    LevelSession::Progress captureDeath() {
+        float x = m_player1 ? m_player1->getPositionX() : 0.f;
+        return m_fields->session.onDeath(getCurrentPercent(), m_gameState.m_levelTime, x);
+    }
+
+    void updateLive() {
+        auto& session = m_fields->session;
+        LiveStatus live;
+        live.levelId = session.level().levelId;
+        live.percentage = session.currentProgress().percent;
+        live.bestPercentage = session.bestPercentage();
+        live.attempts = session.attempts() + 1;
+        live.practice = m_isPracticeMode;
+        LiveChannel::get()->update(live);
+    }
+
+    void destroyPlayer(PlayerObject* player, GameObject* object) {
+        PlayLayer::destroyPlayer(player, object);
+
+        // Also called for hits that don't kill, like the anticheat spike at the start
+        if (player && player->m_isDead) {
+            traceProgress(HookTraceType::Death);
+            captureDeath();
+            updateLive();
+            updateOverlay();
+            OverlayChannel::get()->pushEvent(OverlayEventType::Death);
+        }
+    }
+
+    void collectedObject(EffectGameObject* object) {
+        PlayLayer::collectedObject(object);
+
+        if (!object || (object->m_objectID != SECRET_COIN_ID && object->m_objectID != USER_COIN_ID)) return;
+        if (!m_fields->coinsFound) findCoins();
+
+        auto& coins = m_fields->coins;
+        auto it = std::find(coins.begin(), coins.end(), object);
+        if (it != coins.end()) {
+            traceProgress(HookTraceType::Coin, static_cast<uint8_t>(it - coins.begin()));
+            m_fields->session.onCoin(static_cast<int>(it - coins.begin()));
+            sampleProgress();
+        }
+    }
+
+    void findCoins() {
+        m_fields->coinsFound = true;
+
+        std::vector<GameObject*> found;
+        std::vector<float> xs;
+        for (auto object : CCArrayExt<GameObject*>(m_objects)) {
+            if (object->m_objectID == SECRET_COIN_ID || object->m_objectID == USER_COIN_ID) {
+                found.push_back(object);
+                xs.push_back(object->getPositionX());
             }
         }
-        
-        // Reset current percentage for new attempt
-        m_fields->currentPercentage = 0;
-    }
-
-    bool shouldSubmitDeath(int percentage) {
-        // Never submit in practice mode
-        if (m_isPracticeMode) return false;
-        
-        if (!Mod::get()->getSettingValue<bool>("auto-submit")) return false;
-        if (!Mod::get()->getSettingValue<bool>("submit-fails")) return false;
-        if (!YukiManager::get()->isLinked()) return false;
-        
-        // Must be at least MIN_PERCENTAGE_TO_SUBMIT%
-        if (percentage < MIN_PERCENTAGE_TO_SUBMIT) return false;
-        
-        // Rate limit: MIN_SECONDS_BETWEEN_SUBMITS seconds since last submit
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-            now - m_fields->lastSubmitTime
-        ).count();
-        
-        if (elapsed < MIN_SECONDS_BETWEEN_SUBMITS) return false;
-        
-        return true;
+        std::array<int, LevelSession::MAX_COINS> order;
+        int count = LevelSession::orderCoins(xs, order);
+        m_fields->coins = {};
+        for (int i = 0; i < count; i++) m_fields->coins[i] = found[order[i]];
     }
 
-    void submitDeath(int percentage) {
-        if (!m_level) return;
-        
-        m_fields->lastSubmitTime = std::chrono::steady_clock::now();
-        m_fields->hasSubmittedThisSession = true;
+    void storeCheckpoint(CheckpointObject* checkpoint) {
+        PlayLayer::storeCheckpoint(checkpoint);
+        traceProgress(HookTraceType::Sample);
+        sampleProgress();
+    }
+
+    void resetLevel() {
+        // Capture percentage before reset, for restarts that didn't come from a death
+        traceProgress(HookTraceType::Reset, m_isPracticeMode);
+        auto death = captureDeath();
 
-        ScoreData score;
-        score.levelId = m_level->m_levelID.value();
-        score.levelName = m_level->m_levelName;
-        score.levelCreator = m_level->m_creatorName;
-        score.percentage = percentage;
-        score.attempts = m_fields->attempts;
-        score.passed = false;
-        score.isPractice = false; // Deaths are never sent in practice mode anyway
-        score.coinsCollected = m_fields->coinsCollected;
+        PlayLayer::resetLevel();
+
+        Metrics::ScopedTimer timer(Metrics::Timer::ResetLevel);
+        // Also how replaying from the end screen starts
+        YukiManager::get()->setGameState(GameState::Playing);
 
-        YukiManager::get()->submitScore(score);
-        
-        log::debug("Submitted death at {}%", percentage);
+        ScoreEvent score;
+        auto settings = YukiManager::get()->getSubmitSettings();
+        if (m_fields->session.onReset(death, m_isPracticeMode, settings, std::chrono::steady_clock::now(), score)) {
+            YukiManager::get()->queueScore(score, m_fields->session.eventTimeline());
+        }
+
+        updateOverlay();
+        OverlayChannel::get()->pushEvent(OverlayEventType::NewAttempt);
+    }
+
+    void resume() {
+        PlayLayer::resume();
+        traceEvent(HookTraceType::Resume);
+        YukiManager::get()->setGameState(GameState::Playing);
     }
 
     void levelComplete() {
-        m_fields->levelCompleted = true;
-        m_fields->bestPercentage = 100;
+        {
+            Metrics::ScopedTimer timer(Metrics::Timer::LevelComplete);
 
-        // Collect coin status
-        if (m_level) {
-            m_fields->coinsCollected.clear();
-            // In GD, coins collected are stored differently
-            // For now we track if they got all coins
-            int coinsGot = m_level->m_coinsVerified;
-            int totalCoins = m_level->m_coins;
-            for (int i = 0; i < totalCoins; i++) {
-                m_fields->coinsCollected.push_back(i < coinsGot);
+            if (m_level) {
+                traceProgress(HookTraceType::Complete, m_isPracticeMode);
+                sampleProgress();
+                m_fields->session.onComplete(m_isPracticeMode);
+                updateOverlay();
+                OverlayChannel::get()->pushEvent(OverlayEventType::Complete);
             }
         }
 
@@ -134,30 +274,54 @@ class $modify(YukiPlayLayer, PlayLayer) {
     }
 
     void onQuit() {
+        YukiManager::get()->setGameState(GameState::Menu);
+
+        auto& session = m_fields->session;
+        ScoreEvent pending;
+        if (session.takePendingDeath(pending)) {
+            YukiManager::get()->queueScore(pending, session.eventTimeline());
+        }
+        if (m_level && !session.deaths().empty()) {
+            YukiManager::get()->recordHeatmap(session.level().levelId, session.deaths());
+        }
+        if (m_level) {
+            recordSession();
+        }
+        LiveChannel::get()->update({});
+        OverlayChannel::get()->exitLevel();
+        YukiManager::get()->unwatchLeaderboard();
+
+        auto& trace = m_fields->trace;
+        if (trace.active()) {
+            traceEvent(HookTraceType::Quit);
+            auto path = Mod::get()->getSaveDir() / "traces" /
+                        fmt::format("{}-{}.ytrace", session.level().levelId, unixMillis());
+            if (!trace.save(path)) {
+                log::warn("Failed to save hook trace to {}", path.string());
+            }
+        }
+
         PlayLayer::onQuit();
     }
 
-    void submitScore(bool passed) {
-        // Practice mode: only allow passes, not fails
-        if (m_isPracticeMode && !passed) return;
-        
-        if (!YukiManager::get()->isLinked()) return;
-        if (!Mod::get()->getSettingValue<bool>("auto-submit")) return;
-        if (!m_level) return;
-
-        m_fields->lastSubmitTime = std::chrono::steady_clock::now();
+    // Summarizes everything played since the last summary, on completion and on quit
+    void recordSession() {
+        SessionSummary summary;
+        if (m_fields->session.takeSummary(unixMillis(), summary)) {
+            YukiManager::get()->recordSession(summary);
+        }
+    }
 
-        ScoreData score;
-        score.levelId = m_level->m_levelID.value();
-        score.levelName = m_level->m_levelName;
-        score.levelCreator = m_level->m_creatorName;
-        score.percentage = passed ? 100 : m_fields->bestPercentage;
-        score.attempts = m_fields->attempts;
-        score.passed = passed;
-        score.isPractice = m_isPracticeMode;
-        score.coinsCollected = m_fields->coinsCollected;
+    // Returns true if the score is on its way to the server
+    bool submitScore(bool passed) {
+        if (!m_level) return false;
 
-        YukiManager::get()->submitScore(score);
+        ScoreEvent score;
+        auto settings = YukiManager::get()->getSubmitSettings();
+        if (m_fields->session.onFinished(passed, m_isPracticeMode, settings, std::chrono::steady_clock::now(), score)) {
+            return YukiManager::get()->queueScore(score, m_fields->session.eventTimeline());
+        }
+        return false;
     }
 };
 
@@ -165,11 +329,90 @@ class $modify(YukiEndLevelLayer, EndLevelLayer) {
     void customSetup() {
         EndLevelLayer::customSetup();
 
+        Metrics::ScopedTimer timer(Metrics::Timer::EndLevelSetup);
+        // Before the pass is queued, so it goes out right away
+        YukiManager::get()->setGameState(GameState::EndScreen);
+
         // Submit the passing score when EndLevelLayer appears
         auto playLayer = PlayLayer::get();
         if (playLayer) {
             auto yukiLayer = static_cast<YukiPlayLayer*>(playLayer);
-            yukiLayer->submitScore(true);
+            yukiLayer->traceEvent(HookTraceType::EndScreen, yukiLayer->m_isPracticeMode);
+            bool submitted = yukiLayer->submitScore(true);
+            yukiLayer->recordSession();
+            showPreviousBest(yukiLayer);
+            // Practice passes don't rank, so their response has no standings
+            showLeaderboard(yukiLayer->m_fields->session.level().levelId,
+                            submitted && !yukiLayer->m_isPracticeMode);
+        }
+    }
+
+    // The pass response carries the standings, anything else has to ask for them
+    void showLeaderboard(int levelId, bool submitted) {
+        if (levelId <= 0) return;
+
+        auto winSize = CCDirector::get()->getWinSize();
+        Ref<CCLabelBMFont> label = CCLabelBMFont::create("", "chatFont.fnt");
+        label->setScale(0.5f);
+        label->setAnchorPoint({0.f, 1.f});
+        label->setPosition({12, winSize.height - 12});
+        label->setAlignment(CCTextAlignment::kCCTextAlignmentLeft);
+        m_mainLayer->addChild(label);
+
+        YukiManager::get()->watchLeaderboard(levelId, !submitted, [label](const LevelLeaderboard& board) {
+            std::string text = board.rank > 0
+                ? fmt::format("Rank #{} of {}\n", board.rank, board.players)
+                : fmt::format("{} player(s) ranked\n", board.players);
+            for (const auto& entry : board.top) {
+                std::string name = entry.name.size() > 16 ? entry.name.substr(0, 15) + "~" : entry.name;
+                text += fmt::format("{:>3}. {:<16} {:>3}%{}\n", entry.rank, name, entry.percentage,
+                                    entry.self ? " <" : "");
+            }
+            label->setString(text.c_str());
+        });
+    }
+
+    void showPreviousBest(YukiPlayLayer* playLayer) {
+        int& previousBest = playLayer->m_fields->previousBest;
+        std::string text = previousBest < 0 ? "No earlier scores on this device"
+            : previousBest >= 100 ? "Previous best: 100%"
+            : fmt::format("Previous best: {}% (new best!)", previousBest);
+
+        auto label = CCLabelBMFont::create(text.c_str(), "goldFont.fnt");
+        label->setScale(0.5f);
+        auto winSize = CCDirector::get()->getWinSize();
+        label->setPosition({winSize.width / 2, winSize.height - 30});
+        m_mainLayer->addChild(label);
+
+        // Completing again without leaving the level compares against this pass
+        if (!playLayer->m_isPracticeMode) {
+            previousBest = 100;
+        }
+    }
+};
+
+class $modify(YukiPauseLayer, PauseLayer) {
+    void customSetup() {
+        PauseLayer::customSetup();
+        if (auto playLayer = PlayLayer::get()) {
+            static_cast<YukiPlayLayer*>(playLayer)->traceEvent(HookTraceType::Pause);
+        }
+        YukiManager::get()->setGameState(GameState::Paused);
+
+        // This level's scores from the local history
+        if (auto menu = this->getChildByID("right-button-menu")) {
+            auto sprite = CCSprite::createWithSpriteFrameName("GJ_statsBtn_001.png");
+            sprite->setScale(0.6f);
+            auto button = CCMenuItemSpriteExtra::create(sprite, this, menu_selector(YukiPauseLayer::onLevelHistory));
+            button->setID("yuki-history-button"_spr);
+            menu->addChild(button);
+            menu->updateLayout();
+        }
+    }
+
+    void onLevelHistory(CCObject*) {
+        if (auto playLayer = PlayLayer::get()) {
+            HistoryPopup::create(playLayer->m_level->m_levelID.value())->show();
         }
     }
 };
@@ -2,6 +2,9 @@
 #include <Geode/modify/MenuLayer.hpp>
 #include "YukiManager.hpp"
 #include "LinkPopup.hpp"
+#include "ServerConnection.hpp"
+#include "LiveChannel.hpp"
+#include "OverlayChannel.hpp"
 
 using namespace geode::prelude;
 
@@ -9,6 +12,8 @@ class $modify(YukiMenuLayer, MenuLayer) {
     bool init() {
         if (!MenuLayer::init()) return false;
 
+        YukiManager::get()->setGameState(GameState::Menu);
+
         if (auto rightMenu = this->getChildByID("right-side-menu")) {
             // Container for discord icon + status badge
             auto container = CCNode::create();
@@ -51,6 +56,33 @@ class $modify(YukiMenuLayer, MenuLayer) {
 
 $on_mod(Loaded) {
     log::info("Yuki mod loaded!");
+
+    YukiManager::get()->init();
+    ServerConnection::get()->init();
+    LiveChannel::get()->init();
+    OverlayChannel::get()->init();
+
+    listenForSettingChanges("auto-submit", [](bool) {
+        YukiManager::get()->refreshSettings();
+    });
+    listenForSettingChanges("submit-fails", [](bool) {
+        YukiManager::get()->refreshSettings();
+    });
+    listenForSettingChanges("max-concurrent-submissions", [](int64_t) {
+        YukiManager::get()->refreshSettings();
+    });
+    listenForSettingChanges("hold-while-playing", [](bool) {
+        YukiManager::get()->refreshSettings();
+    });
+    listenForSettingChanges("debug-metrics", [](bool) {
+        YukiManager::get()->refreshSettings();
+    });
+    listenForSettingChanges("live-status", [](bool) {
+        LiveChannel::get()->refreshSettings();
+    });
+    listenForSettingChanges("stream-overlay", [](bool) {
+        OverlayChannel::get()->refreshSettings();
+    });
     
     if (YukiManager::get()->isLinked()) {
         log::info("Account linked to: {}", YukiManager::get()->getLinkedDiscordUsername());
@@ -0,0 +1,117 @@
+#include "StubServer.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <string_view>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::string_view RESPONSE =
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 11\r\n\r\n{\"ok\":true}";
+
+    // Content-Length of a request head, 0 if it has none
+    size_t contentLength(std::string_view head) {
+        size_t pos = 0;
+        while ((pos = head.find("\r\n", pos)) != std::string_view::npos) {
+            pos += 2;
+            if (head.size() - pos >= 15 && strncasecmp(head.data() + pos, "content-length:", 15) == 0) {
+                return std::strtoul(std::string(head.substr(pos + 15, 20)).c_str(), nullptr, 10);
+            }
+        }
+        return 0;
+    }
+}
+
+StubServer::~StubServer() {
+    stop();
+}
+
+bool StubServer::start() {
+    m_listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listener < 0) return false;
+
+    int one = 1;
+    setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(addr);
+    if (::bind(m_listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(m_listener, 64) != 0 ||
+        ::getsockname(m_listener, reinterpret_cast<sockaddr*>(&addr), &size) != 0) {
+        ::close(m_listener);
+        m_listener = -1;
+        return false;
+    }
+
+    m_port = ntohs(addr.sin_port);
+    m_running = true;
+    m_acceptThread = std::thread([this] { acceptLoop(); });
+    return true;
+}
+
+void StubServer::stop() {
+    if (!m_running.exchange(false)) return;
+
+    // Unblocks accept() and every recv()
+    ::shutdown(m_listener, SHUT_RDWR);
+    {
+        std::lock_guard lock(m_mutex);
+        for (int fd : m_connections) ::shutdown(fd, SHUT_RDWR);
+    }
+    if (m_acceptThread.joinable()) m_acceptThread.join();
+    for (auto& thread : m_connectionThreads) thread.join();
+    ::close(m_listener);
+    m_listener = -1;
+}
+
+void StubServer::acceptLoop() {
+    while (m_running) {
+        int fd = ::accept(m_listener, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        std::lock_guard lock(m_mutex);
+        if (!m_running) {
+            ::close(fd);
+            break;
+        }
+        m_connections.push_back(fd);
+        m_connectionThreads.emplace_back([this, fd] { serve(fd); });
+    }
+}
+
+void StubServer::serve(int fd) {
+    std::string buffer;
+    char chunk[16384];
+    auto receive = [&] {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n > 0) buffer.append(chunk, static_cast<size_t>(n));
+        return n > 0;
+    };
+
+    bool open = true;
+    while (open && m_running) {
+        size_t headEnd;
+        while (open && (headEnd = buffer.find("\r\n\r\n")) == std::string::npos) open = receive();
+        if (!open) break;
+
+        size_t total = headEnd + 4 + contentLength(std::string_view(buffer).substr(0, headEnd));
+        while (open && buffer.size() < total) open = receive();
+        if (!open) break;
+        buffer.erase(0, total);
+
+        if (m_delay.count() > 0) std::this_thread::sleep_for(m_delay);
+        m_requests.fetch_add(1, std::memory_order_relaxed);
+        open = ::send(fd, RESPONSE.data(), RESPONSE.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(RESPONSE.size());
+    }
+
+    std::lock_guard lock(m_mutex);
+    std::erase(m_connections, fd);
+    ::close(fd);
+}
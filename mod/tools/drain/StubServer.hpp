@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Minimal HTTP/1.1 server on 127.0.0.1 that answers every request with 200 and
+// a small JSON body, optionally after a fixed delay. Enough to stand in for the
+// score server when only the client side is being measured.
+class StubServer {
+public:
+    explicit StubServer(std::chrono::microseconds delay) : m_delay(delay) {}
+    ~StubServer();
+
+    StubServer(const StubServer&) = delete;
+    StubServer& operator=(const StubServer&) = delete;
+
+    // Listens on an ephemeral port, false if the socket couldn't be set up
+    bool start();
+    void stop();
+
+    uint16_t port() const { return m_port; }
+    uint64_t requests() const { return m_requests.load(std::memory_order_relaxed); }
+
+private:
+    void acceptLoop();
+    void serve(int fd);
+
+    std::chrono::microseconds m_delay;
+    int m_listener = -1;
+    uint16_t m_port = 0;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_requests{0};
+    std::thread m_acceptThread;
+    std::mutex m_mutex;
+    std::vector<int> m_connections;
+    std::vector<std::thread> m_connectionThreads;
+};
@@ -0,0 +1,325 @@
+// Measures how fast a backed up outbox drains: fills a ScoreOutbox with the
+// scores of a long offline session, reopens it as the mod does on the next
+// launch, then drains it through SubmissionTracker and ScoreCodec into a local
+// HTTP stub. Reports delivery throughput and, separately, the work the mod does
+// on the game thread per batch (reading, encoding, acknowledging and compacting),
+// which is what has to stay small for the drain not to show up as stutter.
+
+#include "../loadgen/HttpClient.hpp"
+#include "ScoreCodec.hpp"
+#include "ScoreOutbox.hpp"
+#include "StubServer.hpp"
+#include "SubmissionTracker.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        // Empty for the built-in stub
+        std::string url;
+        size_t scores = 10000;
+        size_t batch = 32;
+        size_t inFlight = 2;
+        double stubDelayMs = 0;
+        std::string outbox;
+    };
+
+    void usage() {
+        std::puts(
+            "usage: yuki-drain [options]\n"
+            "  --scores N         scores queued while offline (default 10000)\n"
+            "  --batch N          scores per request (default 32, BatchPolicy's default)\n"
+            "  --in-flight N      concurrent requests (default 2, as in the mod)\n"
+            "  --stub-delay MS    built-in stub answers after MS milliseconds (default 0)\n"
+            "  --url URL          send to this plain http server instead of the built-in stub;\n"
+            "                     any 2xx counts as delivered\n"
+            "  --outbox DIR       keep the outbox here instead of a fresh temporary folder");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char* {
+                if (i + 1 >= argc) {
+                    std::fprintf(stderr, "%s needs a value\n", arg.c_str());
+                    std::exit(2);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--url") options.url = value();
+            else if (arg == "--scores") options.scores = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--batch") options.batch = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--in-flight") options.inFlight = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--stub-delay") options.stubDelayMs = std::atof(value());
+            else if (arg == "--outbox") options.outbox = value();
+            else return false;
+        }
+        return options.scores > 0 && options.batch > 0 && options.inFlight > 0 && options.stubDelayMs >= 0;
+    }
+
+    ScoreData makeScore(size_t i) {
+        ScoreData score{};
+        score.levelId = 100000 + static_cast<int>(i % 40) * 7919;
+        score.levelName = "Offline Level " + std::to_string(i % 40);
+        score.levelCreator = "Creator";
+        score.percentage = 5 + static_cast<int>(i * 37 % 95);
+        score.attempts = 1 + static_cast<int>(i);
+        score.passed = score.percentage == 100;
+        score.coinsCollected = {i % 3 == 0, false, i % 7 == 0};
+        score.playedAt = 1700000000000 + static_cast<int64_t>(i) * 20000;
+        return score;
+    }
+
+    // A request handed to the sender threads, and its answer
+    struct Job {
+        uint64_t id;
+        std::vector<uint8_t> body;
+        int status = 0;
+        std::string error;
+    };
+
+    // Sender threads stand in for the mod's async web requests: the game thread
+    // hands a body over and picks the result up later
+    class Senders {
+    public:
+        Senders(size_t count, const std::string& host, uint16_t port) {
+            for (size_t i = 0; i < count; i++) {
+                m_threads.emplace_back([this, host, port] { run(HttpClient(host, port)); });
+            }
+        }
+
+        ~Senders() {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            for (auto& thread : m_threads) thread.join();
+        }
+
+        void submit(std::unique_ptr<Job> job) {
+            {
+                std::lock_guard lock(m_mutex);
+                m_queue.push_back(std::move(job));
+            }
+            m_wake.notify_one();
+        }
+
+        std::unique_ptr<Job> waitDone() {
+            std::unique_lock lock(m_mutex);
+            m_doneWake.wait(lock, [&] { return !m_done.empty(); });
+            auto job = std::move(m_done.front());
+            m_done.pop_front();
+            return job;
+        }
+
+    private:
+        void run(HttpClient&& http) {
+            while (true) {
+                std::unique_ptr<Job> job;
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_wake.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+                    if (m_queue.empty()) return;
+                    job = std::move(m_queue.front());
+                    m_queue.pop_front();
+                }
+
+                auto res = http.post("/api/scores/batch", ScoreCodec::CONTENT_TYPE, job->body.data(), job->body.size());
+                job->status = res.status;
+                job->error = res.error;
+                {
+                    std::lock_guard lock(m_mutex);
+                    m_done.push_back(std::move(job));
+                }
+                m_doneWake.notify_one();
+            }
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_doneWake;
+        std::deque<std::unique_ptr<Job>> m_queue;
+        std::deque<std::unique_ptr<Job>> m_done;
+        bool m_stopping = false;
+        std::vector<std::thread> m_threads;
+    };
+
+    uint32_t micros(Clock::duration duration) {
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+
+    uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t index = std::min(static_cast<size_t>(p * sorted.size()), sorted.size() - 1);
+        return sorted[index];
+    }
+
+    std::string formatUs(uint32_t us) {
+        char buffer[32];
+        if (us >= 1000000) std::snprintf(buffer, sizeof(buffer), "%.2fs", us / 1e6);
+        else if (us >= 1000) std::snprintf(buffer, sizeof(buffer), "%.1fms", us / 1e3);
+        else std::snprintf(buffer, sizeof(buffer), "%uus", us);
+        return buffer;
+    }
+
+    void printLatency(const char* name, std::vector<uint32_t>& samples) {
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        std::printf("  %-9s p50 %-9s p90 %-9s p99 %-9s max %s\n", name, formatUs(percentile(samples, 0.50)).c_str(),
+                    formatUs(percentile(samples, 0.90)).c_str(), formatUs(percentile(samples, 0.99)).c_str(),
+                    formatUs(samples.back()).c_str());
+    }
+
+    int64_t unixMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::unique_ptr<StubServer> stub;
+    std::string host = "127.0.0.1";
+    uint16_t port = 0;
+    if (options.url.empty()) {
+        stub = std::make_unique<StubServer>(
+            std::chrono::microseconds(static_cast<int64_t>(options.stubDelayMs * 1000)));
+        if (!stub->start()) {
+            std::fprintf(stderr, "Couldn't start the HTTP stub\n");
+            return 1;
+        }
+        port = stub->port();
+    } else if (!HttpClient::parseUrl(options.url, host, port)) {
+        std::fprintf(stderr, "Only plain http://host:port URLs are supported, got %s\n", options.url.c_str());
+        return 2;
+    }
+
+    std::filesystem::path outboxDir = options.outbox;
+    bool removeOutbox = outboxDir.empty();
+    if (removeOutbox) {
+        outboxDir = std::filesystem::temp_directory_path() / ("yuki-drain-" + std::to_string(unixMillis()));
+    }
+
+    int status = 0;
+    {
+        // The offline session, every score synced to disk as it happens
+        auto fillStart = Clock::now();
+        {
+            ScoreOutbox outbox(outboxDir);
+            if (!outbox.open()) {
+                std::fprintf(stderr, "Couldn't open an outbox in %s\n", outboxDir.string().c_str());
+                return 1;
+            }
+            for (size_t i = 0; i < options.scores; i++) {
+                if (!outbox.append(makeScore(i))) {
+                    std::fprintf(stderr, "Append failed after %zu scores\n", i);
+                    return 1;
+                }
+            }
+        }
+        double fillSeconds = std::chrono::duration<double>(Clock::now() - fillStart).count();
+        std::error_code ec;
+        auto logSize = std::filesystem::file_size(outboxDir / "outbox.log", ec);
+
+        // Next launch
+        auto openStart = Clock::now();
+        ScoreOutbox outbox(outboxDir);
+        if (!outbox.open()) {
+            std::fprintf(stderr, "Couldn't reopen the outbox\n");
+            return 1;
+        }
+        auto openTime = Clock::now() - openStart;
+
+        ScoreCodec::SessionHeader header;
+        header.authToken = std::string(64, 'a');
+        header.gdAccountId = 20000000;
+        header.gdUsername = "DrainBench";
+        header.installId = std::to_string(outbox.installId());
+
+        SubmissionTracker tracker(options.inFlight);
+        Senders senders(options.inFlight, host, port);
+        std::vector<uint32_t> sendUs;
+        std::vector<uint32_t> ackUs;
+        uint64_t requests = 0;
+        uint64_t failed = 0;
+        uint64_t bytes = 0;
+        std::string lastError;
+
+        auto drainStart = Clock::now();
+        while (outbox.pendingCount() > 0 && failed == 0) {
+            // What drainOutbox and sendBatch do on the game thread
+            while (tracker.canStart()) {
+                auto start = Clock::now();
+                auto batch = outbox.readBatch(options.batch);
+                if (batch.empty()) break;
+
+                std::vector<ScoreData> scores;
+                scores.reserve(batch.size());
+                for (auto& entry : batch) scores.push_back(std::move(entry.score));
+                auto job = std::make_unique<Job>();
+                job->body = ScoreCodec::encodeBatch(header, scores);
+                job->id = tracker.start(batch.back().seq, batch.size());
+                sendUs.push_back(micros(Clock::now() - start));
+
+                bytes += job->body.size();
+                requests++;
+                senders.submit(std::move(job));
+            }
+            if (tracker.stats().inFlightRequests == 0) break;
+
+            // onSubmitFinished, also on the game thread
+            auto job = senders.waitDone();
+            auto start = Clock::now();
+            if (job->status >= 200 && job->status < 300) {
+                if (uint64_t ackSeq = tracker.complete(job->id)) outbox.ack(ackSeq);
+            } else {
+                failed++;
+                lastError = job->status ? "HTTP " + std::to_string(job->status) : job->error;
+                tracker.fail(job->id);
+            }
+            ackUs.push_back(micros(Clock::now() - start));
+        }
+        // Let whatever is still on the wire settle before the senders go away
+        while (tracker.stats().inFlightRequests > 0) tracker.complete(senders.waitDone()->id);
+        double drainSeconds = std::chrono::duration<double>(Clock::now() - drainStart).count();
+
+        std::printf("Outbox of %zu scores, %.1f KB: filled in %.2fs (%.0f scores/s), reopened in %s\n",
+                    options.scores, logSize / 1024.0, fillSeconds, options.scores / fillSeconds,
+                    formatUs(micros(openTime)).c_str());
+        std::printf("Drained in %.2fs: %.0f scores/s, %llu requests of up to %zu, %zu in flight, %.1f KB sent\n",
+                    drainSeconds, (options.scores - outbox.pendingCount()) / drainSeconds,
+                    static_cast<unsigned long long>(requests), options.batch, options.inFlight, bytes / 1024.0);
+        if (failed) std::printf("  failed: %s\n", lastError.c_str());
+        std::printf("Game thread per batch\n");
+        printLatency("send", sendUs);
+        printLatency("ack", ackUs);
+        status = failed == 0 && outbox.pendingCount() == 0 ? 0 : 1;
+    }
+
+    if (stub) stub->stop();
+    if (removeOutbox) {
+        std::error_code ec;
+        std::filesystem::remove_all(outboxDir, ec);
+    }
+    return status;
+}
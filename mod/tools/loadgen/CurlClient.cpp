@@ -0,0 +1,98 @@
+#include "CurlClient.hpp"
+#include <curl/curl.h>
+#include <mutex>
+
+namespace {
+    size_t appendBody(char* data, size_t size, size_t count, void* user) {
+        static_cast<std::string*>(user)->append(data, size * count);
+        return size * count;
+    }
+
+    uint32_t timeUs(CURL* handle, CURLINFO info) {
+        curl_off_t us = 0;
+        curl_easy_getinfo(handle, info, &us);
+        return static_cast<uint32_t>(us);
+    }
+}
+
+CurlClient::CurlClient(std::string baseUrl, int timeoutSeconds)
+    : m_baseUrl(std::move(baseUrl)), m_timeoutSeconds(timeoutSeconds) {
+    static std::once_flag globalInit;
+    std::call_once(globalInit, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    if (!m_baseUrl.empty() && m_baseUrl.back() == '/') m_baseUrl.pop_back();
+    m_handle = curl_easy_init();
+}
+
+CurlClient::~CurlClient() {
+    if (m_handle) curl_easy_cleanup(static_cast<CURL*>(m_handle));
+}
+
+CurlClient::Response CurlClient::post(std::string_view path, std::string_view contentType,
+                                      const void* body, size_t size) {
+    auto* handle = static_cast<CURL*>(m_handle);
+    if (!handle) return {.error = "curl_easy_init failed"};
+
+    std::string header = "Content-Type: ";
+    header += contentType;
+    curl_slist* headers = curl_slist_append(nullptr, header.c_str());
+
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 0L);
+    curl_easy_setopt(handle, CURLOPT_POST, 1L);
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDS, body);
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(size));
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+    auto response = perform(path);
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(headers);
+    return response;
+}
+
+CurlClient::Response CurlClient::get(std::string_view path) {
+    auto* handle = static_cast<CURL*>(m_handle);
+    if (!handle) return {.error = "curl_easy_init failed"};
+
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+    return perform(path);
+}
+
+CurlClient::Response CurlClient::perform(std::string_view path) {
+    auto* handle = static_cast<CURL*>(m_handle);
+    Response response;
+
+    std::string url = m_baseUrl;
+    url += path;
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT, static_cast<long>(m_timeoutSeconds));
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, appendBody);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &response.body);
+
+    CURLcode rc = curl_easy_perform(handle);
+    if (rc != CURLE_OK) {
+        response.error = curl_easy_strerror(rc);
+        return response;
+    }
+
+    long status = 0;
+    long version = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &response.newConnections);
+    curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &version);
+    response.status = static_cast<int>(status);
+    response.httpVersion = version == CURL_HTTP_VERSION_2_0 ? 2 : version == CURL_HTTP_VERSION_1_1 ? 1 : 0;
+
+    // Both are counted from the start of the request, so the TLS handshake is the
+    // difference
+    uint32_t connectedUs = timeUs(handle, CURLINFO_CONNECT_TIME_T);
+    uint32_t tlsDoneUs = timeUs(handle, CURLINFO_APPCONNECT_TIME_T);
+    if (response.newConnections > 0) {
+        response.connectUs = connectedUs;
+        response.tlsUs = tlsDoneUs > connectedUs ? tlsDoneUs - connectedUs : 0;
+    }
+    response.totalUs = timeUs(handle, CURLINFO_TOTAL_TIME_T);
+    return response;
+}
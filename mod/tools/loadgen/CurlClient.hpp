@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// HTTPS client on libcurl, set up like the mod's requests through Geode (HTTP/2
+// over TLS where offered). One instance keeps one easy handle, so its connection
+// is reused between requests the way ServerConnection relies on; a new instance
+// starts from a cold connection.
+class CurlClient {
+public:
+    struct Response {
+        // 0 when the request never got an answer
+        int status = 0;
+        std::string body;
+        std::string error;
+        // libcurl's own timings for the request, in microseconds. `connectUs` and
+        // `tlsUs` are 0 when an open connection was reused.
+        uint32_t connectUs = 0;
+        uint32_t tlsUs = 0;
+        uint32_t totalUs = 0;
+        // New connections this request had to open
+        long newConnections = 0;
+        // 2 when HTTP/2 was negotiated
+        int httpVersion = 0;
+    };
+
+    static constexpr int DEFAULT_TIMEOUT_SECONDS = 15;
+
+    // `baseUrl` is https://host:port. The certificate isn't checked, this only ever
+    // talks to a local test server with a self-signed one.
+    explicit CurlClient(std::string baseUrl, int timeoutSeconds = DEFAULT_TIMEOUT_SECONDS);
+    ~CurlClient();
+
+    CurlClient(const CurlClient&) = delete;
+    CurlClient& operator=(const CurlClient&) = delete;
+
+    Response post(std::string_view path, std::string_view contentType, const void* body, size_t size);
+    Response get(std::string_view path);
+
+private:
+    Response perform(std::string_view path);
+
+    std::string m_baseUrl;
+    int m_timeoutSeconds;
+    void* m_handle;
+};
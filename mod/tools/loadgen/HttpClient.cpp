@@ -0,0 +1,236 @@
+#include "HttpClient.hpp"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t MAX_RESPONSE_SIZE = 16 * 1024 * 1024;
+
+    bool startsWithNoCase(std::string_view value, std::string_view prefix) {
+        if (value.size() < prefix.size()) return false;
+        for (size_t i = 0; i < prefix.size(); i++) {
+            if (std::tolower(static_cast<unsigned char>(value[i])) != std::tolower(static_cast<unsigned char>(prefix[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+HttpClient::HttpClient(std::string host, uint16_t port, int timeoutSeconds)
+    : m_host(std::move(host)), m_port(port), m_timeoutSeconds(timeoutSeconds) {}
+
+HttpClient::~HttpClient() {
+    disconnect();
+}
+
+bool HttpClient::parseUrl(const std::string& url, std::string& host, uint16_t& port) {
+    constexpr std::string_view scheme = "http://";
+    if (url.rfind(scheme, 0) != 0) return false;
+
+    std::string rest = url.substr(scheme.size());
+    if (!rest.empty() && rest.back() == '/') rest.pop_back();
+    if (rest.empty() || rest.find('/') != std::string::npos) return false;
+
+    auto colon = rest.rfind(':');
+    if (colon == std::string::npos) {
+        host = rest;
+        port = 80;
+        return true;
+    }
+
+    host = rest.substr(0, colon);
+    int value = std::atoi(rest.c_str() + colon + 1);
+    if (host.empty() || value <= 0 || value > 65535) return false;
+    port = static_cast<uint16_t>(value);
+    return true;
+}
+
+HttpClient::Response HttpClient::post(std::string_view path, std::string_view contentType,
+                                      const void* body, size_t size) {
+    std::string head;
+    head.reserve(160);
+    head += "POST ";
+    head += path;
+    head += " HTTP/1.1\r\nHost: ";
+    head += m_host;
+    head += "\r\nContent-Type: ";
+    head += contentType;
+    head += "\r\nContent-Length: ";
+    head += std::to_string(size);
+    head += "\r\n\r\n";
+    return send(head, body, size);
+}
+
+HttpClient::Response HttpClient::get(std::string_view path) {
+    std::string head = "GET ";
+    head += path;
+    head += " HTTP/1.1\r\nHost: " + m_host + "\r\n\r\n";
+    return send(head, nullptr, 0);
+}
+
+HttpClient::Response HttpClient::send(const std::string& head, const void* body, size_t size) {
+    Response response;
+
+    // A kept-alive connection the server already closed only shows up once used,
+    // so a failure on a reused connection gets one retry on a fresh one
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = m_socket >= 0;
+        if (!reused && !connect(response.error)) return response;
+
+        std::string request = head;
+        request.append(static_cast<const char*>(body), size);
+
+        size_t sent = 0;
+        bool ok = true;
+        while (sent < request.size()) {
+            ssize_t n = ::send(m_socket, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                response.error = std::string("send: ") + std::strerror(errno);
+                ok = false;
+                break;
+            }
+            sent += static_cast<size_t>(n);
+        }
+
+        if (ok && readResponse(response)) return response;
+
+        disconnect();
+        if (!reused) return response;
+        response = {};
+    }
+    return response;
+}
+
+bool HttpClient::connect(std::string& error) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* result = nullptr;
+    int rc = getaddrinfo(m_host.c_str(), std::to_string(m_port).c_str(), &hints, &result);
+    if (rc != 0) {
+        error = std::string("resolve: ") + gai_strerror(rc);
+        return false;
+    }
+
+    for (auto* ai = result; ai; ai = ai->ai_next) {
+        int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+
+        timeval timeout{m_timeoutSeconds, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            m_socket = fd;
+            break;
+        }
+        error = std::string("connect: ") + std::strerror(errno);
+        ::close(fd);
+    }
+    freeaddrinfo(result);
+
+    m_buffer.clear();
+    return m_socket >= 0;
+}
+
+void HttpClient::disconnect() {
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+    }
+    m_buffer.clear();
+}
+
+bool HttpClient::fill() {
+    char chunk[16384];
+    ssize_t n = ::recv(m_socket, chunk, sizeof(chunk), 0);
+    if (n <= 0) return false;
+    m_buffer.append(chunk, static_cast<size_t>(n));
+    return m_buffer.size() <= MAX_RESPONSE_SIZE;
+}
+
+bool HttpClient::readResponse(Response& out) {
+    size_t headerEnd;
+    while ((headerEnd = m_buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!fill()) {
+            out.error = "connection closed before response";
+            return false;
+        }
+    }
+
+    std::string_view headers(m_buffer.data(), headerEnd);
+    if (headers.size() < 12 || !startsWithNoCase(headers, "HTTP/1.")) {
+        out.error = "malformed status line";
+        return false;
+    }
+    out.status = std::atoi(m_buffer.c_str() + 9);
+
+    long long contentLength = -1;
+    bool chunked = false;
+    bool close = false;
+    size_t lineStart = headers.find("\r\n") + 2;
+    while (lineStart < headers.size()) {
+        size_t lineEnd = headers.find("\r\n", lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = headers.size();
+        auto line = headers.substr(lineStart, lineEnd - lineStart);
+        if (startsWithNoCase(line, "content-length:")) {
+            contentLength = std::atoll(std::string(line.substr(15)).c_str());
+        } else if (startsWithNoCase(line, "transfer-encoding:") &&
+                   line.find("chunked") != std::string_view::npos) {
+            chunked = true;
+        } else if (startsWithNoCase(line, "connection:") &&
+                   line.find("close") != std::string_view::npos) {
+            close = true;
+        }
+        lineStart = lineEnd + 2;
+    }
+
+    m_buffer.erase(0, headerEnd + 4);
+    out.body.clear();
+
+    if (chunked) {
+        while (true) {
+            size_t lineEnd;
+            while ((lineEnd = m_buffer.find("\r\n")) == std::string::npos) {
+                if (!fill()) {
+                    out.error = "truncated chunk";
+                    return false;
+                }
+            }
+            size_t chunkSize = std::strtoul(m_buffer.c_str(), nullptr, 16);
+            while (m_buffer.size() < lineEnd + 2 + chunkSize + 2) {
+                if (!fill()) {
+                    out.error = "truncated chunk";
+                    return false;
+                }
+            }
+            out.body.append(m_buffer, lineEnd + 2, chunkSize);
+            m_buffer.erase(0, lineEnd + 2 + chunkSize + 2);
+            // No trailers are expected from the server
+            if (chunkSize == 0) break;
+        }
+    } else if (contentLength > 0) {
+        while (m_buffer.size() < static_cast<size_t>(contentLength)) {
+            if (!fill()) {
+                out.error = "truncated body";
+                return false;
+            }
+        }
+        out.body.assign(m_buffer, 0, static_cast<size_t>(contentLength));
+        m_buffer.erase(0, static_cast<size_t>(contentLength));
+    }
+
+    if (close) disconnect();
+    return true;
+}
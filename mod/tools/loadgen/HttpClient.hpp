@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Bare HTTP/1.1 client over one kept-alive plain TCP connection, enough to talk
+// to a local server. A dropped connection is reopened on the next request.
+class HttpClient {
+public:
+    struct Response {
+        // 0 when the request never got an answer
+        int status = 0;
+        std::string body;
+        std::string error;
+    };
+
+    static constexpr int DEFAULT_TIMEOUT_SECONDS = 15;
+
+    // `timeoutSeconds` bounds every send and receive
+    HttpClient(std::string host, uint16_t port, int timeoutSeconds = DEFAULT_TIMEOUT_SECONDS);
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    Response post(std::string_view path, std::string_view contentType, const void* body, size_t size);
+    Response get(std::string_view path);
+
+    // Splits http://host:port into its parts, false for anything else
+    static bool parseUrl(const std::string& url, std::string& host, uint16_t& port);
+
+private:
+    Response send(const std::string& head, const void* body, size_t size);
+    bool connect(std::string& error);
+    void disconnect();
+    bool readResponse(Response& out);
+    bool fill();
+
+    std::string m_host;
+    uint16_t m_port;
+    int m_timeoutSeconds;
+    int m_socket = -1;
+    std::string m_buffer;
+};
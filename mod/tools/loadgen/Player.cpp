@@ -0,0 +1,198 @@
+#include "Player.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    const SubmitSettings SETTINGS{true, true, true};
+    constexpr auto RESPAWN = std::chrono::seconds(1);
+    constexpr float UNITS_PER_PERCENT = 60.f;
+
+    // Rough share of levels per difficulty, and how deadly each percent of them is
+    struct Tier {
+        double share;
+        double baseHazard;
+        double sectionHazard;
+        int stars;
+        int difficulty;
+    };
+    constexpr Tier TIERS[] = {
+        {0.30, 0.002, 0.04, 2, 20},
+        {0.35, 0.006, 0.10, 5, 30},
+        {0.25, 0.015, 0.18, 8, 40},
+        {0.10, 0.030, 0.30, 10, 50},
+    };
+}
+
+double LevelProfile::hazard(int percent) const {
+    for (const auto& section : sections) {
+        if (percent >= section.from && percent < section.to) return section.hazard;
+    }
+    return baseHazard;
+}
+
+std::vector<LevelProfile> LevelProfile::generate(size_t count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    std::vector<LevelProfile> levels;
+    levels.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        LevelProfile level;
+        double roll = unit(rng);
+        const Tier* tier = &TIERS[0];
+        for (const auto& candidate : TIERS) {
+            tier = &candidate;
+            if (roll < candidate.share) break;
+            roll -= candidate.share;
+        }
+
+        int levelId = 100000 + static_cast<int>(i) * 7919;
+        level.baseHazard = tier->baseHazard;
+        for (auto& section : level.sections) {
+            section.from = std::uniform_int_distribution<int>(5, 95)(rng);
+            section.to = std::min(section.from + std::uniform_int_distribution<int>(2, 8)(rng), 100);
+            section.hazard = tier->sectionHazard * (0.5 + unit(rng));
+        }
+        level.secondsPerPercent = 0.3 + unit(rng) * 1.2;
+        level.coins = std::uniform_int_distribution<int>(0, 3)(rng);
+
+        auto& meta = level.meta;
+        meta.levelId = levelId;
+        meta.name = "Loadgen Level " + std::to_string(levelId);
+        meta.creator = "LoadgenCreator" + std::to_string(i % 500);
+        meta.description = "U3ludGhldGljIGxldmVsIGZvciBsb2FkIHRlc3Rpbmc="; // "Synthetic level for load testing"
+        meta.difficulty = tier->difficulty;
+        meta.stars = tier->stars;
+        meta.isDemon = tier->stars == 10;
+        meta.demonDifficulty = meta.isDemon ? 3 : 0;
+        meta.length = std::min(static_cast<int>(level.secondsPerPercent * 100 / 30), 4);
+        meta.downloads = std::uniform_int_distribution<int>(100, 5000000)(rng);
+        meta.likes = meta.downloads / 20;
+        levels.push_back(std::move(level));
+    }
+    return levels;
+}
+
+Player::Player(const std::vector<LevelProfile>& levels, const BatchPolicy& batchPolicy, uint64_t seed)
+    : m_levels(levels), m_rng(seed), m_batchPolicy(batchPolicy) {
+    // Players start at different points of their session
+    m_start = Clock::time_point{} + std::chrono::hours(1) +
+              std::chrono::milliseconds(std::uniform_int_distribution<int>(0, 60000)(m_rng));
+    m_now = m_start;
+
+    char id[17];
+    std::snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(m_rng() >> 1 | 1));
+    installId = id;
+    enterLevel();
+}
+
+void Player::enterLevel() {
+    // Popular levels get played far more than the rest
+    size_t index = std::min(static_cast<size_t>(std::exponential_distribution<double>(8.0)(m_rng) * m_levels.size()),
+                            m_levels.size() - 1);
+    m_level = &m_levels[index];
+    m_attemptsLeft = std::uniform_int_distribution<int>(10, 150)(m_rng);
+
+    LevelSession::LevelInfo info;
+    info.levelId = m_level->meta.levelId;
+    info.coinCount = m_level->coins;
+    m_session = LevelSession();
+    m_session.begin(info, 0, m_now);
+
+    if (!m_reportedLevels.contains(info.levelId)) {
+        m_reportedLevels.insert(info.levelId);
+        m_pendingLevels.push_back(m_level->meta);
+    }
+}
+
+bool Player::step(Batch& out) {
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    int death = 100;
+    for (int percent = 0; percent < 100; percent++) {
+        if (unit(m_rng) < m_level->hazard(percent)) {
+            death = percent;
+            break;
+        }
+    }
+
+    // Coins sit at even spacing along the level
+    int coinsPassed = 0;
+    for (int percent = 0; percent < death; percent++) {
+        m_session.onProgress(static_cast<float>(percent), percent * m_level->secondsPerPercent,
+                             percent * UNITS_PER_PERCENT);
+        while (coinsPassed < m_level->coins && percent >= (coinsPassed + 1) * 100 / (m_level->coins + 1)) {
+            if (unit(m_rng) < 0.6) m_session.onCoin(coinsPassed);
+            coinsPassed++;
+        }
+    }
+    m_now += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(death * m_level->secondsPerPercent));
+
+    ScoreEvent event;
+    if (death == 100) {
+        m_session.onProgress(100.f, 100 * m_level->secondsPerPercent, 100 * UNITS_PER_PERCENT);
+        m_session.onComplete(false);
+        if (m_session.onFinished(true, false, SETTINGS, m_now, event)) {
+            queue(event, true);
+        }
+        enterLevel();
+    } else {
+        auto progress = m_session.onDeath(static_cast<float>(death), death * m_level->secondsPerPercent,
+                                          death * UNITS_PER_PERCENT);
+        if (m_session.onReset(progress, false, SETTINGS, m_now, event)) {
+            queue(event, false);
+        }
+
+        if (--m_attemptsLeft <= 0) {
+            // Gives up on the level
+            if (m_session.takePendingDeath(event)) {
+                queue(event, false);
+            }
+            enterLevel();
+        }
+    }
+
+    m_now += RESPAWN;
+    if (m_session.hasPendingDeath() && m_session.flushPendingDeath(m_now, event)) {
+        queue(event, false);
+    }
+
+    if (!m_batchPolicy.shouldFlush(m_pending.size(), m_now)) return false;
+
+    size_t count = std::min(m_pending.size(), m_batchPolicy.maxSize());
+    out.scores.assign(std::make_move_iterator(m_pending.begin()), std::make_move_iterator(m_pending.begin() + count));
+    m_pending.erase(m_pending.begin(), m_pending.begin() + count);
+    out.levels = std::move(m_pendingLevels);
+    m_pendingLevels.clear();
+    m_batchPolicy.onFlushed(m_pending.size(), m_now);
+    return true;
+}
+
+void Player::onBatchResult(const Batch& batch, bool delivered) {
+    if (delivered) return;
+    m_pendingLevels.insert(m_pendingLevels.end(), batch.levels.begin(), batch.levels.end());
+}
+
+void Player::queue(const ScoreEvent& event, bool urgent) {
+    // Same conversion as YukiManager::onScoreEvent
+    ScoreData score;
+    score.seq = ++m_seq;
+    score.levelId = event.levelId;
+    score.levelName = m_level->meta.name;
+    score.levelCreator = m_level->meta.creator;
+    score.percentage = event.percentage;
+    score.attempts = event.attempts;
+    score.passed = event.passed;
+    score.isPractice = event.isPractice;
+    score.coinsCollected.resize(event.coinCount);
+    for (uint8_t i = 0; i < event.coinCount; i++) {
+        score.coinsCollected[i] = (event.coinMask >> i) & 1;
+    }
+    if (auto timeline = m_session.eventTimeline()) {
+        score.timeline = timeline->encode();
+    }
+
+    m_pending.push_back(std::move(score));
+    m_batchPolicy.onQueued(m_now, urgent);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "LevelMeta.hpp"
+#include "LevelSession.hpp"
+#include "BatchPolicy.hpp"
+#include "LruSet.hpp"
+#include "ScoreData.hpp"
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+// A made-up online level with its own difficulty curve
+struct LevelProfile {
+    // Stretch of the level that kills far more often than the rest
+    struct Section {
+        int from;
+        int to;
+        double hazard;
+    };
+
+    LevelMeta meta;
+    int coins = 0;
+    // Chance of dying on any given percent outside the hard sections
+    double baseHazard = 0;
+    std::array<Section, 3> sections{};
+    double secondsPerPercent = 1;
+
+    double hazard(int percent) const;
+
+    static std::vector<LevelProfile> generate(size_t count, uint64_t seed);
+};
+
+// One simulated linked player. Plays attempts in simulated time and runs them
+// through the same LevelSession, TokenBucket and BatchPolicy as the mod, so the
+// scores it produces and how they're batched match a real client.
+class Player {
+public:
+    using Clock = LevelSession::Clock;
+
+    struct Batch {
+        std::vector<ScoreData> scores;
+        std::vector<LevelMeta> levels;
+    };
+
+    Player(const std::vector<LevelProfile>& levels, const BatchPolicy& batchPolicy, uint64_t seed);
+
+    // Plays one attempt and the respawn after it. Returns true if `out` holds a
+    // batch the mod would send now.
+    bool step(Batch& out);
+    // Metadata of a failed batch rides along with the next one, like the mod does
+    void onBatchResult(const Batch& batch, bool delivered);
+
+    // Simulated time played so far
+    Clock::duration elapsed() const { return m_now - m_start; }
+
+    std::string authToken;
+    int gdAccountId = 0;
+    std::string gdUsername;
+    // Stands in for ScoreOutbox::installId(), scores carry their own sequence numbers
+    std::string installId;
+
+private:
+    void enterLevel();
+    void queue(const ScoreEvent& event, bool urgent);
+
+    const std::vector<LevelProfile>& m_levels;
+    std::mt19937_64 m_rng;
+    const LevelProfile* m_level = nullptr;
+    LevelSession m_session;
+    int m_attemptsLeft = 0;
+
+    Clock::time_point m_start;
+    Clock::time_point m_now;
+    BatchPolicy m_batchPolicy;
+    uint64_t m_seq = 0;
+    std::vector<ScoreData> m_pending;
+    std::vector<LevelMeta> m_pendingLevels;
+    LruSet<int> m_reportedLevels{256};
+};
@@ -0,0 +1,812 @@
+// Synthetic load for the score ingest path: links N fake players through
+// /api/link/verify and has them play, sending what the mod would send.
+// Run it against the stack from server/docker-compose.loadtest.yml.
+
+#include "CurlClient.hpp"
+#include "HttpClient.hpp"
+#include "Player.hpp"
+#include "ScoreCodec.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using SteadyClock = std::chrono::steady_clock;
+
+    enum class Wire { Binary, Json, Single };
+
+    struct Options {
+        std::string url = "http://127.0.0.1:3000";
+        size_t players = 100;
+        size_t threads = 0;
+        double duration = 60;
+        double ramp = 10;
+        double speed = 1;
+        size_t levels = 500;
+        Wire wire = Wire::Binary;
+        bool levelMeta = true;
+        size_t repeat = 1;
+        double recentRate = 0;
+        // The mod's BatchPolicy defaults
+        size_t batch = 32;
+        double flushInterval = 5;
+        uint64_t seed = 1;
+        // --no-dedup: run without scores_client_key_idx to see what dedup costs
+        bool dedup = true;
+        // --leaderboard: queries per level and mode instead of player traffic
+        size_t leaderboardQueries = 0;
+        size_t seedRows = 10000000;
+        size_t seedUsers = 100000;
+        size_t seedLevels = 10000;
+        // --connection-bench: submits each over a cold and a warm TLS connection
+        size_t connectionSubmits = 0;
+        std::string tlsUrl = "https://localhost:3443";
+    };
+
+    constexpr size_t RECENT_READER_THREADS = 4;
+
+    void usage() {
+        std::puts(
+            "usage: yuki-loadgen [options]\n"
+            "  --url URL          server to load, plain http only (default http://127.0.0.1:3000)\n"
+            "  --players N        simulated linked players (default 100)\n"
+            "  --threads N        sender threads (default min(players, 4 x cores))\n"
+            "  --duration S       seconds of traffic after setup (default 60)\n"
+            "  --ramp S           spread player start over S seconds (default 10)\n"
+            "  --speed X          play X times faster than real time (default 1)\n"
+            "  --levels N         size of the level pool (default 500)\n"
+            "  --wire MODE        binary | json | single (default binary, what the mod uses;\n"
+            "                     single posts each score to /api/scores)\n"
+            "  --no-level-meta    don't attach level metadata, so the server asks the GD stub\n"
+            "  --repeat N         send every batch N times as if the responses were lost, the\n"
+            "                     server should keep one copy (batch wires only, default 1)\n"
+            "  --recent-rate R    also fetch a random player's newest score R times a second,\n"
+            "                     the lookup /rs does (default 0)\n"
+            "  --batch N          most scores per batch (default 32, as in the mod)\n"
+            "  --flush-interval S flush a batch once its oldest score waited S seconds of game\n"
+            "                     time (default 5, as in the mod)\n"
+            "  --seed N           random seed (default 1)\n"
+            "  --no-dedup         drop the server's (client_install_id, client_seq) index for\n"
+            "                     the run and put it back after, to measure what dedup costs\n"
+            "\n"
+            "  --leaderboard N    instead of player traffic, seed scores and time N leaderboard\n"
+            "                     reads per level, from level_bests and aggregated from scores\n"
+            "  --seed-rows N      seeded score rows to read over (default 10000000)\n"
+            "  --seed-users N     seeded players they belong to (default 100000)\n"
+            "  --seed-levels N    seeded levels they are spread over (default 10000)\n"
+            "\n"
+            "  --connection-bench N  instead of player traffic, time N batch submits over a new\n"
+            "                     TLS connection each and N over one prewarmed connection\n"
+            "  --tls-url URL      TLS endpoint in front of the server for it (default\n"
+            "                     https://localhost:3443), --url is still used to link");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char* {
+                if (i + 1 >= argc) {
+                    std::fprintf(stderr, "%s needs a value\n", arg.c_str());
+                    std::exit(2);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--url") options.url = value();
+            else if (arg == "--players") options.players = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--threads") options.threads = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--duration") options.duration = std::atof(value());
+            else if (arg == "--ramp") options.ramp = std::atof(value());
+            else if (arg == "--speed") options.speed = std::atof(value());
+            else if (arg == "--levels") options.levels = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--no-level-meta") options.levelMeta = false;
+            else if (arg == "--repeat") options.repeat = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--recent-rate") options.recentRate = std::atof(value());
+            else if (arg == "--batch") options.batch = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--flush-interval") options.flushInterval = std::atof(value());
+            else if (arg == "--seed") options.seed = std::strtoull(value(), nullptr, 10);
+            else if (arg == "--no-dedup") options.dedup = false;
+            else if (arg == "--leaderboard") options.leaderboardQueries = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--seed-rows") options.seedRows = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--seed-users") options.seedUsers = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--seed-levels") options.seedLevels = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--connection-bench") options.connectionSubmits = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--tls-url") options.tlsUrl = value();
+            else if (arg == "--wire") {
+                std::string wire = value();
+                if (wire == "binary") options.wire = Wire::Binary;
+                else if (wire == "json") options.wire = Wire::Json;
+                else if (wire == "single") options.wire = Wire::Single;
+                else return false;
+            } else {
+                return false;
+            }
+        }
+        return options.players > 0 && options.levels > 0 && options.duration > 0 && options.speed > 0 &&
+               options.repeat > 0 && options.recentRate >= 0 && options.batch > 0 && options.flushInterval >= 0 &&
+               options.seedUsers > 0 && options.seedLevels > 0 && (options.dedup || options.repeat == 1);
+    }
+
+    // Only what the load generator needs out of the server's flat JSON replies.
+    // Returns the position right after `"key":`, or npos.
+    size_t findJsonValue(const std::string& body, const std::string& key) {
+        auto pos = body.find("\"" + key + "\"");
+        if (pos == std::string::npos) return pos;
+        pos = body.find_first_not_of(" \t\r\n", pos + key.size() + 2);
+        if (pos == std::string::npos || body[pos] != ':') return std::string::npos;
+        return body.find_first_not_of(" \t\r\n", pos + 1);
+    }
+
+    std::string jsonString(const std::string& body, const std::string& key) {
+        auto pos = findJsonValue(body, key);
+        if (pos == std::string::npos || body[pos] != '"') return "";
+        auto end = body.find('"', pos + 1);
+        return end == std::string::npos ? "" : body.substr(pos + 1, end - pos - 1);
+    }
+
+    long long jsonNumber(const std::string& body, const std::string& key, long long fallback) {
+        auto pos = findJsonValue(body, key);
+        if (pos == std::string::npos) return fallback;
+        return std::atoll(body.c_str() + pos);
+    }
+
+    std::string escapeJson(const std::string& value) {
+        std::string out;
+        for (char c : value) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t scoresSent = 0;
+        uint64_t scoresAccepted = 0;
+        uint64_t scoresDuplicate = 0;
+        // Recent score reads for players who haven't sent anything yet
+        uint64_t notFound = 0;
+        uint64_t status2xx = 0;
+        uint64_t status4xx = 0;
+        uint64_t status5xx = 0;
+        uint64_t connectionErrors = 0;
+        uint64_t bytesSent = 0;
+        // Microseconds from when the request was due, so a stalled server shows up
+        // as latency instead of as requests that were never made
+        std::vector<uint32_t> latencyUs;
+        // Microseconds from when the request actually went out
+        std::vector<uint32_t> serviceUs;
+        std::string lastError;
+
+        void merge(const Stats& other) {
+            requests += other.requests;
+            scoresSent += other.scoresSent;
+            scoresAccepted += other.scoresAccepted;
+            scoresDuplicate += other.scoresDuplicate;
+            notFound += other.notFound;
+            status2xx += other.status2xx;
+            status4xx += other.status4xx;
+            status5xx += other.status5xx;
+            connectionErrors += other.connectionErrors;
+            bytesSent += other.bytesSent;
+            latencyUs.insert(latencyUs.end(), other.latencyUs.begin(), other.latencyUs.end());
+            serviceUs.insert(serviceUs.end(), other.serviceUs.begin(), other.serviceUs.end());
+            if (!other.lastError.empty()) lastError = other.lastError;
+        }
+    };
+
+    std::atomic<uint64_t> g_requests{0};
+    std::atomic<uint64_t> g_errors{0};
+
+    struct SimPlayer {
+        std::unique_ptr<Player> player;
+        std::unique_ptr<HttpClient> client;
+        std::string discordId;
+        SteadyClock::time_point startAt;
+    };
+
+    bool linkPlayer(SimPlayer& sim, size_t index, uint64_t runId, std::string& error) {
+        std::string& discordId = sim.discordId;
+        discordId = "loadtest-" + std::to_string(runId) + "-" + std::to_string(index);
+        std::string body = "{\"discord_id\":\"" + discordId + "\",\"discord_username\":\"loadtest_" +
+                           std::to_string(index) + "\"}";
+        auto res = sim.client->post("/api/loadtest/link-code", "application/json", body.data(), body.size());
+        std::string code = jsonString(res.body, "code");
+        if (res.status != 200 || code.empty()) {
+            error = res.status == 404 ? "/api/loadtest/link-code missing, is the server running with LOADTEST=1?"
+                                      : "link code: " + std::to_string(res.status) + " " + res.error + res.body;
+            return false;
+        }
+
+        auto& player = *sim.player;
+        player.gdAccountId = static_cast<int>(20000000 + index);
+        player.gdUsername = "Loadgen" + std::to_string(index);
+        body = "{\"code\":\"" + code + "\",\"gd_account_id\":" + std::to_string(player.gdAccountId) +
+               ",\"gd_username\":\"" + player.gdUsername + "\"}";
+        res = sim.client->post("/api/link/verify", "application/json", body.data(), body.size());
+        player.authToken = jsonString(res.body, "auth_token");
+        if (res.status != 200 || player.authToken.empty()) {
+            error = "verify: " + std::to_string(res.status) + " " + res.error + res.body;
+            return false;
+        }
+        return true;
+    }
+
+    // Sends a batch the way YukiManager::sendBatch (or the old per-score path) does
+    void sendBatch(SimPlayer& sim, Player::Batch& batch, const Options& options,
+                   SteadyClock::time_point due, Stats& stats) {
+        Wire wire = options.wire;
+        bool levelMeta = options.levelMeta;
+        auto& player = *sim.player;
+        if (!levelMeta) batch.levels.clear();
+
+        ScoreCodec::SessionHeader header;
+        header.authToken = player.authToken;
+        header.gdAccountId = player.gdAccountId;
+        header.gdUsername = player.gdUsername;
+        header.installId = player.installId;
+
+        auto record = [&](const HttpClient::Response& res, SteadyClock::time_point sentAt, size_t scores) {
+            auto now = SteadyClock::now();
+            stats.requests++;
+            stats.scoresSent += scores;
+            stats.latencyUs.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - due).count()));
+            stats.serviceUs.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - sentAt).count()));
+            g_requests++;
+
+            if (res.status == 0) {
+                stats.connectionErrors++;
+                stats.lastError = res.error;
+            } else if (res.status < 300) {
+                stats.status2xx++;
+                stats.scoresAccepted += static_cast<uint64_t>(jsonNumber(res.body, "accepted", static_cast<long long>(scores)));
+                stats.scoresDuplicate += static_cast<uint64_t>(jsonNumber(res.body, "duplicates", 0));
+            } else if (res.status < 500) {
+                stats.status4xx++;
+                stats.lastError = std::to_string(res.status) + " " + res.body;
+            } else {
+                stats.status5xx++;
+                stats.lastError = std::to_string(res.status) + " " + res.body;
+            }
+            if (res.status == 0 || res.status >= 300) g_errors++;
+            return res.status >= 200 && res.status < 300;
+        };
+
+        if (wire == Wire::Single) {
+            bool delivered = true;
+            for (const auto& score : batch.scores) {
+                std::string body = "{\"auth_token\":\"" + player.authToken + "\",\"gd_account_id\":" +
+                                   std::to_string(player.gdAccountId) + ",\"gd_username\":\"" +
+                                   escapeJson(player.gdUsername) + "\",\"level_id\":" + std::to_string(score.levelId) +
+                                   ",\"percentage\":" + std::to_string(score.percentage) +
+                                   ",\"attempts\":" + std::to_string(score.attempts) +
+                                   ",\"passed\":" + (score.passed ? "true" : "false") +
+                                   ",\"is_practice\":" + (score.isPractice ? "true" : "false") + ",\"coins_collected\":[";
+                for (size_t i = 0; i < score.coinsCollected.size(); i++) {
+                    body += i ? "," : "";
+                    body += score.coinsCollected[i] ? "true" : "false";
+                }
+                body += "]}";
+
+                auto sentAt = SteadyClock::now();
+                auto res = sim.client->post("/api/scores", "application/json", body.data(), body.size());
+                stats.bytesSent += body.size();
+                delivered &= record(res, sentAt, 1);
+            }
+            player.onBatchResult(batch, delivered);
+            return;
+        }
+
+        // Resends are byte for byte the same request, like the outbox retrying a batch
+        std::vector<uint8_t> binary;
+        std::string json;
+        if (wire == Wire::Binary) binary = ScoreCodec::encodeBatch(header, batch.scores, batch.levels);
+        else json = ScoreCodec::encodeBatchJson(header, batch.scores, batch.levels);
+
+        bool delivered = false;
+        for (size_t i = 0; i < options.repeat; i++) {
+            HttpClient::Response res;
+            auto sentAt = SteadyClock::now();
+            if (wire == Wire::Binary) {
+                stats.bytesSent += binary.size();
+                res = sim.client->post("/api/scores/batch", ScoreCodec::CONTENT_TYPE, binary.data(), binary.size());
+            } else {
+                stats.bytesSent += json.size();
+                res = sim.client->post("/api/scores/batch", "application/json", json.data(), json.size());
+            }
+            delivered |= record(res, sentAt, batch.scores.size());
+        }
+        player.onBatchResult(batch, delivered);
+    }
+
+    // Plays its share of players in real time: always steps whichever player is due
+    // next, sleeping until then
+    void runWorker(std::vector<SimPlayer*> players, const Options& options,
+                   SteadyClock::time_point end, Stats& stats) {
+        struct Due {
+            SteadyClock::time_point at;
+            SimPlayer* sim;
+            Player::Clock::duration simElapsed;
+        };
+        std::vector<Due> queue;
+        for (auto* sim : players) {
+            queue.push_back({sim->startAt, sim, sim->player->elapsed()});
+        }
+        auto later = [](const Due& a, const Due& b) { return a.at > b.at; };
+        std::make_heap(queue.begin(), queue.end(), later);
+
+        Player::Batch batch;
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), later);
+            Due due = queue.back();
+            queue.pop_back();
+            if (due.at >= end) break;
+
+            std::this_thread::sleep_until(due.at);
+            if (due.sim->player->step(batch)) {
+                sendBatch(*due.sim, batch, options, due.at, stats);
+            }
+
+            // Next attempt starts once this one's simulated time has passed
+            auto simElapsed = due.sim->player->elapsed();
+            auto realStep = std::chrono::duration_cast<SteadyClock::duration>(
+                (simElapsed - due.simElapsed) / options.speed);
+            queue.push_back({due.at + realStep, due.sim, simElapsed});
+            std::push_heap(queue.begin(), queue.end(), later);
+        }
+    }
+
+    // Looks up random players' newest score at a fixed rate, like /rs invocations.
+    // Players are picked among those whose traffic already started.
+    void runReader(const std::vector<SimPlayer>& players, const Options& options, HttpClient& client,
+                   uint64_t seed, SteadyClock::time_point start, SteadyClock::time_point end, Stats& stats) {
+        std::mt19937_64 rng(seed);
+        auto interval = std::chrono::duration_cast<SteadyClock::duration>(
+            std::chrono::duration<double>(RECENT_READER_THREADS / options.recentRate));
+
+        for (auto due = start + interval; due < end; due += interval) {
+            std::this_thread::sleep_until(due);
+
+            double started = options.ramp > 0 ? std::chrono::duration<double>(due - start).count() / options.ramp : 1;
+            size_t active = std::clamp<size_t>(static_cast<size_t>(started * players.size()), 1, players.size());
+            const auto& sim = players[std::uniform_int_distribution<size_t>(0, active - 1)(rng)];
+
+            auto sentAt = SteadyClock::now();
+            auto res = client.get("/api/scores/" + sim.discordId + "/recent");
+            auto now = SteadyClock::now();
+            stats.requests++;
+            stats.latencyUs.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - due).count()));
+            stats.serviceUs.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - sentAt).count()));
+
+            if (res.status == 0) {
+                stats.connectionErrors++;
+                stats.lastError = res.error;
+            } else if (res.status < 300) {
+                stats.status2xx++;
+            } else if (res.status == 404 && res.body.find("No recent scores") != std::string::npos) {
+                stats.notFound++;
+            } else if (res.status < 500) {
+                stats.status4xx++;
+                stats.lastError = std::to_string(res.status) + " " + res.body;
+            } else {
+                stats.status5xx++;
+                stats.lastError = std::to_string(res.status) + " " + res.body;
+            }
+        }
+    }
+
+    uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t index = std::min(static_cast<size_t>(p * sorted.size()), sorted.size() - 1);
+        return sorted[index];
+    }
+
+    std::string formatUs(uint32_t us) {
+        char buffer[32];
+        if (us >= 1000000) std::snprintf(buffer, sizeof(buffer), "%.2fs", us / 1e6);
+        else if (us >= 1000) std::snprintf(buffer, sizeof(buffer), "%.1fms", us / 1e3);
+        else std::snprintf(buffer, sizeof(buffer), "%uus", us);
+        return buffer;
+    }
+
+    void printLatency(const char* name, std::vector<uint32_t>& samples) {
+        std::sort(samples.begin(), samples.end());
+        std::printf("  %-12s p50 %-9s p90 %-9s p99 %-9s p99.9 %-9s max %s\n", name,
+                    formatUs(percentile(samples, 0.50)).c_str(), formatUs(percentile(samples, 0.90)).c_str(),
+                    formatUs(percentile(samples, 0.99)).c_str(), formatUs(percentile(samples, 0.999)).c_str(),
+                    formatUs(samples.empty() ? 0 : samples.back()).c_str());
+    }
+
+    // Drops or rebuilds scores_client_key_idx through the LOADTEST route. Building it
+    // again scans the whole table, hence the long timeout.
+    bool setDedup(const std::string& host, uint16_t port, bool enabled) {
+        HttpClient client(host, port, 600);
+        std::string body = enabled ? "{\"enabled\":true}" : "{\"enabled\":false}";
+        auto res = client.post("/api/loadtest/dedup", "application/json", body.data(), body.size());
+        if (res.status == 200) return true;
+        std::fprintf(stderr, "Turning dedup %s failed: %s\n", enabled ? "on" : "off",
+                     res.status == 404 ? "/api/loadtest/dedup missing, is the server running with LOADTEST=1?"
+                                       : (std::to_string(res.status) + " " + res.error + res.body).c_str());
+        return false;
+    }
+
+    // Puts dedup back however the run ends
+    struct DedupOff {
+        const std::string& host;
+        uint16_t port;
+        bool active = false;
+
+        ~DedupOff() {
+            if (active && setDedup(host, port, true)) std::printf("Dedup back on\n");
+        }
+    };
+
+    // Seeds scores straight into the table (in chunks the server takes within the
+    // timeout), builds level bests from them and then reads the same leaderboards
+    // both ways: getLeaderboard off level_bests and level_best_counts, and an
+    // aggregate over scores as every read would be without them.
+    int runLeaderboardBench(const Options& options, const std::string& host, uint16_t port) {
+        constexpr size_t SEED_CHUNK = 500000;
+        HttpClient client(host, port, 600);
+
+        auto seed = [&](size_t rows, std::string& response) {
+            std::string body = "{\"users\":" + std::to_string(options.seedUsers) +
+                               ",\"levels\":" + std::to_string(options.seedLevels) + ",\"rows\":" + std::to_string(rows) + "}";
+            auto res = client.post("/api/loadtest/seed-scores", "application/json", body.data(), body.size());
+            response = res.body;
+            if (res.status == 200) return true;
+            std::fprintf(stderr, "Seeding failed: %s\n",
+                         res.status == 404 ? "/api/loadtest/seed-scores missing, is the server running with LOADTEST=1?"
+                                           : (std::to_string(res.status) + " " + res.error + res.body).c_str());
+            return false;
+        };
+
+        // Rows from an earlier run count, so a rerun goes straight to the reads
+        std::string state;
+        if (!seed(0, state)) return 1;
+        auto seeded = static_cast<size_t>(jsonNumber(state, "rows", 0));
+        if (seeded < options.seedRows) {
+            std::printf("Seeding %zu score rows (%zu already there)...\n", options.seedRows - seeded, seeded);
+            auto seedStart = SteadyClock::now();
+            while (seeded < options.seedRows) {
+                if (!seed(std::min(SEED_CHUNK, options.seedRows - seeded), state)) return 1;
+                seeded = static_cast<size_t>(jsonNumber(state, "rows", 0));
+                std::printf("  %10zu rows  %6.0fs\n", seeded,
+                            std::chrono::duration<double>(SteadyClock::now() - seedStart).count());
+            }
+
+            std::printf("Building level bests...\n");
+            auto backfillStart = SteadyClock::now();
+            auto res = client.post("/api/loadtest/backfill-bests", "application/json", "{}", 2);
+            if (res.status != 200) {
+                std::fprintf(stderr, "Backfill failed: %d %s%s\n", res.status, res.error.c_str(), res.body.c_str());
+                return 1;
+            }
+            std::printf("  done in %.1fs\n", std::chrono::duration<double>(SteadyClock::now() - backfillStart).count());
+        }
+
+        long long firstUser = jsonNumber(state, "first_user", 0);
+        long long lastUser = jsonNumber(state, "last_user", 0);
+        long long firstLevel = jsonNumber(state, "first_level", 0);
+        std::printf("%zu score rows, %lld players, %zu levels\n", seeded, lastUser - firstUser + 1, options.seedLevels);
+
+        // Level popularity falls off steeply, so these are about 5%, 0.3% and
+        // 0.005% of all rows
+        struct Probe {
+            const char* name;
+            long long levelId;
+        };
+        const Probe probes[] = {
+            {"top level", firstLevel},
+            {"level 10", firstLevel + 10},
+            {"mid level", firstLevel + static_cast<long long>(options.seedLevels / 2)},
+        };
+        const char* modes[] = {"materialized", "aggregate"};
+
+        std::mt19937_64 rng(options.seed);
+        std::uniform_int_distribution<long long> pickUser(firstUser, std::max(firstUser, lastUser));
+        bool agree = true;
+        int errors = 0;
+        for (const auto& probe : probes) {
+            std::printf("%s (%lld)\n", probe.name, probe.levelId);
+            std::string answers[2];
+            for (int m = 0; m < 2; m++) {
+                std::vector<uint32_t> latencyUs;
+                for (size_t i = 0; i <= options.leaderboardQueries; i++) {
+                    // The first read of each is checked against the other mode and not timed
+                    long long userId = i == 0 ? firstUser : pickUser(rng);
+                    std::string body = "{\"level_id\":" + std::to_string(probe.levelId) +
+                                       ",\"user_id\":" + std::to_string(userId) + ",\"mode\":\"" + modes[m] + "\"}";
+                    auto sentAt = SteadyClock::now();
+                    auto res = client.post("/api/loadtest/leaderboard", "application/json", body.data(), body.size());
+                    auto us = std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - sentAt).count();
+                    if (res.status != 200) {
+                        errors++;
+                        std::fprintf(stderr, "  %s read failed: %d %s%.200s\n", modes[m], res.status, res.error.c_str(),
+                                     res.body.c_str());
+                        continue;
+                    }
+                    if (i == 0) answers[m] = res.body;
+                    else latencyUs.push_back(static_cast<uint32_t>(us));
+                }
+                printLatency(modes[m], latencyUs);
+            }
+
+            for (const char* key : {"players", "rank", "best"}) {
+                if (jsonNumber(answers[0], key, -1) != jsonNumber(answers[1], key, -2)) {
+                    agree = false;
+                    std::printf("  MISMATCH %s: %lld materialized, %lld aggregate\n", key,
+                                jsonNumber(answers[0], key, -1), jsonNumber(answers[1], key, -2));
+                }
+            }
+            std::printf("  %lld players\n", jsonNumber(answers[0], "players", 0));
+        }
+        return agree && errors == 0 ? 0 : 1;
+    }
+
+    // Times what ServerConnection saves: the same batch submit over a connection
+    // opened just for it (DNS, TCP and TLS first, as after an idle gap) and over one
+    // that was prewarmed with /api/ping and kept open. Cold and warm submits
+    // alternate so both see the same server state.
+    int runConnectionBench(const Options& options, const std::string& host, uint16_t port) {
+        if (options.tlsUrl.rfind("https://", 0) != 0) {
+            std::fprintf(stderr, "--tls-url must be https://host:port, got %s\n", options.tlsUrl.c_str());
+            return 2;
+        }
+
+        auto levels = LevelProfile::generate(options.levels, options.seed);
+        BatchPolicy batchPolicy(options.batch, std::chrono::duration_cast<BatchPolicy::Clock::duration>(
+                                                   std::chrono::duration<double>(options.flushInterval)));
+        SimPlayer sim;
+        sim.player = std::make_unique<Player>(levels, batchPolicy, options.seed * 1000003);
+        sim.client = std::make_unique<HttpClient>(host, port);
+        std::string error;
+        uint64_t runId = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count()) % 1000000000;
+        if (!linkPlayer(sim, 0, runId, error)) {
+            std::fprintf(stderr, "Setup failed: %s\n", error.c_str());
+            return 1;
+        }
+
+        ScoreCodec::SessionHeader header;
+        header.authToken = sim.player->authToken;
+        header.gdAccountId = sim.player->gdAccountId;
+        header.gdUsername = sim.player->gdUsername;
+        header.installId = sim.player->installId;
+
+        CurlClient warm(options.tlsUrl);
+        auto ping = warm.get("/api/ping");
+        if (ping.status != 200) {
+            std::fprintf(stderr, "Prewarm failed: %d %s%.200s\n", ping.status, ping.error.c_str(), ping.body.c_str());
+            return 1;
+        }
+        std::printf("Prewarmed %s over HTTP/%d in %s (TLS handshake %s)\n", options.tlsUrl.c_str(), ping.httpVersion,
+                    formatUs(ping.totalUs).c_str(), formatUs(ping.tlsUs).c_str());
+
+        std::vector<uint32_t> coldUs, warmUs, connectUs, tlsUs;
+        long warmConnections = 0;
+        int errors = 0;
+        Player::Batch batch;
+        for (size_t i = 0; i < options.connectionSubmits * 2; i++) {
+            while (!sim.player->step(batch)) {}
+            if (!options.levelMeta) batch.levels.clear();
+            auto body = ScoreCodec::encodeBatch(header, batch.scores, batch.levels);
+
+            bool cold = i % 2 == 0;
+            CurlClient::Response res;
+            if (cold) {
+                CurlClient fresh(options.tlsUrl);
+                res = fresh.post("/api/scores/batch", ScoreCodec::CONTENT_TYPE, body.data(), body.size());
+            } else {
+                res = warm.post("/api/scores/batch", ScoreCodec::CONTENT_TYPE, body.data(), body.size());
+            }
+
+            bool ok = res.status >= 200 && res.status < 300;
+            sim.player->onBatchResult(batch, ok);
+            if (!ok) {
+                errors++;
+                std::fprintf(stderr, "  submit failed: %d %s%.200s\n", res.status, res.error.c_str(), res.body.c_str());
+                continue;
+            }
+            if (cold) {
+                coldUs.push_back(res.totalUs);
+                connectUs.push_back(res.connectUs);
+                tlsUs.push_back(res.tlsUs);
+            } else {
+                warmUs.push_back(res.totalUs);
+                warmConnections += res.newConnections;
+            }
+        }
+
+        std::printf("\nSubmit latency over %zu batches each\n", options.connectionSubmits);
+        printLatency("cold", coldUs);
+        printLatency("warm", warmUs);
+        std::printf("Cold connection setup\n");
+        printLatency("tcp connect", connectUs);
+        printLatency("tls", tlsUs);
+        // Anything but 0 means the kept connection was dropped between submits
+        std::printf("  warm submits opened %ld new connections\n", warmConnections);
+        return errors == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::string host;
+    uint16_t port;
+    if (!HttpClient::parseUrl(options.url, host, port)) {
+        std::fprintf(stderr, "Only plain http://host:port URLs are supported, got %s\n", options.url.c_str());
+        return 2;
+    }
+
+    if (options.leaderboardQueries > 0) return runLeaderboardBench(options, host, port);
+    if (options.connectionSubmits > 0) return runConnectionBench(options, host, port);
+
+    if (options.threads == 0) {
+        options.threads = std::max<size_t>(std::thread::hardware_concurrency(), 1) * 4;
+    }
+    options.threads = std::min(options.threads, options.players);
+
+    DedupOff dedupOff{host, port};
+    if (!options.dedup) {
+        if (!setDedup(host, port, false)) return 1;
+        dedupOff.active = true;
+        std::printf("Dedup off, scores_client_key_idx dropped\n");
+    }
+
+    auto levels = LevelProfile::generate(options.levels, options.seed);
+    BatchPolicy batchPolicy(options.batch, std::chrono::duration_cast<BatchPolicy::Clock::duration>(
+                                               std::chrono::duration<double>(options.flushInterval)));
+    std::vector<SimPlayer> players(options.players);
+    for (size_t i = 0; i < players.size(); i++) {
+        players[i].player = std::make_unique<Player>(levels, batchPolicy, options.seed * 1000003 + i);
+        players[i].client = std::make_unique<HttpClient>(host, port);
+    }
+
+    // Linking is setup, not part of the measured traffic
+    std::printf("Linking %zu players...\n", players.size());
+    auto setupStart = SteadyClock::now();
+    uint64_t runId = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count()) % 1000000000;
+    std::atomic<size_t> nextPlayer{0};
+    std::atomic<bool> setupFailed{false};
+    std::mutex errorMutex;
+    std::string setupError;
+    {
+        std::vector<std::thread> linkers;
+        for (size_t t = 0; t < options.threads; t++) {
+            linkers.emplace_back([&] {
+                std::string error;
+                for (size_t i; !setupFailed && (i = nextPlayer++) < players.size();) {
+                    if (!linkPlayer(players[i], i, runId, error)) {
+                        setupFailed = true;
+                        std::lock_guard lock(errorMutex);
+                        setupError = error;
+                    }
+                }
+            });
+        }
+        for (auto& linker : linkers) linker.join();
+    }
+    if (setupFailed) {
+        std::fprintf(stderr, "Setup failed: %s\n", setupError.c_str());
+        return 1;
+    }
+    std::printf("Linked in %.1fs\n", std::chrono::duration<double>(SteadyClock::now() - setupStart).count());
+
+    auto start = SteadyClock::now();
+    auto end = start + std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(options.duration));
+    for (size_t i = 0; i < players.size(); i++) {
+        players[i].startAt = start + std::chrono::duration_cast<SteadyClock::duration>(
+            std::chrono::duration<double>(options.ramp * static_cast<double>(i) / static_cast<double>(players.size())));
+    }
+
+    std::vector<Stats> stats(options.threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < options.threads; t++) {
+        std::vector<SimPlayer*> share;
+        for (size_t i = t; i < players.size(); i += options.threads) {
+            share.push_back(&players[i]);
+        }
+        workers.emplace_back(runWorker, std::move(share), std::cref(options), end, std::ref(stats[t]));
+    }
+
+    std::vector<Stats> readStats(options.recentRate > 0 ? RECENT_READER_THREADS : 0);
+    std::vector<std::unique_ptr<HttpClient>> readClients;
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < readStats.size(); t++) {
+        readClients.push_back(std::make_unique<HttpClient>(host, port));
+        readers.emplace_back(runReader, std::cref(players), std::cref(options), std::ref(*readClients.back()),
+                             options.seed * 7919 + t, start, end, std::ref(readStats[t]));
+    }
+
+    std::printf("Running %zu players on %zu threads for %.0fs (%s wire, batches of up to %zu every %gs, %.1fx speed)\n",
+                options.players, options.threads, options.duration,
+                options.wire == Wire::Binary ? "binary" : options.wire == Wire::Json ? "json" : "single", options.batch,
+                options.flushInterval, options.speed);
+    uint64_t lastRequests = 0;
+    while (SteadyClock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::seconds(5));
+        uint64_t requests = g_requests;
+        std::printf("  %6.0fs  %7.1f req/s  %llu errors\n",
+                    std::chrono::duration<double>(SteadyClock::now() - start).count(),
+                    (requests - lastRequests) / 5.0, static_cast<unsigned long long>(g_errors.load()));
+        lastRequests = requests;
+    }
+    for (auto& worker : workers) worker.join();
+    for (auto& reader : readers) reader.join();
+    double elapsed = std::chrono::duration<double>(SteadyClock::now() - start).count();
+
+    Stats total;
+    for (const auto& s : stats) total.merge(s);
+
+    uint64_t errors = total.status4xx + total.status5xx + total.connectionErrors;
+    std::printf("\nResults over %.1fs\n", elapsed);
+    std::printf("  requests  %llu (%.1f/s), %.1f scores each, %.1f KB/s sent\n",
+                static_cast<unsigned long long>(total.requests), total.requests / elapsed,
+                total.requests ? static_cast<double>(total.scoresSent) / total.requests : 0.0,
+                total.bytesSent / elapsed / 1024.0);
+    std::printf("  scores    %llu sent (%.1f/s), %llu accepted, %llu duplicates\n",
+                static_cast<unsigned long long>(total.scoresSent), total.scoresSent / elapsed,
+                static_cast<unsigned long long>(total.scoresAccepted),
+                static_cast<unsigned long long>(total.scoresDuplicate));
+    std::printf("  errors    %.2f%% (4xx %llu, 5xx %llu, connection %llu)\n",
+                total.requests ? 100.0 * errors / total.requests : 0.0, static_cast<unsigned long long>(total.status4xx),
+                static_cast<unsigned long long>(total.status5xx), static_cast<unsigned long long>(total.connectionErrors));
+    if (!total.lastError.empty()) {
+        std::printf("  last error: %.200s\n", total.lastError.c_str());
+    }
+    // With --repeat every score past its first copy must come back as a duplicate
+    bool exactlyOnce = true;
+    if (options.repeat > 1 && options.wire != Wire::Single) {
+        uint64_t expected = total.scoresSent / options.repeat;
+        exactlyOnce = total.scoresAccepted == expected && total.scoresDuplicate == total.scoresSent - expected;
+        std::printf("  dedup     %s (expected %llu accepted)\n", exactlyOnce ? "ok" : "FAILED",
+                    static_cast<unsigned long long>(expected));
+    }
+
+    std::printf("Latency\n");
+    printLatency("scheduled", total.latencyUs);
+    printLatency("service", total.serviceUs);
+    // Batches differ in size, so compare runs on server time spent per score
+    uint64_t serviceTotalUs = 0;
+    for (uint32_t us : total.serviceUs) serviceTotalUs += us;
+    std::printf("  %-12s %.1fus (%s)\n", "per score",
+                total.scoresSent ? static_cast<double>(serviceTotalUs) / total.scoresSent : 0.0,
+                options.dedup ? "dedup on" : "dedup off");
+
+    uint64_t readErrors = 0;
+    if (!readStats.empty()) {
+        Stats reads;
+        for (const auto& s : readStats) reads.merge(s);
+        readErrors = reads.status4xx + reads.status5xx + reads.connectionErrors;
+
+        std::printf("Recent score reads\n");
+        std::printf("  requests  %llu (%.1f/s), %llu found, %llu with no scores yet, %llu errors\n",
+                    static_cast<unsigned long long>(reads.requests), reads.requests / elapsed,
+                    static_cast<unsigned long long>(reads.status2xx), static_cast<unsigned long long>(reads.notFound),
+                    static_cast<unsigned long long>(readErrors));
+        if (!reads.lastError.empty()) {
+            std::printf("  last error: %.200s\n", reads.lastError.c_str());
+        }
+        printLatency("scheduled", reads.latencyUs);
+        printLatency("service", reads.serviceUs);
+    }
+    return errors == 0 && readErrors == 0 && exactlyOnce ? 0 : 1;
+}
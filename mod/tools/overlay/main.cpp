@@ -0,0 +1,400 @@
+// Reads the live state the mod shares for stream overlays and prints it, the
+// starting point for an overlay of your own. Also plays the game's side with a
+// simulated player, and measures both sides with --bench.
+
+#include "OverlayExport.hpp"
+#include "FlushScheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using SteadyClock = std::chrono::steady_clock;
+
+    enum class Mode { Read, Simulate, Bench };
+
+    struct Options {
+        Mode mode = Mode::Read;
+        std::filesystem::path file;
+        double pollMs = 16;
+        double fps = 60;
+        double duration = 5;
+        uint64_t seed = 1;
+    };
+
+    void usage() {
+        std::puts(
+            "usage: yuki-overlay [options] FILE\n"
+            "  FILE               overlay.bin in the mod's save folder (with --bench, a\n"
+            "                     scratch file, default in the temp folder)\n"
+            "  --poll MS          how often to read, like an overlay's refresh (default 16)\n"
+            "  --simulate         write FILE like the game does, with a simulated player\n"
+            "  --bench            time publishing and reading on a scratch file\n"
+            "  --fps N            simulated frame rate (default 60)\n"
+            "  --duration S       how long --bench runs each part (default 5)\n"
+            "  --seed N           random seed for --simulate (default 1)");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char* {
+                if (i + 1 >= argc) {
+                    std::fprintf(stderr, "%s needs a value\n", arg.c_str());
+                    std::exit(2);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--poll") options.pollMs = std::atof(value());
+            else if (arg == "--simulate") options.mode = Mode::Simulate;
+            else if (arg == "--bench") options.mode = Mode::Bench;
+            else if (arg == "--fps") options.fps = std::atof(value());
+            else if (arg == "--duration") options.duration = std::atof(value());
+            else if (arg == "--seed") options.seed = std::strtoull(value(), nullptr, 10);
+            else if (arg.rfind("--", 0) == 0 || !options.file.empty()) return false;
+            else options.file = arg;
+        }
+        if (options.file.empty()) {
+            if (options.mode != Mode::Bench) return false;
+            options.file = std::filesystem::temp_directory_path() / "yuki-overlay-bench.bin";
+        }
+        return options.pollMs >= 0 && options.fps > 0 && options.duration > 0;
+    }
+
+    const char* gameStateName(uint8_t state) {
+        switch (static_cast<GameState>(state)) {
+            case GameState::Menu: return "menu";
+            case GameState::Playing: return "playing";
+            case GameState::Paused: return "paused";
+            case GameState::EndScreen: return "end screen";
+        }
+        return "?";
+    }
+
+    const char* eventName(OverlayEventType type) {
+        switch (type) {
+            case OverlayEventType::EnterLevel: return "enter level";
+            case OverlayEventType::NewAttempt: return "new attempt";
+            case OverlayEventType::Death: return "death";
+            case OverlayEventType::Complete: return "complete";
+            case OverlayEventType::ExitLevel: return "exit level";
+        }
+        return "?";
+    }
+
+    void sleepMs(double ms) {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms));
+    }
+
+    int runReader(const Options& options) {
+        OverlayReader reader;
+        bool waiting = false;
+        OverlayState shown;
+        bool shownAny = false;
+        uint64_t session = 0;
+        uint64_t lostShown = 0;
+        std::vector<OverlayEvent> events;
+
+        while (true) {
+            if (!reader.isOpen() && !reader.open(options.file)) {
+                if (!waiting) std::printf("Waiting for %s...\n", options.file.string().c_str());
+                waiting = true;
+                sleepMs(1000);
+                continue;
+            }
+            if (waiting || reader.session() != session) {
+                std::printf("Reading game session %llx\n", static_cast<unsigned long long>(reader.session()));
+                waiting = false;
+                session = reader.session();
+            }
+
+            events.clear();
+            reader.readEvents(events);
+            for (const auto& event : events) {
+                std::printf("  %-11s level %d, attempt %d at %.1f%%\n", eventName(event.type), event.levelId,
+                            event.attempt, event.percent);
+            }
+
+            OverlayState state;
+            if (reader.readState(state)) {
+                // Only what an overlay would redraw for, not every frame's timestamp
+                bool changed = !shownAny || state.levelId != shown.levelId || state.attempt != shown.attempt ||
+                               static_cast<int>(state.percent) != static_cast<int>(shown.percent) ||
+                               state.gameState != shown.gameState;
+                if (changed) {
+                    double ageMs = (OverlayState::now() - state.updatedAt) / 1e6;
+                    if (state.levelId == 0) {
+                        std::printf("%-10s (%.1fms old)\n", gameStateName(state.gameState), ageMs);
+                    } else {
+                        // Whole percents, the way the game's progress bar shows them
+                        std::printf("%-10s %s (%d) attempt %d, %d%% (best %d%%)%s (%.1fms old)\n",
+                                    gameStateName(state.gameState), state.levelName, state.levelId, state.attempt,
+                                    static_cast<int>(state.percent), static_cast<int>(state.bestPercent),
+                                    state.practice ? " practice" : "", ageMs);
+                    }
+                    shown = state;
+                    shownAny = true;
+                }
+            }
+
+            if (reader.lostEvents() > lostShown) {
+                std::printf("  (%llu events missed)\n", static_cast<unsigned long long>(reader.lostEvents() - lostShown));
+                lostShown = reader.lostEvents();
+            }
+            std::fflush(stdout);
+            sleepMs(options.pollMs);
+        }
+    }
+
+    // Plays one made-up level over and over: steady progress, a death chance per
+    // frame, a short pause before each new attempt and a pause menu now and then
+    int runSimulation(const Options& options) {
+        OverlayWriter writer;
+        if (!writer.open(options.file, OverlayState::now())) {
+            std::fprintf(stderr, "Can't open %s\n", options.file.string().c_str());
+            return 1;
+        }
+
+        std::mt19937_64 rng(options.seed);
+        std::uniform_real_distribution<double> unit(0, 1);
+        auto frame = std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(1 / options.fps));
+
+        auto& state = writer.state();
+        state.levelId = 128;
+        state.setLevelName("Simulated Level");
+        state.attempt = 1;
+        state.gameState = static_cast<uint8_t>(GameState::Playing);
+        writer.pushEvent(OverlayEventType::EnterLevel, OverlayState::now());
+
+        // Percent per frame, about a minute for the whole level
+        const double speed = 100.0 / (60 * options.fps);
+        int respawnFrames = 0;
+        int pausedFrames = 0;
+        std::printf("Simulating a player at %.0f fps into %s\n", options.fps, options.file.string().c_str());
+
+        auto next = SteadyClock::now();
+        while (true) {
+            uint64_t now = OverlayState::now();
+            if (pausedFrames > 0) {
+                if (--pausedFrames == 0) state.gameState = static_cast<uint8_t>(GameState::Playing);
+            } else if (respawnFrames > 0) {
+                if (--respawnFrames == 0) {
+                    state.percent = 0;
+                    state.attempt++;
+                    writer.pushEvent(OverlayEventType::NewAttempt, now);
+                }
+            } else if (unit(rng) < 0.1 / options.fps) {
+                pausedFrames = static_cast<int>(2 * options.fps);
+                state.gameState = static_cast<uint8_t>(GameState::Paused);
+            } else {
+                state.percent = std::min(100.0, state.percent + speed);
+                if (state.percent >= 100) {
+                    writer.pushEvent(OverlayEventType::Complete, now);
+                    state.bestPercent = 100;
+                    respawnFrames = static_cast<int>(3 * options.fps);
+                } else if (unit(rng) < 0.2 / options.fps) {
+                    writer.pushEvent(OverlayEventType::Death, now);
+                    state.bestPercent = std::max(state.bestPercent, state.percent);
+                    respawnFrames = static_cast<int>(options.fps / 2);
+                }
+            }
+            writer.publish(now);
+
+            next += frame;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t index = std::min(static_cast<size_t>(p * sorted.size()), sorted.size() - 1);
+        return sorted[index];
+    }
+
+    std::string formatNs(uint64_t ns) {
+        char buffer[32];
+        if (ns >= 1000000) std::snprintf(buffer, sizeof(buffer), "%.2fms", ns / 1e6);
+        else if (ns >= 1000) std::snprintf(buffer, sizeof(buffer), "%.1fus", ns / 1e3);
+        else std::snprintf(buffer, sizeof(buffer), "%lluns", static_cast<unsigned long long>(ns));
+        return buffer;
+    }
+
+    void printLatency(const char* name, std::vector<uint64_t>& samples) {
+        std::sort(samples.begin(), samples.end());
+        std::printf("  %-12s p50 %-9s p90 %-9s p99 %-9s p99.9 %-9s max %-9s (%zu samples)\n", name,
+                    formatNs(percentile(samples, 0.50)).c_str(), formatNs(percentile(samples, 0.90)).c_str(),
+                    formatNs(percentile(samples, 0.99)).c_str(), formatNs(percentile(samples, 0.999)).c_str(),
+                    formatNs(samples.empty() ? 0 : samples.back()).c_str(), samples.size());
+    }
+
+    // Two parts, each with a reader spinning on another core the whole time:
+    //
+    // - back to back: publish as fast as possible, the worst case for readers
+    //   racing the writer and the cost of a publish with the cache line contended
+    // - paced: publish once per frame at --fps and push an event every tenth,
+    //   timing each publish, how long until the spinning reader sees it, and how
+    //   old the state is when an overlay polling every --poll ms reads it
+    int runBench(const Options& options) {
+        auto duration = std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(options.duration));
+
+        OverlayWriter writer;
+        if (!writer.open(options.file, OverlayState::now())) {
+            std::fprintf(stderr, "Can't open %s\n", options.file.string().c_str());
+            return 1;
+        }
+        auto& state = writer.state();
+        state.levelId = 128;
+        state.setLevelName("Benchmark Level");
+        state.attempt = 1;
+        state.gameState = static_cast<uint8_t>(GameState::Playing);
+        // Every publish sets percent from its own timestamp, so a reader can tell a torn copy
+        uint64_t first = OverlayState::now();
+        state.percent = static_cast<float>(first % 100000);
+        writer.publish(first);
+
+        std::atomic<bool> stop{false};
+        std::atomic<bool> paced{false};
+        std::vector<uint64_t> visible;
+        std::vector<uint64_t> polledAge;
+        std::atomic<uint64_t> spinReads{0};
+        uint64_t spinRetries = 0;
+        uint64_t torn = 0;
+        uint64_t eventsSeen = 0;
+        uint64_t eventsLost = 0;
+
+        // Spins on the state, noting when each new publish first shows up
+        std::thread spinner([&] {
+            OverlayReader reader;
+            if (!reader.open(options.file)) return;
+            std::vector<OverlayEvent> events;
+            uint64_t lastSeen = 0;
+            bool wasPaced = false;
+            while (!stop.load(std::memory_order_relaxed)) {
+                OverlayState seen;
+                if (!reader.readState(seen)) {
+                    // The writer is mid-publish, and may be waiting for this core
+                    std::this_thread::yield();
+                    continue;
+                }
+                spinReads.fetch_add(1, std::memory_order_relaxed);
+                uint64_t now = OverlayState::now();
+                if (seen.percent != static_cast<float>(seen.updatedAt % 100000)) torn++;
+
+                bool isPaced = paced.load(std::memory_order_relaxed);
+                if (isPaced && !wasPaced) reader.readEvents(events);
+                wasPaced = isPaced;
+                if (isPaced && seen.updatedAt != lastSeen) {
+                    visible.push_back(now - seen.updatedAt);
+                    lastSeen = seen.updatedAt;
+                    events.clear();
+                    reader.readEvents(events);
+                    eventsSeen += events.size();
+                }
+            }
+            spinRetries = reader.retries();
+            eventsLost = reader.lostEvents();
+        });
+
+        // Reads the way an overlay would, every --poll ms
+        std::thread poller([&] {
+            OverlayReader reader;
+            if (!reader.open(options.file)) return;
+            while (!stop.load(std::memory_order_relaxed)) {
+                OverlayState seen;
+                if (paced.load(std::memory_order_relaxed) && reader.readState(seen)) {
+                    polledAge.push_back(OverlayState::now() - seen.updatedAt);
+                }
+                sleepMs(options.pollMs);
+            }
+        });
+
+        std::printf("Back to back for %.0fs...\n", options.duration);
+        uint64_t publishes = 0;
+        auto start = SteadyClock::now();
+        auto end = start + duration;
+        while (SteadyClock::now() < end) {
+            for (int i = 0; i < 1000; i++) {
+                uint64_t now = OverlayState::now();
+                state.percent = static_cast<float>(now % 100000);
+                writer.publish(now);
+            }
+            publishes += 1000;
+        }
+        double elapsedNs = std::chrono::duration<double, std::nano>(SteadyClock::now() - start).count();
+        uint64_t hotReads = spinReads.load();
+
+        std::printf("Paced at %.0f fps for %.0fs...\n", options.fps, options.duration);
+        std::vector<uint64_t> publishCost;
+        auto frame = std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(1 / options.fps));
+        uint64_t eventsPushed = 0;
+        paced = true;
+        // Let the spinner catch up on the event count before the first event
+        sleepMs(50);
+        auto next = SteadyClock::now();
+        end = next + duration;
+        for (uint64_t n = 0; next < end; n++) {
+            auto before = SteadyClock::now();
+            uint64_t now = OverlayState::now();
+            state.percent = static_cast<float>(now % 100000);
+            if (n % 10 == 0) {
+                writer.pushEvent(OverlayEventType::Death, now);
+                eventsPushed++;
+            }
+            writer.publish(now);
+            publishCost.push_back(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - before).count()));
+
+            next += frame;
+            std::this_thread::sleep_until(next);
+        }
+        sleepMs(50);
+        stop = true;
+        spinner.join();
+        poller.join();
+
+        std::printf("\nBack to back\n");
+        std::printf("  publish      %.1fns each, %llu publishes\n", elapsedNs / publishes,
+                    static_cast<unsigned long long>(publishes));
+        std::printf("  reader       %llu consistent reads while publishing\n",
+                    static_cast<unsigned long long>(hotReads));
+        std::printf("Paced at %.0f fps\n", options.fps);
+        printLatency("publish", publishCost);
+        printLatency("visible", visible);
+        char name[32];
+        std::snprintf(name, sizeof(name), "age @%.0fms", options.pollMs);
+        printLatency(name, polledAge);
+        std::printf("Reader\n");
+        std::printf("  retries      %llu of %llu reads, %llu torn\n", static_cast<unsigned long long>(spinRetries),
+                    static_cast<unsigned long long>(spinReads.load() + spinRetries), static_cast<unsigned long long>(torn));
+        std::printf("  events       %llu pushed, %llu seen, %llu lost\n", static_cast<unsigned long long>(eventsPushed),
+                    static_cast<unsigned long long>(eventsSeen), static_cast<unsigned long long>(eventsLost));
+
+        writer.close();
+        std::error_code ec;
+        std::filesystem::remove(options.file, ec);
+        return torn == 0 && eventsLost == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    switch (options.mode) {
+        case Mode::Read: return runReader(options);
+        case Mode::Simulate: return runSimulation(options);
+        case Mode::Bench: return runBench(options);
+    }
+    return 0;
+}
@@ -0,0 +1,700 @@
+// Replays hook traces recorded by the mod (Record Hook Traces) through the
+// mod's own submission path: LevelSession decides what gets submitted, scores go
+// through the outbox, BatchPolicy, FlushScheduler, SubmissionTracker and
+// RetryBackoff exactly as YukiManager drives them, and batches are posted to a
+// local server. Reports request volume, latency, allocation counts and the game
+// thread's work per frame while playing, so the same recorded sessions can be
+// compared across changes.
+
+#include "../loadgen/HttpClient.hpp"
+#include "BatchPolicy.hpp"
+#include "FlushScheduler.hpp"
+#include "HookTrace.hpp"
+#include "LevelSession.hpp"
+#include "LruSet.hpp"
+#include "RetryBackoff.hpp"
+#include "ScoreCodec.hpp"
+#include "ScoreOutbox.hpp"
+#include "StringTable.hpp"
+#include "SubmissionTracker.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    // Every allocation made while one of these counters is current is added to it
+    std::atomic<uint64_t>* g_allocCounter = nullptr;
+
+    class CountAllocations {
+    public:
+        explicit CountAllocations(std::atomic<uint64_t>& counter) : m_previous(g_allocCounter) {
+            g_allocCounter = &counter;
+        }
+        ~CountAllocations() { g_allocCounter = m_previous; }
+
+    private:
+        std::atomic<uint64_t>* m_previous;
+    };
+}
+
+void* operator new(size_t size) {
+    if (auto counter = g_allocCounter) counter->fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::string url = "http://127.0.0.1:3000";
+        double speed = 1;
+        size_t loops = 1;
+        bool dryRun = false;
+        // Hold Uploads While Playing
+        bool hold = true;
+        std::string outbox;
+        std::vector<std::string> traces;
+    };
+
+    // Same settings as YukiManager's defaults
+    constexpr size_t MAX_CONCURRENT_SUBMISSIONS = 2;
+    constexpr auto DRAIN_INTERVAL = std::chrono::seconds(1);
+    // Time between two traces, the player picking the next level
+    constexpr auto LEVEL_GAP = std::chrono::seconds(3);
+    // How long to keep draining after the last trace before giving up
+    constexpr auto MAX_TAIL = std::chrono::minutes(10);
+
+    void usage() {
+        std::puts(
+            "usage: yuki-replay [options] TRACE...\n"
+            "  --url URL          server to send to, plain http only (default http://127.0.0.1:3000)\n"
+            "  --speed X          replay X times faster than recorded, 0 for as fast as possible\n"
+            "                     (default 1)\n"
+            "  --loops N          replay the traces N times over (default 1)\n"
+            "  --dry-run          don't link or send anything, every batch counts as delivered\n"
+            "  --no-hold          send while playing, as with Hold Uploads While Playing off\n"
+            "  --outbox DIR       keep the outbox here instead of a fresh temporary folder\n"
+            "TRACE is a .ytrace file or a folder of them, replayed in name order.");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char* {
+                if (i + 1 >= argc) {
+                    std::fprintf(stderr, "%s needs a value\n", arg.c_str());
+                    std::exit(2);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--url") options.url = value();
+            else if (arg == "--speed") options.speed = std::atof(value());
+            else if (arg == "--loops") options.loops = std::strtoul(value(), nullptr, 10);
+            else if (arg == "--dry-run") options.dryRun = true;
+            else if (arg == "--no-hold") options.hold = false;
+            else if (arg == "--outbox") options.outbox = value();
+            else if (arg.starts_with("--")) return false;
+            else options.traces.push_back(arg);
+        }
+        return !options.traces.empty() && options.speed >= 0 && options.loops > 0;
+    }
+
+    bool loadTraces(const std::vector<std::string>& args, std::vector<HookTrace>& out) {
+        std::vector<std::filesystem::path> paths;
+        for (const auto& arg : args) {
+            std::error_code ec;
+            if (!std::filesystem::is_directory(arg, ec)) {
+                paths.emplace_back(arg);
+                continue;
+            }
+            std::vector<std::filesystem::path> found;
+            for (const auto& entry : std::filesystem::directory_iterator(arg, ec)) {
+                if (entry.path().extension() == ".ytrace") found.push_back(entry.path());
+            }
+            std::sort(found.begin(), found.end());
+            paths.insert(paths.end(), found.begin(), found.end());
+        }
+
+        for (const auto& path : paths) {
+            HookTrace trace;
+            if (!HookTrace::load(path, trace)) {
+                std::fprintf(stderr, "%s is not a hook trace\n", path.string().c_str());
+                return false;
+            }
+            if (trace.truncated) {
+                std::fprintf(stderr, "warning: %s was cut short while recording\n", path.string().c_str());
+            }
+            out.push_back(std::move(trace));
+        }
+        return !out.empty();
+    }
+
+    // Only what the replayer needs out of the server's flat JSON replies.
+    // Returns the position right after `"key":`, or npos.
+    size_t findJsonValue(const std::string& body, const std::string& key) {
+        auto pos = body.find("\"" + key + "\"");
+        if (pos == std::string::npos) return pos;
+        pos = body.find_first_not_of(" \t\r\n", pos + key.size() + 2);
+        if (pos == std::string::npos || body[pos] != ':') return std::string::npos;
+        return body.find_first_not_of(" \t\r\n", pos + 1);
+    }
+
+    std::string jsonString(const std::string& body, const std::string& key) {
+        auto pos = findJsonValue(body, key);
+        if (pos == std::string::npos || body[pos] != '"') return "";
+        auto end = body.find('"', pos + 1);
+        return end == std::string::npos ? "" : body.substr(pos + 1, end - pos - 1);
+    }
+
+    long long jsonNumber(const std::string& body, const std::string& key, long long fallback) {
+        auto pos = findJsonValue(body, key);
+        if (pos == std::string::npos) return fallback;
+        return std::atoll(body.c_str() + pos);
+    }
+
+    int64_t unixMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    struct Stats {
+        uint64_t records = 0;
+        // Spent in LevelSession, what the hooks cost the game thread
+        Clock::duration hookTime{};
+        uint64_t scoresQueued = 0;
+        uint64_t batches = 0;
+        uint64_t scoresSent = 0;
+        uint64_t scoresAccepted = 0;
+        uint64_t scoresDuplicate = 0;
+        uint64_t failedBatches = 0;
+        uint64_t heldFlushes = 0;
+        uint64_t bytesSent = 0;
+        std::vector<uint32_t> latencyUs;
+        // Game thread work in each frame that had any while the level was being
+        // played: the hooks and the flushes they start (see timeFrame)
+        std::vector<uint32_t> playingFrameNs;
+        std::string lastError;
+        // Made by the hook side (LevelSession) and by everything after queueScore
+        std::atomic<uint64_t> hookAllocs{0};
+        std::atomic<uint64_t> submitAllocs{0};
+    };
+
+    // The submission half of YukiManager, on the replay's virtual clock. Requests
+    // are synchronous, so a batch finishes before the next one starts.
+    class Client {
+    public:
+        Client(const Options& options, std::filesystem::path outboxDir, HttpClient* http, Stats& stats)
+            : m_options(options), m_outbox(std::move(outboxDir)), m_http(http), m_stats(stats) {
+            m_flushScheduler.setEnabled(options.hold);
+        }
+
+        bool open(std::string& error) {
+            if (!m_outbox.open()) {
+                error = "couldn't open the outbox";
+                return false;
+            }
+            char id[17];
+            std::snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(m_outbox.installId()));
+            m_header.installId = id;
+            return m_options.dryRun || link(error);
+        }
+
+        StringTable& strings() { return m_strings; }
+        GameState gameState() const { return m_flushScheduler.state(); }
+        size_t queueDepth() const { return m_outbox.pendingCount() - m_outbox.inFlightCount(); }
+        size_t pending() const { return m_outbox.pendingCount(); }
+        // Spent on what the mod does off the game thread: building and storing
+        // scores on the submit worker, and requests on web threads
+        Clock::duration offThreadTime() const { return m_offThread; }
+
+        // YukiManager::reportLevel
+        void reportLevel(const LevelMeta& level) {
+            if (level.levelId <= 0 || m_reportedLevels.contains(level.levelId)) return;
+            if (m_pendingLevels.size() >= 64 && !m_pendingLevels.contains(level.levelId)) {
+                m_pendingLevels.erase(m_pendingLevels.begin());
+            }
+            m_pendingLevels[level.levelId] = level;
+        }
+
+        // queueScore, then onScoreEvent and submitScore as the submit worker runs them
+        void queueScore(const ScoreEvent& event, const AttemptTimeline* timeline, Clock::time_point now) {
+            CountAllocations count(m_stats.submitAllocs);
+            m_stats.scoresQueued++;
+            auto workerStart = Clock::now();
+
+            ScoreData score;
+            score.levelId = event.levelId;
+            score.levelName = m_strings.lookup(event.levelNameId);
+            score.levelCreator = m_strings.lookup(event.levelCreatorId);
+            score.percentage = event.percentage;
+            score.attempts = event.attempts;
+            score.passed = event.passed;
+            score.isPractice = event.isPractice;
+            score.coinsCollected.resize(event.coinCount);
+            for (uint8_t i = 0; i < event.coinCount; i++) {
+                score.coinsCollected[i] = (event.coinMask >> i) & 1;
+            }
+            if (timeline && !timeline->empty()) {
+                score.timeline = timeline->encode();
+            }
+            score.playedAt = unixMillis();
+
+            bool stored = m_outbox.append(score);
+            m_offThread += Clock::now() - workerStart;
+            if (!stored) {
+                m_stats.lastError = "outbox append failed";
+                return;
+            }
+            m_batchPolicy.onQueued(now, score.passed);
+            drainOutbox(now);
+        }
+
+        void setGameState(GameState state, Clock::time_point now) {
+            if (!m_flushScheduler.setState(state)) return;
+            if (queueDepth() > 0) {
+                m_stats.heldFlushes++;
+                drainOutbox(now);
+            }
+        }
+
+        void drainOutbox(Clock::time_point now) {
+            CountAllocations count(m_stats.submitAllocs);
+            m_submissions.setMaxInFlight(MAX_CONCURRENT_SUBMISSIONS);
+            if (m_flushScheduler.shouldHold(queueDepth(), now)) return;
+
+            while (m_submissions.canStart() && m_backoff.ready(now) &&
+                   m_batchPolicy.shouldFlush(queueDepth(), now)) {
+                auto batch = m_outbox.readBatch(m_batchPolicy.maxSize());
+                if (batch.empty()) return;
+
+                sendBatch(batch, now);
+                m_batchPolicy.onFlushed(queueDepth(), now);
+                m_flushScheduler.onFlushed();
+            }
+        }
+
+    private:
+        bool link(std::string& error) {
+            // Unique per run, so every replay starts as a new player
+            std::string discordId = "replay-" + std::to_string(unixMillis());
+            std::string body = "{\"discord_id\":\"" + discordId + "\",\"discord_username\":\"replay\"}";
+            auto res = m_http->post("/api/loadtest/link-code", "application/json", body.data(), body.size());
+            std::string code = jsonString(res.body, "code");
+            if (res.status != 200 || code.empty()) {
+                error = res.status == 404 ? "/api/loadtest/link-code missing, is the server running with LOADTEST=1?"
+                                          : "link code: " + std::to_string(res.status) + " " + res.error + res.body;
+                return false;
+            }
+
+            m_header.gdAccountId = 29000000 + static_cast<int>(unixMillis() % 1000000);
+            m_header.gdUsername = "Replay" + std::to_string(m_header.gdAccountId);
+            body = "{\"code\":\"" + code + "\",\"gd_account_id\":" + std::to_string(m_header.gdAccountId) +
+                   ",\"gd_username\":\"" + m_header.gdUsername + "\"}";
+            res = m_http->post("/api/link/verify", "application/json", body.data(), body.size());
+            m_header.authToken = jsonString(res.body, "auth_token");
+            if (res.status != 200 || m_header.authToken.empty()) {
+                error = "verify: " + std::to_string(res.status) + " " + res.error + res.body;
+                return false;
+            }
+            return true;
+        }
+
+        void sendBatch(const std::vector<OutboxEntry>& batch, Clock::time_point now) {
+            std::vector<ScoreData> scores;
+            std::vector<LevelMeta> levels;
+            std::vector<int> levelIds;
+            scores.reserve(batch.size());
+            for (const auto& entry : batch) {
+                scores.push_back(entry.score);
+
+                int levelId = entry.score.levelId;
+                auto it = m_pendingLevels.find(levelId);
+                if (it != m_pendingLevels.end() && std::find(levelIds.begin(), levelIds.end(), levelId) == levelIds.end()) {
+                    levels.push_back(it->second);
+                    levelIds.push_back(levelId);
+                }
+            }
+
+            auto body = ScoreCodec::encodeBatch(m_header, scores, levels);
+            uint64_t id = m_submissions.start(batch.back().seq, batch.size());
+            m_stats.batches++;
+            m_stats.scoresSent += batch.size();
+            m_stats.bytesSent += body.size();
+
+            if (m_options.dryRun) {
+                m_stats.scoresAccepted += batch.size();
+                onSubmitFinished(id, levelIds, true, false, now);
+                return;
+            }
+
+            auto sentAt = Clock::now();
+            auto res = m_http->post("/api/scores/batch", ScoreCodec::CONTENT_TYPE, body.data(), body.size());
+            auto latency = Clock::now() - sentAt;
+            m_offThread += latency;
+            m_stats.latencyUs.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+
+            if (res.status >= 200 && res.status < 300) {
+                m_stats.scoresAccepted += static_cast<uint64_t>(
+                    jsonNumber(res.body, "accepted", static_cast<long long>(batch.size())));
+                m_stats.scoresDuplicate += static_cast<uint64_t>(jsonNumber(res.body, "duplicates", 0));
+                onSubmitFinished(id, levelIds, true, false, now);
+                return;
+            }
+
+            m_stats.failedBatches++;
+            m_stats.lastError = res.status == 0 ? res.error : std::to_string(res.status) + " " + res.body;
+            // Client errors (bad token, malformed body) won't succeed on a retry
+            bool retryable = res.status == 0 || res.status < 400 || res.status >= 500 || res.status == 429;
+            onSubmitFinished(id, levelIds, false, retryable, now);
+        }
+
+        void onSubmitFinished(uint64_t id, const std::vector<int>& levelIds, bool delivered, bool retryable,
+                              Clock::time_point now) {
+            if (delivered) {
+                for (int levelId : levelIds) {
+                    m_pendingLevels.erase(levelId);
+                    m_reportedLevels.insert(levelId);
+                }
+            }
+
+            if (delivered || !retryable) {
+                if (uint64_t ackSeq = m_submissions.complete(id)) {
+                    m_outbox.ack(ackSeq);
+                }
+                m_backoff.onSuccess();
+            } else {
+                m_submissions.fail(id);
+                m_backoff.onFailure(now);
+            }
+
+            if (m_submissions.needsRewind()) {
+                m_outbox.rewind();
+                m_submissions.reset();
+            }
+        }
+
+        const Options& m_options;
+        StringTable m_strings;
+        ScoreOutbox m_outbox;
+        HttpClient* m_http;
+        Stats& m_stats;
+        ScoreCodec::SessionHeader m_header;
+
+        SubmissionTracker m_submissions{MAX_CONCURRENT_SUBMISSIONS};
+        RetryBackoff m_backoff{std::chrono::seconds(2), std::chrono::minutes(5)};
+        BatchPolicy m_batchPolicy{32, std::chrono::seconds(5)};
+        FlushScheduler m_flushScheduler{32, std::chrono::minutes(2)};
+        std::unordered_map<int, LevelMeta> m_pendingLevels;
+        LruSet<int> m_reportedLevels{256};
+        Clock::duration m_offThread{};
+    };
+
+    // Runs one frame's game thread work and records what it cost if the level is
+    // being played after it. A flush started mid-attempt lands in that frame, one
+    // started by pausing or leaving doesn't.
+    template <typename Work>
+    void timeFrame(Client& client, Stats& stats, Work&& work) {
+        auto offThread = client.offThreadTime();
+        auto start = Clock::now();
+        work();
+        if (client.gameState() != GameState::Playing) return;
+
+        auto spent = Clock::now() - start - (client.offThreadTime() - offThread);
+        stats.playingFrameNs.push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(spent).count()));
+    }
+
+    // Maps the traces' time onto the replay clock and paces to --speed. Policy
+    // decisions all see trace time, so a replay sends the same batches at any speed.
+    class Timeline {
+    public:
+        Timeline(Client& client, Stats& stats, double speed) : m_client(client), m_stats(stats), m_speed(speed) {}
+
+        Clock::time_point now() const { return m_now; }
+
+        // Runs the drain timer up to `at` and waits until it's due
+        void advanceTo(Clock::time_point at, bool pace = true) {
+            while (m_nextDrain <= at) {
+                if (pace) sleepUntil(m_nextDrain);
+                m_now = m_nextDrain;
+                timeFrame(m_client, m_stats, [&] { m_client.drainOutbox(m_now); });
+                m_nextDrain += DRAIN_INTERVAL;
+            }
+            if (pace) sleepUntil(at);
+            m_now = std::max(m_now, at);
+        }
+
+    private:
+        void sleepUntil(Clock::time_point at) {
+            if (m_speed <= 0) return;
+            auto real = m_realStart + std::chrono::duration_cast<Clock::duration>((at - m_start) / m_speed);
+            std::this_thread::sleep_until(real);
+        }
+
+        Client& m_client;
+        Stats& m_stats;
+        double m_speed;
+        Clock::time_point m_start = Clock::now();
+        Clock::time_point m_realStart = m_start;
+        Clock::time_point m_now = m_start;
+        Clock::time_point m_nextDrain = m_start + DRAIN_INTERVAL;
+    };
+
+    // Feeds one trace to a LevelSession the way the PlayLayer hooks do
+    void replayTrace(const HookTrace& trace, Client& client, Timeline& timeline, Stats& stats) {
+        auto start = timeline.now();
+        // The replayer's player is linked, whatever the recording one was
+        SubmitSettings settings = trace.settings;
+        settings.linked = true;
+
+        LevelSession session;
+        ScoreEvent score;
+        {
+            CountAllocations count(stats.hookAllocs);
+            LevelSession::LevelInfo info;
+            info.levelId = trace.level.levelId;
+            info.nameId = client.strings().intern(trace.level.name);
+            info.creatorId = client.strings().intern(trace.level.creator);
+            info.coinCount = trace.coinCount;
+            session.begin(info, unixMillis(), start);
+        }
+        if (trace.online) client.reportLevel(trace.level);
+        client.setGameState(GameState::Playing, start);
+
+        for (const auto& record : trace.records) {
+            auto now = start + std::chrono::microseconds(record.atUs);
+            timeline.advanceTo(now);
+            stats.records++;
+
+            // The hooks and whatever they flush, as one frame of the game
+            timeFrame(client, stats, [&] {
+                bool queued = false;
+                // Applied once the hook's own work is timed, the flush it may trigger is submit work
+                std::optional<GameState> state;
+                auto hookStart = Clock::now();
+                {
+                    CountAllocations count(stats.hookAllocs);
+                    switch (record.type) {
+                        case HookTraceType::Tick:
+                            if (client.gameState() == GameState::Playing) {
+                                session.onProgress(record.percent, record.seconds, record.x);
+                            }
+                            queued = session.hasPendingDeath() && session.flushPendingDeath(now, score);
+                            break;
+                        case HookTraceType::Sample:
+                            session.onProgress(record.percent, record.seconds, record.x);
+                            break;
+                        case HookTraceType::Coin:
+                            session.onCoin(record.arg);
+                            session.onProgress(record.percent, record.seconds, record.x);
+                            break;
+                        case HookTraceType::Death:
+                            session.onDeath(record.percent, record.seconds, record.x);
+                            break;
+                        case HookTraceType::Reset: {
+                            auto death = session.onDeath(record.percent, record.seconds, record.x);
+                            state = GameState::Playing;
+                            queued = session.onReset(death, record.arg, settings, now, score);
+                            break;
+                        }
+                        case HookTraceType::Complete:
+                            session.onProgress(record.percent, record.seconds, record.x);
+                            session.onComplete(record.arg);
+                            break;
+                        case HookTraceType::EndScreen:
+                            state = GameState::EndScreen;
+                            queued = session.onFinished(true, record.arg, settings, now, score);
+                            break;
+                        case HookTraceType::Pause:
+                            state = GameState::Paused;
+                            break;
+                        case HookTraceType::Resume:
+                            state = GameState::Playing;
+                            break;
+                        case HookTraceType::Quit:
+                            state = GameState::Menu;
+                            queued = session.takePendingDeath(score);
+                            break;
+                    }
+                }
+                stats.hookTime += Clock::now() - hookStart;
+                if (state) client.setGameState(*state, now);
+                if (queued) client.queueScore(score, session.eventTimeline(), now);
+            });
+        }
+
+        // A trace of a game that closed mid-level has no quit
+        if (client.gameState() != GameState::Menu) {
+            client.setGameState(GameState::Menu, timeline.now());
+            if (session.takePendingDeath(score)) client.queueScore(score, session.eventTimeline(), timeline.now());
+        }
+    }
+
+    uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t index = std::min(static_cast<size_t>(p * sorted.size()), sorted.size() - 1);
+        return sorted[index];
+    }
+
+    std::string formatUs(uint32_t us) {
+        char buffer[32];
+        if (us >= 1000000) std::snprintf(buffer, sizeof(buffer), "%.2fs", us / 1e6);
+        else if (us >= 1000) std::snprintf(buffer, sizeof(buffer), "%.1fms", us / 1e3);
+        else std::snprintf(buffer, sizeof(buffer), "%uus", us);
+        return buffer;
+    }
+
+    std::string formatNs(double ns) {
+        if (ns >= 1000) return formatUs(static_cast<uint32_t>(ns / 1000));
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.0fns", ns);
+        return buffer;
+    }
+
+    std::string formatDuration(Clock::duration duration) {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%lldh%02lldm%02llds", static_cast<long long>(seconds / 3600),
+                      static_cast<long long>(seconds / 60 % 60), static_cast<long long>(seconds % 60));
+        return buffer;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::vector<HookTrace> traces;
+    if (!loadTraces(options.traces, traces)) return 2;
+
+    std::string host;
+    uint16_t port;
+    if (!HttpClient::parseUrl(options.url, host, port)) {
+        std::fprintf(stderr, "Only plain http://host:port URLs are supported, got %s\n", options.url.c_str());
+        return 2;
+    }
+    HttpClient http(host, port);
+
+    std::filesystem::path outboxDir = options.outbox;
+    bool removeOutbox = outboxDir.empty();
+    if (removeOutbox) {
+        outboxDir = std::filesystem::temp_directory_path() / ("yuki-replay-" + std::to_string(unixMillis()));
+    }
+
+    Stats stats;
+    std::string error;
+    int status = 0;
+    {
+        Client client(options, outboxDir, &http, stats);
+        if (!client.open(error)) {
+            std::fprintf(stderr, "Setup failed: %s\n", error.c_str());
+            return 1;
+        }
+
+        size_t totalRecords = 0;
+        for (const auto& trace : traces) totalRecords += trace.records.size();
+        char speed[32] = "full speed";
+        if (options.speed > 0) std::snprintf(speed, sizeof(speed), "%gx speed", options.speed);
+        std::printf("Replaying %zu trace(s) %zu time(s), %zu records each time, at %s\n", traces.size(),
+                    options.loops, totalRecords, speed);
+
+        Timeline timeline(client, stats, options.speed);
+        auto virtualStart = timeline.now();
+        auto realStart = Clock::now();
+        for (size_t loop = 0; loop < options.loops; loop++) {
+            for (const auto& trace : traces) {
+                replayTrace(trace, client, timeline, stats);
+                timeline.advanceTo(timeline.now() + LEVEL_GAP);
+            }
+        }
+        auto played = timeline.now() - virtualStart;
+        double elapsed = std::chrono::duration<double>(Clock::now() - realStart).count();
+
+        // Whatever the batch policy still holds goes out on the drain timer, no need to wait for it
+        auto tailEnd = timeline.now() + MAX_TAIL;
+        while (client.pending() > 0 && timeline.now() < tailEnd) {
+            timeline.advanceTo(timeline.now() + DRAIN_INTERVAL, false);
+        }
+
+        std::printf("\nReplayed %s of play in %.2fs (%.0fx)\n", formatDuration(played).c_str(), elapsed,
+                    elapsed > 0 ? std::chrono::duration<double>(played).count() / elapsed : 0.0);
+        std::printf("  hooks     %llu records, %.0fns each, %llu allocations (%.3f per record)\n",
+                    static_cast<unsigned long long>(stats.records),
+                    stats.records ? std::chrono::duration<double, std::nano>(stats.hookTime).count() / stats.records : 0.0,
+                    static_cast<unsigned long long>(stats.hookAllocs.load()),
+                    stats.records ? static_cast<double>(stats.hookAllocs) / stats.records : 0.0);
+        std::printf("  scores    %llu queued, %llu sent in %llu batches (%.1f per batch), %llu accepted, "
+                    "%llu duplicates\n",
+                    static_cast<unsigned long long>(stats.scoresQueued), static_cast<unsigned long long>(stats.scoresSent),
+                    static_cast<unsigned long long>(stats.batches),
+                    stats.batches ? static_cast<double>(stats.scoresSent) / stats.batches : 0.0,
+                    static_cast<unsigned long long>(stats.scoresAccepted),
+                    static_cast<unsigned long long>(stats.scoresDuplicate));
+        std::printf("  submit    %llu allocations (%.1f per score), %.1f KB sent, %llu flushes on pause or exit\n",
+                    static_cast<unsigned long long>(stats.submitAllocs.load()),
+                    stats.scoresQueued ? static_cast<double>(stats.submitAllocs) / stats.scoresQueued : 0.0,
+                    stats.bytesSent / 1024.0, static_cast<unsigned long long>(stats.heldFlushes));
+        std::printf("  errors    %llu failed batches, %zu scores left in the outbox\n",
+                    static_cast<unsigned long long>(stats.failedBatches), client.pending());
+        if (!stats.lastError.empty()) {
+            std::printf("  last error: %.200s\n", stats.lastError.c_str());
+        }
+        if (!stats.latencyUs.empty()) {
+            auto& samples = stats.latencyUs;
+            std::sort(samples.begin(), samples.end());
+            std::printf("Latency\n  service   p50 %-9s p90 %-9s p99 %-9s max %s\n",
+                        formatUs(percentile(samples, 0.50)).c_str(), formatUs(percentile(samples, 0.90)).c_str(),
+                        formatUs(percentile(samples, 0.99)).c_str(), formatUs(samples.back()).c_str());
+        }
+        if (!stats.playingFrameNs.empty()) {
+            auto& frames = stats.playingFrameNs;
+            double mean = 0;
+            for (uint32_t ns : frames) mean += ns;
+            mean /= static_cast<double>(frames.size());
+            double variance = 0;
+            for (uint32_t ns : frames) variance += (ns - mean) * (ns - mean);
+            variance /= static_cast<double>(frames.size());
+            auto overMs = std::count_if(frames.begin(), frames.end(), [](uint32_t ns) { return ns >= 1000000; });
+
+            std::sort(frames.begin(), frames.end());
+            std::printf("Frame work while playing, %s\n",
+                        options.hold ? "holding uploads" : "not holding uploads (--no-hold)");
+            std::printf("  %zu frames  mean %-9s stddev %-9s p50 %-9s p99 %-9s max %-9s %lld over 1ms\n",
+                        frames.size(), formatNs(mean).c_str(), formatNs(std::sqrt(variance)).c_str(),
+                        formatNs(percentile(frames, 0.50)).c_str(), formatNs(percentile(frames, 0.99)).c_str(),
+                        formatNs(frames.back()).c_str(), static_cast<long long>(overMs));
+        }
+        status = stats.failedBatches == 0 && client.pending() == 0 ? 0 : 1;
+    }
+
+    if (removeOutbox) {
+        std::error_code ec;
+        std::filesystem::remove_all(outboxDir, ec);
+    }
+    return status;
+}
@@ -0,0 +1,65 @@
+// Stand-in for the GD servers' downloadGJLevel22.php during load tests.
+// Answers every level ID with a made-up level in the same format the real
+// endpoint uses, after STUB_DELAY_MS to keep cache misses realistically slow.
+// With STUB_MISSING_EVERY=n, every level ID divisible by n answers "-1" like a
+// deleted level. GET /stats returns how many level requests arrived, to compare
+// against what the server's health check says it sent.
+import { createServer } from "node:http";
+
+const port = parseInt(process.env.PORT || "8080");
+const delayMs = parseInt(process.env.STUB_DELAY_MS || "150");
+const missingEvery = parseInt(process.env.STUB_MISSING_EVERY || "0");
+
+let requests = 0;
+
+function levelResponse(levelId) {
+  const stars = (levelId % 10) + 1;
+  const fields = {
+    1: levelId,
+    2: `Stub Level ${levelId}`,
+    3: Buffer.from(`Generated for load testing (${levelId})`).toString("base64"),
+    5: 1,
+    6: 1000 + (levelId % 5000),
+    9: [10, 20, 30, 40, 50][levelId % 5],
+    10: levelId * 37 % 1000000,
+    12: levelId % 20,
+    14: levelId * 7 % 100000,
+    15: levelId % 5,
+    17: stars === 10 ? 1 : "",
+    18: stars,
+    35: 0,
+    43: 3,
+  };
+  const level = Object.entries(fields).map(([key, value]) => `${key}:${value}`).join(":");
+  const creatorId = 1000 + (levelId % 5000);
+  return `${level}#${creatorId}:StubCreator${creatorId}:${creatorId}#`;
+}
+
+function exists(levelId) {
+  return levelId > 0 && !(missingEvery > 0 && levelId % missingEvery === 0);
+}
+
+createServer((req, res) => {
+  if (req.method === "GET" && req.url === "/stats") {
+    res.writeHead(200, { "Content-Type": "application/json" });
+    res.end(JSON.stringify({ requests }));
+    return;
+  }
+
+  let body = "";
+  req.on("data", (chunk) => (body += chunk));
+  req.on("end", () => {
+    requests++;
+    const levelId = parseInt(new URLSearchParams(body).get("levelID") || "0");
+    setTimeout(() => {
+      res.writeHead(200, { "Content-Type": "text/plain" });
+      res.end(req.url?.endsWith("/downloadGJLevel22.php") && exists(levelId) ? levelResponse(levelId) : "-1");
+    }, delayMs);
+  });
+}).listen(port, () => {
+  console.log(`GD stub listening on ${port} (${delayMs}ms delay)`);
+});
+
+setInterval(() => {
+  if (requests > 0) console.log(`GD stub: ${requests} level requests so far`);
+}, 30_000).unref();
@@ -0,0 +1,74 @@
+import {
+  SlashCommandBuilder,
+  ChatInputCommandInteraction,
+  EmbedBuilder,
+} from "discord.js";
+import { db } from "../../db/index.js";
+import { users, deathHeatmaps } from "../../db/schema.js";
+import { and, eq } from "drizzle-orm";
+import { getDefaultLevelName, getLevelInfo } from "../../lib/gdApi.js";
+import { summarizeHeatmap, peakDeathPercent } from "../../lib/heatmap.js";
+
+const ROWS = 20;
+const BAR_WIDTH = 20;
+
+export const data = new SlashCommandBuilder()
+  .setName("heatmap")
+  .setDescription("Show where you die the most on a level")
+  .addIntegerOption((option) =>
+    option.setName("level").setDescription("Level ID").setRequired(true)
+  );
+
+export async function execute(interaction: ChatInputCommandInteraction) {
+  const discordId = interaction.user.id;
+  const levelId = interaction.options.getInteger("level", true);
+
+  const user = await db.query.users.findFirst({
+    where: eq(users.discordId, discordId),
+  });
+
+  if (!user) {
+    await interaction.reply({
+      content: "❌ Your account is not linked! Use `/link` to connect your GD account.",
+      ephemeral: true,
+    });
+    return;
+  }
+
+  const heatmap = await db.query.deathHeatmaps.findFirst({
+    where: and(eq(deathHeatmaps.userId, user.id), eq(deathHeatmaps.levelId, levelId)),
+  });
+
+  if (!heatmap || heatmap.totalDeaths === 0) {
+    await interaction.reply({
+      content: "📭 No deaths recorded on this level yet.",
+      ephemeral: true,
+    });
+    return;
+  }
+
+  await interaction.deferReply();
+
+  const rows = summarizeHeatmap(heatmap.counts, ROWS);
+  const maxDeaths = Math.max(...rows.map((row) => row.deaths));
+  const lines = rows.map((row) => {
+    const width = maxDeaths > 0 ? Math.round((row.deaths / maxDeaths) * BAR_WIDTH) : 0;
+    const label = `${row.from.toString().padStart(2)}-${row.to}%`.padEnd(8);
+    return `${label}${"█".repeat(width)}${" ".repeat(BAR_WIDTH - width)} ${row.deaths}`;
+  });
+
+  const defaultLevel = getDefaultLevelName(levelId);
+  const levelInfo = defaultLevel ? null : await getLevelInfo(levelId);
+  const levelName = defaultLevel?.name ?? levelInfo?.name ?? `Level #${levelId}`;
+  const peak = peakDeathPercent(heatmap.counts);
+
+  const embed = new EmbedBuilder()
+    .setColor(0xdb2323)
+    .setTitle(`Deaths on ${levelName}`)
+    .setDescription("```\n" + lines.join("\n") + "\n```")
+    .setFooter({
+      text: `${heatmap.totalDeaths} deaths${peak !== null ? ` • Most deaths at ${peak.toFixed(1)}%` : ""}`,
+    });
+
+  await interaction.editReply({ embeds: [embed] });
+}
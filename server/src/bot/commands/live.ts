@@ -0,0 +1,117 @@
+import {
+  SlashCommandBuilder,
+  ChatInputCommandInteraction,
+  EmbedBuilder,
+} from "discord.js";
+import { db } from "../../db/index.js";
+import { users } from "../../db/schema.js";
+import { eq } from "drizzle-orm";
+import { getDefaultLevelName, getLevelInfo } from "../../lib/gdApi.js";
+import { getLiveStatus, liveEvents, type LiveStatus } from "../../lib/liveStatus.js";
+
+// How long the reply keeps following the player, and how often it's edited
+const FOLLOW_MS = 5 * 60_000;
+const EDIT_INTERVAL_MS = 5_000;
+
+export const data = new SlashCommandBuilder()
+  .setName("live")
+  .setDescription("Show what a linked player is playing right now")
+  .addUserOption((option) =>
+    option.setName("user").setDescription("Player to show (defaults to you)")
+  );
+
+async function levelName(levelId: number): Promise<string> {
+  const defaultLevel = getDefaultLevelName(levelId);
+  if (defaultLevel) return defaultLevel.name;
+  const levelInfo = await getLevelInfo(levelId);
+  return levelInfo?.name ?? `Level #${levelId}`;
+}
+
+function progressBar(percentage: number): string {
+  const width = 20;
+  const filled = Math.round((percentage / 100) * width);
+  return "█".repeat(filled) + "░".repeat(width - filled);
+}
+
+async function buildEmbed(username: string, status: LiveStatus | null): Promise<EmbedBuilder> {
+  if (!status) {
+    return new EmbedBuilder()
+      .setColor(0x808080)
+      .setTitle(`${username} isn't playing right now`);
+  }
+
+  return new EmbedBuilder()
+    .setColor(status.practice ? 0x3b82f6 : 0x22c55e)
+    .setTitle(`${username} is playing ${await levelName(status.levelId)}${status.practice ? " (practice)" : ""}`)
+    .setDescription(`\`${progressBar(status.percentage)}\` **${status.percentage}%**`)
+    .addFields(
+      { name: "Best", value: `${status.bestPercentage}%`, inline: true },
+      { name: "Attempt", value: `${status.attempts}`, inline: true },
+    )
+    .setFooter({ text: `Level ID: ${status.levelId}` })
+    .setTimestamp(new Date(status.updatedAt));
+}
+
+export async function execute(interaction: ChatInputCommandInteraction) {
+  const target = interaction.options.getUser("user") ?? interaction.user;
+
+  const user = await db.query.users.findFirst({
+    where: eq(users.discordId, target.id),
+  });
+
+  if (!user) {
+    await interaction.reply({
+      content: target.id === interaction.user.id
+        ? "❌ Your account is not linked! Use `/link` to connect your GD account."
+        : "❌ That user hasn't linked their GD account.",
+      ephemeral: true,
+    });
+    return;
+  }
+
+  const username = user.gdUsername ?? target.username;
+  const status = getLiveStatus(target.id);
+  await interaction.reply({ embeds: [await buildEmbed(username, status)] });
+  if (!status) return;
+
+  // Follow the player by listening to the updates the mod pushes, no polling
+  let latest: LiveStatus | null = status;
+  let lastEdit = Date.now();
+  let pending: NodeJS.Timeout | null = null;
+
+  const flush = async () => {
+    pending = null;
+    lastEdit = Date.now();
+    try {
+      await interaction.editReply({ embeds: [await buildEmbed(username, latest)] });
+    } catch (error) {
+      console.error("Failed to update /live reply:", error);
+      stop();
+    }
+  };
+
+  const onUpdate = (update: LiveStatus) => {
+    if (update.discordId !== target.id) return;
+    latest = update.levelId === 0 ? null : update;
+
+    if (!latest) {
+      stop();
+      void flush();
+      return;
+    }
+    // Only the newest state matters, so edits are throttled rather than queued
+    if (!pending) {
+      pending = setTimeout(flush, Math.max(EDIT_INTERVAL_MS - (Date.now() - lastEdit), 0));
+    }
+  };
+
+  const stop = () => {
+    liveEvents.off("update", onUpdate);
+    clearTimeout(timeout);
+    if (pending) clearTimeout(pending);
+    pending = null;
+  };
+
+  const timeout = setTimeout(stop, FOLLOW_MS);
+  liveEvents.on("update", onUpdate);
+}
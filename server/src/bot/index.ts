@@ -11,13 +11,15 @@ import {
 import * as recentCommand from "./commands/recent.js";
 import * as rsCommand from "./commands/rs.js";
 import * as linkCommand from "./commands/link.js";
+import * as heatmapCommand from "./commands/heatmap.js";
+import * as liveCommand from "./commands/live.js";
 
 interface Command {
-  data: SlashCommandBuilder;
+  data: Pick<SlashCommandBuilder, "name" | "toJSON">;
   execute: (interaction: ChatInputCommandInteraction) => Promise<void>;
 }
 
-const commands: Command[] = [recentCommand, rsCommand, linkCommand];
+const commands: Command[] = [recentCommand, rsCommand, linkCommand, heatmapCommand, liveCommand];
 
 export async function startBot() {
   const client = new Client({
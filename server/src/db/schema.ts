@@ -1,4 +1,10 @@
-import { pgTable, serial, text, integer, boolean, timestamp, jsonb } from "drizzle-orm/pg-core";
+import { pgTable, serial, text, integer, bigint, boolean, timestamp, jsonb, primaryKey, index, uniqueIndex, customType } from "drizzle-orm/pg-core";
+
+const bytea = customType<{ data: Buffer; driverData: Buffer }>({
+  dataType() {
+    return "bytea";
+  },
+});
 
 export const users = pgTable("users", {
   id: serial("id").primaryKey(),
@@ -19,8 +25,21 @@ export const scores = pgTable("scores", {
   passed: boolean("passed").notNull(),
   isPractice: boolean("is_practice").default(false),
   coins: jsonb("coins").$type<boolean[]>(),
+  // (install ID, outbox sequence number) from the mod, null for scores sent
+  // without one. Resending a score hits the unique index and is skipped.
+  clientInstallId: text("client_install_id"),
+  clientSeq: bigint("client_seq", { mode: "number" }),
+  // Unix ms on the player's clock and the hash history sync compares
+  // (lib/rangeSync.ts), only for scores from mods that send the time
+  playedAt: bigint("played_at", { mode: "number" }),
+  syncHash: bigint("sync_hash", { mode: "bigint" }),
   createdAt: timestamp("created_at").defaultNow(),
-});
+}, (table) => ({
+  clientKeyIdx: uniqueIndex("scores_client_key_idx").on(table.clientInstallId, table.clientSeq),
+  syncIdx: index("scores_sync_idx").on(table.userId, table.levelId, table.playedAt),
+  // A player's newest score, for /recent when it isn't cached
+  userRecentIdx: index("scores_user_recent_idx").on(table.userId, table.createdAt.desc()),
+}));
 
 export const levelCache = pgTable("level_cache", {
   levelId: integer("level_id").primaryKey(),
@@ -39,9 +58,89 @@ export const levelCache = pgTable("level_cache", {
   cachedAt: timestamp("cached_at").defaultNow(),
 });
 
+// Per-user, per-level death histogram in fixed 0.1% buckets, merged on upload
+export const deathHeatmaps = pgTable("death_heatmaps", {
+  userId: integer("user_id").references(() => users.id).notNull(),
+  levelId: integer("level_id").notNull(),
+  counts: integer("counts").array().notNull(),
+  totalDeaths: integer("total_deaths").notNull().default(0),
+  updatedAt: timestamp("updated_at").defaultNow(),
+}, (table) => ({
+  pk: primaryKey({ columns: [table.userId, table.levelId] }),
+}));
+
+// Heatmap uploads already merged, by (install ID, upload seq) from the mod. An
+// upload resent after its response got lost hits the key and is skipped.
+export const heatmapUploads = pgTable("heatmap_uploads", {
+  clientInstallId: text("client_install_id").notNull(),
+  uploadSeq: bigint("upload_seq", { mode: "number" }).notNull(),
+  userId: integer("user_id").references(() => users.id).notNull(),
+  levelId: integer("level_id").notNull(),
+  createdAt: timestamp("created_at").defaultNow(),
+}, (table) => ({
+  pk: primaryKey({ columns: [table.clientInstallId, table.uploadSeq] }),
+}));
+
+// Downsampled (time, x) shape of a pass or new best attempt, as encoded by the mod
+export const attemptTimelines = pgTable("attempt_timelines", {
+  scoreId: integer("score_id").references(() => scores.id).primaryKey(),
+  data: bytea("data").notNull(),
+  pointCount: integer("point_count").notNull(),
+  durationMs: integer("duration_ms").notNull(),
+});
+
+// One row per stretch of play on a level, sent by the mod on completion or quit.
+// Rows add up, so per-level stats don't need the individual death scores.
+export const sessionSummaries = pgTable("session_summaries", {
+  id: serial("id").primaryKey(),
+  userId: integer("user_id").references(() => users.id).notNull(),
+  levelId: integer("level_id").notNull(),
+  attempts: integer("attempts").notNull(),
+  bestPercentage: integer("best_percentage").notNull(),
+  timeAliveMs: bigint("time_alive_ms", { mode: "number" }).notNull(),
+  completed: boolean("completed").notNull().default(false),
+  usedPractice: boolean("used_practice").notNull().default(false),
+  // Sparse [bucket, count] pairs in 0.1% buckets, like death_heatmaps
+  deaths: jsonb("deaths").$type<[number, number][]>(),
+  startedAt: timestamp("started_at"),
+  endedAt: timestamp("ended_at"),
+  createdAt: timestamp("created_at").defaultNow(),
+}, (table) => ({
+  userLevelIdx: index("session_summaries_user_level_idx").on(table.userId, table.levelId),
+}));
+
+// Each user's best non-practice percentage per level, raised as scores come in.
+// The rank index serves a level's top N without touching the scores table.
+export const levelBests = pgTable("level_bests", {
+  userId: integer("user_id").references(() => users.id).notNull(),
+  levelId: integer("level_id").notNull(),
+  bestPercentage: integer("best_percentage").notNull(),
+  attempts: integer("attempts"),
+  // When the best was first reached, earlier wins a tie
+  achievedAt: timestamp("achieved_at").defaultNow().notNull(),
+}, (table) => ({
+  pk: primaryKey({ columns: [table.userId, table.levelId] }),
+  rankIdx: index("level_bests_rank_idx").on(table.levelId, table.bestPercentage.desc(), table.achievedAt),
+}));
+
+// How many players have each best percentage on a level, kept in step with
+// level_bests. A rank is one plus the players above it, at most 100 rows to add.
+export const levelBestCounts = pgTable("level_best_counts", {
+  levelId: integer("level_id").notNull(),
+  percentage: integer("percentage").notNull(),
+  players: integer("players").notNull().default(0),
+}, (table) => ({
+  pk: primaryKey({ columns: [table.levelId, table.percentage] }),
+}));
+
 export type User = typeof users.$inferSelect;
 export type NewUser = typeof users.$inferInsert;
 export type Score = typeof scores.$inferSelect;
 export type NewScore = typeof scores.$inferInsert;
 export type LevelCache = typeof levelCache.$inferSelect;
 export type NewLevelCache = typeof levelCache.$inferInsert;
+export type DeathHeatmap = typeof deathHeatmaps.$inferSelect;
+export type AttemptTimeline = typeof attemptTimelines.$inferSelect;
+export type SessionSummary = typeof sessionSummaries.$inferSelect;
+export type NewSessionSummary = typeof sessionSummaries.$inferInsert;
+export type LevelBest = typeof levelBests.$inferSelect;
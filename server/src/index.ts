@@ -6,7 +6,16 @@ import { logger } from "hono/logger";
 
 import linkRoutes from "./routes/link.js";
 import scoresRoutes from "./routes/scores.js";
+import heatmapsRoutes from "./routes/heatmaps.js";
+import sessionsRoutes from "./routes/sessions.js";
+import liveRoutes from "./routes/live.js";
+import leaderboardsRoutes from "./routes/leaderboards.js";
+import syncRoutes from "./routes/sync.js";
 import { startBot } from "./bot/index.js";
+import { levelFetchStats, levelInfoStats } from "./lib/gdApi.js";
+import { liveStats } from "./lib/liveStatus.js";
+import { recentStats } from "./lib/recentScores.js";
+import { backfillLevelBests } from "./lib/leaderboard.js";
 
 const app = new Hono();
 
@@ -20,12 +29,23 @@ app.get("/", (c) => {
     name: "Yuki",
     version: "1.0.0",
     status: "ok",
+    levelInfo: { ...levelInfoStats, ...levelFetchStats },
+    live: liveStats,
+    recent: recentStats,
   });
 });
 
+// Keep-alive ping from the mod, as cheap as a response gets
+app.get("/api/ping", (c) => c.body(null, 204));
+
 // Routes
 app.route("/", linkRoutes);
 app.route("/", scoresRoutes);
+app.route("/", heatmapsRoutes);
+app.route("/", sessionsRoutes);
+app.route("/", liveRoutes);
+app.route("/", leaderboardsRoutes);
+app.route("/", syncRoutes);
 
 // Start server
 const port = parseInt(process.env.PORT || "3000");
@@ -39,5 +59,13 @@ serve({
 
 console.log(`✅ Server running at http://localhost:${port}`);
 
-// Start Discord bot
-startBot().catch(console.error);
+// Level bests are kept up as scores arrive, this only catches up on older scores.
+// In the background, a large backfill shouldn't hold up serving.
+backfillLevelBests().catch((error) => console.error("Failed to backfill level bests:", error));
+
+// Start Discord bot, load tests run without one
+if (process.env.LOADTEST === "1") {
+  console.log("⚠️ LOADTEST=1: Discord bot disabled, /api/loadtest routes enabled");
+} else {
+  startBot().catch(console.error);
+}
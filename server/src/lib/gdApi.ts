@@ -1,10 +1,20 @@
 import { db } from "../db/index.js";
 import { levelCache, type NewLevelCache } from "../db/schema.js";
-import { eq } from "drizzle-orm";
+import { eq, isNull, lt, or, sql } from "drizzle-orm";
+import type { DecodedLevel } from "./scoreCodec.js";
+import { LevelFetcher, type StoredLevel, type UpstreamResult } from "./levelFetcher.js";
 
-const GD_API_URL = "http://www.boomlings.com/database";
+// Overridable so load tests can point at a local stub instead of the real GD servers
+const GD_API_URL = process.env.GD_API_URL || "http://www.boomlings.com/database";
 const CACHE_DURATION_MS = 24 * 60 * 60 * 1000; // 24 hours
 const GD_REQUEST_SECRET = "Wmfd2893gb7";
+// Levels played this often within a day are refreshed an hour before they expire
+const REFRESH_AHEAD_MS = 60 * 60 * 1000;
+const POPULAR_HITS = 50;
+// Unlisted or deleted levels stay that way for a while, failures may be gone soon
+const MISSING_TTL_MS = 10 * 60 * 1000;
+const ERROR_TTL_MS = 60 * 1000;
+const GD_API_CONCURRENCY = parseInt(process.env.GD_API_CONCURRENCY || "4");
 
 const DIFFICULTY_MAP: Record<number, string> = {
   0: "N/A",
@@ -215,11 +225,28 @@ const DEFAULT_LEVELS: Record<number, DefaultLevelInfo> = {
   },
 };
 
+// Cache rows written from level info the mod supplied, exposed on the health check
+// next to levelFetchStats
+export const levelInfoStats = {
+  clientSupplied: 0,
+};
+
+function resolveDifficulty(
+  numerator: number,
+  isDemon: boolean,
+  demonDiff: number
+): { difficulty: string; demonDifficulty: string | null } {
+  if (isDemon) {
+    return { difficulty: "Demon", demonDifficulty: DEMON_DIFFICULTY_MAP[demonDiff] || "Hard Demon" };
+  }
+  return { difficulty: DIFFICULTY_MAP[numerator] || "N/A", demonDifficulty: null };
+}
+
 export function getDefaultLevelName(levelId: number): DefaultLevelInfo | null {
   return DEFAULT_LEVELS[levelId] || null;
 }
 
-interface GDLevelInfo {
+export interface GDLevelInfo {
   levelId: number;
   name: string;
   creator: string;
@@ -252,7 +279,7 @@ function decodeBase64(str: string): string {
   }
 }
 
-async function fetchLevelFromGD(levelId: number): Promise<GDLevelInfo | null> {
+async function fetchLevelFromGD(levelId: number): Promise<UpstreamResult<GDLevelInfo>> {
   try {
     const response = await fetch(`${GD_API_URL}/downloadGJLevel22.php`, {
       method: "POST",
@@ -267,8 +294,13 @@ async function fetchLevelFromGD(levelId: number): Promise<GDLevelInfo | null> {
     });
 
     const text = await response.text();
-    if (text === "-1" || !text) {
-      return null;
+    if (text === "-1") {
+      return { status: "missing" };
+    }
+    // Rate limits and outages come back as errors or empty bodies
+    if (!response.ok || !text) {
+      console.error(`GD servers answered level ${levelId} with ${response.status}`);
+      return { status: "error" };
     }
 
     const parts = text.split("#");
@@ -302,18 +334,12 @@ async function fetchLevelFromGD(levelId: number): Promise<GDLevelInfo | null> {
     const isDemon = levelData["17"] === "1";
     const demonDiff = parseInt(levelData["43"] || "0");
 
-    let difficulty = DIFFICULTY_MAP[difficultyNumerator] || "N/A";
-    let demonDifficulty: string | null = null;
-
-    if (isDemon) {
-      difficulty = "Demon";
-      demonDifficulty = DEMON_DIFFICULTY_MAP[demonDiff] || "Hard Demon";
-    }
+    const { difficulty, demonDifficulty } = resolveDifficulty(difficultyNumerator, isDemon, demonDiff);
 
     // Duration in seconds (key 15 is song offset, we'll estimate based on objects)
     const duration = parseInt(levelData["15"] || "0");
 
-    return {
+    const level: GDLevelInfo = {
       levelId,
       name: levelData["2"] || "Unknown",
       creator,
@@ -328,50 +354,42 @@ async function fetchLevelFromGD(levelId: number): Promise<GDLevelInfo | null> {
       downloads: parseInt(levelData["10"] || "0"),
       likes: parseInt(levelData["14"] || "0"),
     };
+    return { status: "found", value: level };
   } catch (error) {
     console.error("Error fetching level from GD:", error);
-    return null;
+    return { status: "error" };
   }
 }
 
-export async function getLevelInfo(
-  levelId: number
-): Promise<GDLevelInfo | null> {
-  // Check cache first
+async function loadCachedLevel(levelId: number): Promise<StoredLevel<GDLevelInfo> | null> {
   const cached = await db.query.levelCache.findFirst({
     where: eq(levelCache.levelId, levelId),
   });
+  if (!cached || !cached.cachedAt) return null;
 
-  if (cached && cached.cachedAt) {
-    const cacheAge = Date.now() - cached.cachedAt.getTime();
-    if (cacheAge < CACHE_DURATION_MS) {
-      return {
-        levelId: cached.levelId,
-        name: cached.name,
-        creator: cached.creator || "Unknown",
-        description: cached.description || "",
-        difficulty: cached.difficulty || "N/A",
-        stars: cached.stars || 0,
-        isDemon: cached.isDemon || false,
-        demonDifficulty: cached.demonDifficulty,
-        songName: cached.songName || "Unknown",
-        songAuthor: cached.songAuthor || "Unknown",
-        duration: cached.duration || 0,
-        downloads: cached.downloads || 0,
-        likes: cached.likes || 0,
-      };
-    }
-  }
-
-  // Fetch from GD servers
-  const levelInfo = await fetchLevelFromGD(levelId);
-  if (!levelInfo) {
-    return null;
-  }
+  return {
+    storedAt: cached.cachedAt.getTime(),
+    value: {
+      levelId: cached.levelId,
+      name: cached.name,
+      creator: cached.creator || "Unknown",
+      description: cached.description || "",
+      difficulty: cached.difficulty || "N/A",
+      stars: cached.stars || 0,
+      isDemon: cached.isDemon || false,
+      demonDifficulty: cached.demonDifficulty,
+      songName: cached.songName || "Unknown",
+      songAuthor: cached.songAuthor || "Unknown",
+      duration: cached.duration || 0,
+      downloads: cached.downloads || 0,
+      likes: cached.likes || 0,
+    },
+  };
+}
 
-  // Update cache
+async function storeCachedLevel(levelId: number, levelInfo: GDLevelInfo): Promise<void> {
   const cacheData: NewLevelCache = {
-    levelId: levelInfo.levelId,
+    levelId,
     name: levelInfo.name,
     creator: levelInfo.creator,
     description: levelInfo.description,
@@ -391,6 +409,104 @@ export async function getLevelInfo(
     target: levelCache.levelId,
     set: cacheData,
   });
+}
+
+const levelFetcher = new LevelFetcher<GDLevelInfo>(
+  { load: loadCachedLevel, fetch: fetchLevelFromGD, store: storeCachedLevel },
+  {
+    maxAgeMs: CACHE_DURATION_MS,
+    refreshAheadMs: REFRESH_AHEAD_MS,
+    popularHits: POPULAR_HITS,
+    missingTtlMs: MISSING_TTL_MS,
+    errorTtlMs: ERROR_TTL_MS,
+    concurrency: GD_API_CONCURRENCY,
+    maxTracked: 100_000,
+  }
+);
+
+// How getLevelInfo lookups were served, exposed on the health check
+export const levelFetchStats = levelFetcher.stats;
+
+// From level_cache while it's fresh, otherwise from the GD servers. Null for
+// levels they don't have and, with nothing cached, while they can't be reached.
+export function getLevelInfo(levelId: number): Promise<GDLevelInfo | null> {
+  return levelFetcher.get(levelId);
+}
+
+// Writes level info the mod sent along with its scores into the cache, so
+// getLevelInfo doesn't have to ask the GD servers. One insert for the whole batch,
+// which leaves rows that are still fresh alone: most batches describe levels
+// someone already cached today. Returns the level IDs now cached.
+export async function cacheClientLevels(levels: DecodedLevel[]): Promise<Set<number>> {
+  // By level, a batch can describe the same level twice and one statement can't
+  // write a row twice
+  const rows = new Map<number, NewLevelCache>();
+
+  for (const level of levels) {
+    if (!level || !level.level_id || !level.name) continue;
+
+    const { difficulty, demonDifficulty } = resolveDifficulty(
+      level.difficulty,
+      !!level.is_demon,
+      level.demon_difficulty
+    );
+
+    let songName = level.song_name || "Unknown";
+    let songAuthor = level.song_author || "Unknown";
+    if (!(level.song_id > 0)) {
+      const officialSong = OFFICIAL_SONGS[level.audio_track];
+      if (officialSong) {
+        songName = officialSong.name;
+        songAuthor = officialSong.author;
+      }
+    }
+
+    const cacheData: NewLevelCache = {
+      levelId: level.level_id,
+      name: level.name,
+      creator: level.creator || "Unknown",
+      description: decodeBase64(level.description || ""),
+      difficulty,
+      stars: level.stars || 0,
+      isDemon: !!level.is_demon,
+      demonDifficulty,
+      songName,
+      songAuthor,
+      duration: level.length || 0,
+      downloads: level.downloads || 0,
+      likes: level.likes || 0,
+      cachedAt: new Date(),
+    };
+    rows.set(level.level_id, cacheData);
+  }
+
+  if (rows.size === 0) return new Set();
+
+  const expired = new Date(Date.now() - CACHE_DURATION_MS);
+  const written = await db
+    .insert(levelCache)
+    .values([...rows.values()])
+    .onConflictDoUpdate({
+      target: levelCache.levelId,
+      set: {
+        name: sql`excluded.name`,
+        creator: sql`excluded.creator`,
+        description: sql`excluded.description`,
+        difficulty: sql`excluded.difficulty`,
+        stars: sql`excluded.stars`,
+        isDemon: sql`excluded.is_demon`,
+        demonDifficulty: sql`excluded.demon_difficulty`,
+        songName: sql`excluded.song_name`,
+        songAuthor: sql`excluded.song_author`,
+        duration: sql`excluded.duration`,
+        downloads: sql`excluded.downloads`,
+        likes: sql`excluded.likes`,
+        cachedAt: sql`excluded.cached_at`,
+      },
+      setWhere: or(isNull(levelCache.cachedAt), lt(levelCache.cachedAt, expired)),
+    })
+    .returning({ levelId: levelCache.levelId });
 
-  return levelInfo;
+  levelInfoStats.clientSupplied += written.length;
+  return new Set(rows.keys());
 }
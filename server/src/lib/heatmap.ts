@@ -0,0 +1,37 @@
+// Death heatmaps are fixed 0.1% buckets (mod/src/core/DeathHistogram.hpp)
+export const HEATMAP_BUCKETS = 1000;
+
+export interface HeatmapRow {
+  from: number;
+  to: number;
+  deaths: number;
+}
+
+// Collapses the buckets into `rows` equal percentage ranges, O(buckets)
+export function summarizeHeatmap(counts: number[], rows: number): HeatmapRow[] {
+  const perRow = HEATMAP_BUCKETS / rows;
+  const result: HeatmapRow[] = [];
+
+  for (let row = 0; row < rows; row++) {
+    let deaths = 0;
+    for (let i = row * perRow; i < (row + 1) * perRow; i++) {
+      deaths += counts[i] || 0;
+    }
+    result.push({ from: (row * 100) / rows, to: ((row + 1) * 100) / rows, deaths });
+  }
+
+  return result;
+}
+
+// Percentage of the single most lethal bucket
+export function peakDeathPercent(counts: number[]): number | null {
+  let peak = -1;
+  let peakCount = 0;
+  counts.forEach((count, i) => {
+    if (count > peakCount) {
+      peak = i;
+      peakCount = count;
+    }
+  });
+  return peak < 0 ? null : (peak * 100) / HEATMAP_BUCKETS;
+}
@@ -0,0 +1,171 @@
+import { db } from "../db/index.js";
+import { users, scores, levelBests, levelBestCounts } from "../db/schema.js";
+import { and, asc, desc, eq, inArray, sql } from "drizzle-orm";
+
+export const LEADERBOARD_SIZE = 5;
+export const MAX_LEADERBOARD_SIZE = 50;
+
+export interface LeaderboardEntry {
+  rank: number;
+  name: string;
+  percentage: number;
+  self: boolean;
+}
+
+export interface Leaderboard {
+  level_id: number;
+  players: number;
+  // The requesting user's rank and best, 0 if they aren't on the board
+  rank: number;
+  best: number;
+  top: LeaderboardEntry[];
+}
+
+export interface StoredScore {
+  levelId: number;
+  percentage: number;
+  attempts?: number | null;
+  isPractice?: boolean | null;
+}
+
+// A percentage that can go on a board. Ranks are counted over level_best_counts
+// buckets, so anything else there would skew every rank on the level.
+function isRankable(score: StoredScore): boolean {
+  return Number.isInteger(score.levelId) && Number.isInteger(score.percentage) &&
+    score.percentage >= 0 && score.percentage <= 100;
+}
+
+// Raises the user's level bests with scores that were just stored, moving them
+// between level_best_counts buckets. Re-applying the same scores changes nothing.
+export async function recordBests(userId: number, stored: StoredScore[]): Promise<void> {
+  const bests = new Map<number, StoredScore>();
+  for (const score of stored) {
+    if (score.isPractice || !isRankable(score)) continue;
+    const current = bests.get(score.levelId);
+    if (!current || score.percentage > current.percentage) bests.set(score.levelId, score);
+  }
+  if (bests.size === 0) return;
+
+  await db.transaction(async (tx) => {
+    // A user's batches can arrive together, one at a time keeps the counts exact
+    await tx.select({ id: users.id }).from(users).where(eq(users.id, userId)).for("update");
+
+    const existing = await tx
+      .select({ levelId: levelBests.levelId, bestPercentage: levelBests.bestPercentage })
+      .from(levelBests)
+      .where(and(eq(levelBests.userId, userId), inArray(levelBests.levelId, [...bests.keys()])));
+    const previous = new Map(existing.map((row) => [row.levelId, row.bestPercentage]));
+
+    for (const [levelId, score] of bests) {
+      const old = previous.get(levelId);
+      if (old !== undefined && old >= score.percentage) continue;
+
+      const row = { bestPercentage: score.percentage, attempts: score.attempts ?? null, achievedAt: new Date() };
+      await tx
+        .insert(levelBests)
+        .values({ userId, levelId, ...row })
+        .onConflictDoUpdate({ target: [levelBests.userId, levelBests.levelId], set: row });
+
+      if (old !== undefined) {
+        await tx
+          .update(levelBestCounts)
+          .set({ players: sql`${levelBestCounts.players} - 1` })
+          .where(and(eq(levelBestCounts.levelId, levelId), eq(levelBestCounts.percentage, old)));
+      }
+      await tx
+        .insert(levelBestCounts)
+        .values({ levelId, percentage: score.percentage, players: 1 })
+        .onConflictDoUpdate({
+          target: [levelBestCounts.levelId, levelBestCounts.percentage],
+          set: { players: sql`${levelBestCounts.players} + 1` },
+        });
+    }
+  });
+}
+
+// Top `limit` of a level and where `userId` stands. Reads the top rows off the
+// rank index and at most 101 count rows, however many scores the level has.
+export async function getLeaderboard(levelId: number, userId: number | null, limit = LEADERBOARD_SIZE): Promise<Leaderboard> {
+  const [top, counts, mine] = await Promise.all([
+    db
+      .select({
+        userId: levelBests.userId,
+        percentage: levelBests.bestPercentage,
+        gdUsername: users.gdUsername,
+        discordUsername: users.discordUsername,
+      })
+      .from(levelBests)
+      .innerJoin(users, eq(users.id, levelBests.userId))
+      .where(eq(levelBests.levelId, levelId))
+      .orderBy(desc(levelBests.bestPercentage), asc(levelBests.achievedAt))
+      .limit(Math.min(Math.max(limit, 1), MAX_LEADERBOARD_SIZE)),
+    db
+      .select({ percentage: levelBestCounts.percentage, players: levelBestCounts.players })
+      .from(levelBestCounts)
+      .where(eq(levelBestCounts.levelId, levelId)),
+    userId === null
+      ? Promise.resolve([])
+      : db
+          .select({ bestPercentage: levelBests.bestPercentage })
+          .from(levelBests)
+          .where(and(eq(levelBests.userId, userId), eq(levelBests.levelId, levelId))),
+  ]);
+
+  // Players tied on a percentage share the rank
+  const rankOf = (percentage: number) =>
+    1 + counts.reduce((above, row) => (row.percentage > percentage ? above + row.players : above), 0);
+
+  return {
+    level_id: levelId,
+    players: counts.reduce((total, row) => total + row.players, 0),
+    rank: mine[0] ? rankOf(mine[0].bestPercentage) : 0,
+    best: mine[0]?.bestPercentage ?? 0,
+    top: top.map((row) => ({
+      rank: rankOf(row.percentage),
+      name: row.gdUsername || row.discordUsername || "Unknown",
+      percentage: row.percentage,
+      self: row.userId === userId,
+    })),
+  };
+}
+
+// The scores the backfill takes bests from, the same ones recordBests accepts
+const RANKABLE_SCORES = sql`${scores.isPractice} is not true and ${scores.percentage} between 0 and 100`;
+
+// Fills the tables from scores that have no best behind them: stored before the
+// tables existed, or whose recordBests failed. Safe to run while scores arrive.
+export async function backfillLevelBests(): Promise<void> {
+  // Read-only and without locks, a full scan only when there is nothing to do
+  const [missing] = await db
+    .select({ id: scores.id })
+    .from(scores)
+    .where(sql`${RANKABLE_SCORES} and not exists (
+      select 1 from ${levelBests}
+      where ${levelBests.userId} = ${scores.userId} and ${levelBests.levelId} = ${scores.levelId}
+    )`)
+    .limit(1);
+  if (!missing) return;
+
+  await db.transaction(async (tx) => {
+    // recordBests waits while this runs, so the counts rebuilt below match
+    // level_bests exactly, whatever it wrote before the lock was taken
+    await tx.execute(sql`lock table level_bests, level_best_counts in share row exclusive mode`);
+    await tx.execute(sql`
+      insert into level_bests (user_id, level_id, best_percentage, attempts, achieved_at)
+      select distinct on (user_id, level_id) user_id, level_id, percentage, attempts, coalesce(created_at, now())
+      from scores
+      where ${RANKABLE_SCORES}
+      order by user_id, level_id, percentage desc, created_at asc
+      on conflict (user_id, level_id) do update
+        set best_percentage = excluded.best_percentage, attempts = excluded.attempts, achieved_at = excluded.achieved_at
+        where excluded.best_percentage > level_bests.best_percentage
+    `);
+    await tx.execute(sql`delete from level_best_counts`);
+    await tx.execute(sql`
+      insert into level_best_counts (level_id, percentage, players)
+      select level_id, best_percentage, count(*)
+      from level_bests
+      group by level_id, best_percentage
+    `);
+  });
+}
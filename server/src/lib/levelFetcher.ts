@@ -0,0 +1,185 @@
+// Level info lookups that stay gentle on the GD servers when many players hit
+// the same level at once:
+//
+// - Concurrent lookups of one level share a single load and upstream request.
+// - Levels the GD servers don't have, or failed to answer for, are remembered
+//   for a short while instead of being asked for again on every score.
+// - At most `concurrency` upstream requests run at a time, the rest queue.
+// - A level looked up often is refreshed in the background shortly before its
+//   stored copy expires, so its players never wait on the GD servers.
+// - When a refresh fails, the expired copy is served rather than nothing.
+
+export type UpstreamResult<T> =
+  | { status: "found"; value: T }
+  | { status: "missing" }
+  | { status: "error" };
+
+export interface StoredLevel<T> {
+  value: T;
+  storedAt: number;
+}
+
+export interface LevelSource<T> {
+  // The stored copy (level_cache), however old, or null
+  load(levelId: number): Promise<StoredLevel<T> | null>;
+  // Asks the GD servers
+  fetch(levelId: number): Promise<UpstreamResult<T>>;
+  store(levelId: number, value: T): Promise<void>;
+}
+
+export interface LevelFetcherOptions {
+  maxAgeMs: number;
+  // How long before expiry a popular level gets refreshed
+  refreshAheadMs: number;
+  // Lookups since the last refresh that make a level popular
+  popularHits: number;
+  missingTtlMs: number;
+  errorTtlMs: number;
+  concurrency: number;
+  // Bound on the remembered misses and hit counts each
+  maxTracked: number;
+}
+
+export class LevelFetcher<T> {
+  readonly stats = {
+    cacheHits: 0,
+    coalesced: 0,
+    upstreamFetches: 0,
+    upstreamMissing: 0,
+    upstreamErrors: 0,
+    negativeHits: 0,
+    refreshedAhead: 0,
+    staleServed: 0,
+    queued: 0,
+  };
+
+  private readonly inflight = new Map<number, Promise<T | null>>();
+  private readonly refreshing = new Set<number>();
+  // Level ID to when its miss expires
+  private readonly misses = new Map<number, number>();
+  private readonly hits = new Map<number, number>();
+  private active = 0;
+  private readonly waiting: (() => void)[] = [];
+
+  constructor(
+    private readonly source: LevelSource<T>,
+    private readonly options: LevelFetcherOptions
+  ) {}
+
+  get(levelId: number): Promise<T | null> {
+    const pending = this.inflight.get(levelId);
+    if (pending) {
+      this.stats.coalesced++;
+      return pending;
+    }
+
+    const lookup = this.lookup(levelId).finally(() => this.inflight.delete(levelId));
+    this.inflight.set(levelId, lookup);
+    return lookup;
+  }
+
+  private async lookup(levelId: number): Promise<T | null> {
+    const stored = await this.source.load(levelId);
+    const now = Date.now();
+
+    if (stored && now - stored.storedAt < this.options.maxAgeMs) {
+      this.stats.cacheHits++;
+      this.refreshIfPopular(levelId, stored, now);
+      return stored.value;
+    }
+
+    if (this.missRemembered(levelId, now)) {
+      this.stats.negativeHits++;
+      return stored?.value ?? null;
+    }
+
+    const result = await this.fetchUpstream(levelId);
+    if (result.status === "found") return result.value;
+
+    if (stored) this.stats.staleServed++;
+    return stored?.value ?? null;
+  }
+
+  private missRemembered(levelId: number, now: number): boolean {
+    const expiresAt = this.misses.get(levelId);
+    if (expiresAt === undefined) return false;
+    if (now < expiresAt) return true;
+    this.misses.delete(levelId);
+    return false;
+  }
+
+  private refreshIfPopular(levelId: number, stored: StoredLevel<T>, now: number): void {
+    const hits = (this.hits.get(levelId) ?? 0) + 1;
+    this.track(this.hits, levelId, hits);
+
+    const expiresIn = this.options.maxAgeMs - (now - stored.storedAt);
+    if (
+      hits < this.options.popularHits ||
+      expiresIn > this.options.refreshAheadMs ||
+      this.refreshing.has(levelId) ||
+      this.missRemembered(levelId, now)
+    ) {
+      return;
+    }
+
+    this.stats.refreshedAhead++;
+    this.refreshing.add(levelId);
+    this.fetchUpstream(levelId)
+      .catch((error) => console.error(`Failed to refresh level ${levelId}:`, error))
+      .finally(() => this.refreshing.delete(levelId));
+  }
+
+  private async fetchUpstream(levelId: number): Promise<UpstreamResult<T>> {
+    await this.acquire();
+    let result: UpstreamResult<T>;
+    try {
+      this.stats.upstreamFetches++;
+      result = await this.source.fetch(levelId);
+    } catch {
+      result = { status: "error" };
+    } finally {
+      this.release();
+    }
+
+    if (result.status === "found") {
+      this.hits.delete(levelId);
+      this.misses.delete(levelId);
+      // The caller gets the level either way, the next lookup will just fetch again
+      await this.source.store(levelId, result.value).catch((error) =>
+        console.error(`Failed to store level ${levelId}:`, error)
+      );
+    } else {
+      const missing = result.status === "missing";
+      if (missing) this.stats.upstreamMissing++;
+      else this.stats.upstreamErrors++;
+      const ttl = missing ? this.options.missingTtlMs : this.options.errorTtlMs;
+      this.track(this.misses, levelId, Date.now() + ttl);
+    }
+    return result;
+  }
+
+  // Insertion order is age, so the oldest entry goes first
+  private track(map: Map<number, number>, levelId: number, value: number): void {
+    map.delete(levelId);
+    map.set(levelId, value);
+    if (map.size > this.options.maxTracked) {
+      map.delete(map.keys().next().value!);
+    }
+  }
+
+  private async acquire(): Promise<void> {
+    if (this.active < this.options.concurrency) {
+      this.active++;
+      return;
+    }
+    this.stats.queued++;
+    // release() hands its slot straight over, so active stays counted
+    await new Promise<void>((resolve) => this.waiting.push(resolve));
+  }
+
+  private release(): void {
+    const next = this.waiting.shift();
+    if (next) next();
+    else this.active--;
+  }
+}
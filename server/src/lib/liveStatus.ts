@@ -0,0 +1,60 @@
+import { EventEmitter } from "node:events";
+
+// Players the server hasn't heard from in this long are no longer shown as playing.
+// The mod sends a heartbeat every 20s while in a level.
+export const LIVE_STALE_AFTER_MS = 60_000;
+
+export interface LiveStatus {
+  userId: number;
+  discordId: string;
+  seq: number;
+  levelId: number;
+  percentage: number;
+  bestPercentage: number;
+  attempts: number;
+  practice: boolean;
+  updatedAt: number;
+}
+
+// Live state only lives in memory, it's worthless a minute after a restart anyway
+const statuses = new Map<string, LiveStatus>();
+
+// Emits "update" with a LiveStatus whenever a player's status changes, including
+// leaving a level (levelId 0). Lets the bot follow a player without polling.
+export const liveEvents = new EventEmitter();
+liveEvents.setMaxListeners(0);
+
+export const liveStats = {
+  updates: 0,
+  outOfOrder: 0,
+};
+
+// Returns false when `status` is older than what's already stored
+export function setLiveStatus(status: LiveStatus): boolean {
+  const previous = statuses.get(status.discordId);
+  // The mod restarts its sequence when the game restarts, so only trust ordering
+  // among recent updates
+  if (previous && status.seq <= previous.seq && status.updatedAt - previous.updatedAt < LIVE_STALE_AFTER_MS) {
+    liveStats.outOfOrder++;
+    return false;
+  }
+
+  liveStats.updates++;
+  if (status.levelId === 0) {
+    statuses.delete(status.discordId);
+  } else {
+    statuses.set(status.discordId, status);
+  }
+  liveEvents.emit("update", status);
+  return true;
+}
+
+export function getLiveStatus(discordId: string): LiveStatus | null {
+  const status = statuses.get(discordId);
+  if (!status) return null;
+  if (Date.now() - status.updatedAt > LIVE_STALE_AFTER_MS) {
+    statuses.delete(discordId);
+    return null;
+  }
+  return status;
+}
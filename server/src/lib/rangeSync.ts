@@ -0,0 +1,37 @@
+// History sync between the mod's local score history and the scores table
+// (mod/src/core/RangeSync.hpp). Scores are ordered by (level_id, played_at) and a
+// range is summarized as its count and the wrapping 64-bit sum of its hashes, so
+// both sides can tell whether they hold the same scores without listing them.
+
+const MASK = (1n << 64n) - 1n;
+
+// splitmix64's finalizer
+function mix(z: bigint): bigint {
+  z = ((z ^ (z >> 30n)) * 0xbf58476d1ce4e5b9n) & MASK;
+  z = ((z ^ (z >> 27n)) * 0x94d049bb133111ebn) & MASK;
+  return z ^ (z >> 31n);
+}
+
+export interface SyncFields {
+  levelId: number;
+  playedAt: number;
+  percentage: number;
+  attempts: number | null | undefined;
+  passed: boolean;
+  isPractice: boolean | null | undefined;
+}
+
+// Same as syncHash() in RangeSync.cpp, as the signed value Postgres stores
+export function syncHash(score: SyncFields): bigint {
+  let h = 0x9e3779b97f4a7c15n;
+  h = mix(h ^ BigInt.asUintN(32, BigInt(score.levelId)));
+  h = mix(h ^ BigInt.asUintN(64, BigInt(score.playedAt)));
+  h = mix(h ^ ((BigInt.asUintN(32, BigInt(score.attempts ?? 0)) << 32n) | BigInt.asUintN(32, BigInt(score.percentage))));
+  h = mix(h ^ BigInt((score.passed ? 1 : 0) | (score.isPractice ? 2 : 0)));
+  return BigInt.asIntN(64, h);
+}
+
+// A stored hash, or Postgres' numeric sum of them, as the mod's u64 in hex
+export function wrapHashSum(sum: string | null): string {
+  return BigInt.asUintN(64, BigInt(sum ?? "0")).toString(16).padStart(16, "0");
+}
@@ -0,0 +1,219 @@
+import type { APIEmbed } from "discord.js";
+import { db } from "../db/index.js";
+import { users, scores } from "../db/schema.js";
+import { desc, eq } from "drizzle-orm";
+import { getLevelInfo, getDefaultLevelName, type GDLevelInfo } from "./gdApi.js";
+
+// Each player's newest score, written by the ingest routes as scores arrive, so
+// /recent and GET /api/scores/:discordId/recent don't have to ask Postgres. An
+// entry with its embed is around 1 KB, the default bound keeps it near 100 MB.
+const MAX_ENTRIES = parseInt(process.env.RECENT_CACHE_SIZE || "100000");
+
+// What /recent and the API show of a score
+export interface RecentScoreRow {
+  id: number;
+  userId: number;
+  levelId: number;
+  percentage: number;
+  attempts: number | null;
+  passed: boolean;
+  isPractice: boolean | null;
+  coins: boolean[] | null;
+  playedAt: number | null;
+  createdAt: Date | null;
+}
+
+export interface RecentScore {
+  discordId: string;
+  gdUsername: string | null;
+  score: RecentScoreRow;
+  // Filled in once the level info resolves, usually right after the score arrives
+  level: GDLevelInfo | null;
+  embed: APIEmbed | null;
+}
+
+export interface RecentLookup {
+  linked: boolean;
+  recent: RecentScore | null;
+}
+
+// Map iteration order doubles as recency, the first entry is evicted first
+const entries = new Map<string, RecentScore>();
+
+export const recentStats = {
+  hits: 0,
+  misses: 0,
+  evictions: 0,
+};
+
+function touch(entry: RecentScore): void {
+  entries.delete(entry.discordId);
+  entries.set(entry.discordId, entry);
+  while (entries.size > MAX_ENTRIES) {
+    entries.delete(entries.keys().next().value!);
+    recentStats.evictions++;
+  }
+}
+
+function formatDuration(seconds: number): string {
+  const mins = Math.floor(seconds / 60);
+  const secs = seconds % 60;
+  return `${mins}:${secs.toString().padStart(2, "0")}`;
+}
+
+function formatCoins(coins: boolean[] | null): string {
+  if (!coins || coins.length === 0) return "";
+  return coins.map(c => c ? "🪙" : "⚫").join("");
+}
+
+function formatTimestamp(date: Date): string {
+  return date.toLocaleString("en-US", {
+    month: "numeric",
+    day: "numeric",
+    year: "2-digit",
+    hour: "numeric",
+    minute: "2-digit",
+    hour12: true,
+  });
+}
+
+export function renderRecentEmbed(score: RecentScoreRow, levelInfo: GDLevelInfo | null): APIEmbed {
+  let levelName = `Level #${score.levelId}`;
+  let creator = "Unknown";
+  let starsText = "";
+  let durationText = "";
+  let songText = "";
+  const gdbrowserUrl = `https://gdbrowser.com/${score.levelId}`;
+
+  // Check if it's a default level (IDs 1-22 are main levels)
+  const defaultLevelInfo = getDefaultLevelName(score.levelId);
+
+  if (defaultLevelInfo) {
+    levelName = defaultLevelInfo.name;
+    creator = "RobTop";
+    starsText = `${defaultLevelInfo.stars}★`;
+    durationText = formatDuration(defaultLevelInfo.duration);
+    songText = `${defaultLevelInfo.songAuthor} - ${defaultLevelInfo.songName}`;
+  } else if (levelInfo) {
+    levelName = levelInfo.name;
+    creator = levelInfo.creator;
+    starsText = levelInfo.stars > 0 ? `${levelInfo.stars}★` : "";
+    durationText = levelInfo.duration > 0 ? formatDuration(levelInfo.duration) : "";
+    songText = `${levelInfo.songAuthor} - ${levelInfo.songName}`;
+  }
+
+  const statusEmoji = score.passed ? "✅" : "❌";
+  const practiceTag = score.isPractice ? " 🔧" : "";
+
+  let description = `▸ ${statusEmoji}${practiceTag} (${score.percentage}%) ▸ Attempt #${score.attempts || 1}`;
+
+  if (durationText || songText) {
+    description += "\n▸";
+    if (durationText) description += ` ⏱️ \`${durationText}\``;
+    if (songText) description += ` ▸ 🎶 \`${songText}\``;
+  }
+
+  // Add coins line for passes
+  if (score.passed && score.coins && score.coins.length > 0) {
+    const coinsStr = formatCoins(score.coins);
+    if (coinsStr) {
+      description += `\n▸ Coins: ${coinsStr}`;
+    }
+  }
+
+  const title = starsText
+    ? `${levelName} by ${creator} [${starsText}]`
+    : `${levelName} by ${creator}`;
+
+  return {
+    color: 0x2378DB,
+    title,
+    url: gdbrowserUrl,
+    description,
+    footer: {
+      text: `On GD Official Server • ${formatTimestamp(score.createdAt || new Date())}`,
+    },
+  };
+}
+
+async function resolve(entry: RecentScore): Promise<void> {
+  // Main levels are rendered from the built-in table
+  const level = getDefaultLevelName(entry.score.levelId) ? null : await getLevelInfo(entry.score.levelId);
+  entry.level = level;
+  entry.embed = renderRecentEmbed(entry.score, level);
+}
+
+// Write-through from the ingest routes with the newest score they just stored.
+// Level info resolves in the background, from what the mod sent along or level_cache.
+export function rememberRecentScore(discordId: string, gdUsername: string | null, score: RecentScoreRow): void {
+  const current = entries.get(discordId);
+  // A batch that finished late can hold older scores than one already cached
+  if (current && current.score.id > score.id) return;
+
+  const entry: RecentScore = { discordId, gdUsername, score, level: null, embed: null };
+  touch(entry);
+  resolve(entry).catch((error) => console.error("Failed to render recent score:", error));
+}
+
+// Relinking can change the GD account the cached entry names
+export function forgetRecentScore(discordId: string): void {
+  entries.delete(discordId);
+}
+
+// Only reaches Postgres for players whose newest score isn't cached, through
+// scores_user_recent_idx
+async function loadRecentScore(discordId: string): Promise<RecentLookup> {
+  const user = await db.query.users.findFirst({
+    where: eq(users.discordId, discordId),
+  });
+  if (!user) return { linked: false, recent: null };
+
+  const [score] = await db
+    .select({
+      id: scores.id,
+      userId: scores.userId,
+      levelId: scores.levelId,
+      percentage: scores.percentage,
+      attempts: scores.attempts,
+      passed: scores.passed,
+      isPractice: scores.isPractice,
+      coins: scores.coins,
+      playedAt: scores.playedAt,
+      createdAt: scores.createdAt,
+    })
+    .from(scores)
+    .where(eq(scores.userId, user.id))
+    .orderBy(desc(scores.createdAt))
+    .limit(1);
+  if (!score) return { linked: true, recent: null };
+
+  return {
+    linked: true,
+    recent: { discordId, gdUsername: user.gdUsername, score, level: null, embed: null },
+  };
+}
+
+// The entry can still be waiting on its level info, see recentEmbed()
+export async function getRecentScore(discordId: string): Promise<RecentLookup> {
+  let entry = entries.get(discordId);
+  if (entry) {
+    recentStats.hits++;
+    touch(entry);
+  } else {
+    recentStats.misses++;
+    const lookup = await loadRecentScore(discordId);
+    if (!lookup.recent) return lookup;
+
+    // A score may have arrived while this was loading
+    const current = entries.get(discordId);
+    entry = current && current.score.id >= lookup.recent.score.id ? current : lookup.recent;
+    touch(entry);
+  }
+  return { linked: true, recent: entry };
+}
+
+// Renders the entry unless that already happened, which may have to fetch the level
+export async function recentEmbed(entry: RecentScore): Promise<APIEmbed> {
+  if (!entry.embed) await resolve(entry);
+  return entry.embed!;
+}
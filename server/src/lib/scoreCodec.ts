@@ -0,0 +1,219 @@
+// Decoder for the mod's binary score batches (mod/src/core/ScoreCodec.cpp)
+//
+//   "YK" | version u8 | session header | varint count | score... | varint levels | level...
+//
+// Version 2 scores may carry an attempt timeline (flag bit 2) after the coins.
+// Version 3 appends metadata for the levels the mod hasn't reported yet.
+// Version 4 adds the install ID to the header and a sequence number before each
+// score, the pair identifying a score across resends.
+// Version 5 adds when each score was played (unix ms, 0 if unknown) after its seq.
+
+export const SCORE_BATCH_CONTENT_TYPE = "application/x-yuki-scores";
+// What the mod sends as its install ID, which scopes score and heatmap upload seqs
+export const INSTALL_ID_PATTERN = /^[0-9a-f]{1,32}$/;
+
+const MIN_VERSION = 1;
+const VERSION = 5;
+const MAX_STRING_SIZE = 4096;
+const MAX_TIMELINE_SIZE = 8192;
+const MAX_BATCH_SIZE = 4096;
+const MAX_COINS = 64;
+const MAX_LEVELS = 256;
+
+export interface DecodedScore {
+  // Outbox sequence number, unique per install_id
+  seq?: number;
+  // Unix milliseconds on the player's clock
+  played_at?: number;
+  level_id: number;
+  percentage: number;
+  attempts: number;
+  passed: boolean;
+  is_practice: boolean;
+  coins_collected: boolean[];
+  // Base64 in JSON bodies, raw bytes in binary ones
+  timeline?: string | Uint8Array;
+}
+
+// Level metadata as the game has it (mod/src/core/LevelMeta.hpp)
+export interface DecodedLevel {
+  level_id: number;
+  name: string;
+  creator: string;
+  description: string;
+  difficulty: number;
+  stars: number;
+  is_demon: boolean;
+  demon_difficulty: number;
+  audio_track: number;
+  song_id: number;
+  song_name: string;
+  song_author: string;
+  length: number;
+  downloads: number;
+  likes: number;
+}
+
+export interface DecodedBatch {
+  auth_token: string;
+  gd_account_id: number;
+  gd_username: string;
+  install_id?: string;
+  scores: DecodedScore[];
+  levels?: DecodedLevel[];
+}
+
+class Reader {
+  private pos = 0;
+
+  constructor(private readonly buf: Uint8Array) {}
+
+  get done(): boolean {
+    return this.pos === this.buf.length;
+  }
+
+  byte(): number {
+    if (this.pos >= this.buf.length) throw new Error("Truncated batch");
+    return this.buf[this.pos++];
+  }
+
+  // Varint as its 7-bit groups, so masks wider than 53 bits don't lose precision
+  groups(): number[] {
+    const groups: number[] = [];
+    for (;;) {
+      const b = this.byte();
+      groups.push(b & 0x7f);
+      if (!(b & 0x80)) return groups;
+      if (groups.length >= 10) throw new Error("Varint too long");
+    }
+  }
+
+  varUint(): number {
+    const groups = this.groups();
+    if (groups.length > 8) throw new Error("Varint out of range");
+    return groups.reduceRight((value, group) => value * 128 + group, 0);
+  }
+
+  varInt(): number {
+    const raw = this.varUint();
+    return raw % 2 === 0 ? raw / 2 : -(raw + 1) / 2;
+  }
+
+  string(): string {
+    const length = this.varUint();
+    if (length > MAX_STRING_SIZE || this.pos + length > this.buf.length) {
+      throw new Error("Bad string length");
+    }
+    const value = Buffer.from(this.buf.subarray(this.pos, this.pos + length)).toString("utf-8");
+    this.pos += length;
+    return value;
+  }
+
+  bytes(): Uint8Array {
+    const length = this.varUint();
+    if (length > MAX_TIMELINE_SIZE || this.pos + length > this.buf.length) {
+      throw new Error("Bad timeline length");
+    }
+    const value = this.buf.slice(this.pos, this.pos + length);
+    this.pos += length;
+    return value;
+  }
+}
+
+export function decodeScoreBatch(buf: Uint8Array): DecodedBatch {
+  const r = new Reader(buf);
+
+  if (r.byte() !== 0x59 || r.byte() !== 0x4b) throw new Error("Bad magic");
+  const version = r.byte();
+  if (version < MIN_VERSION || version > VERSION) throw new Error(`Unsupported version ${version}`);
+
+  const auth_token = r.string();
+  const gd_account_id = r.varInt();
+  const gd_username = r.string();
+  const install_id = version >= 4 ? r.string() : undefined;
+  const count = r.varUint();
+  if (count > MAX_BATCH_SIZE) throw new Error("Batch too large");
+
+  const scores: DecodedScore[] = [];
+  for (let i = 0; i < count; i++) {
+    const seq = version >= 4 ? r.varUint() : undefined;
+    const played_at = version >= 5 ? r.varUint() || undefined : undefined;
+    const level_id = r.varInt();
+    const percentage = r.varUint();
+    const attempts = r.varUint();
+    const flags = r.byte();
+    const coinCount = r.varUint();
+    if (coinCount > MAX_COINS) throw new Error("Too many coins");
+    const mask = r.groups();
+
+    const coins_collected: boolean[] = [];
+    for (let c = 0; c < coinCount; c++) {
+      const group = mask[Math.floor(c / 7)] ?? 0;
+      coins_collected.push(((group >> c % 7) & 1) === 1);
+    }
+
+    const timeline = flags & 4 ? r.bytes() : undefined;
+
+    scores.push({
+      seq,
+      played_at,
+      level_id,
+      percentage,
+      attempts,
+      passed: (flags & 1) !== 0,
+      is_practice: (flags & 2) !== 0,
+      coins_collected,
+      timeline,
+    });
+  }
+
+  const levels: DecodedLevel[] = [];
+  if (version >= 3) {
+    const levelCount = r.varUint();
+    if (levelCount > MAX_LEVELS) throw new Error("Too many levels");
+
+    for (let i = 0; i < levelCount; i++) {
+      levels.push({
+        level_id: r.varInt(),
+        name: r.string(),
+        creator: r.string(),
+        description: r.string(),
+        difficulty: r.varInt(),
+        stars: r.varInt(),
+        is_demon: (r.byte() & 1) !== 0,
+        demon_difficulty: r.varInt(),
+        audio_track: r.varInt(),
+        song_id: r.varInt(),
+        song_name: r.string(),
+        song_author: r.string(),
+        length: r.varInt(),
+        downloads: r.varInt(),
+        likes: r.varInt(),
+      });
+    }
+  }
+
+  if (!r.done) throw new Error("Trailing bytes");
+
+  return { auth_token, gd_account_id, gd_username, install_id, scores, levels };
+}
+
+// Most coins a GD level has, secret and user coins alike
+const MAX_LEVEL_COINS = 3;
+// The columns scores go into are 32-bit
+const MAX_INT = 2147483647;
+
+// Whether a decoded score is one the game could have produced. JSON bodies hold
+// whatever the client put there and the binary format can carry values far out
+// of range, so scores from both go through this before they're stored. A pass
+// on the first try comes with 0 attempts, the mod counts attempts on reset.
+export function isValidScore(score: DecodedScore | null | undefined): score is DecodedScore {
+  return (
+    !!score &&
+    Number.isInteger(score.level_id) && score.level_id !== 0 && Math.abs(score.level_id) <= MAX_INT &&
+    Number.isInteger(score.percentage) && score.percentage >= 0 && score.percentage <= 100 &&
+    Number.isInteger(score.attempts) && score.attempts >= 0 && score.attempts <= MAX_INT &&
+    Array.isArray(score.coins_collected) && score.coins_collected.length <= MAX_LEVEL_COINS &&
+    score.coins_collected.every((coin) => typeof coin === "boolean")
+  );
+}
@@ -0,0 +1,53 @@
+// Attempt timelines recorded by the mod (mod/src/core/AttemptTimeline.cpp)
+//
+//   version u8 | varint count | (varint dt ms, zigzag varint dx)...
+
+const VERSION = 1;
+const MAX_POINTS = 4096;
+
+export interface TimelinePoint {
+  timeMs: number;
+  x: number;
+}
+
+export function decodeTimeline(buf: Uint8Array): TimelinePoint[] {
+  let pos = 0;
+
+  const byte = (): number => {
+    if (pos >= buf.length) throw new Error("Truncated timeline");
+    return buf[pos++];
+  };
+
+  const varUint = (): number => {
+    let value = 0;
+    let scale = 1;
+    for (let i = 0; i < 8; i++) {
+      const b = byte();
+      value += (b & 0x7f) * scale;
+      if (!(b & 0x80)) return value;
+      scale *= 128;
+    }
+    throw new Error("Varint too long");
+  };
+
+  const varInt = (): number => {
+    const raw = varUint();
+    return raw % 2 === 0 ? raw / 2 : -(raw + 1) / 2;
+  };
+
+  if (byte() !== VERSION) throw new Error("Unsupported timeline version");
+  const count = varUint();
+  if (count > MAX_POINTS) throw new Error("Timeline too long");
+
+  const points: TimelinePoint[] = [];
+  let timeMs = 0;
+  let x = 0;
+  for (let i = 0; i < count; i++) {
+    timeMs += varUint();
+    x += varInt();
+    points.push({ timeMs, x });
+  }
+
+  if (pos !== buf.length) throw new Error("Trailing bytes");
+  return points;
+}
@@ -0,0 +1,105 @@
+import { Hono } from "hono";
+import { db } from "../db/index.js";
+import { users, deathHeatmaps, heatmapUploads } from "../db/schema.js";
+import { eq, sql } from "drizzle-orm";
+import { HEATMAP_BUCKETS } from "../lib/heatmap.js";
+import { INSTALL_ID_PATTERN } from "../lib/scoreCodec.js";
+
+const heatmapsRouter = new Hono();
+
+const MAX_HEATMAPS_PER_REQUEST = 50;
+
+interface HeatmapUpload {
+  level_id: number;
+  buckets: number;
+  counts: [number, number][];
+  // Unique per install_id and the same on a resend, absent from older mods
+  upload_seq?: number;
+}
+
+// Merge per-session death histograms from GD mod
+heatmapsRouter.post("/api/heatmaps", async (c) => {
+  const body = await c.req.json() as {
+    auth_token: string;
+    install_id?: string;
+    heatmaps: HeatmapUpload[];
+  };
+
+  if (!body.auth_token || !Array.isArray(body.heatmaps)) {
+    return c.json({ success: false, error: "Missing required fields" }, 400);
+  }
+
+  if (body.heatmaps.length > MAX_HEATMAPS_PER_REQUEST) {
+    return c.json({ success: false, error: "Too many heatmaps" }, 413);
+  }
+
+  const user = await db.query.users.findFirst({
+    where: eq(users.authToken, body.auth_token),
+  });
+
+  if (!user) {
+    return c.json({ success: false, error: "Invalid auth token" }, 401);
+  }
+
+  // Uploads are only deduplicated when the mod identifies them, older mods resend blindly
+  const installId = typeof body.install_id === "string" && INSTALL_ID_PATTERN.test(body.install_id)
+    ? body.install_id
+    : null;
+
+  let merged = 0;
+  let duplicates = 0;
+  for (const heatmap of body.heatmaps) {
+    if (!heatmap?.level_id || heatmap.buckets !== HEATMAP_BUCKETS || !Array.isArray(heatmap.counts)) {
+      continue;
+    }
+
+    const counts = new Array<number>(HEATMAP_BUCKETS).fill(0);
+    let total = 0;
+    for (const [bucket, count] of heatmap.counts) {
+      if (!Number.isInteger(bucket) || bucket < 0 || bucket >= HEATMAP_BUCKETS) continue;
+      if (!Number.isInteger(count) || count <= 0) continue;
+      counts[bucket] += count;
+      total += count;
+    }
+    if (total === 0) continue;
+
+    const seq = installId && Number.isSafeInteger(heatmap.upload_seq) && heatmap.upload_seq! > 0
+      ? heatmap.upload_seq!
+      : null;
+
+    const applied = await db.transaction(async (tx) => {
+      if (seq !== null) {
+        const fresh = await tx
+          .insert(heatmapUploads)
+          .values({ clientInstallId: installId!, uploadSeq: seq, userId: user.id, levelId: heatmap.level_id })
+          .onConflictDoNothing()
+          .returning({ uploadSeq: heatmapUploads.uploadSeq });
+        if (fresh.length === 0) return false;
+      }
+
+      // Added up by the upsert itself, which also covers two uploads racing to
+      // create the level's row: the second one merges into the first
+      await tx
+        .insert(deathHeatmaps)
+        .values({ userId: user.id, levelId: heatmap.level_id, counts, totalDeaths: total })
+        .onConflictDoUpdate({
+          target: [deathHeatmaps.userId, deathHeatmaps.levelId],
+          set: {
+            counts: sql`(
+              select array_agg(coalesce(a, 0) + coalesce(b, 0) order by i)
+              from unnest(death_heatmaps.counts, excluded.counts) with ordinality as t(a, b, i)
+            )`,
+            totalDeaths: sql`death_heatmaps.total_deaths + excluded.total_deaths`,
+            updatedAt: new Date(),
+          },
+        });
+      return true;
+    });
+    if (applied) merged++;
+    else duplicates++;
+  }
+
+  return c.json({ success: true, merged, duplicates });
+});
+
+export default heatmapsRouter;
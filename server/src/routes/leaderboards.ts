@@ -0,0 +1,153 @@
+import { Hono } from "hono";
+import { db } from "../db/index.js";
+import { users } from "../db/schema.js";
+import { eq, sql } from "drizzle-orm";
+import {
+  backfillLevelBests,
+  getLeaderboard,
+  LEADERBOARD_SIZE,
+  MAX_LEADERBOARD_SIZE,
+  type Leaderboard,
+} from "../lib/leaderboard.js";
+
+const leaderboardsRouter = new Hono();
+
+// A level's top scores and the caller's rank, for GD mod levels it hasn't just passed
+leaderboardsRouter.post("/api/leaderboard", async (c) => {
+  const body = await c.req.json() as {
+    auth_token: string;
+    level_id: number;
+    limit?: number;
+  };
+
+  if (!body.auth_token || !Number.isInteger(body.level_id)) {
+    return c.json({ success: false, error: "Missing required fields" }, 400);
+  }
+
+  const user = await db.query.users.findFirst({
+    where: eq(users.authToken, body.auth_token),
+  });
+
+  if (!user) {
+    return c.json({ success: false, error: "Invalid auth token" }, 401);
+  }
+
+  const limit = Number.isInteger(body.limit) ? body.limit! : LEADERBOARD_SIZE;
+  return c.json({ success: true, leaderboard: await getLeaderboard(body.level_id, user.id, limit) });
+});
+
+// Benchmark support for yuki-loadgen --leaderboard: bulk seeding of scores and the
+// same leaderboard read both off the maintained tables and aggregated from scores.
+// Only exists when the server was started with LOADTEST=1.
+if (process.env.LOADTEST === "1") {
+  // Seeded levels sit above any real level ID
+  const SEED_LEVEL_BASE = 1_900_000_000;
+  const MAX_SEED_ROWS = 1_000_000;
+
+  async function seededUsers() {
+    const [range] = await db.execute<{ first: number | null; last: number | null }>(sql`
+      select min(id) as first, max(id) as last from users where discord_id like 'loadtest-seed-%'
+    `);
+    return { first: range?.first ?? 0, last: range?.last ?? 0 };
+  }
+
+  // Adds `rows` scores from `users` seeded players over `levels` levels. Level
+  // popularity is skewed like the real thing, level 0 gets the most scores.
+  // Straight into the table, level bests are built afterwards by /backfill-bests.
+  leaderboardsRouter.post("/api/loadtest/seed-scores", async (c) => {
+    const body = await c.req.json() as { users: number; levels: number; rows: number };
+    const userCount = Math.floor(body.users);
+    const levelCount = Math.floor(body.levels);
+    const rows = Math.floor(body.rows);
+    if (!(userCount > 0) || !(levelCount > 0) || !(rows >= 0) || rows > MAX_SEED_ROWS) {
+      return c.json({ success: false, error: `users, levels and up to ${MAX_SEED_ROWS} rows` }, 400);
+    }
+
+    await db.execute(sql`
+      insert into users (discord_id, discord_username, gd_username, auth_token)
+      select 'loadtest-seed-' || i, 'seed_' || i, 'Seed' || i, 'loadtest-seed-token-' || i
+      from generate_series(1, ${userCount}::int) as i
+      on conflict do nothing
+    `);
+    const { first, last } = await seededUsers();
+
+    if (rows > 0) {
+      await db.execute(sql`
+        insert into scores (user_id, level_id, percentage, attempts, passed, is_practice, created_at)
+        select ${first}::int + floor(random() * ${last - first + 1}::int)::int,
+               ${SEED_LEVEL_BASE}::int + floor(${levelCount}::int * power(random(), 3))::int,
+               p, 1 + floor(random() * 500)::int, p = 100, random() < 0.05,
+               now() - random() * interval '365 days'
+        from (select floor(101 * power(random(), 2))::int as p from generate_series(1, ${rows}::int)) as seeded
+      `);
+    }
+
+    const [total] = await db.execute<{ count: number }>(sql`
+      select count(*)::int as count from scores where level_id >= ${SEED_LEVEL_BASE}::int
+    `);
+    return c.json({ success: true, first_user: first, last_user: last, first_level: SEED_LEVEL_BASE, rows: total.count });
+  });
+
+  leaderboardsRouter.post("/api/loadtest/backfill-bests", async (c) => {
+    await backfillLevelBests();
+    return c.json({ success: true });
+  });
+
+  // The same answer as getLeaderboard, from the scores table alone: what every
+  // read would cost without level_bests and level_best_counts
+  async function aggregateLeaderboard(levelId: number, userId: number | null, limit: number): Promise<Leaderboard> {
+    const bests = sql`
+      select user_id, max(percentage) as best, min(created_at) as achieved
+      from scores
+      where level_id = ${levelId}::int and is_practice is not true and percentage between 0 and 100
+      group by user_id
+    `;
+    const [top, [summary]] = await Promise.all([
+      db.execute<{ user_id: number; best: number; name: string | null; rank: number }>(sql`
+        with bests as (${bests}),
+        ranked as (select user_id, best, achieved, rank() over (order by best desc) as rank from bests)
+        select ranked.user_id, ranked.best, ranked.rank::int as rank,
+               coalesce(users.gd_username, users.discord_username) as name
+        from ranked join users on users.id = ranked.user_id
+        order by ranked.best desc, ranked.achieved asc
+        limit ${limit}::int
+      `),
+      db.execute<{ players: number; best: number | null; above: number }>(sql`
+        with bests as (${bests}),
+        mine as (select best from bests where user_id = ${userId ?? 0}::int)
+        select (select count(*)::int from bests) as players,
+               (select best from mine) as best,
+               (select count(*)::int from bests where best > (select best from mine)) as above
+      `),
+    ]);
+
+    return {
+      level_id: levelId,
+      players: summary.players,
+      rank: summary.best === null ? 0 : summary.above + 1,
+      best: summary.best ?? 0,
+      top: [...top].map((row) => ({
+        rank: row.rank,
+        name: row.name || "Unknown",
+        percentage: row.best,
+        self: row.user_id === userId,
+      })),
+    };
+  }
+
+  leaderboardsRouter.post("/api/loadtest/leaderboard", async (c) => {
+    const body = await c.req.json() as { level_id: number; user_id?: number; mode: string; limit?: number };
+    if (!Number.isInteger(body.level_id) || (body.mode !== "materialized" && body.mode !== "aggregate")) {
+      return c.json({ success: false, error: "level_id and mode (materialized | aggregate)" }, 400);
+    }
+    const userId = Number.isInteger(body.user_id) ? body.user_id! : null;
+    const limit = Math.min(Math.max(Number.isInteger(body.limit) ? body.limit! : LEADERBOARD_SIZE, 1), MAX_LEADERBOARD_SIZE);
+
+    const leaderboard = body.mode === "materialized"
+      ? await getLeaderboard(body.level_id, userId, limit)
+      : await aggregateLeaderboard(body.level_id, userId, limit);
+    return c.json({ success: true, leaderboard });
+  });
+}
+
+export default leaderboardsRouter;
@@ -3,6 +3,7 @@ import { db } from "../db/index.js";
 import { users } from "../db/schema.js";
 import { eq } from "drizzle-orm";
 import { generateLinkCode, verifyLinkCode } from "../lib/linkCodes.js";
+import { forgetRecentScore } from "../lib/recentScores.js";
 import { nanoid } from "nanoid";
 
 const link = new Hono();
@@ -102,6 +103,19 @@ link.get("/callback", async (c) => {
   }
 });
 
+// Load tests link thousands of fake players, which can't go through Discord OAuth.
+// Only exists when the server was started with LOADTEST=1.
+if (process.env.LOADTEST === "1") {
+  link.post("/api/loadtest/link-code", async (c) => {
+    const body = await c.req.json() as { discord_id: string; discord_username: string };
+    if (!body.discord_id?.startsWith("loadtest-")) {
+      return c.json({ success: false, error: "Load test users need a loadtest- discord_id" }, 400);
+    }
+    const code = generateLinkCode(body.discord_id, body.discord_username || body.discord_id);
+    return c.json({ success: true, code });
+  });
+}
+
 // Verify link code from GD mod
 link.post("/api/link/verify", async (c) => {
   const body = await c.req.json() as {
@@ -140,6 +154,7 @@ link.post("/api/link/verify", async (c) => {
         discordUsername: pendingLink.discordUsername,
       })
       .where(eq(users.discordId, pendingLink.discordId));
+    forgetRecentScore(pendingLink.discordId);
   } else {
     // Create new user
     await db.insert(users).values({
@@ -0,0 +1,73 @@
+import { Hono } from "hono";
+import { db } from "../db/index.js";
+import { users } from "../db/schema.js";
+import { eq } from "drizzle-orm";
+import { setLiveStatus } from "../lib/liveStatus.js";
+
+const liveRouter = new Hono();
+
+// Every playing user sends an update about once a second, don't make each one a
+// database round trip
+const AUTH_CACHE_MS = 60_000;
+const authCache = new Map<string, { userId: number; discordId: string; expiresAt: number }>();
+
+async function findUser(authToken: string) {
+  const cached = authCache.get(authToken);
+  if (cached && cached.expiresAt > Date.now()) return cached;
+
+  const user = await db.query.users.findFirst({
+    where: eq(users.authToken, authToken),
+  });
+  if (!user) {
+    authCache.delete(authToken);
+    return null;
+  }
+
+  const entry = { userId: user.id, discordId: user.discordId, expiresAt: Date.now() + AUTH_CACHE_MS };
+  authCache.set(authToken, entry);
+  return entry;
+}
+
+function clampPercent(value: unknown): number {
+  return typeof value === "number" && Number.isFinite(value) ? Math.min(Math.max(Math.trunc(value), 0), 100) : 0;
+}
+
+// Live progress from GD mod. Acknowledges with the sequence number it was sent,
+// the mod only sends its next update once the previous one is acknowledged.
+liveRouter.post("/api/live", async (c) => {
+  const body = await c.req.json() as {
+    auth_token: string;
+    seq: number;
+    level_id: number;
+    percentage: number;
+    best_percentage: number;
+    attempts: number;
+    practice: boolean;
+  };
+
+  if (!body.auth_token || !Number.isInteger(body.seq) || !Number.isInteger(body.level_id)) {
+    return c.json({ success: false, error: "Missing required fields" }, 400);
+  }
+
+  const user = await findUser(body.auth_token);
+  if (!user) {
+    return c.json({ success: false, error: "Invalid auth token" }, 401);
+  }
+
+  // A stale update is still acknowledged, resending it wouldn't help
+  setLiveStatus({
+    userId: user.userId,
+    discordId: user.discordId,
+    seq: body.seq,
+    levelId: Math.max(body.level_id, 0),
+    percentage: clampPercent(body.percentage),
+    bestPercentage: clampPercent(body.best_percentage),
+    attempts: Number.isInteger(body.attempts) ? Math.max(body.attempts, 0) : 0,
+    practice: !!body.practice,
+    updatedAt: Date.now(),
+  });
+
+  return c.json({ success: true, ack: body.seq });
+});
+
+export default liveRouter;
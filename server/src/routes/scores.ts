@@ -1,11 +1,55 @@
 import { Hono } from "hono";
 import { db } from "../db/index.js";
-import { users, scores } from "../db/schema.js";
-import { eq, desc } from "drizzle-orm";
-import { getLevelInfo } from "../lib/gdApi.js";
+import { users, scores, attemptTimelines, type NewScore } from "../db/schema.js";
+import { eq, sql } from "drizzle-orm";
+import { getLevelInfo, cacheClientLevels } from "../lib/gdApi.js";
+import {
+  decodeScoreBatch,
+  INSTALL_ID_PATTERN,
+  isValidScore,
+  SCORE_BATCH_CONTENT_TYPE,
+  type DecodedBatch,
+  type DecodedScore,
+} from "../lib/scoreCodec.js";
+import { decodeTimeline } from "../lib/timeline.js";
+import { getLeaderboard, recordBests, type Leaderboard } from "../lib/leaderboard.js";
+import { syncHash } from "../lib/rangeSync.js";
+import { getRecentScore, recentEmbed, rememberRecentScore, type RecentScoreRow } from "../lib/recentScores.js";
 
 const scoresRouter = new Hono();
 
+const MAX_BATCH_SIZE = 256;
+
+// Off only while yuki-loadgen --no-dedup measures what dedup costs, see below
+let dedupScores = true;
+
+// The columns a stored score goes into the recent score cache with
+const RECENT_COLUMNS = {
+  id: scores.id,
+  userId: scores.userId,
+  levelId: scores.levelId,
+  percentage: scores.percentage,
+  attempts: scores.attempts,
+  passed: scores.passed,
+  isPractice: scores.isPractice,
+  coins: scores.coins,
+  playedAt: scores.playedAt,
+  createdAt: scores.createdAt,
+};
+
+// A broken timeline only costs the timeline, never the score it came with
+function parseTimeline(timeline: DecodedScore["timeline"]) {
+  if (!timeline) return null;
+  try {
+    const data = typeof timeline === "string" ? Buffer.from(timeline, "base64") : Buffer.from(timeline);
+    const points = decodeTimeline(data);
+    if (points.length === 0) return null;
+    return { data, pointCount: points.length, durationMs: points[points.length - 1].timeMs };
+  } catch {
+    return null;
+  }
+}
+
 // Receive score from GD mod
 scoresRouter.post("/api/scores", async (c) => {
   const body = await c.req.json() as {
@@ -36,6 +80,10 @@ scoresRouter.post("/api/scores", async (c) => {
     return c.json({ success: false, error: "Missing required fields" }, 400);
   }
 
+  if (!isValidScore(body)) {
+    return c.json({ success: false, error: "Invalid score" }, 400);
+  }
+
   // Find user by auth token
   const user = await db.query.users.findFirst({
     where: eq(users.authToken, auth_token),
@@ -54,7 +102,7 @@ scoresRouter.post("/api/scores", async (c) => {
   }
 
   // Insert score
-  await db.insert(scores).values({
+  const [stored] = await db.insert(scores).values({
     userId: user.id,
     levelId: level_id,
     percentage,
@@ -62,7 +110,8 @@ scoresRouter.post("/api/scores", async (c) => {
     passed,
     isPractice: is_practice || false,
     coins: coins_collected,
-  });
+  }).returning(RECENT_COLUMNS);
+  rememberRecentScore(user.discordId, gd_username || user.gdUsername, stored);
 
   // Prefetch level info in background
   getLevelInfo(level_id).catch(console.error);
@@ -70,38 +119,207 @@ scoresRouter.post("/api/scores", async (c) => {
   return c.json({ success: true });
 });
 
-// Get recent score for a user (internal use by bot)
-scoresRouter.get("/api/scores/:discordId/recent", async (c) => {
-  const discordId = c.req.param("discordId");
+// Receive many scores from GD mod in one request, as JSON or the binary batch format
+scoresRouter.post("/api/scores/batch", async (c) => {
+  const contentType = c.req.header("Content-Type") || "";
+
+  let body: DecodedBatch;
+  if (contentType.startsWith(SCORE_BATCH_CONTENT_TYPE)) {
+    try {
+      body = decodeScoreBatch(new Uint8Array(await c.req.arrayBuffer()));
+    } catch (error) {
+      return c.json({ success: false, error: `Malformed batch: ${(error as Error).message}` }, 400);
+    }
+  } else if (contentType.startsWith("application/json")) {
+    body = await c.req.json() as DecodedBatch;
+  } else {
+    return c.json({ success: false, error: "Unsupported content type" }, 415);
+  }
+
+  const { auth_token, gd_account_id, gd_username } = body;
+  // Scores are only deduplicated when the mod identifies them, older mods resend blindly
+  const installId = typeof body.install_id === "string" && INSTALL_ID_PATTERN.test(body.install_id)
+    ? body.install_id
+    : null;
+
+  if (!auth_token || !Array.isArray(body.scores)) {
+    return c.json({ success: false, error: "Missing required fields" }, 400);
+  }
+
+  if (body.scores.length > MAX_BATCH_SIZE) {
+    return c.json({ success: false, error: `Batch too large (max ${MAX_BATCH_SIZE})` }, 413);
+  }
 
   const user = await db.query.users.findFirst({
-    where: eq(users.discordId, discordId),
+    where: eq(users.authToken, auth_token),
   });
 
   if (!user) {
-    return c.json({ success: false, error: "User not linked" }, 404);
+    return c.json({ success: false, error: "Invalid auth token" }, 401);
+  }
+
+  if (gd_username && gd_username !== user.gdUsername) {
+    await db
+      .update(users)
+      .set({ gdUsername: gd_username, gdAccountId: gd_account_id })
+      .where(eq(users.id, user.id));
+  }
+
+  // Skip malformed entries instead of failing the batch, the mod won't resend it.
+  // Both wire formats decode to the same shape and get the same check.
+  const accepted = body.scores.filter(isValidScore);
+  const rows: NewScore[] = accepted.map((score) => {
+    const seq = installId && Number.isSafeInteger(score.seq) && score.seq! > 0 ? score.seq! : null;
+    const playedAt = Number.isSafeInteger(score.played_at) && score.played_at! > 0 ? score.played_at! : null;
+    const row = {
+      userId: user.id,
+      levelId: score.level_id,
+      percentage: score.percentage,
+      attempts: score.attempts,
+      passed: !!score.passed,
+      isPractice: !!score.is_practice,
+      coins: score.coins_collected,
+      clientInstallId: seq ? installId : null,
+      clientSeq: seq,
+      playedAt,
+    };
+    // Only scores with the player's own timestamp take part in history sync
+    return { ...row, syncHash: playedAt ? syncHash({ ...row, playedAt }) : null };
+  });
+
+  let inserted: (RecentScoreRow & { clientSeq: number | null })[] = [];
+  if (rows.length > 0) {
+    const timelines = accepted.map((score) => parseTimeline(score.timeline));
+    const returning = { ...RECENT_COLUMNS, clientSeq: scores.clientSeq };
+
+    // Scores and their timelines are stored together or not at all, so a resend
+    // never finds a score whose timeline went missing
+    inserted = await db.transaction(async (tx) => {
+      // Skipped rows don't come back from RETURNING, so only a seq can tie a
+      // returned row to its timeline. A timeline on a score without one goes in
+      // with its score on its own.
+      const alone = rows.flatMap((row, i) => (timelines[i] && row.clientSeq == null ? [i] : []));
+      const together = rows.filter((row, i) => !(timelines[i] && row.clientSeq == null));
+
+      // A resent score hits scores_client_key_idx and is skipped, so a batch whose
+      // response got lost can be sent again safely
+      const stored: typeof inserted = together.length > 0
+        ? await tx
+            .insert(scores)
+            .values(together)
+            .onConflictDoNothing(dedupScores ? { target: [scores.clientInstallId, scores.clientSeq] } : undefined)
+            .returning(returning)
+        : [];
+
+      const bySeq = new Map(stored.flatMap((row) => (row.clientSeq !== null ? [[row.clientSeq, row.id] as const] : [])));
+      const timelineRows = rows.flatMap((row, i) => {
+        const timeline = timelines[i];
+        const scoreId = timeline && row.clientSeq != null ? bySeq.get(row.clientSeq) : undefined;
+        return scoreId !== undefined ? [{ scoreId, ...timeline! }] : [];
+      });
+      for (const i of alone) {
+        const [row] = await tx.insert(scores).values(rows[i]).returning(returning);
+        stored.push(row);
+        timelineRows.push({ scoreId: row.id, ...timelines[i]! });
+      }
+
+      if (timelineRows.length > 0) {
+        await tx.insert(attemptTimelines).values(timelineRows);
+      }
+      return stored;
+    });
+  }
+
+  // Bests only ever go up, so resent scores are harmless here. The scores are
+  // already stored, a failure only costs the leaderboard update.
+  await recordBests(user.id, rows).catch((error) => console.error("Failed to update level bests:", error));
+
+  // A pass gets its level's standings back, so the mod can show them on the end screen
+  const passedLevels = new Set(rows.filter((row) => row.passed && !row.isPractice).map((row) => row.levelId));
+  const leaderboards: Leaderboard[] = await Promise.all(
+    [...passedLevels].map((levelId) => getLeaderboard(levelId, user.id))
+  ).catch((error) => {
+    console.error("Failed to read leaderboards:", error);
+    return [];
+  });
+
+  // Levels the mod described don't need a trip to the GD servers
+  const suppliedLevels = Array.isArray(body.levels)
+    ? await cacheClientLevels(body.levels).catch((error) => {
+        console.error("Failed to cache client level info:", error);
+        return new Set<number>();
+      })
+    : new Set<number>();
+
+  // Whoever runs /rs next most likely wants this one. After the mod's levels are
+  // cached, so rendering it doesn't go to the GD servers for them.
+  if (inserted.length > 0) {
+    const { clientSeq, ...newest } = inserted.reduce((a, b) => (b.id > a.id ? b : a));
+    rememberRecentScore(user.discordId, gd_username || user.gdUsername, newest);
+  }
+
+  // Prefetch level info in background
+  for (const levelId of new Set(rows.map((row) => row.levelId))) {
+    if (suppliedLevels.has(levelId)) continue;
+    getLevelInfo(levelId).catch(console.error);
   }
 
-  const recentScore = await db.query.scores.findFirst({
-    where: eq(scores.userId, user.id),
-    orderBy: [desc(scores.createdAt)],
+  return c.json({
+    success: true,
+    accepted: inserted.length,
+    duplicates: rows.length - inserted.length,
+    rejected: body.scores.length - rows.length,
+    leaderboards,
   });
+});
+
+// Get recent score for a user (internal use by bot)
+scoresRouter.get("/api/scores/:discordId/recent", async (c) => {
+  const discordId = c.req.param("discordId");
 
-  if (!recentScore) {
+  // Served from memory unless the player hasn't sent anything since the server started
+  const { linked, recent } = await getRecentScore(discordId);
+
+  if (!linked) {
+    return c.json({ success: false, error: "User not linked" }, 404);
+  }
+
+  if (!recent) {
     return c.json({ success: false, error: "No recent scores" }, 404);
   }
 
-  // Get level info
-  const levelInfo = await getLevelInfo(recentScore.levelId);
+  await recentEmbed(recent);
 
   return c.json({
     success: true,
     score: {
-      ...recentScore,
-      gdUsername: user.gdUsername,
+      ...recent.score,
+      gdUsername: recent.gdUsername,
     },
-    level: levelInfo,
+    level: recent.level,
   });
 });
 
+// Drops or rebuilds scores_client_key_idx, so a load test can compare ingest with
+// and without dedup. Only exists when the server was started with LOADTEST=1,
+// npm run db:push puts the index back too.
+if (process.env.LOADTEST === "1") {
+  scoresRouter.post("/api/loadtest/dedup", async (c) => {
+    const body = await c.req.json() as { enabled: boolean };
+    if (typeof body.enabled !== "boolean") {
+      return c.json({ success: false, error: "Missing required fields" }, 400);
+    }
+
+    if (body.enabled) {
+      await db.execute(sql`
+        create unique index if not exists scores_client_key_idx on scores (client_install_id, client_seq)
+      `);
+    } else {
+      await db.execute(sql`drop index if exists scores_client_key_idx`);
+    }
+    dedupScores = body.enabled;
+    return c.json({ success: true, enabled: dedupScores });
+  });
+}
+
 export default scoresRouter;
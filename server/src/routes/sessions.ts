@@ -0,0 +1,115 @@
+import { Hono } from "hono";
+import { db } from "../db/index.js";
+import { users, sessionSummaries, type NewSessionSummary } from "../db/schema.js";
+import { and, eq, sql } from "drizzle-orm";
+import { HEATMAP_BUCKETS } from "../lib/heatmap.js";
+
+const sessionsRouter = new Hono();
+
+const MAX_SESSIONS_PER_REQUEST = 50;
+
+interface SessionUpload {
+  level_id: number;
+  attempts: number;
+  best_percentage: number;
+  time_alive_ms: number;
+  completed: boolean;
+  used_practice: boolean;
+  started_at: number;
+  ended_at: number;
+  deaths: [number, number][];
+}
+
+function toDate(ms: unknown): Date | null {
+  return typeof ms === "number" && Number.isFinite(ms) && ms > 0 ? new Date(ms) : null;
+}
+
+// Receive session summaries from GD mod
+sessionsRouter.post("/api/sessions", async (c) => {
+  const body = await c.req.json() as {
+    auth_token: string;
+    sessions: SessionUpload[];
+  };
+
+  if (!body.auth_token || !Array.isArray(body.sessions)) {
+    return c.json({ success: false, error: "Missing required fields" }, 400);
+  }
+
+  if (body.sessions.length > MAX_SESSIONS_PER_REQUEST) {
+    return c.json({ success: false, error: "Too many sessions" }, 413);
+  }
+
+  const user = await db.query.users.findFirst({
+    where: eq(users.authToken, body.auth_token),
+  });
+
+  if (!user) {
+    return c.json({ success: false, error: "Invalid auth token" }, 401);
+  }
+
+  // Skip malformed entries instead of failing the request, the mod won't resend them
+  const rows: NewSessionSummary[] = body.sessions
+    .filter((session) => session?.level_id && Number.isInteger(session.attempts) && session.attempts > 0)
+    .map((session) => ({
+      userId: user.id,
+      levelId: session.level_id,
+      attempts: session.attempts,
+      bestPercentage: Math.min(Math.max(session.best_percentage || 0, 0), 100),
+      timeAliveMs: Math.max(session.time_alive_ms || 0, 0),
+      completed: !!session.completed,
+      usedPractice: !!session.used_practice,
+      deaths: (Array.isArray(session.deaths) ? session.deaths : []).filter(
+        (pair) =>
+          Array.isArray(pair) &&
+          Number.isInteger(pair[0]) && pair[0] >= 0 && pair[0] < HEATMAP_BUCKETS &&
+          Number.isInteger(pair[1]) && pair[1] > 0
+      ),
+      startedAt: toDate(session.started_at),
+      endedAt: toDate(session.ended_at),
+    }));
+
+  if (rows.length > 0) {
+    await db.insert(sessionSummaries).values(rows);
+  }
+
+  return c.json({ success: true, accepted: rows.length, rejected: body.sessions.length - rows.length });
+});
+
+// Per-level totals for a user, summed from session summaries (internal use by bot)
+sessionsRouter.get("/api/sessions/:discordId/:levelId", async (c) => {
+  const discordId = c.req.param("discordId");
+  const levelId = parseInt(c.req.param("levelId"));
+
+  if (!Number.isInteger(levelId)) {
+    return c.json({ success: false, error: "Invalid level ID" }, 400);
+  }
+
+  const user = await db.query.users.findFirst({
+    where: eq(users.discordId, discordId),
+  });
+
+  if (!user) {
+    return c.json({ success: false, error: "User not linked" }, 404);
+  }
+
+  const [stats] = await db
+    .select({
+      sessions: sql<number>`count(*)::int`,
+      attempts: sql<number>`coalesce(sum(${sessionSummaries.attempts}), 0)::int`,
+      bestPercentage: sql<number>`coalesce(max(${sessionSummaries.bestPercentage}), 0)::int`,
+      timeAliveMs: sql<number>`coalesce(sum(${sessionSummaries.timeAliveMs}), 0)::bigint`.mapWith(Number),
+      completions: sql<number>`count(*) filter (where ${sessionSummaries.completed})::int`,
+      firstPlayed: sql<Date | null>`min(${sessionSummaries.startedAt})`,
+      lastPlayed: sql<Date | null>`max(${sessionSummaries.endedAt})`,
+    })
+    .from(sessionSummaries)
+    .where(and(eq(sessionSummaries.userId, user.id), eq(sessionSummaries.levelId, levelId)));
+
+  if (!stats || stats.sessions === 0) {
+    return c.json({ success: false, error: "No sessions for this level" }, 404);
+  }
+
+  return c.json({ success: true, stats });
+});
+
+export default sessionsRouter;
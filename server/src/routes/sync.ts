@@ -0,0 +1,203 @@
+import { Hono } from "hono";
+import { db } from "../db/index.js";
+import { users, scores, levelCache } from "../db/schema.js";
+import { and, asc, eq, gte, isNotNull, sql, type SQL } from "drizzle-orm";
+import { wrapHashSum } from "../lib/rangeSync.js";
+
+const syncRouter = new Hono();
+
+const MAX_RANGES_PER_REQUEST = 64;
+const MAX_LISTED_ITEMS = 64;
+// A differing range the mod listed its hashes for is answered with the difference,
+// unless the server has more than this many scores in it
+const MAX_DIFF_SIZE = 1024;
+// Otherwise, a range with this few scores is answered with the scores themselves
+const LEAF_SIZE = 32;
+// And anything bigger is split into this many ranges of about equal size
+const FANOUT = 16;
+
+type SyncKey = [number, number];
+
+interface SyncRange {
+  from: SyncKey;
+  // Exclusive, null or left out for the end of the key space
+  to: SyncKey | null;
+  count: number;
+  hash: string;
+  // Hashes of the mod's scores in the range, when it has few
+  items?: string[];
+}
+
+function isKey(value: unknown): value is SyncKey {
+  return Array.isArray(value) && value.length === 2 && value.every((n) => Number.isSafeInteger(n));
+}
+
+function keyBefore(key: SyncKey): SQL {
+  return sql`(${scores.levelId}, ${scores.playedAt}) < (${key[0]}::int, ${key[1]}::bigint)`;
+}
+
+function rangeWhere(userId: number, since: number, from: SyncKey, to: SyncKey | null): SQL {
+  return and(
+    eq(scores.userId, userId),
+    isNotNull(scores.syncHash),
+    gte(scores.playedAt, since),
+    sql`(${scores.levelId}, ${scores.playedAt}) >= (${from[0]}::int, ${from[1]}::bigint)`,
+    to ? keyBefore(to) : undefined
+  )!;
+}
+
+async function rangeItems(where: SQL) {
+  const rows = await db
+    .select({
+      levelId: scores.levelId,
+      playedAt: scores.playedAt,
+      percentage: scores.percentage,
+      attempts: scores.attempts,
+      passed: scores.passed,
+      isPractice: scores.isPractice,
+      coins: scores.coins,
+      syncHash: scores.syncHash,
+      name: levelCache.name,
+    })
+    .from(scores)
+    .leftJoin(levelCache, eq(levelCache.levelId, scores.levelId))
+    .where(where)
+    .orderBy(asc(scores.levelId), asc(scores.playedAt));
+
+  return rows.map((row) => ({
+    hash: wrapHashSum(String(row.syncHash)),
+    level_id: row.levelId,
+    played_at: row.playedAt,
+    percentage: row.percentage,
+    attempts: row.attempts ?? 0,
+    passed: row.passed,
+    is_practice: !!row.isPractice,
+    coins: row.coins ?? [],
+    name: row.name ?? "",
+  }));
+}
+
+// Cuts a range the mod's fingerprint disagrees with into FANOUT parts at every
+// count/FANOUT-th key and fingerprints each. Both queries walk the range on
+// scores_sync_idx, only the cut points and sums come back.
+async function splitRange(where: SQL, range: SyncRange, count: number): Promise<SyncRange[] | null> {
+  const step = Math.ceil(count / FANOUT);
+  const numbered = db
+    .select({
+      levelId: scores.levelId,
+      playedAt: scores.playedAt,
+      n: sql<number>`row_number() over (order by ${scores.levelId}, ${scores.playedAt})`.as("n"),
+    })
+    .from(scores)
+    .where(where)
+    .as("numbered");
+  const cuts = await db
+    .select({ levelId: numbered.levelId, playedAt: numbered.playedAt })
+    .from(numbered)
+    .where(sql`${numbered.n} > 1 and (${numbered.n} - 1) % ${step} = 0`)
+    .orderBy(numbered.n);
+
+  // Scores sharing a key can't be told apart by range, so cut each key only once
+  const bounds: SyncKey[] = [];
+  let last = range.from;
+  for (const cut of cuts) {
+    const key: SyncKey = [cut.levelId, cut.playedAt!];
+    if (key[0] === last[0] && key[1] === last[1]) continue;
+    bounds.push(key);
+    last = key;
+  }
+  if (bounds.length === 0) return null;
+
+  const cases = bounds.map((bound, i) => sql`when ${keyBefore(bound)} then ${i}::int`);
+  const part = sql<number>`case ${sql.join(cases, sql` `)} else ${bounds.length}::int end`;
+  const sums = await db
+    .select({ part, count: sql<number>`count(*)::int`, hash: sql<string | null>`sum(${scores.syncHash})::text` })
+    .from(scores)
+    .where(where)
+    .groupBy(sql`1`);
+
+  const edges = [range.from, ...bounds];
+  return edges.map((from, i) => {
+    const sum = sums.find((row) => row.part === i);
+    return {
+      from,
+      to: i + 1 < edges.length ? edges[i + 1] : range.to,
+      count: sum?.count ?? 0,
+      hash: wrapHashSum(sum?.hash ?? null),
+    };
+  });
+}
+
+// One round of history sync with GD mod: each range it sends comes back as a
+// match, the difference from the hashes it listed, the server's scores in it, or
+// smaller ranges to compare next round
+syncRouter.post("/api/sync", async (c) => {
+  const body = await c.req.json() as {
+    auth_token: string;
+    since: number;
+    ranges: SyncRange[];
+  };
+
+  if (!body.auth_token || !Array.isArray(body.ranges)) {
+    return c.json({ success: false, error: "Missing required fields" }, 400);
+  }
+
+  if (body.ranges.length > MAX_RANGES_PER_REQUEST) {
+    return c.json({ success: false, error: "Too many ranges" }, 413);
+  }
+
+  const user = await db.query.users.findFirst({
+    where: eq(users.authToken, body.auth_token),
+  });
+
+  if (!user) {
+    return c.json({ success: false, error: "Invalid auth token" }, 401);
+  }
+
+  const since = Number.isSafeInteger(body.since) ? Math.max(body.since, 0) : 0;
+  const results = [];
+  for (const range of body.ranges) {
+    if (
+      !range || !isKey(range.from) || (range.to != null && !isKey(range.to)) ||
+      (range.items !== undefined && (!Array.isArray(range.items) || range.items.length > MAX_LISTED_ITEMS))
+    ) {
+      return c.json({ success: false, error: "Malformed range" }, 400);
+    }
+    range.to ??= null;
+
+    const where = rangeWhere(user.id, since, range.from, range.to);
+    const [mine] = await db
+      .select({ count: sql<number>`count(*)::int`, hash: sql<string | null>`sum(${scores.syncHash})::text` })
+      .from(scores)
+      .where(where);
+
+    if (mine.count === range.count && wrapHashSum(mine.hash) === range.hash) {
+      results.push({ status: "match" });
+      continue;
+    }
+
+    // The mod has few scores here: send back which of them are missing and the
+    // scores it doesn't have
+    if (range.items && mine.count <= MAX_DIFF_SIZE) {
+      const unmatched = new Map<string, number[]>();
+      range.items.forEach((hash, i) => unmatched.set(hash, [...(unmatched.get(hash) ?? []), i]));
+
+      const serverOnly = [];
+      for (const item of await rangeItems(where)) {
+        const waiting = unmatched.get(item.hash);
+        if (waiting?.length) waiting.pop();
+        else serverOnly.push(item);
+      }
+      const missing = [...unmatched.values()].flat().sort((a, b) => a - b);
+      results.push({ status: "diff", missing, items: serverOnly });
+      continue;
+    }
+
+    const parts = mine.count > LEAF_SIZE ? await splitRange(where, range, mine.count) : null;
+    results.push(parts ? { status: "split", parts } : { status: "items", items: await rangeItems(where) });
+  }
+
+  return c.json({ success: true, results });
+});
+
+export default syncRouter;
@@ -0,0 +1,168 @@
+// Runs the batch route against a real database: set DATABASE_URL to one with the
+// schema pushed (npm run db:push), then npm test. Skipped without one.
+import "dotenv/config";
+import assert from "node:assert/strict";
+import { after, before, test } from "node:test";
+import { eq, inArray } from "drizzle-orm";
+import { db } from "../src/db/index.js";
+import * as schema from "../src/db/schema.js";
+import scoresRouter from "../src/routes/scores.js";
+
+const skip = process.env.DATABASE_URL ? false : "DATABASE_URL not set";
+
+// A level ID and user no real data uses, removed again afterwards
+const LEVEL_ID = 2000000000 + Math.floor(Math.random() * 100000000);
+const DISCORD_ID = `test-${LEVEL_ID}`;
+const AUTH_TOKEN = `test-token-${LEVEL_ID}`;
+
+// version 1, two points: (0ms, 0) and (+100ms, +10)
+const TIMELINE = Buffer.from([1, 2, 0, 0, 100, 20]).toString("base64");
+
+const LEVEL = {
+  level_id: LEVEL_ID,
+  name: "Batch Test",
+  creator: "Tests",
+  description: "",
+  difficulty: 0,
+  stars: 0,
+  is_demon: false,
+  demon_difficulty: 0,
+  audio_track: 0,
+  song_id: 0,
+  song_name: "",
+  song_author: "",
+  length: 0,
+  downloads: 0,
+  likes: 0,
+};
+
+let userId = 0;
+
+function score(percentage: number, extra: Record<string, unknown> = {}) {
+  return { level_id: LEVEL_ID, percentage, attempts: 4, passed: false, is_practice: false, coins_collected: [], ...extra };
+}
+
+async function postBatch(body: Record<string, unknown>) {
+  const res = await scoresRouter.request("/api/scores/batch", {
+    method: "POST",
+    headers: { "Content-Type": "application/json" },
+    body: JSON.stringify({ auth_token: AUTH_TOKEN, gd_account_id: 1, gd_username: "Tests", levels: [LEVEL], ...body }),
+  });
+  assert.equal(res.status, 200);
+  return await res.json() as { accepted: number; duplicates: number; rejected: number };
+}
+
+async function storedScores() {
+  const rows = await db
+    .select({ id: schema.scores.id, percentage: schema.scores.percentage, attempts: schema.scores.attempts })
+    .from(schema.scores)
+    .where(eq(schema.scores.userId, userId));
+  const timelines = rows.length === 0 ? [] : await db
+    .select({ scoreId: schema.attemptTimelines.scoreId, pointCount: schema.attemptTimelines.pointCount })
+    .from(schema.attemptTimelines)
+    .where(inArray(schema.attemptTimelines.scoreId, rows.map((row) => row.id)));
+  return { rows, timelines };
+}
+
+async function clearScores() {
+  const { rows } = await storedScores();
+  if (rows.length === 0) return;
+  await db.delete(schema.attemptTimelines).where(inArray(schema.attemptTimelines.scoreId, rows.map((row) => row.id)));
+  await db.delete(schema.scores).where(eq(schema.scores.userId, userId));
+}
+
+before(async () => {
+  if (skip) return;
+  const [user] = await db
+    .insert(schema.users)
+    .values({ discordId: DISCORD_ID, authToken: AUTH_TOKEN, gdUsername: "Tests" })
+    .returning({ id: schema.users.id });
+  userId = user.id;
+});
+
+after(async () => {
+  if (skip) return;
+  await clearScores();
+  await db.delete(schema.levelBests).where(eq(schema.levelBests.userId, userId));
+  await db.delete(schema.levelBestCounts).where(eq(schema.levelBestCounts.levelId, LEVEL_ID));
+  await db.delete(schema.levelCache).where(eq(schema.levelCache.levelId, LEVEL_ID));
+  await db.delete(schema.users).where(eq(schema.users.id, userId));
+  await db.$client.end();
+});
+
+test("a batch sent three times stores one score and one timeline", { skip }, async () => {
+  const batch = { install_id: "00000000deadbeef", scores: [score(57, { seq: 1, timeline: TIMELINE })] };
+
+  const first = await postBatch(batch);
+  const second = await postBatch(batch);
+  const third = await postBatch(batch);
+  assert.deepEqual([first.accepted, second.accepted, third.accepted], [1, 0, 0]);
+  assert.deepEqual([second.duplicates, third.duplicates], [1, 1]);
+
+  const { rows, timelines } = await storedScores();
+  assert.equal(rows.length, 1);
+  assert.equal(timelines.length, 1);
+  assert.equal(timelines[0].scoreId, rows[0].id);
+  assert.equal(timelines[0].pointCount, 2);
+  await clearScores();
+});
+
+test("timelines of scores without a seq land on their own score", { skip }, async () => {
+  // An older mod: no install ID, so nothing to match returned rows by but the insert itself
+  const result = await postBatch({ scores: [score(11), score(22, { timeline: TIMELINE }), score(33)] });
+  assert.equal(result.accepted, 3);
+
+  const { rows, timelines } = await storedScores();
+  assert.equal(rows.length, 3);
+  assert.equal(timelines.length, 1);
+  assert.equal(rows.find((row) => row.id === timelines[0].scoreId)?.percentage, 22);
+  await clearScores();
+});
+
+test("a pass on the first try is stored", { skip }, async () => {
+  // Attempts only go up on a reset, so nothing has counted the first one yet
+  const result = await postBatch({ scores: [score(100, { passed: true, attempts: 0 })] });
+  assert.equal(result.accepted, 1);
+  assert.equal(result.rejected, 0);
+
+  const { rows } = await storedScores();
+  assert.equal(rows.length, 1);
+  assert.equal(rows[0].percentage, 100);
+  assert.equal(rows[0].attempts, 0);
+  await clearScores();
+});
+
+test("invalid scores are dropped, the rest of the batch is kept", { skip }, async () => {
+  const result = await postBatch({
+    scores: [score(40), score(140), score(40.5), score(60, { attempts: -1 }), score(70, { coins_collected: [1, 2, 3, 4] })],
+  });
+  assert.equal(result.accepted, 1);
+  assert.equal(result.rejected, 4);
+  await clearScores();
+});
+
+test("level info from the mod fills the cache but doesn't overwrite a fresh row", { skip }, async () => {
+  async function cachedName() {
+    const [row] = await db
+      .select({ name: schema.levelCache.name })
+      .from(schema.levelCache)
+      .where(eq(schema.levelCache.levelId, LEVEL_ID));
+    return row?.name;
+  }
+
+  // The same level twice in one batch still goes in as one row
+  await postBatch({ scores: [score(10)], levels: [LEVEL, LEVEL] });
+  assert.equal(await cachedName(), "Batch Test");
+
+  await postBatch({ scores: [score(20)], levels: [{ ...LEVEL, name: "Renamed" }] });
+  assert.equal(await cachedName(), "Batch Test");
+
+  // Once the row is past its day it's refreshed from what the mod sends
+  await db
+    .update(schema.levelCache)
+    .set({ cachedAt: new Date(Date.now() - 2 * 24 * 60 * 60 * 1000) })
+    .where(eq(schema.levelCache.levelId, LEVEL_ID));
+  await postBatch({ scores: [score(30)], levels: [{ ...LEVEL, name: "Renamed" }] });
+  assert.equal(await cachedName(), "Renamed");
+  await clearScores();
+});